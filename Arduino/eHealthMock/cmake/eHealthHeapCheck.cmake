@@ -0,0 +1,29 @@
+# Fails when the static library LIBRARY references the heap.
+#
+# Run as a post-build step: cmake -DLIBRARY=<archive> -DNM=<nm> -P eHealthHeapCheck.cmake
+# Every undefined symbol of every object is matched against the C allocator,
+# operator new and delete, and the String and std::string classes.
+
+execute_process(
+	COMMAND ${NM} -C -A -u ${LIBRARY}
+	OUTPUT_VARIABLE symbols
+	RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "${NM} failed on ${LIBRARY}")
+endif()
+
+string(REPLACE "\n" ";" symbols "${symbols}")
+set(offenders "")
+foreach(line IN LISTS symbols)
+	if(line MATCHES " U (malloc|calloc|realloc|free|strdup|posix_memalign|aligned_alloc)$"
+		OR line MATCHES " U operator (new|delete)"
+		OR line MATCHES " U String::"
+		OR line MATCHES "basic_string")
+		string(APPEND offenders "\n  ${line}")
+	endif()
+endforeach()
+
+if(offenders)
+	message(FATAL_ERROR "${LIBRARY} is built without the heap but references it:${offenders}")
+endif()
@@ -0,0 +1,357 @@
+/*
+*=========================================================================================
+ *  Heartbeat detector of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthBeat.h"
+
+	//! Rate the input is decimated toward, in Hz.
+	#define BEAT_TARGET_RATE 200
+
+	//! Largest derivative squared, so the square fits 16 bits after the shift.
+	#define BEAT_SLOPE_LIMIT 4095
+
+	//! Wraps i to a ring of size entries, a power of 2.
+	#define BEAT_RING(i, size) ((i) & ((size) - 1))
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	//! Function that handles the creation and setup of instances
+	eHealthBeatDetector::eHealthBeatDetector(void)
+	{
+		setSampleRate(250);
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	//!******************************************************************************
+	//!		Name:	setSampleRate()													*
+	//!		Description: Sets the rate of the ECG samples and resets.				*
+	//!		Param : uint16_t hz: samples per second, 0 to stop.						*
+	//!		Returns: bool, false if hz is out of range.								*
+	//!		Example: eHealth.heartbeat.setSampleRate(800);							*
+	//!******************************************************************************
+
+	bool eHealthBeatDetector::setSampleRate(uint16_t hz)
+	{
+		bool valid = hz >= EHEALTH_BEAT_MIN_RATE && hz <= EHEALTH_BEAT_MAX_RATE;
+
+		inputRate = valid ? hz : 0;
+		factor = valid ? (hz + BEAT_TARGET_RATE / 2) / BEAT_TARGET_RATE : 1;
+		if (!factor) {
+			factor = 1;
+		}
+		scale = 16384 / factor;
+
+		uint16_t internal = inputRate / factor;
+		refractory = internal / 5;
+		tWave = (uint16_t)((uint32_t)internal * 9 / 25);
+		learning = 2 * internal;
+		quiet = 3 * internal;
+		// 150 ms, rounded. Below 300 Hz internally, so at most 45 samples.
+		window = (3 * internal + 10) / 20;
+		if (!window) {
+			window = 1;
+		}
+
+		reset();
+		return valid || !hz;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	reset()															*
+	//!		Description: Forgets every sample and beat.								*
+	//!		Param : void															*
+	//!		Returns: void															*
+	//!		Example: eHealth.heartbeat.reset();										*
+	//!******************************************************************************
+
+	void eHealthBeatDetector::reset(void)
+	{
+		phase = 0;
+		sum = 0;
+		n = 0;
+		primed = false;
+		beatCount = 0;
+		relearn();
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	update()														*
+	//!		Description: Feeds one ECG sample.										*
+	//!		Param : uint16_t sample: ADC counts.									*
+	//!		Returns: bool, true if a beat was detected at this sample.				*
+	//!		Example: if (eHealth.heartbeat.update(raw)) digitalWrite(13, HIGH);	*
+	//!******************************************************************************
+
+	bool eHealthBeatDetector::update(uint16_t sample)
+	{
+		if (!inputRate) {
+			return false;
+		}
+
+		sum += sample > 1023 ? 1023 : sample;
+		if (++phase < factor) {
+			return false;
+		}
+
+		int16_t x = (int16_t)(((uint32_t)sum * scale) >> 12);
+		phase = 0;
+		sum = 0;
+		return step(x);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	process()														*
+	//!		Description: Feeds a block of ECG samples.								*
+	//!		Param : const uint16_t * samples, size_t count							*
+	//!		Returns: size_t with the beats detected.								*
+	//!		Example: eHealth.heartbeat.process(ecg, 64);							*
+	//!******************************************************************************
+
+	size_t eHealthBeatDetector::process(const uint16_t * samples, size_t count)
+	{
+		size_t found = 0;
+
+		for (size_t i = 0; i < count; i++) {
+			found += update(samples[i]);
+		}
+		return found;
+	}
+
+
+//***************************************************************
+// Private Methods												*
+//***************************************************************
+
+	//! Filters one decimated sample and looks for a beat in it.
+
+	bool eHealthBeatDetector::step(int16_t x)
+	{
+		if (!primed) {
+			prime(x);
+		}
+
+		// Low-pass, gain 36: 12 Hz at 200 Hz. Its zeros cancel the poles on
+		// the unit circle, which integer arithmetic keeps exact.
+		int32_t low = 2 * low1 - low2 + x - 2 * (int32_t)lowIn[BEAT_RING(n - 6, 16)] + lowIn[BEAT_RING(n - 12, 16)];
+		lowIn[BEAT_RING(n, 16)] = x;
+		low2 = low1;
+		low1 = low;
+
+		// High-pass: the input 16 samples ago less the mean of the last 32.
+		int16_t scaled = (int16_t)(low >> 3);
+		highSum += scaled - highIn[BEAT_RING(n, 32)];
+		highIn[BEAT_RING(n, 32)] = scaled;
+		int16_t band = (int16_t)(highIn[BEAT_RING(n - 16, 32)] - (highSum >> 5));
+
+		// Five point derivative, squared.
+		int32_t slope = (2 * (int32_t)band + band1 - band3 - 2 * (int32_t)band4) >> 3;
+		band4 = band3;
+		band3 = band2;
+		band2 = band1;
+		band1 = band;
+		if (slope > BEAT_SLOPE_LIMIT) {
+			slope = BEAT_SLOPE_LIMIT;
+		} else if (slope < -BEAT_SLOPE_LIMIT) {
+			slope = -BEAT_SLOPE_LIMIT;
+		}
+		uint16_t energy = (uint16_t)((uint32_t)(slope * slope) >> 8);
+
+		// Moving window integration.
+		integral += energy;
+		integral -= integrand[slot];
+		integrand[slot] = energy;
+		if (++slot == window) {
+			slot = 0;
+		}
+
+		uint32_t value = integral;
+		uint32_t beatsBefore = beatCount;
+
+		if (n < learnUntil) {
+			if (value > learnMax) {
+				learnMax = value;
+			}
+			learnSum += value;
+		} else if (n == learnUntil) {
+			signalLevel = learnMax / 3;
+			noiseLevel = learnSum / learning / 2;
+			thresholds();
+		}
+
+		// Peaks: the top of a rise, once the value has fallen to half of it.
+		// The next rise starts 50% above the bottom of the fall.
+		if (rising) {
+			if (value > extreme) {
+				extreme = value;
+				extremeAt = n;
+			} else if (value < extreme / 2) {
+				peak(extreme, extremeAt);
+				rising = false;
+				extreme = value;
+			}
+		} else if (value < extreme) {
+			extreme = value;
+		} else if (value > extreme + extreme / 2 + 1) {
+			rising = true;
+			extreme = value;
+			extremeAt = n;
+		}
+
+		if (n > learnUntil) {
+			uint32_t since = n - lastBeat;
+
+			if (intervalCount && missed && since > (uint32_t)intervalSum * 166 / (100 * intervalCount)) {
+				// Search back: the missed beat is the largest peak since.
+				signalLevel += ((int32_t)missed - (int32_t)signalLevel) / 4;
+				beat(missed, missedAt);
+				thresholds();
+			} else if (since > quiet) {
+				relearn();
+			}
+		}
+
+		n++;
+		return beatCount != beatsBefore;
+	}
+
+/*******************************************************************************************************/
+
+	//! Fills the filter windows as if x had always been the input.
+
+	void eHealthBeatDetector::prime(int16_t x)
+	{
+		int16_t scaled = (int16_t)((36 * (int32_t)x) >> 3);
+
+		for (uint8_t i = 0; i < 16; i++) {
+			lowIn[i] = x;
+		}
+		low1 = low2 = 36 * (int32_t)x;
+		for (uint8_t i = 0; i < 32; i++) {
+			highIn[i] = scaled;
+		}
+		highSum = 32 * (int32_t)scaled;
+		band1 = band2 = band3 = band4 = 0;
+		for (uint8_t i = 0; i < sizeof(integrand) / sizeof(integrand[0]); i++) {
+			integrand[i] = 0;
+		}
+		integral = 0;
+		slot = 0;
+		primed = true;
+	}
+
+/*******************************************************************************************************/
+
+	//! Classifies a peak of the integrated signal found at sample at.
+
+	void eHealthBeatDetector::peak(uint32_t height, uint32_t at)
+	{
+		if (at < learnUntil) {
+			return;
+		}
+		if (anchored && at - lastBeat < refractory) {
+			return;
+		}
+
+		// A small peak soon after a beat is its T wave. Pan and Tompkins
+		// compare slopes; the heights of the integrated signal serve as well.
+		bool tail = anchored && at - lastBeat < tWave && height < lastHeight / 2;
+
+		if (height > threshold1 && !tail) {
+			signalLevel += ((int32_t)height - (int32_t)signalLevel) / 8;
+			beat(height, at);
+		} else {
+			noiseLevel += ((int32_t)height - (int32_t)noiseLevel) / 8;
+			if (height > threshold2 && height > missed) {
+				missed = height;
+				missedAt = at;
+			}
+		}
+		thresholds();
+	}
+
+/*******************************************************************************************************/
+
+	//! Records a beat of the given height at sample at.
+
+	void eHealthBeatDetector::beat(uint32_t height, uint32_t at)
+	{
+		// An interval needs a beat before it since the last learning phase.
+		if (anchored) {
+			uint16_t interval = (uint16_t)(at - lastBeat);
+
+			intervalSum += interval - intervals[intervalSlot];
+			intervals[intervalSlot] = interval;
+			intervalSlot = BEAT_RING(intervalSlot + 1, EHEALTH_BEAT_RR_HISTORY);
+			if (intervalCount < EHEALTH_BEAT_RR_HISTORY) {
+				intervalCount++;
+			}
+
+			uint32_t samples = (uint32_t)intervalSum * factor;
+			uint32_t perMinute = ((uint32_t)60 * inputRate * intervalCount + samples / 2) / samples;
+			rate = perMinute > 255 ? 255 : (uint8_t)perMinute;
+			lastInterval = (uint16_t)(((uint32_t)interval * factor * 1000 + inputRate / 2) / inputRate);
+		}
+
+		lastBeat = at;
+		lastHeight = height;
+		anchored = true;
+		beatCount++;
+		missed = 0;
+	}
+
+/*******************************************************************************************************/
+
+	//! Starts learning the peak levels again, from sample n.
+
+	void eHealthBeatDetector::relearn(void)
+	{
+		learnUntil = n + learning;
+		learnMax = 0;
+		learnSum = 0;
+		signalLevel = 0;
+		noiseLevel = 0;
+		thresholds();
+
+		rising = true;
+		extreme = 0;
+		extremeAt = n;
+		missed = 0;
+		lastBeat = learnUntil;
+		anchored = false;
+
+		for (uint8_t i = 0; i < EHEALTH_BEAT_RR_HISTORY; i++) {
+			intervals[i] = 0;
+		}
+		intervalSum = 0;
+		intervalCount = 0;
+		intervalSlot = 0;
+		rate = 0;
+		lastInterval = 0;
+	}
+
+/*******************************************************************************************************/
+
+	//! Derives the thresholds from the peak levels.
+
+	void eHealthBeatDetector::thresholds(void)
+	{
+		threshold1 = noiseLevel + ((int32_t)signalLevel - (int32_t)noiseLevel) / 4;
+		threshold2 = threshold1 / 2;
+	}
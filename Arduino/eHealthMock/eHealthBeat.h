@@ -0,0 +1,184 @@
+/*
+*=========================================================================================
+ *  Heartbeat detector of the eHealth Mock.
+ *
+ *  Finds the QRS complexes of an ECG as it streams in, after Pan and
+ *  Tompkins, and derives the heart rate and the RR interval (time between
+ *  two R waves) from them. Every stage is integer and keeps a fixed window,
+ *  so each sample costs the same small amount of work and memory:
+ *
+ *    decimate    inputs above 300 Hz are summed down to 150-300 Hz
+ *    band-pass   low-pass y = 2y1 - y2 + x - 2x6 + x12, then the mean of
+ *                the last 32 samples is removed (5-15 Hz at 200 Hz)
+ *    derivative  (2x + x1 - x3 - 2x4) / 8, squared
+ *    integrate   sum over a 150 ms moving window
+ *
+ *  A peak of the integrated signal is a beat when it rises above a threshold
+ *  a quarter of the way from the running noise peak level to the running
+ *  beat peak level. The first 2 seconds only learn the two levels. Peaks
+ *  within 200 ms of a beat are ignored, and peaks within 360 ms of one and
+ *  less than half its height are taken for its T wave. When no beat comes
+ *  for 1.66 average RR intervals, the largest peak above half the threshold
+ *  since the last beat is taken as the missed one. After 3 seconds without
+ *  a beat the detector forgets the rate and learns again.
+ *
+ *  Beats are reported about 200 ms after their R wave, once the integrated
+ *  signal has fallen from its peak. The heart rate averages the last 8 RR
+ *  intervals.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthBeat_h
+#define eHealthBeat_h
+
+#include "Arduino.h"
+
+	//! Lowest and highest ECG sample rates the detector takes, in Hz.
+	#define EHEALTH_BEAT_MIN_RATE 100
+	#define EHEALTH_BEAT_MAX_RATE 2000
+
+	//! RR intervals averaged into the heart rate, a power of 2.
+	#define EHEALTH_BEAT_RR_HISTORY 8
+
+// Library interface description
+class eHealthBeatDetector {
+
+	public:
+
+		//! Class constructor. Expects the waveform's default 250 Hz.
+		eHealthBeatDetector(void);
+
+		//! Sets the rate of the samples fed to the detector, and resets it.
+		/*!
+		\param uint16_t hz : samples per second, 0 to stop detecting.
+		\return bool : false if hz is outside EHEALTH_BEAT_MIN_RATE to
+		 *  EHEALTH_BEAT_MAX_RATE. The detector is then stopped.
+		*/	bool setSampleRate(uint16_t hz);
+
+		//! Returns the sample rate, 0 when stopped.
+		uint16_t sampleRate(void) const { return inputRate; }
+
+		//! Forgets every sample and beat, as if just constructed at this rate.
+		void reset(void);
+
+		//! Feeds one sample.
+		/*!
+		\param uint16_t sample : ADC counts (0-1023).
+		\return bool : true if a beat was detected at this sample.
+		*/	bool update(uint16_t sample);
+
+		//! Feeds count samples, the same as count calls to update().
+		/*!
+		\param const uint16_t * samples : ADC counts (0-1023).
+		\param size_t count : samples.
+		\return size_t : beats detected.
+		*/	size_t process(const uint16_t * samples, size_t count);
+
+		//! Returns the heart rate in beats per minute, 0 until two beats are
+		//! found or after 3 seconds without one.
+		uint8_t bpm(void) const { return rate; }
+
+		//! Returns the last RR interval in milliseconds, 0 when bpm() is.
+		uint16_t rrInterval(void) const { return lastInterval; }
+
+		//! Returns the beats detected since the last reset.
+		uint32_t beats(void) const { return beatCount; }
+
+	private:
+
+		//! Filters one decimated sample and looks for a beat in it.
+		bool step(int16_t x);
+
+		//! Fills the filter windows as if x had always been the input.
+		void prime(int16_t x);
+
+		//! Classifies a peak of the integrated signal found at sample at.
+		void peak(uint32_t height, uint32_t at);
+
+		//! Records a beat of the given height at sample at.
+		void beat(uint32_t height, uint32_t at);
+
+		//! Starts learning the peak levels again, from sample n.
+		void relearn(void);
+
+		//! Derives the thresholds from the peak levels.
+		void thresholds(void);
+
+		//! Input rate, decimation factor, samples summed so far and the scale
+		//! that turns their sum into 4 times their mean, in Q12.
+		uint16_t inputRate;
+		uint8_t factor;
+		uint8_t phase;
+		uint16_t sum;
+		uint16_t scale;
+
+		//! Durations in decimated samples.
+		uint16_t refractory;
+		uint16_t tWave;
+		uint16_t learning;
+		uint16_t quiet;
+		uint8_t window;
+
+		//! Decimated samples filtered, the first one primes the filters.
+		uint32_t n;
+		bool primed;
+
+		//! Low-pass: its last inputs and last two outputs.
+		int16_t lowIn[16];
+		int32_t low1, low2;
+
+		//! High-pass: the last 32 low-pass outputs and their sum.
+		int16_t highIn[32];
+		int32_t highSum;
+
+		//! Derivative: the last four band-pass outputs.
+		int16_t band1, band2, band3, band4;
+
+		//! Moving window integrator.
+		uint16_t integrand[48];
+		uint32_t integral;
+		uint8_t slot;
+
+		//! Peak search: the top of the current rise or the bottom of the fall.
+		bool rising;
+		uint32_t extreme;
+		uint32_t extremeAt;
+
+		//! Learning phase: end, largest value and sum of values.
+		uint32_t learnUntil;
+		uint32_t learnMax;
+		uint32_t learnSum;
+
+		//! Running peak levels and thresholds.
+		uint32_t signalLevel;
+		uint32_t noiseLevel;
+		uint32_t threshold1;
+		uint32_t threshold2;
+
+		//! Largest peak above threshold2 since the last beat, for the search back.
+		uint32_t missed;
+		uint32_t missedAt;
+
+		//! Beats: the last one and its height, whether it came after the last
+		//! learning phase, the last RR intervals and their sum.
+		uint32_t lastBeat;
+		uint32_t lastHeight;
+		bool anchored;
+		uint32_t beatCount;
+		uint16_t intervals[EHEALTH_BEAT_RR_HISTORY];
+		uint16_t intervalSum;
+		uint8_t intervalCount;
+		uint8_t intervalSlot;
+
+		//! Derived outputs.
+		uint8_t rate;
+		uint16_t lastInterval;
+};
+
+#endif
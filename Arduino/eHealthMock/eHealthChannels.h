@@ -0,0 +1,42 @@
+/*
+*=========================================================================================
+ *  Channel identifiers of the eHealth Mock.
+ *
+ *  Every reading the library can stream (frames, sample buffers, traces) is
+ *  tagged with one of these channels. Sets of channels are bitmaps built with
+ *  EHEALTH_CHANNEL_BIT().
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthChannels_h
+#define eHealthChannels_h
+
+	//! Streamable channels, with the unit of their raw value.
+	enum eHealthChannel {
+		EHEALTH_ECG = 0,		//!< ADC counts (0-1023)
+		EHEALTH_EMG,			//!< ADC counts (0-1023)
+		EHEALTH_AIRFLOW,		//!< ADC counts (0-1023)
+		EHEALTH_GSR,			//!< ADC counts (0-1023) of the skin conductance voltage
+		EHEALTH_TEMPERATURE,	//!< Hundredths of a degree Celsius
+		EHEALTH_SPO2,			//!< Percent
+		EHEALTH_BPM,			//!< Beats per minute
+		EHEALTH_POSITION,		//!< Body position code (see getBodyPosition())
+		EHEALTH_SYSTOLIC,		//!< mmHg
+		EHEALTH_DIASTOLIC,		//!< mmHg
+		EHEALTH_GLUCOSE,		//!< mg/dL
+		EHEALTH_CHANNEL_COUNT
+	};
+
+	//! Bit of channel in a channel bitmap.
+	#define EHEALTH_CHANNEL_BIT(channel) ((uint16_t)(1U << (channel)))
+
+	//! Bitmap with every channel set.
+	#define EHEALTH_ALL_CHANNELS ((uint16_t)((1U << EHEALTH_CHANNEL_COUNT) - 1))
+
+#endif
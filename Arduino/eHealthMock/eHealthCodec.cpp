@@ -0,0 +1,482 @@
+/*
+*=========================================================================================
+ *  Lossless waveform codec of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthCodec.h"
+
+
+//***************************************************************
+// Bit packing													*
+//***************************************************************
+
+	//! Residuals per width code.
+	#define GROUP_SIZE 8
+
+	//! Width code that stands for 16 bits.
+	#define WIDE_CODE 15
+
+	//! Returns the number of channels set in channels.
+	static uint8_t countChannels(uint16_t channels)
+	{
+		uint8_t count = 0;
+
+		for (; channels; channels &= channels - 1) {
+			count++;
+		}
+		return count;
+	}
+
+	//! Returns the bits needed to hold value.
+	static inline uint8_t bitsOf(uint16_t value)
+	{
+		return value ? (uint8_t)(sizeof(unsigned int) * 8 - __builtin_clz(value)) : 0;
+	}
+
+	//! Returns the packet length its header announces, 0 if the header is not valid.
+	static size_t packetSize(const uint8_t * header)
+	{
+		uint16_t channels = eHealthRead16(&header[2]);
+
+		if (channels == 0 || (channels & ~EHEALTH_ALL_CHANNELS) || header[4] == 0) {
+			return 0;
+		}
+		return EHEALTH_PACKET_HEADER_SIZE + header[14] + EHEALTH_PACKET_CRC_SIZE;
+	}
+
+	//! Packs values LSB first into a bounded buffer.
+	struct bitWriter {
+		uint8_t * out;
+		uint8_t * end;
+		uint32_t bitBuffer;
+		uint8_t bitCount;
+		bool overflow;
+
+		bitWriter(uint8_t * data, size_t size) : out(data), end(data + size), bitBuffer(0), bitCount(0), overflow(false) {}
+
+		//! Appends the low width bits of value, width at most 16.
+		void put(uint16_t value, uint8_t width)
+		{
+			bitBuffer |= (uint32_t)value << bitCount;
+			bitCount += width;
+
+			while (bitCount >= 8) {
+				emit();
+			}
+		}
+
+		//! Writes out the last partial byte.
+		void flush(void)
+		{
+			if (bitCount) {
+				emit();
+			}
+		}
+
+		void emit(void)
+		{
+			if (out < end) {
+				*out++ = (uint8_t)bitBuffer;
+			} else {
+				overflow = true;
+			}
+			bitBuffer >>= 8;
+			bitCount = bitCount > 8 ? bitCount - 8 : 0;
+		}
+	};
+
+	//! Unpacks values LSB first. Reading past the end yields zeros and sets overrun.
+	struct bitReader {
+		const uint8_t * in;
+		const uint8_t * end;
+		uint32_t bitBuffer;
+		uint8_t bitCount;
+		bool overrun;
+
+		bitReader(const uint8_t * data, size_t size) : in(data), end(data + size), bitBuffer(0), bitCount(0), overrun(false) {}
+
+		//! Returns the next width bits, width at most 16.
+		uint16_t get(uint8_t width)
+		{
+			while (bitCount < width) {
+				if (in < end) {
+					bitBuffer |= (uint32_t)*in++ << bitCount;
+				} else {
+					overrun = true;
+				}
+				bitCount += 8;
+			}
+			uint16_t value = (uint16_t)(bitBuffer & ((1UL << width) - 1));
+			bitBuffer >>= width;
+			bitCount -= width;
+			return value;
+		}
+	};
+
+	//! Returns the prediction of the next value of a channel.
+	static inline uint16_t predict(uint8_t order, uint16_t last, uint16_t before)
+	{
+		return order == EHEALTH_PREDICT_LINEAR ? (uint16_t)(2 * last - before) : last;
+	}
+
+
+//***************************************************************
+// Packet view													*
+//***************************************************************
+
+	//! Fills packet from the header of a packet already checked.
+	static void readPacket(const uint8_t * data, eHealthPacket & packet)
+	{
+		packet.channels = eHealthRead16(&data[2]);
+		packet.count = data[4];
+		packet.sequence = eHealthRead16(&data[5]);
+		packet.timestamp = (uint32_t)eHealthRead16(&data[7]) | ((uint32_t)eHealthRead16(&data[9]) << 16);
+		packet.period = eHealthRead16(&data[11]);
+		packet.flags = data[13];
+		packet.channelCount = countChannels(packet.channels);
+		packet.payload = &data[EHEALTH_PACKET_HEADER_SIZE];
+		packet.payloadLength = data[14];
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	eHealthPacketParse()											*
+	//!		Description: Reads the packet starting at data in place.				*
+	//!		Param : const uint8_t * data, size_t length, eHealthPacket & packet		*
+	//!		Returns: size_t with the packet length, 0 if not a valid packet			*
+	//!		Example: size_t n = eHealthPacketParse(map + offset, left, packet);		*
+	//!******************************************************************************
+
+	size_t eHealthPacketParse(const uint8_t * data, size_t length, eHealthPacket & packet)
+	{
+		if (length < EHEALTH_PACKET_HEADER_SIZE || data[0] != EHEALTH_PACKET_SYNC0 || data[1] != EHEALTH_PACKET_SYNC1) {
+			return 0;
+		}
+
+		size_t packetLength = packetSize(data);
+		if (packetLength == 0 || packetLength > length || !eHealthCrcValid(data, packetLength)) {
+			return 0;
+		}
+
+		readPacket(data, packet);
+		return packetLength;
+	}
+
+
+//***************************************************************
+// Encoder														*
+//***************************************************************
+
+	eHealthCodecEncoder::eHealthCodecEncoder(void)
+	{
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			last[channel] = 0;
+			before[channel] = 0;
+			order[channel] = EHEALTH_PREDICT_DELTA;
+			nextOrder[channel] = EHEALTH_PREDICT_DELTA;
+		}
+		primed = 0;
+		nextSequence = 0;
+		interval = EHEALTH_CODEC_KEYFRAME_INTERVAL;
+		sinceKeyframe = interval;
+	}
+
+	void eHealthCodecEncoder::setPredictor(uint8_t channel, eHealthPredictor predictor)
+	{
+		if (channel < EHEALTH_CHANNEL_COUNT && predictor <= EHEALTH_PREDICT_LINEAR) {
+			nextOrder[channel] = predictor;
+		}
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	encode()														*
+	//!		Description: Encodes count snapshots of channels into packet.			*
+	//!		Param : channels, count, timestamp, period, values, packet, capacity	*
+	//!		Returns: size_t with the packet length, 0 if it does not fit.			*
+	//!		Example: n = codec.encode(channels, 32, t, 4000, values, buf, 272);		*
+	//!******************************************************************************
+
+	size_t eHealthCodecEncoder::encode(uint16_t channels, uint8_t count, uint32_t timestamp, uint16_t period,
+		const uint16_t * values, uint8_t * packet, size_t capacity)
+	{
+		if (count == 0 || channels == 0 || (channels & ~EHEALTH_ALL_CHANNELS)
+			|| capacity < EHEALTH_PACKET_HEADER_SIZE + EHEALTH_PACKET_CRC_SIZE) {
+			return 0;
+		}
+
+		bool keyframe = sinceKeyframe >= interval;
+		uint16_t wasPrimed = keyframe ? 0 : primed;
+		uint8_t channelCount = countChannels(channels);
+
+		size_t room = capacity - EHEALTH_PACKET_HEADER_SIZE - EHEALTH_PACKET_CRC_SIZE;
+		bitWriter bits(&packet[EHEALTH_PACKET_HEADER_SIZE], room < EHEALTH_PACKET_MAX_PAYLOAD ? room : EHEALTH_PACKET_MAX_PAYLOAD);
+
+		// The history only changes once the whole packet fits.
+		uint16_t newLast[EHEALTH_CHANNEL_COUNT];
+		uint16_t newBefore[EHEALTH_CHANNEL_COUNT];
+		uint8_t slot = 0;
+
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (!(channels & EHEALTH_CHANNEL_BIT(channel))) {
+				continue;
+			}
+			uint8_t width = eHealthFrameChannelBits(channel);
+			uint16_t mask = (uint16_t)((1UL << width) - 1);
+			uint8_t shift = 16 - width;
+			const uint16_t * in = values + slot++;
+			uint16_t l = last[channel];
+			uint16_t b = before[channel];
+			uint8_t o = order[channel];
+			uint8_t i = 0;
+
+			if (!(wasPrimed & EHEALTH_CHANNEL_BIT(channel))) {
+				// Start again from a raw value.
+				o = nextOrder[channel];
+				l = b = in[0] & mask;
+				bits.put(o, 2);
+				bits.put(l, width);
+				i = 1;
+			}
+
+			while (i < count) {
+				uint8_t n = count - i < GROUP_SIZE ? count - i : GROUP_SIZE;
+				uint16_t residuals[GROUP_SIZE];
+				uint16_t all = 0;
+
+				for (uint8_t j = 0; j < n; j++) {
+					uint16_t v = in[(uint16_t)(i + j) * channelCount] & mask;
+					uint16_t r = v;
+
+					if (o != EHEALTH_PREDICT_NONE) {
+						// The error wraps at the channel width, then zigzag.
+						int16_t e = (int16_t)(uint16_t)((uint16_t)(v - predict(o, l, b)) << shift) >> shift;
+						r = (uint16_t)((uint16_t)e << 1) ^ (uint16_t)(e >> 15);
+					}
+					b = l;
+					l = v;
+					residuals[j] = r;
+					all |= r;
+				}
+
+				uint8_t code = bitsOf(all);
+				uint8_t groupWidth = code;
+				if (code >= WIDE_CODE) {
+					code = WIDE_CODE;
+					groupWidth = 16;
+				}
+				bits.put(code, 4);
+				for (uint8_t j = 0; j < n; j++) {
+					bits.put(residuals[j], groupWidth);
+				}
+				i += n;
+			}
+
+			if (bits.overflow) {
+				return 0;
+			}
+			newLast[channel] = l;
+			newBefore[channel] = b;
+		}
+
+		bits.flush();
+		if (bits.overflow) {
+			return 0;
+		}
+
+		// It fits: keep the history.
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (channels & EHEALTH_CHANNEL_BIT(channel)) {
+				if (!(wasPrimed & EHEALTH_CHANNEL_BIT(channel))) {
+					order[channel] = nextOrder[channel];
+				}
+				last[channel] = newLast[channel];
+				before[channel] = newBefore[channel];
+			}
+		}
+		primed = wasPrimed | channels;
+		sinceKeyframe = keyframe ? 1 : sinceKeyframe + 1;
+
+		uint8_t payloadLength = (uint8_t)(bits.out - &packet[EHEALTH_PACKET_HEADER_SIZE]);
+
+		packet[0] = EHEALTH_PACKET_SYNC0;
+		packet[1] = EHEALTH_PACKET_SYNC1;
+		eHealthWrite16(&packet[2], channels);
+		packet[4] = count;
+		eHealthWrite16(&packet[5], nextSequence++);
+		eHealthWrite16(&packet[7], (uint16_t)timestamp);
+		eHealthWrite16(&packet[9], (uint16_t)(timestamp >> 16));
+		eHealthWrite16(&packet[11], period);
+		packet[13] = keyframe ? EHEALTH_PACKET_KEYFRAME : 0;
+		packet[14] = payloadLength;
+
+		uint8_t * crc = &packet[EHEALTH_PACKET_HEADER_SIZE + payloadLength];
+		eHealthWrite16(crc, eHealthCrc16(0xFFFF, &packet[2], crc - &packet[2]));
+		return EHEALTH_PACKET_HEADER_SIZE + payloadLength + EHEALTH_PACKET_CRC_SIZE;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	encodeSome()													*
+	//!		Description: Encodes as many snapshots as one packet holds.				*
+	//!		Param : as encode(), and uint8_t & consumed								*
+	//!		Returns: size_t with the packet length, 0 if no snapshot fits.			*
+	//!		Example: n = codec.encodeSome(ch, 32, t, 4000, v, buf, 272, used);		*
+	//!******************************************************************************
+
+	size_t eHealthCodecEncoder::encodeSome(uint16_t channels, uint8_t count, uint32_t timestamp, uint16_t period,
+		const uint16_t * values, uint8_t * packet, size_t capacity, uint8_t & consumed)
+	{
+		size_t size = encode(channels, count, timestamp, period, values, packet, capacity);
+
+		if (size) {
+			consumed = count;
+			return size;
+		}
+
+		// A packet only grows with its snapshots: search for the most that
+		// fit, on copies of the encoder so that only the last encode counts.
+		uint8_t fits = 0;
+		uint8_t tooMany = count;
+		while (tooMany - fits > 1) {
+			uint8_t middle = fits + (tooMany - fits) / 2;
+			eHealthCodecEncoder probe = *this;
+			if (probe.encode(channels, middle, timestamp, period, values, packet, capacity)) {
+				fits = middle;
+			} else {
+				tooMany = middle;
+			}
+		}
+
+		consumed = fits;
+		return fits ? encode(channels, fits, timestamp, period, values, packet, capacity) : 0;
+	}
+
+
+//***************************************************************
+// Decoder														*
+//***************************************************************
+
+	eHealthCodecDecoder::eHealthCodecDecoder(void)
+		: input(EHEALTH_PACKET_SYNC0, EHEALTH_PACKET_SYNC1, EHEALTH_PACKET_HEADER_SIZE, packetSize, buffer)
+	{
+		reset();
+	}
+
+	void eHealthCodecDecoder::reset(void)
+	{
+		input.reset();
+		primed = 0;
+		synced = false;
+		expected = 0;
+		packetCount = 0;
+		skippedCount = 0;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	feed()															*
+	//!		Description: Consumes bytes until a packet is complete.					*
+	//!		Param : const uint8_t * data, size_t length								*
+	//!		Returns: size_t with the bytes consumed									*
+	//!		Example: used = decoder.feed(data, length);								*
+	//!******************************************************************************
+
+	size_t eHealthCodecDecoder::feed(const uint8_t * data, size_t length)
+	{
+		size_t consumed = input.feed(data, length);
+
+		if (input.available()) {
+			readPacket(input.message(), current);
+			packetCount++;
+		}
+		return consumed;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	decode()														*
+	//!		Description: Decodes a packet against the history of the ones before.	*
+	//!		Param : const eHealthPacket & packet, uint16_t * values					*
+	//!		Returns: bool, false if it cannot be decoded							*
+	//!		Example: if (decoder.decode(decoder.packet(), values)) { ... }			*
+	//!******************************************************************************
+
+	bool eHealthCodecDecoder::decode(const eHealthPacket & packet, uint16_t * values)
+	{
+		if (packet.keyframe()) {
+			primed = 0;
+			synced = true;
+		} else if (!synced || packet.sequence != expected) {
+			synced = false;
+			skippedCount++;
+			return false;
+		}
+
+		bitReader bits(packet.payload, packet.payloadLength);
+		uint8_t slot = 0;
+
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (!(packet.channels & EHEALTH_CHANNEL_BIT(channel))) {
+				continue;
+			}
+			uint8_t width = eHealthFrameChannelBits(channel);
+			uint16_t mask = (uint16_t)((1UL << width) - 1);
+			uint16_t * out = values + slot++;
+			uint16_t l = last[channel];
+			uint16_t b = before[channel];
+			uint8_t i = 0;
+
+			if (!(primed & EHEALTH_CHANNEL_BIT(channel))) {
+				order[channel] = (uint8_t)bits.get(2);
+				l = b = bits.get(width);
+				out[0] = l;
+				primed |= EHEALTH_CHANNEL_BIT(channel);
+				i = 1;
+			}
+			uint8_t o = order[channel];
+			if (o > EHEALTH_PREDICT_LINEAR) {
+				bits.overrun = true;
+				break;
+			}
+
+			while (i < packet.count) {
+				uint8_t n = packet.count - i < GROUP_SIZE ? packet.count - i : GROUP_SIZE;
+				uint8_t code = (uint8_t)bits.get(4);
+				uint8_t groupWidth = code == WIDE_CODE ? 16 : code;
+
+				for (uint8_t j = 0; j < n; j++) {
+					uint16_t r = bits.get(groupWidth);
+					uint16_t v = r;
+
+					if (o != EHEALTH_PREDICT_NONE) {
+						v = predict(o, l, b) + (uint16_t)((r >> 1) ^ (uint16_t)-(r & 1));
+					}
+					v &= mask;
+					out[(uint16_t)(i + j) * packet.channelCount] = v;
+					b = l;
+					l = v;
+				}
+				i += n;
+			}
+
+			last[channel] = l;
+			before[channel] = b;
+		}
+
+		// Every bit read, and no more than the payload holds.
+		if (bits.overrun || bits.in != bits.end) {
+			synced = false;
+			skippedCount++;
+			return false;
+		}
+
+		expected = packet.sequence + 1;
+		return true;
+	}
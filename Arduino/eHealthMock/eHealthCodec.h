@@ -0,0 +1,256 @@
+/*
+*=========================================================================================
+ *  Lossless waveform codec of the eHealth Mock.
+ *
+ *  Sends the same snapshots as a binary frame (eHealthFrame.h) in fewer
+ *  bytes. Each channel predicts its next value from the last ones and only
+ *  the error (residual) is sent:
+ *
+ *    order 0  raw value
+ *    order 1  delta: the last value
+ *    order 2  linear: 2 * last - the one before
+ *
+ *  Residuals are zigzag coded (0, -1, 1, -2, ... become 0, 1, 2, 3, ...) and
+ *  bit packed in groups of 8, each group at the width of its largest value,
+ *  given by a 4-bit code before it (15 stands for 16 bits). A smooth ECG at
+ *  250 Hz mostly needs 3 or 4 bits a sample instead of 10.
+ *
+ *  A packet depends on the history of the packets before it. Every
+ *  EHEALTH_CODEC_KEYFRAME_INTERVAL packets the encoder sends a keyframe,
+ *  which starts every channel again from a raw value, so a receiver that
+ *  joins late or loses a packet resumes at the next keyframe.
+ *
+ *    offset  size  field
+ *         0     2  sync word 0xA5 0x5C
+ *         2     2  channel bitmap (EHEALTH_CHANNEL_BIT)
+ *         4     1  snapshot count (1-255)
+ *         5     2  sequence number
+ *         7     4  timestamp of the first snapshot, micros()
+ *        11     2  period between snapshots in microseconds (0 for one)
+ *        13     1  flags, bit 0: keyframe
+ *        14     1  payload length n
+ *        15     n  payload, channels in ascending order (see below)
+ *      15+n     2  CRC-16/CCITT-FALSE of bytes 2 to 15+n-1
+ *
+ *  Payload bits are packed LSB first. For each channel, in a keyframe or the
+ *  first time the channel is sent after one: its 2-bit order, then its first
+ *  value raw at the channel's frame width. Then the residuals of its other
+ *  values, in groups of 8. The sync word differs from a frame's, so a frame
+ *  decoder skips packets and a packet decoder skips frames.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthCodec_h
+#define eHealthCodec_h
+
+#include "Arduino.h"
+#include "eHealthChannels.h"
+#include "eHealthConfig.h"
+#include "eHealthFrame.h"
+
+	#define EHEALTH_PACKET_SYNC0 0xA5
+	#define EHEALTH_PACKET_SYNC1 0x5C
+
+	//! Bytes before the payload.
+	#define EHEALTH_PACKET_HEADER_SIZE 15
+
+	//! Bytes after the payload.
+	#define EHEALTH_PACKET_CRC_SIZE 2
+
+	//! Largest payload a packet may carry.
+	#define EHEALTH_PACKET_MAX_PAYLOAD 255
+
+	//! Largest packet on the wire.
+	#define EHEALTH_PACKET_MAX_SIZE (EHEALTH_PACKET_HEADER_SIZE + EHEALTH_PACKET_MAX_PAYLOAD + EHEALTH_PACKET_CRC_SIZE)
+
+	//! Set in the flags of a keyframe.
+	#define EHEALTH_PACKET_KEYFRAME 0x01
+
+	//! Predictors of eHealthCodecEncoder::setPredictor().
+	enum eHealthPredictor {
+		EHEALTH_PREDICT_NONE = 0,
+		EHEALTH_PREDICT_DELTA = 1,
+		EHEALTH_PREDICT_LINEAR = 2
+	};
+
+
+//***************************************************************
+// Packet view													*
+//***************************************************************
+
+	//! A received packet. Points into the decoder's buffer, valid until the next feed().
+	struct eHealthPacket {
+		uint16_t channels;
+		uint8_t count;
+		uint16_t sequence;
+		uint32_t timestamp;
+		uint16_t period;
+		uint8_t flags;
+
+		//! Channels set in the bitmap.
+		uint8_t channelCount;
+
+		//! Coded values.
+		const uint8_t * payload;
+		uint8_t payloadLength;
+
+		//! Returns true when the packet can be decoded without the ones before it.
+		bool keyframe(void) const { return flags & EHEALTH_PACKET_KEYFRAME; }
+	};
+
+	//! Reads the packet starting at data in place.
+	/*!
+	\param const uint8_t * data : the sync word of the packet.
+	\param size_t length : bytes available at data.
+	\param eHealthPacket & packet : receives the packet.
+	\return size_t : length of the packet, 0 if data does not hold a complete,
+	 *  valid packet.
+	*/	size_t eHealthPacketParse(const uint8_t * data, size_t length, eHealthPacket & packet);
+
+
+//***************************************************************
+// Encoder														*
+//***************************************************************
+
+class eHealthCodecEncoder {
+
+	public:
+
+		//! Class constructor. Every channel uses the delta predictor and the
+		//! first packet, sequence number 0, is a keyframe.
+		eHealthCodecEncoder(void);
+
+		//! Selects the predictor of channel. It is used from the next keyframe on.
+		void setPredictor(uint8_t channel, eHealthPredictor order);
+
+		//! Sends a keyframe every packets packets (1 sends only keyframes).
+		void setKeyframeInterval(uint16_t packets) { interval = packets ? packets : 1; }
+
+		//! Makes the next packet a keyframe, for example when a receiver connects.
+		void forceKeyframe(void) { sinceKeyframe = interval; }
+
+		//! Encodes count snapshots of channels into packet.
+		/*!
+		\param uint16_t channels : channel bitmap.
+		\param uint8_t count : number of snapshots.
+		\param uint32_t timestamp : micros() of the first snapshot.
+		\param uint16_t period : microseconds between snapshots.
+		\param const uint16_t * values : count * channels set values, snapshot
+		 *  major, as eHealthFrameEncoder::encode() takes them.
+		\param uint8_t * packet : output buffer, EHEALTH_PACKET_MAX_SIZE holds any packet.
+		\param size_t capacity : size of packet.
+		\return size_t : packet length, 0 if it does not fit: noisy values may
+		 *  need more payload than a packet carries, see encodeSome(). The
+		 *  encoder is then left as it was.
+		*/	size_t encode(uint16_t channels, uint8_t count, uint32_t timestamp, uint16_t period,
+				const uint16_t * values, uint8_t * packet, size_t capacity);
+
+		//! Encodes as many of count snapshots as one packet holds.
+		/*!
+		 *  Encode the rest with further calls, from values + consumed *
+		 *  channelCount and timestamp + consumed * period. With
+		 *  EHEALTH_PACKET_MAX_SIZE of room at least one snapshot always fits.
+		\param uint8_t & consumed : receives the number of snapshots in the packet.
+		\return size_t : packet length, 0 if not even one snapshot fits.
+		 *  The other parameters are those of encode().
+		*/	size_t encodeSome(uint16_t channels, uint8_t count, uint32_t timestamp, uint16_t period,
+				const uint16_t * values, uint8_t * packet, size_t capacity, uint8_t & consumed);
+
+		//! Returns the sequence number of the next packet.
+		uint16_t sequence(void) const { return nextSequence; }
+
+	private:
+
+		//! Per channel: the last two values sent and the predictor.
+		uint16_t last[EHEALTH_CHANNEL_COUNT];
+		uint16_t before[EHEALTH_CHANNEL_COUNT];
+		uint8_t order[EHEALTH_CHANNEL_COUNT];
+		uint8_t nextOrder[EHEALTH_CHANNEL_COUNT];
+
+		//! Channels sent since the last keyframe.
+		uint16_t primed;
+
+		uint16_t nextSequence;
+		uint16_t interval;
+		uint16_t sinceKeyframe;
+};
+
+
+//***************************************************************
+// Decoder														*
+//***************************************************************
+
+class eHealthCodecDecoder {
+
+	public:
+
+		//! Class constructor. Waits for a keyframe.
+		eHealthCodecDecoder(void);
+
+		//! Drops any partial packet and the history, and clears the counters.
+		void reset(void);
+
+		//! Consumes bytes until a packet is complete or data runs out.
+		/*!
+		 *  Releases the previously returned packet first, as
+		 *  eHealthFrameDecoder::feed() does.
+		\param const uint8_t * data : received bytes.
+		\param size_t length : number of bytes.
+		\return size_t : bytes consumed. Check available() afterwards.
+		*/	size_t feed(const uint8_t * data, size_t length);
+
+		//! Returns true when packet() holds a complete packet with a valid CRC.
+		bool available(void) const { return input.available(); }
+
+		//! Returns the current packet.
+		const eHealthPacket & packet(void) const { return current; }
+
+		//! Decodes a packet. Call it for every packet, in order.
+		/*!
+		\param const eHealthPacket & packet : usually packet(), or one from eHealthPacketParse().
+		\param uint16_t * values : receives count * channelCount values, snapshot major.
+		\return bool : false if the packet needs history the decoder does not
+		 *  have (a packet was lost, or no keyframe came yet) or is malformed.
+		 *  values is then undefined, and packets are skipped until a keyframe.
+		*/	bool decode(const eHealthPacket & packet, uint16_t * values);
+
+		//! Valid packets received.
+		uint32_t packets(void) const { return packetCount; }
+
+		//! Packets rejected for a bad CRC.
+		uint32_t crcErrors(void) const { return input.crcErrors(); }
+
+		//! Bytes skipped while searching for a packet.
+		uint32_t droppedBytes(void) const { return input.droppedBytes(); }
+
+		//! Packets decode() could not decode.
+		uint32_t skipped(void) const { return skippedCount; }
+
+	private:
+
+		uint8_t buffer[EHEALTH_PACKET_MAX_SIZE];
+		eHealthSyncBuffer input;
+
+		eHealthPacket current;
+
+		//! History, as in the encoder.
+		uint16_t last[EHEALTH_CHANNEL_COUNT];
+		uint16_t before[EHEALTH_CHANNEL_COUNT];
+		uint8_t order[EHEALTH_CHANNEL_COUNT];
+		uint16_t primed;
+
+		//! True once a keyframe was decoded and no packet lost since.
+		bool synced;
+		uint16_t expected;
+
+		uint32_t packetCount;
+		uint32_t skippedCount;
+};
+
+#endif
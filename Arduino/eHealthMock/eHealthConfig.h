@@ -0,0 +1,186 @@
+/*
+*=========================================================================================
+ *  Build-time configuration of the eHealth Mock.
+ *
+ *  Each setting can be changed here or passed as a compiler flag
+ *  (-DEHEALTH_USE_GSR=0, build_flags in PlatformIO, ...). The Arduino IDE
+ *  compiles the library apart from the sketch, so a #define in the sketch
+ *  does not reach it: edit this file instead.
+ *
+ *  A sensor set to 0 is compiled out of the library: its methods, its state
+ *  and its histories are gone, and using them is a compile error. Its
+ *  channels read 0 through readChannel() and are left out of writeFrame()
+ *  and acquire(). This frees flash and most of the RAM of the class on
+ *  boards with 2 KB of SRAM.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthConfig_h
+#define eHealthConfig_h
+
+#include "eHealthChannels.h"
+
+
+//***************************************************************
+// Sensors														*
+//***************************************************************
+
+	//! Electrocardiogram: getECG(), getECGBlock().
+	#ifndef EHEALTH_USE_ECG
+		#define EHEALTH_USE_ECG 1
+	#endif
+
+	//! Heartbeat detection on the ECG (eHealthBeat.h): getBPM() and
+	//! getRRInterval() follow the ECG read. About 250 bytes of RAM.
+	#ifndef EHEALTH_USE_HEARTBEAT
+		#define EHEALTH_USE_HEARTBEAT EHEALTH_USE_ECG
+	#endif
+
+	#if EHEALTH_USE_HEARTBEAT && !EHEALTH_USE_ECG
+		#error "EHEALTH_USE_HEARTBEAT needs EHEALTH_USE_ECG"
+	#endif
+
+	//! Electromyogram: getEMG(), getEMGBlock().
+	#ifndef EHEALTH_USE_EMG
+		#define EHEALTH_USE_EMG 1
+	#endif
+
+	//! Breathing: getAirFlow(), getAirFlowBlock(), airFlowWave().
+	#ifndef EHEALTH_USE_AIRFLOW
+		#define EHEALTH_USE_AIRFLOW 1
+	#endif
+
+	//! Galvanic skin response: the skin conductance getters and getGSRBlock().
+	#ifndef EHEALTH_USE_GSR
+		#define EHEALTH_USE_GSR 1
+	#endif
+
+	//! Body temperature: getTemperature().
+	#ifndef EHEALTH_USE_TEMPERATURE
+		#define EHEALTH_USE_TEMPERATURE 1
+	#endif
+
+	//! Pulse and oxygen in blood: getOxygenSaturation(), getBPM().
+	#ifndef EHEALTH_USE_PULSIOXIMETER
+		#define EHEALTH_USE_PULSIOXIMETER 1
+	#endif
+
+	//! Patient position (MMA8452 accelerometer): getBodyPosition().
+	#ifndef EHEALTH_USE_POSITION
+		#define EHEALTH_USE_POSITION 1
+	#endif
+
+	//! Sphygmomanometer: readBloodPressureSensor() and its history.
+	#ifndef EHEALTH_USE_BLOOD_PRESSURE
+		#define EHEALTH_USE_BLOOD_PRESSURE 1
+	#endif
+
+	//! Glucometer: readGlucometer() and its history.
+	#ifndef EHEALTH_USE_GLUCOMETER
+		#define EHEALTH_USE_GLUCOMETER 1
+	#endif
+
+	//! Bitmap of the channels of the sensors compiled in.
+	#define EHEALTH_CHANNELS ((uint16_t)( \
+		(EHEALTH_USE_ECG ? EHEALTH_CHANNEL_BIT(EHEALTH_ECG) : 0) | \
+		(EHEALTH_USE_EMG ? EHEALTH_CHANNEL_BIT(EHEALTH_EMG) : 0) | \
+		(EHEALTH_USE_AIRFLOW ? EHEALTH_CHANNEL_BIT(EHEALTH_AIRFLOW) : 0) | \
+		(EHEALTH_USE_GSR ? EHEALTH_CHANNEL_BIT(EHEALTH_GSR) : 0) | \
+		(EHEALTH_USE_TEMPERATURE ? EHEALTH_CHANNEL_BIT(EHEALTH_TEMPERATURE) : 0) | \
+		(EHEALTH_USE_PULSIOXIMETER ? EHEALTH_CHANNEL_BIT(EHEALTH_SPO2) | EHEALTH_CHANNEL_BIT(EHEALTH_BPM) : 0) | \
+		(EHEALTH_USE_POSITION ? EHEALTH_CHANNEL_BIT(EHEALTH_POSITION) : 0) | \
+		(EHEALTH_USE_BLOOD_PRESSURE ? EHEALTH_CHANNEL_BIT(EHEALTH_SYSTOLIC) | EHEALTH_CHANNEL_BIT(EHEALTH_DIASTOLIC) : 0) | \
+		(EHEALTH_USE_GLUCOMETER ? EHEALTH_CHANNEL_BIT(EHEALTH_GLUCOSE) : 0)))
+
+	//! Sensors that share the waveform synthesizer and the analog block reader.
+	#define EHEALTH_USE_WAVEFORM (EHEALTH_USE_ECG || EHEALTH_USE_EMG || EHEALTH_USE_AIRFLOW)
+	#define EHEALTH_USE_ANALOG_BLOCK (EHEALTH_USE_ECG || EHEALTH_USE_EMG || EHEALTH_USE_GSR)
+
+
+//***************************************************************
+// Accelerometer												*
+//***************************************************************
+
+	//! Full scale range of the MMA8452 in g: 2, 4 or 8.
+	#ifndef EHEALTH_ACCEL_SCALE
+		#define EHEALTH_ACCEL_SCALE 2
+	#endif
+
+	//! Output data rate of the MMA8452, between 0 and 7.
+	//! 0=800Hz, 1=400, 2=200, 3=100, 4=50, 5=12.5, 6=6.25, 7=1.56
+	#ifndef EHEALTH_ACCEL_DATA_RATE
+		#define EHEALTH_ACCEL_DATA_RATE 0
+	#endif
+
+	#if EHEALTH_ACCEL_SCALE != 2 && EHEALTH_ACCEL_SCALE != 4 && EHEALTH_ACCEL_SCALE != 8
+		#error "EHEALTH_ACCEL_SCALE must be 2, 4 or 8"
+	#endif
+
+	#if EHEALTH_ACCEL_DATA_RATE < 0 || EHEALTH_ACCEL_DATA_RATE > 7
+		#error "EHEALTH_ACCEL_DATA_RATE must be between 0 and 7"
+	#endif
+
+
+//***************************************************************
+// Memory														*
+//***************************************************************
+
+	//! 1 removes every method that allocates from the heap, String
+	//! numberToMonth() being the only one. Use the buffer overload and the
+	//! record formatters instead. The host build checks that a library built
+	//! this way references no allocator.
+	#ifndef EHEALTH_NO_HEAP
+		#define EHEALTH_NO_HEAP 0
+	#endif
+
+
+//***************************************************************
+// Histories													*
+//***************************************************************
+
+	//! Records kept by the default glucose and blood pressure histories.
+	#ifndef EHEALTH_HISTORY_CAPACITY
+		#if defined(__AVR__)
+			#define EHEALTH_HISTORY_CAPACITY 8
+		#else
+			#define EHEALTH_HISTORY_CAPACITY 64
+		#endif
+	#endif
+
+
+//***************************************************************
+// Filters														*
+//***************************************************************
+
+	//! Longest decimation filter of eHealthFilter, a multiple of 8. Each
+	//! filter keeps three times this many 16-bit words.
+	#ifndef EHEALTH_FILTER_MAX_TAPS
+		#if defined(__AVR__)
+			#define EHEALTH_FILTER_MAX_TAPS 16
+		#else
+			#define EHEALTH_FILTER_MAX_TAPS 64
+		#endif
+	#endif
+
+	#if EHEALTH_FILTER_MAX_TAPS % 8 || EHEALTH_FILTER_MAX_TAPS > 128
+		#error "EHEALTH_FILTER_MAX_TAPS must be a multiple of 8, at most 128"
+	#endif
+
+
+//***************************************************************
+// Codec														*
+//***************************************************************
+
+	//! Packets between keyframes of eHealthCodecEncoder. A receiver that
+	//! loses a packet waits at most this many packets to decode again.
+	#ifndef EHEALTH_CODEC_KEYFRAME_INTERVAL
+		#define EHEALTH_CODEC_KEYFRAME_INTERVAL 16
+	#endif
+
+#endif
@@ -0,0 +1,387 @@
+/*
+*=========================================================================================
+ *  Streaming filter and decimator of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthFilter.h"
+
+#include <math.h>
+
+	//! Quality of the mains notch: 5 Hz wide at 50 Hz.
+	#define NOTCH_Q 10.0f
+
+	//! 1 / (2 Q) of a Butterworth section.
+	#define BUTTERWORTH_ALPHA 0.70710678f
+
+	//! Samples process() runs through one section at a time, bounded by the stack.
+	#if defined(__AVR__)
+		#define FILTER_CHUNK 16
+	#else
+		#define FILTER_CHUNK 128
+	#endif
+
+	//! Converts ADC counts to the internal format: centered, 4 fraction bits.
+	static inline int16_t toInternal(uint16_t value)
+	{
+		if (value > 1023) {
+			value = 1023;
+		}
+		return (int16_t)(((int16_t)value - 512) * 16);
+	}
+
+	//! Converts an internal sample back to ADC counts, rounded and clamped.
+	static inline uint16_t toCounts(int32_t x)
+	{
+		int32_t counts = ((x + 8) >> 4) + 512;
+		return counts < 0 ? 0 : counts > 1023 ? 1023 : (uint16_t)counts;
+	}
+
+	//! Converts a coefficient to Q14.
+	static inline int16_t q14(float value)
+	{
+		float scaled = value * 16384.0f;
+		return (int16_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+	}
+
+	//! Returns the dot product of count taps and samples.
+	static int32_t dot(const int16_t * __restrict__ taps, const int16_t * __restrict__ samples, uint8_t count)
+	{
+		int32_t sum = 0;
+
+		for (uint8_t i = 0; i < count; i++) {
+			sum += (int32_t)taps[i] * samples[i];
+		}
+		return sum;
+	}
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	//! Function that handles the creation and setup of instances
+	eHealthFilter::eHealthFilter(void)
+	{
+		enabled = 0;
+		tapCount = 0;
+		factor = 1;
+		rate = 250;
+		memset(corner, 0, sizeof(corner));
+		memset(sections, 0, sizeof(sections));
+		reset();
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	//!******************************************************************************
+	//!		Name:	setSampleRate()													*
+	//!		Description: Sets the input rate and designs the stages again.			*
+	//!		Param : uint16_t hz														*
+	//!		Returns: bool, false if a stage no longer fits							*
+	//!		Example: filter.setSampleRate(1000);									*
+	//!******************************************************************************
+
+	bool eHealthFilter::setSampleRate(uint16_t hz)
+	{
+		bool fits = true;
+
+		rate = hz ? hz : 1;
+		for (uint8_t s = 0; s < SECTIONS; s++) {
+			fits &= design(s);
+		}
+		return fits;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	setNotch()														*
+	//!		Description: Enables the mains notch, 0 disables it.					*
+	//!		Param : uint8_t hz														*
+	//!		Returns: bool, false if hz is above half the rate						*
+	//!		Example: filter.setNotch(50);											*
+	//!******************************************************************************
+
+	bool eHealthFilter::setNotch(uint8_t hz)
+	{
+		corner[NOTCH] = hz;
+		return design(NOTCH);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	setBandPass()													*
+	//!		Description: Enables the Butterworth band-pass.							*
+	//!		Param : float lowHz, float highHz										*
+	//!		Returns: bool, false if a corner is too high							*
+	//!		Example: filter.setBandPass(0.5, 40);									*
+	//!******************************************************************************
+
+	bool eHealthFilter::setBandPass(float lowHz, float highHz)
+	{
+		corner[HIGH_PASS] = lowHz;
+		corner[LOW_PASS] = highHz;
+		bool low = design(HIGH_PASS);
+		bool high = design(LOW_PASS);
+		return low && high;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	setDecimation()													*
+	//!		Description: Sets the decimation factor.								*
+	//!		Param : uint8_t factor													*
+	//!		Returns: bool, false if factor is 0										*
+	//!		Example: filter.setDecimation(4);										*
+	//!******************************************************************************
+
+	bool eHealthFilter::setDecimation(uint8_t value)
+	{
+		if (value == 0) {
+			return false;
+		}
+
+		factor = value;
+		tapCount = 0;
+		if (factor > 1) {
+			tapCount = 8 * factor < EHEALTH_FILTER_MAX_TAPS ? 8 * factor : EHEALTH_FILTER_MAX_TAPS;
+
+			// Hamming windowed sinc, cut off at 0.4 of the output rate.
+			float cutoff = 0.4f / factor;
+			float middle = (tapCount - 1) / 2.0f;
+			float h[EHEALTH_FILTER_MAX_TAPS];
+			float sum = 0;
+
+			for (uint8_t i = 0; i < tapCount; i++) {
+				float t = i - middle;
+				float sinc = 2 * cutoff * (t == 0 ? 1.0f : sinf(2 * (float)M_PI * cutoff * t) / (2 * (float)M_PI * cutoff * t));
+				h[i] = sinc * (0.54f - 0.46f * cosf(2 * (float)M_PI * i / (tapCount - 1)));
+				sum += h[i];
+			}
+
+			// Unity gain at DC, exactly: the rounding is left in the middle tap.
+			int32_t total = 0;
+			for (uint8_t i = 0; i < tapCount; i++) {
+				taps[i] = (int16_t)(h[i] / sum * 32768.0f + 0.5f);
+				total += taps[i];
+			}
+			taps[tapCount / 2] += (int16_t)(32768 - total);
+		}
+
+		reset();
+		return true;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	reset()															*
+	//!		Description: Clears the filter state.									*
+	//!		Param : void															*
+	//!		Returns: void															*
+	//!		Example: filter.reset();												*
+	//!******************************************************************************
+
+	void eHealthFilter::reset(void)
+	{
+		for (uint8_t s = 0; s < SECTIONS; s++) {
+			section & f = sections[s];
+			f.x1 = f.x2 = f.y1 = f.y2 = f.e1 = f.e2 = 0;
+		}
+		memset(window, 0, sizeof(window));
+		position = 0;
+		phase = 0;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	push()															*
+	//!		Description: Filters one sample.										*
+	//!		Param : uint16_t value, uint16_t & out									*
+	//!		Returns: bool, true if an output was produced							*
+	//!		Example: if (filter.push(raw, out)) send(out);							*
+	//!******************************************************************************
+
+	bool eHealthFilter::push(uint16_t value, uint16_t & out)
+	{
+		int16_t x = filter(toInternal(value));
+
+		if (factor == 1) {
+			out = toCounts(x);
+			return true;
+		}
+		return decimate(x, out);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	process()														*
+	//!		Description: Filters a block of samples.								*
+	//!		Param : const uint16_t * in, size_t count, uint16_t * out				*
+	//!		Returns: size_t with the samples written to out							*
+	//!		Example: n = filter.process(in, 256, out);								*
+	//!******************************************************************************
+
+	size_t eHealthFilter::process(const uint16_t * in, size_t count, uint16_t * out)
+	{
+		int16_t x[FILTER_CHUNK];
+		size_t produced = 0;
+
+		// The same arithmetic as push(), one section at a time over a chunk,
+		// so each section keeps its state in registers.
+		while (count) {
+			size_t n = count < FILTER_CHUNK ? count : FILTER_CHUNK;
+
+			for (size_t i = 0; i < n; i++) {
+				x[i] = toInternal(in[i]);
+			}
+			for (uint8_t s = 0; s < SECTIONS; s++) {
+				if (enabled & (1 << s)) {
+					run(sections[s], x, n);
+				}
+			}
+
+			if (factor == 1) {
+				for (size_t i = 0; i < n; i++) {
+					out[produced++] = toCounts(x[i]);
+				}
+			} else {
+				for (size_t i = 0; i < n; i++) {
+					produced += decimate(x[i], out[produced]);
+				}
+			}
+
+			in += n;
+			count -= n;
+		}
+		return produced;
+	}
+
+
+//***************************************************************
+// Private Methods												*
+//***************************************************************
+
+	//! Designs section s from its corner frequency (the RBJ cookbook forms).
+
+	bool eHealthFilter::design(uint8_t s)
+	{
+		section & f = sections[s];
+		float hz = corner[s];
+
+		f.x1 = f.x2 = f.y1 = f.y2 = f.e1 = f.e2 = 0;
+		enabled &= ~(1 << s);
+
+		if (hz <= 0) {
+			return true;
+		}
+		if (hz >= rate / 2.0f) {
+			return false;
+		}
+
+		float w = 2 * (float)M_PI * hz / rate;
+		float cosw = cosf(w);
+		float alpha = sinf(w) * (s == NOTCH ? 0.5f / NOTCH_Q : BUTTERWORTH_ALPHA);
+		float a0 = 1 + alpha;
+
+		f.a1 = q14(-2 * cosw / a0);
+		f.a2 = q14((1 - alpha) / a0);
+
+		// b0 and b2 are rounded once and b1 derived from them where it can
+		// be, so the zeros stay exactly on the unit circle or at DC.
+		if (s == NOTCH) {
+			f.b0 = f.b2 = q14(1 / a0);
+			f.b1 = f.a1;
+		} else if (s == HIGH_PASS) {
+			f.b0 = f.b2 = q14((1 + cosw) / 2 / a0);
+			f.b1 = -2 * f.b0;
+		} else {
+			f.b0 = f.b2 = q14((1 - cosw) / 2 / a0);
+			f.b1 = 2 * f.b0;
+		}
+
+		enabled |= 1 << s;
+		return true;
+	}
+
+/*******************************************************************************************************/
+
+	//! Runs x through the enabled sections.
+
+	int16_t eHealthFilter::filter(int16_t x)
+	{
+		for (uint8_t s = 0; s < SECTIONS; s++) {
+			if (enabled & (1 << s)) {
+				run(sections[s], &x, 1);
+			}
+		}
+		return x;
+	}
+
+/*******************************************************************************************************/
+
+	//! Runs count samples through section f, in place.
+
+	void eHealthFilter::run(section & f, int16_t * x, size_t count)
+	{
+		int32_t b0 = f.b0, b1 = f.b1, b2 = f.b2, a1 = f.a1, a2 = f.a2;
+		int16_t x1 = f.x1, x2 = f.x2, y1 = f.y1, y2 = f.y2, e1 = f.e1, e2 = f.e2;
+
+		for (size_t i = 0; i < count; i++) {
+			int16_t in = x[i];
+			int32_t acc = b0 * in + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2 + 2 * (int32_t)e1 - e2;
+			int32_t y = acc >> 14;
+			int16_t e = (int16_t)(acc - y * 16384);
+
+			if (y > 32767 || y < -32768) {
+				y = y > 0 ? 32767 : -32768;
+				e = 0;
+			}
+
+			x2 = x1;
+			x1 = in;
+			y2 = y1;
+			y1 = (int16_t)y;
+			e2 = e1;
+			e1 = e;
+			x[i] = (int16_t)y;
+		}
+
+		f.x1 = x1;
+		f.x2 = x2;
+		f.y1 = y1;
+		f.y2 = y2;
+		f.e1 = e1;
+		f.e2 = e2;
+	}
+
+/*******************************************************************************************************/
+
+	//! Appends x to the decimator window. True when an output is due.
+
+	bool eHealthFilter::decimate(int16_t x, uint16_t & out)
+	{
+		// Each sample is stored twice, so the last tapCount samples are
+		// always contiguous at window + position.
+		window[position] = x;
+		window[position + tapCount] = x;
+		if (++position == tapCount) {
+			position = 0;
+		}
+
+		if (++phase < factor) {
+			return false;
+		}
+		phase = 0;
+
+		int32_t sum = dot(taps, window + position, tapCount);
+		out = toCounts((sum + (1L << 14)) >> 15);
+		return true;
+	}
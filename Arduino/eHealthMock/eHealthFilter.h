@@ -0,0 +1,144 @@
+/*
+*=========================================================================================
+ *  Streaming filter and decimator of the eHealth Mock.
+ *
+ *  Cleans up and thins an oversampled ADC channel (ECG, EMG) before it goes
+ *  out over the serial link:
+ *
+ *    eHealthFilter filter;
+ *    filter.setSampleRate(1000);
+ *    filter.setNotch(50);				// mains interference
+ *    filter.setBandPass(0.5, 40);		// baseline wander and muscle noise
+ *    filter.setDecimation(4);			// 250 samples per second out
+ *
+ *    uint16_t out;
+ *    if (filter.push(eHealth.readChannel(EHEALTH_ECG), out)) { send(out); }
+ *
+ *  Values in and out are ADC counts (0-1023). Inside, samples are centered
+ *  on 512 and carry 4 fraction bits. The band-pass removes the DC level, so
+ *  its output is centered on 512.
+ *
+ *  The notch and the band-pass edges are second order sections (biquads)
+ *  with Q14 coefficients, computed once when the filter is configured. Each
+ *  section carries its rounding error into the next samples (second order
+ *  error feedback), so a high-pass near DC neither drifts nor settles on an
+ *  offset. The decimator is a windowed-sinc low-pass that only computes the
+ *  samples it keeps, which costs what its polyphase form does: its taps per
+ *  output, or taps / factor per input. Its dot product runs over a
+ *  contiguous window that the host compiler vectorizes.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthFilter_h
+#define eHealthFilter_h
+
+#include "Arduino.h"
+#include "eHealthConfig.h"
+
+// Library interface description
+class eHealthFilter {
+
+	public:
+
+		//! Class constructor. Passes samples through unchanged at 250 Hz.
+		eHealthFilter(void);
+
+		//! Sets the input sample rate and designs the enabled stages again.
+		/*!
+		\param uint16_t hz : samples per second pushed.
+		\return bool : false if a stage no longer fits below half of hz. It
+		 *  is disabled.
+		*/	bool setSampleRate(uint16_t hz);
+
+		//! Enables the mains notch.
+		/*!
+		\param uint8_t hz : mains frequency, 50 or 60. 0 disables the notch.
+		\return bool : false if hz is not below half of the sample rate.
+		*/	bool setNotch(uint8_t hz);
+
+		//! Enables the band-pass, two second order Butterworth sections.
+		/*!
+		\param float lowHz : high-pass corner, 0 for none.
+		\param float highHz : low-pass corner, 0 for none.
+		\return bool : false if a corner is not below half of the sample rate.
+		*/	bool setBandPass(float lowHz, float highHz);
+
+		//! Sets the decimation factor.
+		/*!
+		 *  The low-pass in front of it passes up to 0.4 of the output rate
+		 *  with as many taps as EHEALTH_FILTER_MAX_TAPS allows, 8 per unit of
+		 *  factor.
+		\param uint8_t factor : one output every factor inputs, 1 for none.
+		\return bool : false if factor is 0.
+		*/	bool setDecimation(uint8_t factor);
+
+		//! Returns the decimation factor.
+		uint8_t decimation(void) const { return factor; }
+
+		//! Returns the rate of the samples produced.
+		uint16_t outputRate(void) const { return rate / factor; }
+
+		//! Clears the filter state, as if no sample had been pushed.
+		void reset(void);
+
+		//! Filters one sample.
+		/*!
+		\param uint16_t value : ADC counts.
+		\param uint16_t & out : the filtered sample, when one is produced.
+		\return bool : true if this input completed an output sample.
+		*/	bool push(uint16_t value, uint16_t & out);
+
+		//! Filters count samples, the same as count calls to push().
+		/*!
+		\param const uint16_t * in : count samples.
+		\param size_t count : samples.
+		\param uint16_t * out : room for count / decimation() + 1 samples.
+		\return size_t : samples written to out.
+		*/	size_t process(const uint16_t * in, size_t count, uint16_t * out);
+
+	private:
+
+		//! Second order section: coefficients in Q14, the last two inputs and
+		//! outputs, and the last two rounding errors.
+		struct section {
+			int16_t b0, b1, b2, a1, a2;
+			int16_t x1, x2, y1, y2;
+			int16_t e1, e2;
+		};
+
+		//! Sections of the cascade, in order.
+		enum { NOTCH, HIGH_PASS, LOW_PASS, SECTIONS };
+
+		//! Designs section s from its corner frequency.
+		bool design(uint8_t s);
+
+		//! Runs x through the enabled sections.
+		int16_t filter(int16_t x);
+
+		//! Runs count samples through section f, in place.
+		static void run(section & f, int16_t * x, size_t count);
+
+		//! Appends x to the decimator window. True when an output is due.
+		bool decimate(int16_t x, uint16_t & out);
+
+		section sections[SECTIONS];
+		float corner[SECTIONS];
+		uint8_t enabled;
+
+		int16_t taps[EHEALTH_FILTER_MAX_TAPS];
+		int16_t window[2 * EHEALTH_FILTER_MAX_TAPS];
+		uint8_t tapCount;
+		uint8_t position;
+		uint8_t factor;
+		uint8_t phase;
+
+		uint16_t rate;
+};
+
+#endif
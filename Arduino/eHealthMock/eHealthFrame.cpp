@@ -0,0 +1,454 @@
+/*
+*=========================================================================================
+ *  Binary framed serial protocol of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthFrame.h"
+
+
+//***************************************************************
+// Channel layout and CRC										*
+//***************************************************************
+
+	//! Packed width in bits of each channel, indexed by eHealthChannel.
+	static const uint8_t channelBits[EHEALTH_CHANNEL_COUNT] PROGMEM = {
+		10,	// ECG
+		10,	// EMG
+		10,	// AIRFLOW
+		10,	// GSR
+		16,	// TEMPERATURE
+		8,	// SPO2
+		8,	// BPM
+		8,	// POSITION
+		8,	// SYSTOLIC
+		8,	// DIASTOLIC
+		10,	// GLUCOSE
+	};
+
+	//! CRC-16/CCITT-FALSE, one nibble at a time: 32 bytes of table.
+	static const uint16_t crcNibble[16] PROGMEM = {
+		0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+		0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+	};
+
+	uint8_t eHealthFrameChannelBits(uint8_t channel)
+	{
+		return channel < EHEALTH_CHANNEL_COUNT ? pgm_read_byte(&channelBits[channel]) : 0;
+	}
+
+	uint16_t eHealthFrameSnapshotBits(uint16_t channels)
+	{
+		uint16_t bits = 0;
+
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (channels & EHEALTH_CHANNEL_BIT(channel)) {
+				bits += pgm_read_byte(&channelBits[channel]);
+			}
+		}
+		return bits;
+	}
+
+	uint16_t eHealthCrc16(uint16_t crc, const uint8_t * data, size_t length)
+	{
+		for (size_t i = 0; i < length; i++) {
+			crc ^= (uint16_t)data[i] << 8;
+			crc = (crc << 4) ^ pgm_read_word(&crcNibble[crc >> 12]);
+			crc = (crc << 4) ^ pgm_read_word(&crcNibble[crc >> 12]);
+		}
+		return crc;
+	}
+
+	bool eHealthCrcValid(const uint8_t * message, size_t length)
+	{
+		size_t covered = length - EHEALTH_FRAME_CRC_SIZE;
+
+		return eHealthCrc16(0xFFFF, &message[2], covered - 2) == eHealthRead16(&message[covered]);
+	}
+
+	//! Returns the number of channels set in channels.
+	static uint8_t countChannels(uint16_t channels)
+	{
+		uint8_t count = 0;
+
+		for (; channels; channels &= channels - 1) {
+			count++;
+		}
+		return count;
+	}
+
+
+//***************************************************************
+// Frame view													*
+//***************************************************************
+
+	//!******************************************************************************
+	//!		Name:	unpack()														*
+	//!		Description: Unpacks every value of the frame, snapshot major.			*
+	//!		Param : uint16_t * values with room for count * channelCount			*
+	//!		Returns: void															*
+	//!		Example: decoder.frame().unpack(values);								*
+	//!******************************************************************************
+
+	void eHealthFrame::unpack(uint16_t * values) const
+	{
+		const uint8_t * in = payload;
+		uint32_t bitBuffer = 0;
+		uint8_t bitCount = 0;
+
+		for (uint8_t snapshot = 0; snapshot < count; snapshot++) {
+			for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+				if (!(channels & EHEALTH_CHANNEL_BIT(channel))) {
+					continue;
+				}
+				uint8_t width = pgm_read_byte(&channelBits[channel]);
+
+				while (bitCount < width) {
+					bitBuffer |= (uint32_t)*in++ << bitCount;
+					bitCount += 8;
+				}
+				*values++ = (uint16_t)(bitBuffer & ((1UL << width) - 1));
+				bitBuffer >>= width;
+				bitCount -= width;
+			}
+		}
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	value()															*
+	//!		Description: Returns the value of channel in snapshot.					*
+	//!		Param : uint8_t snapshot, uint8_t channel (must be in the frame)		*
+	//!		Returns: uint16_t														*
+	//!		Example: uint16_t ecg = frame.value(3, EHEALTH_ECG);					*
+	//!******************************************************************************
+
+	uint16_t eHealthFrame::value(uint8_t snapshot, uint8_t channel) const
+	{
+		uint16_t below = channels & (EHEALTH_CHANNEL_BIT(channel) - 1);
+		uint32_t bit = (uint32_t)snapshot * eHealthFrameSnapshotBits(channels) + eHealthFrameSnapshotBits(below);
+		uint8_t width = pgm_read_byte(&channelBits[channel]);
+
+		// A value spans at most three bytes.
+		const uint8_t * in = payload + bit / 8;
+		uint8_t bytes = (bit % 8 + width + 7) / 8;
+		uint32_t bitBuffer = 0;
+
+		for (uint8_t i = 0; i < bytes; i++) {
+			bitBuffer |= (uint32_t)in[i] << (8 * i);
+		}
+		return (uint16_t)((bitBuffer >> (bit % 8)) & ((1UL << width) - 1));
+	}
+
+
+	//! Returns the frame length a header announces, 0 if the header is not valid.
+	static size_t frameLengthOf(const uint8_t * header)
+	{
+		return eHealthFrameEncoder::frameSize(eHealthRead16(&header[2]), header[4]);
+	}
+
+	//! Fills frame from the header of a frame already checked.
+	static void readFrame(const uint8_t * data, eHealthFrame & frame)
+	{
+		frame.channels = eHealthRead16(&data[2]);
+		frame.count = data[4];
+		frame.sequence = eHealthRead16(&data[5]);
+		frame.timestamp = (uint32_t)eHealthRead16(&data[7]) | ((uint32_t)eHealthRead16(&data[9]) << 16);
+		frame.period = eHealthRead16(&data[11]);
+		frame.channelCount = countChannels(frame.channels);
+		frame.payload = &data[EHEALTH_FRAME_HEADER_SIZE];
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	eHealthFrameParse()												*
+	//!		Description: Reads the frame starting at data in place.					*
+	//!		Param : const uint8_t * data, size_t length, eHealthFrame & frame		*
+	//!		Returns: size_t with the frame length, 0 if not a valid frame			*
+	//!		Example: size_t n = eHealthFrameParse(map + offset, left, frame);		*
+	//!******************************************************************************
+
+	size_t eHealthFrameParse(const uint8_t * data, size_t length, eHealthFrame & frame)
+	{
+		if (length < EHEALTH_FRAME_HEADER_SIZE || data[0] != EHEALTH_FRAME_SYNC0 || data[1] != EHEALTH_FRAME_SYNC1) {
+			return 0;
+		}
+
+		size_t frameLength = frameLengthOf(data);
+		if (frameLength == 0 || frameLength > length || !eHealthCrcValid(data, frameLength)) {
+			return 0;
+		}
+
+		readFrame(data, frame);
+		return frameLength;
+	}
+
+
+//***************************************************************
+// Encoder														*
+//***************************************************************
+
+	eHealthFrameEncoder::eHealthFrameEncoder(void) : nextSequence(0) {}
+
+
+	//!******************************************************************************
+	//!		Name:	frameSize()														*
+	//!		Description: Returns the size of a frame, 0 if it would be too large.	*
+	//!		Param : uint16_t channels, uint8_t count								*
+	//!		Returns: size_t															*
+	//!		Example: size_t size = eHealthFrameEncoder::frameSize(channels, 32);	*
+	//!******************************************************************************
+
+	size_t eHealthFrameEncoder::frameSize(uint16_t channels, uint8_t count)
+	{
+		uint32_t payload = ((uint32_t)eHealthFrameSnapshotBits(channels) * count + 7) / 8;
+
+		if (payload > EHEALTH_FRAME_MAX_PAYLOAD || count == 0 || channels == 0
+			|| (channels & ~EHEALTH_ALL_CHANNELS)) {
+			return 0;
+		}
+		return EHEALTH_FRAME_HEADER_SIZE + payload + EHEALTH_FRAME_CRC_SIZE;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	encode()														*
+	//!		Description: Encodes count snapshots of channels into frame.			*
+	//!		Param : channels, count, timestamp, period, values, frame, capacity		*
+	//!		Returns: size_t with the frame length, 0 if it does not fit.			*
+	//!		Example: n = encoder.encode(channels, 1, micros(), 0, values, buf, 64);	*
+	//!******************************************************************************
+
+	size_t eHealthFrameEncoder::encode(uint16_t channels, uint8_t count, uint32_t timestamp, uint16_t period,
+		const uint16_t * values, uint8_t * frame, size_t capacity)
+	{
+		size_t size = frameSize(channels, count);
+
+		if (size == 0 || size > capacity) {
+			return 0;
+		}
+
+		frame[0] = EHEALTH_FRAME_SYNC0;
+		frame[1] = EHEALTH_FRAME_SYNC1;
+		eHealthWrite16(&frame[2], channels);
+		frame[4] = count;
+		eHealthWrite16(&frame[5], nextSequence++);
+		eHealthWrite16(&frame[7], (uint16_t)timestamp);
+		eHealthWrite16(&frame[9], (uint16_t)(timestamp >> 16));
+		eHealthWrite16(&frame[11], period);
+
+		uint8_t * out = &frame[EHEALTH_FRAME_HEADER_SIZE];
+		uint32_t bitBuffer = 0;
+		uint8_t bitCount = 0;
+
+		for (uint8_t snapshot = 0; snapshot < count; snapshot++) {
+			for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+				if (!(channels & EHEALTH_CHANNEL_BIT(channel))) {
+					continue;
+				}
+				uint8_t width = pgm_read_byte(&channelBits[channel]);
+
+				// Values wider than the channel are truncated to its width.
+				bitBuffer |= (uint32_t)(*values++ & ((1UL << width) - 1)) << bitCount;
+				bitCount += width;
+
+				while (bitCount >= 8) {
+					*out++ = (uint8_t)bitBuffer;
+					bitBuffer >>= 8;
+					bitCount -= 8;
+				}
+			}
+		}
+		if (bitCount) {
+			*out++ = (uint8_t)bitBuffer;
+		}
+
+		eHealthWrite16(out, eHealthCrc16(0xFFFF, &frame[2], out - &frame[2]));
+		return size;
+	}
+
+
+//***************************************************************
+// Sync buffer													*
+//***************************************************************
+
+	eHealthSyncBuffer::eHealthSyncBuffer(uint8_t first, uint8_t second, size_t size, lengthFunction length, uint8_t * storage)
+		: sync0(first), sync1(second), headerSize(size), lengthOf(length), buffer(storage)
+	{
+		reset();
+	}
+
+	void eHealthSyncBuffer::reset(void)
+	{
+		filled = 0;
+		messageLength = 0;
+		ready = false;
+		crcErrorCount = 0;
+		droppedCount = 0;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	feed()															*
+	//!		Description: Consumes bytes until a message is complete.				*
+	//!		Param : const uint8_t * data, size_t length								*
+	//!		Returns: size_t with the bytes consumed									*
+	//!		Example: used = input.feed(data, length);								*
+	//!******************************************************************************
+
+	size_t eHealthSyncBuffer::feed(const uint8_t * data, size_t length)
+	{
+		if (ready) {
+			// Release the previous message. A resync may have left bytes behind it.
+			ready = false;
+			filled -= messageLength;
+			memmove(buffer, buffer + messageLength, filled);
+			messageLength = 0;
+			if (parse()) {
+				return 0;
+			}
+		}
+
+		size_t consumed = 0;
+
+		while (consumed < length) {
+			if (filled == 0) {
+				// Between messages: skip to the next sync byte without copying.
+				const uint8_t * sync = (const uint8_t *)memchr(data + consumed, sync0, length - consumed);
+				if (!sync) {
+					droppedCount += length - consumed;
+					return length;
+				}
+				droppedCount += sync - (data + consumed);
+				consumed = sync - data;
+			}
+
+			// Copy only what the current message still needs.
+			size_t take = needed() - filled;
+			if (take > length - consumed) {
+				take = length - consumed;
+			}
+			memcpy(buffer + filled, data + consumed, take);
+			filled += take;
+			consumed += take;
+
+			if (parse()) {
+				return consumed;
+			}
+		}
+		return consumed;
+	}
+
+
+	//! Bytes needed before the buffer can be examined again.
+
+	size_t eHealthSyncBuffer::needed(void) const
+	{
+		if (filled < 2) {
+			return 2;
+		}
+		if (messageLength == 0) {
+			return headerSize;
+		}
+		return messageLength;
+	}
+
+
+	//! Examines the buffer, dropping bytes that cannot start a message.
+	//! Returns true when a complete, valid message is ready.
+
+	bool eHealthSyncBuffer::parse(void)
+	{
+		for (;;) {
+			if (filled == 0) {
+				return false;
+			}
+			if (buffer[0] != sync0) {
+				const uint8_t * sync = (const uint8_t *)memchr(buffer, sync0, filled);
+				discard(sync ? (size_t)(sync - buffer) : filled);
+				continue;
+			}
+			if (filled < 2) {
+				return false;
+			}
+			if (buffer[1] != sync1) {
+				discard(1);
+				continue;
+			}
+			if (filled < headerSize) {
+				return false;
+			}
+
+			if (messageLength == 0) {
+				messageLength = lengthOf(buffer);
+				if (messageLength == 0) {
+					// Not a valid header: the sync word was part of the data.
+					discard(1);
+					continue;
+				}
+			}
+			if (filled < messageLength) {
+				return false;
+			}
+
+			// The header is valid and complete: only the CRC can fail.
+			if (!eHealthCrcValid(buffer, messageLength)) {
+				crcErrorCount++;
+				discard(1);
+				continue;
+			}
+
+			ready = true;
+			return true;
+		}
+	}
+
+
+	//! Discards the first count buffered bytes.
+
+	void eHealthSyncBuffer::discard(size_t count)
+	{
+		filled -= count;
+		memmove(buffer, buffer + count, filled);
+		messageLength = 0;
+		droppedCount += count;
+	}
+
+
+//***************************************************************
+// Decoder														*
+//***************************************************************
+
+	eHealthFrameDecoder::eHealthFrameDecoder(void)
+		: input(EHEALTH_FRAME_SYNC0, EHEALTH_FRAME_SYNC1, EHEALTH_FRAME_HEADER_SIZE, frameLengthOf, buffer), frameCount(0) {}
+
+	void eHealthFrameDecoder::reset(void)
+	{
+		input.reset();
+		frameCount = 0;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	feed()															*
+	//!		Description: Consumes bytes until a frame is complete.					*
+	//!		Param : const uint8_t * data, size_t length								*
+	//!		Returns: size_t with the bytes consumed									*
+	//!		Example: used = decoder.feed(data, length);								*
+	//!******************************************************************************
+
+	size_t eHealthFrameDecoder::feed(const uint8_t * data, size_t length)
+	{
+		size_t consumed = input.feed(data, length);
+
+		if (input.available()) {
+			readFrame(input.message(), current);
+			frameCount++;
+		}
+		return consumed;
+	}
@@ -0,0 +1,274 @@
+/*
+*=========================================================================================
+ *  Binary framed serial protocol of the eHealth Mock.
+ *
+ *  A frame carries one or more consecutive snapshots of a set of channels:
+ *
+ *    offset  size  field
+ *         0     2  sync word 0xA5 0x5A
+ *         2     2  channel bitmap (EHEALTH_CHANNEL_BIT)
+ *         4     1  snapshot count (1-255)
+ *         5     2  sequence number
+ *         7     4  timestamp of the first snapshot, micros()
+ *        11     2  period between snapshots in microseconds (0 for one)
+ *        13     n  payload: the snapshots, channels in ascending order, each
+ *                  value packed LSB first in its fixed width (see below)
+ *      13+n     2  CRC-16/CCITT-FALSE of bytes 2 to 13+n-1
+ *
+ *  Multi-byte fields are little endian. Analog channels take 10 bits, so a
+ *  frame of 32 ECG samples is 55 bytes against about 160 as text.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthFrame_h
+#define eHealthFrame_h
+
+#include "Arduino.h"
+#include "eHealthChannels.h"
+
+	#define EHEALTH_FRAME_SYNC0 0xA5
+	#define EHEALTH_FRAME_SYNC1 0x5A
+
+	//! Bytes before the payload.
+	#define EHEALTH_FRAME_HEADER_SIZE 13
+
+	//! Bytes after the payload.
+	#define EHEALTH_FRAME_CRC_SIZE 2
+
+	//! Largest payload a frame may carry.
+	#define EHEALTH_FRAME_MAX_PAYLOAD 255
+
+	//! Largest frame on the wire.
+	#define EHEALTH_FRAME_MAX_SIZE (EHEALTH_FRAME_HEADER_SIZE + EHEALTH_FRAME_MAX_PAYLOAD + EHEALTH_FRAME_CRC_SIZE)
+
+	//! Returns the packed width in bits of channel.
+	uint8_t eHealthFrameChannelBits(uint8_t channel);
+
+	//! Returns the packed size in bits of one snapshot of channels.
+	uint16_t eHealthFrameSnapshotBits(uint16_t channels);
+
+	//! Updates a CRC-16/CCITT-FALSE (start from 0xFFFF) with length bytes.
+	uint16_t eHealthCrc16(uint16_t crc, const uint8_t * data, size_t length);
+
+	//! Returns true when the last two bytes of a message of length bytes hold
+	//! the CRC of its bytes from 2 on, as frames and codec packets end.
+	bool eHealthCrcValid(const uint8_t * message, size_t length);
+
+	//! Reads a little endian 16-bit value.
+	static inline uint16_t eHealthRead16(const uint8_t * p)
+	{
+		return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+	}
+
+	//! Writes a little endian 16-bit value.
+	static inline void eHealthWrite16(uint8_t * p, uint16_t value)
+	{
+		p[0] = (uint8_t)value;
+		p[1] = (uint8_t)(value >> 8);
+	}
+
+
+//***************************************************************
+// Frame view													*
+//***************************************************************
+
+	//! A decoded frame. Points into the decoder's buffer, valid until the next feed().
+	struct eHealthFrame {
+		uint16_t channels;
+		uint8_t count;
+		uint16_t sequence;
+		uint32_t timestamp;
+		uint16_t period;
+
+		//! Channels set in the bitmap.
+		uint8_t channelCount;
+
+		//! Packed snapshots.
+		const uint8_t * payload;
+
+		//! Unpacks every value, snapshot major: count * channelCount values.
+		void unpack(uint16_t * values) const;
+
+		//! Returns true when the frame carries channel.
+		bool has(uint8_t channel) const { return channel < EHEALTH_CHANNEL_COUNT && (channels & EHEALTH_CHANNEL_BIT(channel)); }
+
+		//! Returns the value of channel in snapshot, without unpacking the rest.
+		uint16_t value(uint8_t snapshot, uint8_t channel) const;
+	};
+
+	//! Reads the frame starting at data in place.
+	/*!
+	 *  frame points into data, nothing is copied.
+	\param const uint8_t * data : the sync word of the frame.
+	\param size_t length : bytes available at data.
+	\param eHealthFrame & frame : receives the frame.
+	\return size_t : length of the frame, 0 if data does not hold a complete,
+	 *  valid frame.
+	*/	size_t eHealthFrameParse(const uint8_t * data, size_t length, eHealthFrame & frame);
+
+
+//***************************************************************
+// Encoder														*
+//***************************************************************
+
+class eHealthFrameEncoder {
+
+	public:
+
+		//! Class constructor. The first frame has sequence number 0.
+		eHealthFrameEncoder(void);
+
+		//! Returns the size of a frame of count snapshots of channels, 0 if too large.
+		static size_t frameSize(uint16_t channels, uint8_t count);
+
+		//! Encodes count snapshots of channels into frame.
+		/*!
+		\param uint16_t channels : channel bitmap.
+		\param uint8_t count : number of snapshots.
+		\param uint32_t timestamp : micros() of the first snapshot.
+		\param uint16_t period : microseconds between snapshots.
+		\param const uint16_t * values : count * channels set values, snapshot major.
+		\param uint8_t * frame : output buffer.
+		\param size_t capacity : size of frame.
+		\return size_t : frame length, 0 if it does not fit.
+		*/	size_t encode(uint16_t channels, uint8_t count, uint32_t timestamp, uint16_t period,
+				const uint16_t * values, uint8_t * frame, size_t capacity);
+
+		//! Returns the sequence number of the next frame.
+		uint16_t sequence(void) const { return nextSequence; }
+
+	private:
+
+		uint16_t nextSequence;
+};
+
+
+//***************************************************************
+// Sync buffer													*
+//***************************************************************
+
+//! Gathers received bytes into whole messages for a decoder: a sync word, a
+//! header announcing the length, and a CRC at the end, as frames and codec
+//! packets are laid out. Bytes that cannot start a message are skipped.
+class eHealthSyncBuffer {
+
+	public:
+
+		//! Returns the message length a complete header announces, 0 if the header is not valid.
+		typedef size_t (*lengthFunction)(const uint8_t * header);
+
+		//! Class constructor.
+		/*!
+		\param uint8_t first : first byte of the sync word.
+		\param uint8_t second : second byte of the sync word.
+		\param size_t size : bytes of the header, from the sync word.
+		\param lengthFunction length : reads the header.
+		\param uint8_t * storage : room for the longest message length() announces.
+		*/	eHealthSyncBuffer(uint8_t first, uint8_t second, size_t size, lengthFunction length, uint8_t * storage);
+
+		//! Drops any partial message and clears the counters.
+		void reset(void);
+
+		//! Consumes bytes until a message is complete or data runs out.
+		/*!
+		 *  Releases the previously returned message first. Bytes are copied
+		 *  once into the storage; nothing is allocated.
+		\param const uint8_t * data : received bytes.
+		\param size_t length : number of bytes.
+		\return size_t : bytes consumed. Check available() afterwards.
+		*/	size_t feed(const uint8_t * data, size_t length);
+
+		//! Returns true when message() holds a complete message with a valid CRC.
+		bool available(void) const { return ready; }
+
+		//! Returns the current message, from its sync word.
+		const uint8_t * message(void) const { return buffer; }
+
+		//! Messages rejected for a bad CRC.
+		uint32_t crcErrors(void) const { return crcErrorCount; }
+
+		//! Bytes skipped while searching for a message.
+		uint32_t droppedBytes(void) const { return droppedCount; }
+
+	private:
+
+		//! Bytes needed before the buffer can be examined again.
+		size_t needed(void) const;
+
+		//! Examines the buffer. Returns true when it holds a message.
+		bool parse(void);
+
+		//! Discards the first count buffered bytes.
+		void discard(size_t count);
+
+		uint8_t sync0;
+		uint8_t sync1;
+		size_t headerSize;
+		lengthFunction lengthOf;
+		uint8_t * buffer;
+
+		size_t filled;
+		size_t messageLength;
+		bool ready;
+
+		uint32_t crcErrorCount;
+		uint32_t droppedCount;
+};
+
+
+//***************************************************************
+// Decoder														*
+//***************************************************************
+
+class eHealthFrameDecoder {
+
+	public:
+
+		//! Class constructor.
+		eHealthFrameDecoder(void);
+
+		//! Drops any partial frame and clears the counters.
+		void reset(void);
+
+		//! Consumes bytes until a frame is complete or data runs out.
+		/*!
+		 *  Releases the previously returned frame first. Bytes are copied once
+		 *  into a fixed buffer; nothing is allocated.
+		\param const uint8_t * data : received bytes.
+		\param size_t length : number of bytes.
+		\return size_t : bytes consumed. Check available() afterwards.
+		*/	size_t feed(const uint8_t * data, size_t length);
+
+		//! Returns true when frame() holds a complete frame with a valid CRC.
+		bool available(void) const { return input.available(); }
+
+		//! Returns the current frame.
+		const eHealthFrame & frame(void) const { return current; }
+
+		//! Valid frames decoded.
+		uint32_t frames(void) const { return frameCount; }
+
+		//! Frames rejected for a bad CRC.
+		uint32_t crcErrors(void) const { return input.crcErrors(); }
+
+		//! Bytes skipped while searching for a frame.
+		uint32_t droppedBytes(void) const { return input.droppedBytes(); }
+
+	private:
+
+		uint8_t buffer[EHEALTH_FRAME_MAX_SIZE];
+		eHealthSyncBuffer input;
+
+		eHealthFrame current;
+
+		uint32_t frameCount;
+};
+
+#endif
+
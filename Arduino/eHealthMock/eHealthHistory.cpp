@@ -0,0 +1,235 @@
+/*
+*=========================================================================================
+ *  Time indexed measurement history of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthHistory.h"
+
+
+//***************************************************************
+// Dates														*
+//***************************************************************
+
+	//! Days from 2000-03-01 to the first of March of each year are counted
+	//! in 400 year eras, after H. Hinnant's days_from_civil.
+
+	uint32_t eHealthMinutes(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute)
+	{
+		int32_t y = (int32_t)year - (month <= 2);
+		int32_t era = (y >= 0 ? y : y - 399) / 400;
+		uint32_t yearOfEra = (uint32_t)(y - era * 400);
+		uint32_t dayOfYear = (153UL * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+		uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+		// 730425 days from 0000-03-01 to 2000-01-01.
+		int32_t days = era * 146097L + (int32_t)dayOfEra - 730425L;
+		return (uint32_t)days * 1440UL + hour * 60UL + minute;
+	}
+
+	void eHealthMinutesToDate(uint32_t minutes, uint16_t & year, uint8_t & month, uint8_t & day,
+		uint8_t & hour, uint8_t & minute)
+	{
+		minute = minutes % 60;
+		hour = (minutes / 60) % 24;
+
+		// Days since 0000-03-01.
+		uint32_t days = minutes / 1440 + 730425UL;
+		uint32_t era = days / 146097UL;
+		uint32_t dayOfEra = days - era * 146097UL;
+		uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+		uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+		uint32_t monthIndex = (5 * dayOfYear + 2) / 153;
+
+		day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+		month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+		year = yearOfEra + era * 400 + (month <= 2);
+	}
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	eHealthHistory::eHealthHistory(uint8_t * storage, size_t bytes, uint8_t valueBytes)
+		: records(storage), evictedCount(0)
+	{
+		valueSize = valueBytes < 1 ? 1 : valueBytes > 4 ? 4 : valueBytes;
+		recordSize = EHEALTH_HISTORY_RECORD_BYTES(valueSize);
+		slots = bytes / recordSize;
+		clear();
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	//!******************************************************************************
+	//!		Name:	add()															*
+	//!		Description: Adds a record, evicting the oldest if the store is full.	*
+	//!		Param : uint32_t minutes, uint32_t value								*
+	//!		Returns: bool, false if the record cannot be stored						*
+	//!		Example: history.add(eHealthMinutes(2016, 10, 10, 10, 10), 95);			*
+	//!******************************************************************************
+
+	bool eHealthHistory::add(uint32_t minutes, uint32_t value)
+	{
+		if (slots == 0 || (valueSize < 4 && value >> (8 * valueSize))) {
+			return false;
+		}
+
+		// An empty store takes the time of its first record as its zero.
+		if (count == 0) {
+			head = 0;
+			base = minutes;
+		}
+		if (minutes < base ? time(count - 1) - minutes > EHEALTH_HISTORY_MAX_SPAN
+				: minutes - base > EHEALTH_HISTORY_MAX_SPAN) {
+			return false;
+		}
+
+		// Position of the record: after every record at or before its time.
+		size_t at = count;
+		if (count && minutes < time(count - 1)) {
+			at = lowerBound(minutes + 1);
+		}
+		if (count == slots && at == 0) {
+			return false;
+		}
+
+		// A record older than the zero moves it back to its own time.
+		if (minutes < base) {
+			rebase(minutes);
+		}
+
+		if (count == slots) {
+			head = (head + 1) % slots;
+			count--;
+			at--;
+			evictedCount++;
+		}
+
+		for (size_t i = count; i > at; i--) {
+			copy(i, i - 1);
+		}
+		store(at, minutes, value);
+		count++;
+		return true;
+	}
+
+	void eHealthHistory::clear(void)
+	{
+		head = 0;
+		count = 0;
+		base = 0;
+	}
+
+	uint32_t eHealthHistory::time(size_t i) const
+	{
+		const uint8_t * record = slot(i);
+		return base + ((uint32_t)record[0] | ((uint32_t)record[1] << 8) | ((uint32_t)record[2] << 16));
+	}
+
+	uint32_t eHealthHistory::value(size_t i) const
+	{
+		const uint8_t * field = slot(i) + EHEALTH_HISTORY_TIME_BYTES;
+		uint32_t result = 0;
+
+		for (uint8_t b = valueSize; b-- > 0;) {
+			result = (result << 8) | field[b];
+		}
+		return result;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	lowerBound()													*
+	//!		Description: Returns the index of the first record at or after minutes.	*
+	//!		Param : uint32_t minutes												*
+	//!		Returns: size_t, size() if every record is older						*
+	//!		Example: size_t i = history.lowerBound(eHealthMinutes(2016, 1, 1, 0, 0));*
+	//!******************************************************************************
+
+	size_t eHealthHistory::lowerBound(uint32_t minutes) const
+	{
+		size_t low = 0;
+		size_t high = count;
+
+		while (low < high) {
+			size_t middle = low + (high - low) / 2;
+			if (time(middle) < minutes) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+		return low;
+	}
+
+	size_t eHealthHistory::range(uint32_t from, uint32_t to, size_t & first) const
+	{
+		first = lowerBound(from);
+		size_t last = to > from ? lowerBound(to) : first;
+		return last - first;
+	}
+
+
+//***************************************************************
+// Private Methods												*
+//***************************************************************
+
+	uint8_t * eHealthHistory::slot(size_t i) const
+	{
+		size_t position = head + i;
+		if (position >= slots) {
+			position -= slots;
+		}
+		return records + position * recordSize;
+	}
+
+/*******************************************************************************************************/
+
+	void eHealthHistory::store(size_t i, uint32_t minutes, uint32_t value)
+	{
+		uint8_t * record = slot(i);
+		uint32_t delta = minutes - base;
+
+		record[0] = (uint8_t)delta;
+		record[1] = (uint8_t)(delta >> 8);
+		record[2] = (uint8_t)(delta >> 16);
+		for (uint8_t b = 0; b < valueSize; b++) {
+			record[EHEALTH_HISTORY_TIME_BYTES + b] = (uint8_t)(value >> (8 * b));
+		}
+	}
+
+/*******************************************************************************************************/
+
+	void eHealthHistory::rebase(uint32_t minutes)
+	{
+		uint32_t shift = base - minutes;
+
+		for (size_t i = 0; i < count; i++) {
+			uint8_t * record = slot(i);
+			uint32_t delta = (uint32_t)record[0] | ((uint32_t)record[1] << 8) | ((uint32_t)record[2] << 16);
+
+			delta += shift;
+			record[0] = (uint8_t)delta;
+			record[1] = (uint8_t)(delta >> 8);
+			record[2] = (uint8_t)(delta >> 16);
+		}
+		base = minutes;
+	}
+
+/*******************************************************************************************************/
+
+	void eHealthHistory::copy(size_t to, size_t from)
+	{
+		memcpy(slot(to), slot(from), recordSize);
+	}
+
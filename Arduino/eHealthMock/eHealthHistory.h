@@ -0,0 +1,162 @@
+/*
+*=========================================================================================
+ *  Time indexed measurement history of the eHealth Mock.
+ *
+ *  Keeps the records downloaded from the glucometer and the blood pressure
+ *  sensor in caller sized storage. A record is packed into 3 + V bytes:
+ *
+ *    bytes 0-2   minutes since the zero of the store (31 years)
+ *    bytes 3-    the value, V bytes (1-4), little endian bitfields
+ *
+ *  Records are kept in time order in a ring: when the store is full the
+ *  oldest record is evicted. The zero is the time of the oldest record
+ *  stored so far; a record older than it moves it back. Lookups by time
+ *  are binary searches.
+ *
+ *  Times are minutes since 2000-01-01 00:00, see eHealthMinutes().
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthHistory_h
+#define eHealthHistory_h
+
+#include "Arduino.h"
+
+	//! Bytes of the time field of a record.
+	#define EHEALTH_HISTORY_TIME_BYTES 3
+
+	//! Bytes of a record holding valueBytes of value.
+	#define EHEALTH_HISTORY_RECORD_BYTES(valueBytes) (EHEALTH_HISTORY_TIME_BYTES + (valueBytes))
+
+	//! Latest time a store can hold, in minutes after its first record.
+	#define EHEALTH_HISTORY_MAX_SPAN 0xFFFFFFUL
+
+	//! Returns the minutes from 2000-01-01 00:00 to the given date and time.
+	uint32_t eHealthMinutes(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute);
+
+	//! Splits minutes since 2000-01-01 00:00 into a date and time.
+	void eHealthMinutesToDate(uint32_t minutes, uint16_t & year, uint8_t & month, uint8_t & day,
+		uint8_t & hour, uint8_t & minute);
+
+// Library interface description
+class eHealthHistory {
+
+	public:
+
+		//! Creates an empty store over caller owned storage.
+		/*!
+		\param uint8_t * storage : the records.
+		\param size_t bytes : size of storage. Holds bytes / (3 + valueBytes) records.
+		\param uint8_t valueBytes : bytes of each value, 1 to 4.
+		*/	eHealthHistory(uint8_t * storage, size_t bytes, uint8_t valueBytes);
+
+		//! Adds a record, evicting the oldest one if the store is full.
+		/*!
+		 *  Records normally arrive in time order and are appended in O(1). An
+		 *  older record is inserted in place, in O(n), as is one older than
+		 *  every record, which also moves the zero of the store back.
+		\param uint32_t minutes : time of the record, see eHealthMinutes().
+		\param uint32_t value : the packed value.
+		\return bool : false if the record cannot be stored: its value does
+		 *  not fit, it lies more than EHEALTH_HISTORY_MAX_SPAN minutes from
+		 *  the zero or the newest record, or it is older than every record
+		 *  of a full store.
+		*/	bool add(uint32_t minutes, uint32_t value);
+
+		//! Removes every record.
+		void clear(void);
+
+		//! Returns the number of records.
+		size_t size(void) const { return count; }
+
+		//! Returns the number of records the store holds.
+		size_t capacity(void) const { return slots; }
+
+		//! Returns the number of records evicted since the store was created.
+		uint32_t evicted(void) const { return evictedCount; }
+
+		//! Returns the time of record i, 0 being the oldest.
+		uint32_t time(size_t i) const;
+
+		//! Returns the value of record i, 0 being the oldest.
+		uint32_t value(size_t i) const;
+
+		//! Returns the index of the first record at or after minutes. O(log n).
+		size_t lowerBound(uint32_t minutes) const;
+
+		//! Finds the records from minutes from to minutes to, excluded. O(log n).
+		/*!
+		\param uint32_t from : start of the range.
+		\param uint32_t to : end of the range, excluded.
+		\param size_t & first : receives the index of the first record.
+		\return size_t : number of records in the range.
+		*/	size_t range(uint32_t from, uint32_t to, size_t & first) const;
+
+	protected:
+
+		//! Moves the store onto storage, which holds a copy of its records.
+		void attach(uint8_t * storage) { records = storage; }
+
+	private:
+
+		//! Address of the record at ring position i + head.
+		uint8_t * slot(size_t i) const;
+
+		//! Writes a record at index i.
+		void store(size_t i, uint32_t minutes, uint32_t value);
+
+		//! Moves the zero back to minutes, shifting the stored times.
+		void rebase(uint32_t minutes);
+
+		//! Copies record from to index to.
+		void copy(size_t to, size_t from);
+
+		uint8_t * records;
+		size_t slots;
+		uint8_t valueSize;
+		uint8_t recordSize;
+
+		size_t head;
+		size_t count;
+
+		//! Zero of the time field: the oldest time stored since the last clear().
+		uint32_t base;
+		uint32_t evictedCount;
+};
+
+
+	//! A store that owns storage for N records of V value bytes.
+	template <size_t N, uint8_t V>
+	class eHealthHistoryN : public eHealthHistory {
+
+		public:
+
+			eHealthHistoryN(void) : eHealthHistory(storage, sizeof(storage), V) {}
+
+			//! Copies keep their own storage.
+			eHealthHistoryN(const eHealthHistoryN & other) : eHealthHistory(other)
+			{
+				memcpy(storage, other.storage, sizeof(storage));
+				attach(storage);
+			}
+
+			eHealthHistoryN & operator = (const eHealthHistoryN & other)
+			{
+				eHealthHistory::operator = (other);
+				memcpy(storage, other.storage, sizeof(storage));
+				attach(storage);
+				return *this;
+			}
+
+		private:
+
+			uint8_t storage[N * EHEALTH_HISTORY_RECORD_BYTES(V)];
+	};
+
+#endif
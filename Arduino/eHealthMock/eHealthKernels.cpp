@@ -0,0 +1,52 @@
+/*
+*=========================================================================================
+ *  Block conversion kernels of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthKernels.h"
+
+
+	void eHealthAdcToMillivolts(const uint16_t * __restrict__ adc, uint16_t * __restrict__ millivolts, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			millivolts[i] = eHealthMillivolts(adc[i]);
+		}
+	}
+
+	void eHealthAdcToVoltage(const uint16_t * __restrict__ adc, float * __restrict__ voltage, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			voltage[i] = (float)eHealthMillivolts(adc[i]) * EHEALTH_VOLTS_PER_MILLIVOLT;
+		}
+	}
+
+	void eHealthMillivoltsToConductance(const uint16_t * __restrict__ millivolts, int16_t * __restrict__ conductance, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			conductance[i] = eHealthConductance(millivolts[i]);
+		}
+	}
+
+	void eHealthConductanceToOhms(const int16_t * __restrict__ conductance, int32_t * __restrict__ ohms, size_t count)
+	{
+	#if defined(__AVR__)
+		for (size_t i = 0; i < count; i++) {
+			ohms[i] = eHealthOhms(conductance[i]);
+		}
+	#else
+		// Integer division does not vectorize. A double quotient of these
+		// operands rounds to the same integer, and the loop stays branch free.
+		for (size_t i = 0; i < count; i++) {
+			int16_t c = conductance[i];
+			bool positive = c > 0;
+			double r = 100000000.0 / (positive ? c : 1) + 0.5;
+			ohms[i] = positive ? (int32_t)r : -1;
+		}
+	#endif
+	}
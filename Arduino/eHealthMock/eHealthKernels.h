@@ -0,0 +1,69 @@
+/*
+*=========================================================================================
+ *  Block conversion kernels of the eHealth Mock.
+ *
+ *  Each kernel converts a whole buffer of samples in one call. The loops are
+ *  kept branch free over restrict qualified buffers so the host compiler can
+ *  vectorize them; on the board they are plain loops without call overhead.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthKernels_h
+#define eHealthKernels_h
+
+#include "Arduino.h"
+
+	//! Fixed point units of the integer getters: millivolts, skin conductance
+	//! in hundredths of a microsiemens and skin resistance in ohms. The
+	//! float getters are these values times the scales below.
+	#define EHEALTH_VOLTS_PER_MILLIVOLT 0.001f
+	#define EHEALTH_MICROSIEMENS_PER_COUNT 0.01f
+
+	//! Converts a 10-bit ADC reading (0-1023) to millivolts (0-5000).
+	/*!
+	 *  Equals round(adc * 5000 / 1023) for every reading; the multiply and
+	 *  shift stand in for the division, which the board does in software.
+	\param uint16_t adc : the reading.
+	\return uint16_t : millivolts.
+	*/	static inline uint16_t eHealthMillivolts(uint16_t adc)
+	{
+		return (uint16_t)(((uint32_t)adc * 1281251UL + (1UL << 17)) >> 18);
+	}
+
+	//! Converts a skin conductance voltage to conductance in hundredths of a
+	//! microsiemens, 20 * (V - 0.5) exactly. 0 mV yields -100 (-1 uS), as
+	//! getSkinConductance() does.
+	static inline int16_t eHealthConductance(uint16_t millivolts)
+	{
+		int16_t conductance = 2 * ((int16_t)millivolts - 500);
+		return millivolts > 0 ? conductance : -100;
+	}
+
+	//! Converts a conductance in hundredths of a microsiemens to resistance in
+	//! ohms, rounded. Non positive conductances yield -1, as getSkinResistance() does.
+	static inline int32_t eHealthOhms(int16_t conductance)
+	{
+		// 10^8 ohms at 0.01 uS.
+		return conductance > 0 ? (int32_t)((100000000UL + (uint16_t)conductance / 2) / (uint16_t)conductance) : -1;
+	}
+
+	//! Converts count raw ADC readings (0-1023) to millivolts (0-5000).
+	void eHealthAdcToMillivolts(const uint16_t * __restrict__ adc, uint16_t * __restrict__ millivolts, size_t count);
+
+	//! Converts count raw ADC readings (0-1023) to voltage (0-5V), through millivolts.
+	void eHealthAdcToVoltage(const uint16_t * __restrict__ adc, float * __restrict__ voltage, size_t count);
+
+	//! Converts skin conductance voltages to conductance in hundredths of a microsiemens.
+	void eHealthMillivoltsToConductance(const uint16_t * __restrict__ millivolts, int16_t * __restrict__ conductance, size_t count);
+
+	//! Converts skin conductances in hundredths of a microsiemens to resistance in ohms.
+	void eHealthConductanceToOhms(const int16_t * __restrict__ conductance, int32_t * __restrict__ ohms, size_t count);
+
+#endif
+
@@ -0,0 +1,518 @@
+/*
+*=========================================================================================
+ *  Register-level emulation of the MMA8452 accelerometer of the position sensor.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthMMA8452.h"
+
+
+//***************************************************************
+// Register fields												*
+//***************************************************************
+
+	//! CTRL_REG1.
+	#define CTRL_REG1_ACTIVE 0x01
+	#define CTRL_REG1_F_READ 0x02
+
+	//! CTRL_REG2.
+	#define CTRL_REG2_RST 0x40
+
+	//! F_SETUP: F_MODE in bits 6-7, the watermark in bits 0-5.
+	#define F_MODE_FILL 0x80
+	#define F_MODE_MASK 0xC0
+	#define F_WMRK_MASK 0x3F
+
+	//! F_STATUS.
+	#define F_STATUS_OVF 0x80
+	#define F_STATUS_WMRK 0x40
+
+	//! STATUS: XDR, YDR, ZDR in bits 0-2 and ZYXDR, set when any of them is,
+	//! in bit 3; the overwrite flags are the same bits shifted by 4. Only
+	//! the per-axis bits are stored.
+	#define STATUS_ZYXDR 0x08
+	#define STATUS_ZYXOW 0x80
+
+	//! PL_CFG and PL_STATUS.
+	#define PL_CFG_EN 0x40
+	#define PL_STATUS_NEWLF 0x80
+	#define PL_STATUS_LO 0x40
+
+	//! Time between samples for each data rate of CTRL_REG1, in microseconds.
+	static const uint32_t dataRatePeriod[8] PROGMEM = {
+		1250, 2500, 5000, 10000, 20000, 80000, 160000, 640000
+	};
+
+	//! Length of one breath of the motion model, in microseconds.
+	static const uint32_t BREATH_PERIOD = 4000000UL;
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	eHealthMMA8452::eHealthMMA8452(void)
+		: sway(20), noise(8), rng(0x4D4D41UL)
+	{
+		setGravity(0, 0, 1000);
+		reset();
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+
+	//!******************************************************************************
+	//!		Name:	reset()															*
+	//!		Description: Returns the device to its power-on state.					*
+	//!		Param : void															*
+	//!		Returns: void															*
+	//!		Example: accelerometer.reset();											*
+	//!******************************************************************************
+
+	void eHealthMMA8452::reset(void)
+	{
+		memset(registers, 0, sizeof(registers));
+		registers[MMA8452_WHO_AM_I] = MMA8452_DEVICE_ID;
+		registers[MMA8452_PL_CFG] = 0x80;
+		registers[MMA8452_PL_BF_ZCOMP] = 0x44;
+		registers[MMA8452_PL_THS_REG] = 0x84;
+
+		memset(latest, 0, sizeof(latest));
+		memset(latch, 0, sizeof(latch));
+		fifoHead = 0;
+		fifoCountValue = 0;
+		fifoOverflow = false;
+		nextSampleAt = 0;
+		produced = 0;
+		lastPortraitLandscape = 0;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	readRegister()													*
+	//!		Description: Reads one register.										*
+	//!		Param : uint8_t address													*
+	//!		Returns: uint8_t with the register value								*
+	//!		Example: uint8_t id = accelerometer.readRegister(MMA8452_WHO_AM_I);		*
+	//!******************************************************************************
+
+	uint8_t eHealthMMA8452::readRegister(uint8_t address)
+	{
+		update();
+		return read(address);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	readRegisters()													*
+	//!		Description: Reads count registers as one I2C burst read.				*
+	//!		Param : uint8_t address, size_t count, uint8_t * dest					*
+	//!		Returns: void															*
+	//!		Example: accelerometer.readRegisters(MMA8452_OUT_X_MSB, 192, buffer);	*
+	//!******************************************************************************
+
+	void eHealthMMA8452::readRegisters(uint8_t address, size_t count, uint8_t * dest)
+	{
+		update();
+		for (size_t i = 0; i < count; i++) {
+			dest[i] = read(address);
+			address = next(address);
+		}
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	writeRegister()													*
+	//!		Description: Writes one register, as the device would accept it.		*
+	//!		Param : uint8_t address, uint8_t value									*
+	//!		Returns: void															*
+	//!		Example: accelerometer.writeRegister(MMA8452_CTRL_REG1, 0x19);			*
+	//!******************************************************************************
+
+	void eHealthMMA8452::writeRegister(uint8_t address, uint8_t value)
+	{
+		update();
+
+		switch (address) {
+			case MMA8452_CTRL_REG1:
+				if (active()) {
+					// Only the mode can change while active.
+					if (!(value & CTRL_REG1_ACTIVE)) {
+						registers[MMA8452_CTRL_REG1] &= ~CTRL_REG1_ACTIVE;
+						registers[MMA8452_SYSMOD] = 0;
+					}
+				} else {
+					registers[MMA8452_CTRL_REG1] = value;
+					if (value & CTRL_REG1_ACTIVE) {
+						registers[MMA8452_SYSMOD] = 1;
+						nextSampleAt = (uint32_t)micros() + samplePeriod();
+					}
+				}
+				return;
+
+			case MMA8452_CTRL_REG2:
+				if (value & CTRL_REG2_RST) {
+					reset();
+				} else {
+					registers[MMA8452_CTRL_REG2] = value;
+				}
+				return;
+
+			// Read-only registers.
+			case MMA8452_STATUS:
+			case MMA8452_OUT_X_MSB:
+			case MMA8452_OUT_X_LSB:
+			case MMA8452_OUT_Y_MSB:
+			case MMA8452_OUT_Y_LSB:
+			case MMA8452_OUT_Z_MSB:
+			case MMA8452_OUT_Z_LSB:
+			case MMA8452_SYSMOD:
+			case MMA8452_INT_SOURCE:
+			case MMA8452_WHO_AM_I:
+			case MMA8452_PL_STATUS:
+				return;
+
+			default:
+				break;
+		}
+
+		if (address >= MMA8452_REGISTER_COUNT || active()) {
+			return;
+		}
+
+		if (address == MMA8452_F_SETUP && ((value ^ registers[address]) & F_MODE_MASK)) {
+			// Changing the FIFO mode empties it.
+			fifoHead = 0;
+			fifoCountValue = 0;
+			fifoOverflow = false;
+		}
+		registers[address] = value;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	setGravity()													*
+	//!		Description: Sets the gravity vector the sensor sees, in mg.			*
+	//!		Param : int16_t x, int16_t y, int16_t z									*
+	//!		Returns: void															*
+	//!		Example: accelerometer.setGravity(0, 0, -1000);							*
+	//!******************************************************************************
+
+	void eHealthMMA8452::setGravity(int16_t x, int16_t y, int16_t z)
+	{
+		update();
+		gravity[0] = x;
+		gravity[1] = y;
+		gravity[2] = z;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	setMotion()														*
+	//!		Description: Sets the breathing sway and the noise, in mg.				*
+	//!		Param : uint16_t swayMilliG, uint16_t noiseMilliG						*
+	//!		Returns: void															*
+	//!		Example: accelerometer.setMotion(0, 0);									*
+	//!******************************************************************************
+
+	void eHealthMMA8452::setMotion(uint16_t swayMilliG, uint16_t noiseMilliG)
+	{
+		update();
+		sway = swayMilliG;
+		noise = noiseMilliG;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	samplePeriod()													*
+	//!		Description: Returns the time between samples at the data rate.		*
+	//!		Param : void															*
+	//!		Returns: uint32_t with the period in microseconds						*
+	//!		Example: uint32_t period = accelerometer.samplePeriod();				*
+	//!******************************************************************************
+
+	uint32_t eHealthMMA8452::samplePeriod(void) const
+	{
+		return pgm_read_dword(&dataRatePeriod[(registers[MMA8452_CTRL_REG1] >> 3) & 0x07]);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	fifoCount()														*
+	//!		Description: Returns the samples waiting in the FIFO.					*
+	//!		Param : void															*
+	//!		Returns: uint8_t with the count											*
+	//!		Example: uint8_t waiting = accelerometer.fifoCount();					*
+	//!******************************************************************************
+
+	uint8_t eHealthMMA8452::fifoCount(void)
+	{
+		update();
+		return fifoCountValue;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	samples()														*
+	//!		Description: Returns the samples produced since power-on.				*
+	//!		Param : void															*
+	//!		Returns: uint32_t with the count										*
+	//!		Example: uint32_t produced = accelerometer.samples();					*
+	//!******************************************************************************
+
+	uint32_t eHealthMMA8452::samples(void)
+	{
+		update();
+		return produced;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	generate()														*
+	//!		Description: Computes samples of the motion model without producing	*
+	//!		them.																	*
+	//!		Param : uint32_t index, size_t count, int16_t * counts					*
+	//!		Returns: void															*
+	//!		Example: accelerometer.generate(0, 50, counts);						*
+	//!******************************************************************************
+
+	void eHealthMMA8452::generate(uint32_t index, size_t count, int16_t * counts)
+	{
+		for (size_t i = 0; i < count; i++) {
+			sample(index + i, counts + 3 * i);
+		}
+	}
+
+
+//***************************************************************
+// Private Methods												*
+//***************************************************************
+
+	//! Produces the samples due by micros(). Samples that would only be
+	//! overwritten before anyone could read them are counted, not computed.
+
+	void eHealthMMA8452::update(void)
+	{
+		if (!active()) {
+			return;
+		}
+
+		uint32_t now = (uint32_t)micros();
+		if ((int32_t)(now - nextSampleAt) < 0) {
+			return;
+		}
+
+		uint32_t period = samplePeriod();
+		uint32_t due = (now - nextSampleAt) / period + 1;
+		uint32_t first = produced;
+		int16_t counts[3];
+
+		produced += due;
+		nextSampleAt += due * period;
+
+		if ((registers[MMA8452_F_SETUP] & F_MODE_MASK) == F_MODE_FILL) {
+			// Fill mode keeps the oldest samples and stops when full.
+			uint32_t room = EHEALTH_MMA8452_FIFO_SIZE - fifoCountValue;
+			for (uint32_t i = 0; i < due && i < room; i++) {
+				sample(first + i, counts);
+				push(counts);
+			}
+			if (due > room) {
+				fifoOverflow = true;
+				sample(first + due - 1, latest);
+			}
+			return;
+		}
+
+		// Circular mode, or no FIFO: only the newest samples survive.
+		uint32_t skipped = due > EHEALTH_MMA8452_FIFO_SIZE ? due - EHEALTH_MMA8452_FIFO_SIZE : 0;
+		if (skipped) {
+			if (fifoEnabled()) {
+				fifoOverflow = true;
+			} else {
+				registers[MMA8452_STATUS] |= 0x70;
+			}
+		}
+		for (uint32_t i = skipped; i < due; i++) {
+			sample(first + i, counts);
+			push(counts);
+		}
+	}
+
+/*******************************************************************************************************/
+
+	//! Gravity, plus a breathing sway along x, plus uniform noise, in counts
+	//! of the full scale range.
+
+	void eHealthMMA8452::sample(uint32_t index, int16_t * counts)
+	{
+		// 2, 4 and 8 g; the reserved fourth setting reads as 8 g.
+		uint8_t range = registers[MMA8452_XYZ_DATA_CFG] & 0x03;
+		int32_t countsPerG = 1024 >> (range > 2 ? 2 : range);
+
+		// Triangle wave over one breath, from -sway to +sway.
+		uint32_t t = (uint32_t)(((uint64_t)index * samplePeriod()) % BREATH_PERIOD);
+		uint32_t half = BREATH_PERIOD / 2;
+		int32_t rise = t < half ? t : BREATH_PERIOD - t;
+		int32_t swayMilliG = (int32_t)((int64_t)rise * 2 * sway / half) - sway;
+
+		for (uint8_t axis = 0; axis < 3; axis++) {
+			int32_t milliG = gravity[axis];
+
+			if (axis == 0) {
+				milliG += swayMilliG;
+			}
+			if (noise) {
+				milliG += (int32_t)(rng.at((uint64_t)index * 3 + axis) % (2UL * noise + 1)) - noise;
+			}
+
+			int32_t value = milliG * countsPerG / 1000;
+			counts[axis] = value > 2047 ? 2047 : value < -2048 ? -2048 : value;
+		}
+	}
+
+/*******************************************************************************************************/
+
+	//! Stores a new sample: in the FIFO when it is enabled (overwriting the
+	//! oldest when full), and in the outputs with their data ready flags.
+
+	void eHealthMMA8452::push(const int16_t * counts)
+	{
+		memcpy(latest, counts, sizeof(latest));
+
+		if (!fifoEnabled()) {
+			uint8_t status = registers[MMA8452_STATUS];
+			// Unread data is overwritten.
+			registers[MMA8452_STATUS] = status | (status & 0x07) << 4 | 0x07;
+			return;
+		}
+
+		if (fifoCountValue == EHEALTH_MMA8452_FIFO_SIZE) {
+			fifoHead = (fifoHead + 1) % EHEALTH_MMA8452_FIFO_SIZE;
+			fifoCountValue--;
+			fifoOverflow = true;
+		}
+		memcpy(fifo[(fifoHead + fifoCountValue) % EHEALTH_MMA8452_FIFO_SIZE], counts, sizeof(latest));
+		fifoCountValue++;
+	}
+
+/*******************************************************************************************************/
+
+	//! Reading F_STATUS clears the overflow flag, reading OUT_X_MSB pops the
+	//! FIFO, and reading the MSB of an axis clears its data ready flags.
+
+	uint8_t eHealthMMA8452::read(uint8_t address)
+	{
+		if (address >= MMA8452_REGISTER_COUNT) {
+			return 0;
+		}
+
+		if (address == MMA8452_STATUS) {
+			if (!fifoEnabled()) {
+				uint8_t status = registers[MMA8452_STATUS];
+				return status | (status & 0x07 ? STATUS_ZYXDR : 0) | (status & 0x70 ? STATUS_ZYXOW : 0);
+			}
+
+			uint8_t watermark = registers[MMA8452_F_SETUP] & F_WMRK_MASK;
+			uint8_t status = fifoCountValue;
+			if (fifoOverflow) {
+				status |= F_STATUS_OVF;
+			}
+			if (watermark && fifoCountValue >= watermark) {
+				status |= F_STATUS_WMRK;
+			}
+			fifoOverflow = false;
+			return status;
+		}
+
+		if (address >= MMA8452_OUT_X_MSB && address <= MMA8452_OUT_Z_LSB) {
+			uint8_t axis = (address - MMA8452_OUT_X_MSB) / 2;
+			const int16_t * value = latest;
+
+			if (fifoEnabled()) {
+				if (address == MMA8452_OUT_X_MSB && fifoCountValue) {
+					memcpy(latch, fifo[fifoHead], sizeof(latch));
+					fifoHead = (fifoHead + 1) % EHEALTH_MMA8452_FIFO_SIZE;
+					fifoCountValue--;
+				}
+				value = latch;
+			} else if (address & 0x01) {
+				registers[MMA8452_STATUS] &= ~(0x11 << axis);
+			}
+
+			// 12-bit samples, left-justified.
+			if (address & 0x01) {
+				return (uint8_t)((uint16_t)value[axis] >> 4);
+			}
+			return (uint8_t)(value[axis] << 4);
+		}
+
+		if (address == MMA8452_PL_STATUS) {
+			uint8_t status = portraitLandscape();
+			if (status != lastPortraitLandscape) {
+				lastPortraitLandscape = status;
+				status |= PL_STATUS_NEWLF;
+			}
+			return status;
+		}
+
+		return registers[address];
+	}
+
+/*******************************************************************************************************/
+
+	//! Burst reads move to the next register, skip the LSBs in fast read,
+	//! and loop over the outputs while the FIFO is enabled.
+
+	uint8_t eHealthMMA8452::next(uint8_t address) const
+	{
+		bool fast = registers[MMA8452_CTRL_REG1] & CTRL_REG1_F_READ;
+		uint8_t lastOutput = fast ? MMA8452_OUT_Z_MSB : MMA8452_OUT_Z_LSB;
+
+		if (address == lastOutput) {
+			return fifoEnabled() ? MMA8452_OUT_X_MSB : (fast ? MMA8452_STATUS : lastOutput + 1);
+		}
+		if (fast && address >= MMA8452_OUT_X_MSB && address < MMA8452_OUT_Z_MSB) {
+			return address + 2;
+		}
+		return address + 1 < MMA8452_REGISTER_COUNT ? address + 1 : MMA8452_STATUS;
+	}
+
+/*******************************************************************************************************/
+
+	//! Back/front in BAFRO, portrait up/down and landscape right/left in
+	//! LAPO, and the Z-tilt lockout when the device lies within about 29
+	//! degrees of flat.
+
+	uint8_t eHealthMMA8452::portraitLandscape(void) const
+	{
+		if (!(registers[MMA8452_PL_CFG] & PL_CFG_EN)) {
+			return 0;
+		}
+
+		int32_t x = latest[0];
+		int32_t y = latest[1];
+		int32_t z = latest[2];
+		uint8_t status = z < 0 ? 0x01 : 0x00;
+
+		if ((y < 0 ? -y : y) >= (x < 0 ? -x : x)) {
+			status |= (y > 0 ? 1 : 0) << 1;
+		} else {
+			status |= (x > 0 ? 2 : 3) << 1;
+		}
+
+		// cos(29 deg)^2 is about 49/64.
+		if (z * z * 64 > 49 * (x * x + y * y + z * z)) {
+			status |= PL_STATUS_LO;
+		}
+		return status;
+	}
+
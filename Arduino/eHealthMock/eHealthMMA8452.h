@@ -0,0 +1,189 @@
+/*
+*=========================================================================================
+ *  Register-level emulation of the MMA8452 accelerometer of the position sensor.
+ *
+ *  Driver code talks to it exactly as to the I2C device: readRegister(),
+ *  readRegisters() and writeRegister() on the register map of the datasheet.
+ *  It follows the device where drivers depend on it:
+ *
+ *  - Standby and active modes (CTRL_REG1 ACTIVE, SYSMOD). Configuration
+ *    writes are ignored while active, as on the device.
+ *  - The output data rate of CTRL_REG1 (800 Hz down to 1.56 Hz) and the
+ *    full scale range of XYZ_DATA_CFG (2, 4 or 8 g). Samples are produced
+ *    against micros(), so delay() on the host fills the outputs at the
+ *    configured rate.
+ *  - 12-bit left-justified outputs, with fast read (F_READ, 8-bit) and the
+ *    register auto-increment of burst reads.
+ *  - A 32-sample FIFO set up by F_SETUP (circular or fill mode, watermark)
+ *    and read back in bursts: reading from OUT_X_MSB pops one sample, and
+ *    the address wraps back to OUT_X_MSB, so one readRegisters() call of
+ *    6 * n bytes (3 * n in fast read) drains n samples. The MMA8452 itself
+ *    has no FIFO; this one behaves as the one of the MMA8451, which shares
+ *    its register map, so burst-read drivers can be tuned before moving to
+ *    that part.
+ *  - The portrait/landscape status of PL_STATUS, once enabled in PL_CFG.
+ *
+ *  The motion model is the gravity vector of the body position (setGravity())
+ *  with a breathing sway and sensor noise on top. Both are functions of the
+ *  sample index, so a stream does not depend on how it is read.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthMMA8452_h
+#define eHealthMMA8452_h
+
+#include "Arduino.h"
+#include "eHealthRandom.h"
+
+	//! Samples the FIFO holds. 32 on the device; lower it to save RAM.
+	#ifndef EHEALTH_MMA8452_FIFO_SIZE
+		#define EHEALTH_MMA8452_FIFO_SIZE 32
+	#endif
+
+	//! Registers of the MMA8452 (and MMA8451) used by the emulation.
+	enum eHealthMMA8452Register {
+		MMA8452_STATUS = 0x00,			//!< F_STATUS while the FIFO is enabled
+		MMA8452_OUT_X_MSB = 0x01,
+		MMA8452_OUT_X_LSB = 0x02,
+		MMA8452_OUT_Y_MSB = 0x03,
+		MMA8452_OUT_Y_LSB = 0x04,
+		MMA8452_OUT_Z_MSB = 0x05,
+		MMA8452_OUT_Z_LSB = 0x06,
+		MMA8452_F_SETUP = 0x09,
+		MMA8452_SYSMOD = 0x0B,
+		MMA8452_INT_SOURCE = 0x0C,
+		MMA8452_WHO_AM_I = 0x0D,
+		MMA8452_XYZ_DATA_CFG = 0x0E,
+		MMA8452_PL_STATUS = 0x10,
+		MMA8452_PL_CFG = 0x11,
+		MMA8452_PL_COUNT = 0x12,
+		MMA8452_PL_BF_ZCOMP = 0x13,
+		MMA8452_PL_THS_REG = 0x14,
+		MMA8452_CTRL_REG1 = 0x2A,
+		MMA8452_CTRL_REG2 = 0x2B,
+		MMA8452_REGISTER_COUNT = 0x32
+	};
+
+	//! Value of WHO_AM_I.
+	#define MMA8452_DEVICE_ID 0x2A
+
+// Library interface description
+class eHealthMMA8452 {
+
+	public:
+
+		//! Creates the device in its power-on state: standby, 2 g, 800 Hz,
+		//! FIFO disabled, lying supine.
+		eHealthMMA8452(void);
+
+		//! Returns the device to its power-on state, as CTRL_REG2 RST does.
+		/*!
+		 *  The motion model is kept.
+		*/	void reset(void);
+
+		//! Reads one register.
+		uint8_t readRegister(uint8_t address);
+
+		//! Reads count registers from address on, with the auto-increment of
+		//! an I2C burst read.
+		/*!
+		\param uint8_t address : first register.
+		\param size_t count : bytes to read.
+		\param uint8_t * dest : buffer for count bytes.
+		\return void
+		*/	void readRegisters(uint8_t address, size_t count, uint8_t * dest);
+
+		//! Writes one register. Read-only registers, and configuration
+		//! registers while active, ignore the write.
+		void writeRegister(uint8_t address, uint8_t value);
+
+		//! Sets the gravity vector the sensor sees, in mg.
+		/*!
+		 *  Supine is (0, 0, 1000). The breathing sway and the noise are added
+		 *  on top. Samples due before the call keep the previous vector.
+		\param int16_t x, y, z : gravity along each axis in mg.
+		\return void
+		*/	void setGravity(int16_t x, int16_t y, int16_t z);
+
+		//! Sets the breathing sway and the noise added to each axis, in mg.
+		void setMotion(uint16_t swayMilliG, uint16_t noiseMilliG);
+
+		//! Selects the noise stream.
+		void seed(uint32_t value) { rng.seed(value); }
+
+		//! Returns true in active mode.
+		bool active(void) const { return registers[MMA8452_CTRL_REG1] & 0x01; }
+
+		//! Returns the time between samples at the current data rate, in microseconds.
+		uint32_t samplePeriod(void) const;
+
+		//! Returns the samples waiting in the FIFO.
+		uint8_t fifoCount(void);
+
+		//! Returns the samples produced since power-on, including those
+		//! lost to FIFO overflows.
+		uint32_t samples(void);
+
+		//! Computes samples of the motion model without producing them.
+		/*!
+		 *  Registers, FIFO and sample clock are left alone, so simulations
+		 *  that are not paced by micros() can read the same stream in blocks.
+		\param uint32_t index : first sample, counted from power-on.
+		\param size_t count : samples to compute.
+		\param int16_t * counts : 3 * count counts, x, y, z of each sample.
+		\return void
+		*/	void generate(uint32_t index, size_t count, int16_t * counts);
+
+	private:
+
+		//! Produces the samples due by micros().
+		void update(void);
+
+		//! Computes sample index of the motion model into counts.
+		void sample(uint32_t index, int16_t * counts);
+
+		//! Stores a new sample in the outputs and the FIFO.
+		void push(const int16_t * counts);
+
+		//! Returns register address as read now.
+		uint8_t read(uint8_t address);
+
+		//! Returns the address a burst read moves to after address.
+		uint8_t next(uint8_t address) const;
+
+		//! Computes PL_STATUS from the latest sample.
+		uint8_t portraitLandscape(void) const;
+
+		bool fifoEnabled(void) const { return registers[MMA8452_F_SETUP] & 0xC0; }
+
+		uint8_t registers[MMA8452_REGISTER_COUNT];
+
+		//! Latest sample, and the one OUT_* show in FIFO mode.
+		int16_t latest[3];
+		int16_t latch[3];
+
+		int16_t fifo[EHEALTH_MMA8452_FIFO_SIZE][3];
+		uint8_t fifoHead;
+		uint8_t fifoCountValue;
+		bool fifoOverflow;
+
+		//! micros() of the next sample while active.
+		uint32_t nextSampleAt;
+		uint32_t produced;
+
+		//! PL_STATUS last read, for its NEWLF flag.
+		uint8_t lastPortraitLandscape;
+
+		int16_t gravity[3];
+		uint16_t sway;
+		uint16_t noise;
+		eHealthRandom rng;
+};
+
+#endif
@@ -41,6 +41,7 @@
 
 // include this library's description file
 #include "eHealthMock.h"
+#include "eHealthKernels.h"
 
 
 //***************************************************************
@@ -61,12 +62,37 @@
 	#define	int1Pin 2
 	#define int2Pin 3
 
-	//! Set the scale below either 2, 4 or 8.
-	const byte scale = 2;
+	//! Scale (2, 4 or 8 g) and output data rate (0-7), set in eHealthConfig.h.
+	const byte scale = EHEALTH_ACCEL_SCALE;
+	const byte dataRate = EHEALTH_ACCEL_DATA_RATE;
 
-	//! Set the output data rate below. Value should be between 0 and 7.
-	//! 0=800Hz, 1=400, 2=200, 3=100, 4=50, 5=12.5, 6=6.25, 7=1.56
-	const byte dataRate = 0;
+	//! Samples converted per pass of the block methods. Bounds their stack use.
+	#if defined(__AVR__)
+		#define BLOCK_CHUNK 8
+	#else
+		#define BLOCK_CHUNK 64
+	#endif
+
+
+#if EHEALTH_USE_GLUCOMETER || EHEALTH_USE_BLOOD_PRESSURE
+
+	//! Writes "17 October 2026 08:30 " for the record formatters.
+	static void printRecordDate(eHealthTextWriter & text, uint16_t year, uint8_t month,
+		uint8_t day, uint8_t hour, uint8_t minutes)
+	{
+		text.printNumber(day);
+		text.print(' ');
+		text.print(eHealthMonthName(month));
+		text.print(' ');
+		text.printNumber(year);
+		text.print(' ');
+		text.printNumber(hour, 2);
+		text.print(':');
+		text.printNumber(minutes, 2);
+		text.print(' ');
+	}
+
+#endif
 
 
 //***************************************************************
@@ -77,8 +103,31 @@
 	eHealthClassMock::eHealthClassMock(void) {
 
 	    /*void constructor*/
-        // Set up the random number seed. Used in various places
-        randomSeed(micros());
+        // Set up the random number seed of this instance. Used in various places
+        seed(micros());
+
+    #if EHEALTH_USE_BLOOD_PRESSURE
+        systolic = 0;
+        diastolic = 0;
+        pressureStore = NULL;
+    #endif
+    #if EHEALTH_USE_PULSIOXIMETER
+        BPM = 0;
+        SPO2 = 0;
+    #endif
+    #if EHEALTH_USE_POSITION
+        bodyPos = EHEALTH_UNDEFINED_POSITION;
+        memset(accelCount, 0, sizeof(accelCount));
+        memset(accel, 0, sizeof(accel));
+    #endif
+    #if EHEALTH_USE_GLUCOMETER
+        glucoseStore = NULL;
+    #endif
+
+        out = &eHealthSerialOutput();
+        source = NULL;
+        ring = NULL;
+        ringChannels = 0;
     }
 
 
@@ -87,6 +136,8 @@
 //***************************************************************
 
 
+#if EHEALTH_USE_POSITION
+
 	//!******************************************************************************
 	//!	Name:	initPositionSensor()												*
 	//!	Description: Initializes the position sensor and configure some values.		*
@@ -97,9 +148,18 @@
 
 	void eHealthClassMock::initPositionSensor(void)
 	{
-        // Nothing to do
+		EHEALTH_PROBE(INIT_POSITION_SENSOR);
+
+		// Read the WHO_AM_I register, this is a good test of communication
+		if (readRegister(MMA8452_WHO_AM_I) == MMA8452_DEVICE_ID) {
+			initMMA8452(scale, dataRate);
+		}
 	}
 
+#endif
+
+
+#if EHEALTH_USE_BLOOD_PRESSURE
 
 	//!******************************************************************************
 	//!	Name:	readBloodPressureSensor()											*
@@ -111,22 +171,38 @@
 
 	void eHealthClassMock::readBloodPressureSensor(void)
 	{
+		EHEALTH_PROBE(READ_BLOOD_PRESSURE_SENSOR);
+
+        eHealthHistory & history = bloodPressureHistory();
+        bool empty = history.size() == 0;
+        uint32_t newest = empty ? 0 : history.time(history.size() - 1);
 
-        length = 5;// The protocol sends the number of measures
+        uint8_t length = 5;// The protocol sends the number of measures
 
         for (int i = 0; i<length; i++) { // The protocol sends data in this order
-            bloodPressureDataVector[i].year = 2016
-            bloodPressureDataVector[i].month = 10
-            bloodPressureDataVector[i].day = 10
-            bloodPressureDataVector[i].hour = 10
-            bloodPressureDataVector[i].minutes = 10
-            bloodPressureDataVector[i].systolic = 120
-            bloodPressureDataVector[i].diastolic = 80
-            bloodPressureDataVector[i].pulse = 65
+            uint32_t minutes = eHealthMinutes(2016, 10, 10, 10, 10);
+            uint16_t systolicValue = 120;
+            uint8_t diastolicValue = 80;
+            uint8_t pulse = 65;
+
+            // The sensor sends everything it stores: keep only what is new.
+            if (empty || minutes > newest) {
+                history.add(minutes, systolicValue | ((uint32_t)diastolicValue << 9) | ((uint32_t)pulse << 17));
+            }
+        }
+
+        if (history.size()) {
+            bloodPressureData last = getBloodPressureRecord(history.size() - 1);
+            systolic = last.systolic;
+            diastolic = last.diastolic;
         }
 	}
 
+#endif
+
+
 
+#if EHEALTH_USE_PULSIOXIMETER
 
 	//!******************************************************************************
 	//!		Name:	initPulsioximeter()												*
@@ -138,9 +214,15 @@
 
 	void eHealthClassMock::initPulsioximeter(void)
 	{
+		EHEALTH_PROBE(INIT_PULSIOXIMETER);
+
 		// Nothing to do
 	}
 
+#endif
+
+#if EHEALTH_USE_TEMPERATURE
+
 	//!******************************************************************************
 	//!		Name:	getTemperature()												*
 	//!		Description: Returns the corporal temperature.							*
@@ -151,12 +233,36 @@
 
 	float eHealthClassMock::getTemperature(void)
 	{
-		//Local variables
-		float Temperature = 37.5; //Corporal Temperature
+		EHEALTH_PROBE(GET_TEMPERATURE);
+
+		return getTemperatureCentidegrees() / 100.0;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	getTemperatureCentidegrees()									*
+	//!		Description: Returns the corporal temperature in hundredths of a		*
+	//!		degree.																	*
+	//!		Param : void															*
+	//!		Returns: int16_t with the temperature, 3750 for 37.5 degrees			*
+	//!		Example: int16_t temperature = eHealth.getTemperatureCentidegrees();	*
+	//!******************************************************************************
+
+	int16_t eHealthClassMock::getTemperatureCentidegrees(void)
+	{
+		EHEALTH_PROBE(GET_TEMPERATURE_CENTIDEGREES);
 
-		return Temperature;
+		//Corporal Temperature
+		uint16_t centidegrees = 3750;
+
+		replayed(EHEALTH_TEMPERATURE, centidegrees);
+		return centidegrees;
 	}
 
+#endif
+
+#if EHEALTH_USE_PULSIOXIMETER
+
 	//!******************************************************************************
 	//!		Name:	getOxygenSaturation()											*
 	//!		Description: Returns the oxygen saturation in blood in percent.			*
@@ -167,6 +273,13 @@
 
 	int eHealthClassMock::getOxygenSaturation(void)
 	{
+		EHEALTH_PROBE(GET_OXYGEN_SATURATION);
+
+		uint16_t value;
+
+		if (replayed(EHEALTH_SPO2, value)) {
+			return value;
+		}
 		return SPO2;
 	}
 
@@ -180,9 +293,25 @@
 
 	int eHealthClassMock::getBPM(void)
 	{
+		EHEALTH_PROBE(GET_BPM);
+
+		uint16_t value;
+
+		if (replayed(EHEALTH_BPM, value)) {
+			return value;
+		}
+	#if EHEALTH_USE_HEARTBEAT
+		if (heartbeat.bpm()) {
+			return heartbeat.bpm();
+		}
+	#endif
 		return BPM;
 	}
 
+#endif
+
+
+#if EHEALTH_USE_GSR
 
 	//!******************************************************************************
 	//!		Name:	getSkinConductance()											*
@@ -194,19 +323,9 @@
 
 	float eHealthClassMock::getSkinConductance(void)
 	{
-		// Local variable declaration.
-		float conductance = -1.0;
-		delay(1);
-
-		float voltage = eHealthClassMock::getSkinConductanceVoltage(void)
-
-        if(voltage > 0) {
-            conductance = 20*((voltage - 0.5));
-        }
+		EHEALTH_PROBE(GET_SKIN_CONDUCTANCE);
 
-		delay(1);
-
-		return conductance;
+		return getSkinConductanceHundredths() * EHEALTH_MICROSIEMENS_PER_COUNT;
 	}
 
 
@@ -220,18 +339,9 @@
 
 	float eHealthClassMock::getSkinResistance(void)
 	{
-		// Local variable declaration.
-		float resistance = -1;
-		float conductance = eHealthClassMock::getSkinConductance(void);
-
-		//Conductance calcultacion
-		if(conductance > 0) {
-            resistance = 1 / (conductance / 1000000);
-        }
+		EHEALTH_PROBE(GET_SKIN_RESISTANCE);
 
-		delay(2);
-
-		return resistance;
+		return getSkinResistanceOhms();
 	}
 
 
@@ -245,18 +355,82 @@
 
 	float eHealthClassMock::getSkinConductanceVoltage(void)
 	{
+		EHEALTH_PROBE(GET_SKIN_CONDUCTANCE_VOLTAGE);
+
+		return getSkinConductanceMillivolts() * EHEALTH_VOLTS_PER_MILLIVOLT;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	getSkinConductanceHundredths()									*
+	//!		Description: Returns the skin conductance in hundredths of a			*
+	//!		microsiemens.															*
+	//!		Param : void															*
+	//!		Returns: int16_t with the conductance, -100 when the voltage is 0		*
+	//!		Example: int16_t conductance = eHealth.getSkinConductanceHundredths();	*
+	//!******************************************************************************
+
+	int16_t eHealthClassMock::getSkinConductanceHundredths(void)
+	{
+		EHEALTH_PROBE(GET_SKIN_CONDUCTANCE_HUNDREDTHS);
+
+		delay(1);
+		uint16_t millivolts = getSkinConductanceMillivolts();
+		delay(1);
+
+		return eHealthConductance(millivolts);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	getSkinResistanceOhms()											*
+	//!		Description: Returns the value of skin resistance in ohms.				*
+	//!		Param : void															*
+	//!		Returns: int32_t with the resistance, -1 when the conductance is not	*
+	//!		positive																*
+	//!		Example: int32_t resistance = eHealth.getSkinResistanceOhms();			*
+	//!******************************************************************************
+
+	int32_t eHealthClassMock::getSkinResistanceOhms(void)
+	{
+		EHEALTH_PROBE(GET_SKIN_RESISTANCE_OHMS);
+
+		int16_t conductance = getSkinConductanceHundredths();
+
 		delay(2);
 
-		//Get a random number instead of analog pin value
-		int sensorValue = random(1, 1024);
+		return eHealthOhms(conductance);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	getSkinConductanceMillivolts()									*
+	//!		Description: Returns the skin conductance value in millivolts.			*
+	//!		Param : void															*
+	//!		Returns: uint16_t with the skin conductance value (0-5000 mV)			*
+	//!		Example: uint16_t millivolts = eHealth.getSkinConductanceMillivolts();	*
+	//!******************************************************************************
 
-		//Convert the random value to voltage.
-		float voltage = ( sensorValue * 5.0 ) / 1023;
+	uint16_t eHealthClassMock::getSkinConductanceMillivolts(void)
+	{
+		EHEALTH_PROBE(GET_SKIN_CONDUCTANCE_MILLIVOLTS);
+
+		delay(2);
+
+		//Get a random number instead of analog pin value
+		uint16_t sensorValue;
+		if (!replayed(EHEALTH_GSR, sensorValue)) {
+			sensorValue = rng.uniform(1, 1024);
+		}
 
 		delay(2);
-		return voltage;
+		return eHealthMillivolts(sensorValue);
 	}
 
+#endif
+
+
+#if EHEALTH_USE_ECG
 
 	//!******************************************************************************
 	//!		Name:	getECG()														*
@@ -268,16 +442,51 @@
 
 	float eHealthClassMock::getECG(void)
 	{
-		float analog0;
-		// Get random value
-		int sensorValue = random(1, 1024);
+		EHEALTH_PROBE(GET_ECG);
+
+		return getECGMillivolts() * EHEALTH_VOLTS_PER_MILLIVOLT;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	getECGMillivolts()												*
+	//!		Description: Returns the ECG in millivolts, without floating point.	*
+	//!		Param : void															*
+	//!		Returns: uint16_t with the ECG value (0-5000 mV)						*
+	//!		Example: uint16_t millivolts = eHealth.getECGMillivolts();				*
+	//!******************************************************************************
+
+	uint16_t eHealthClassMock::getECGMillivolts(void)
+	{
+		EHEALTH_PROBE(GET_ECG_MILLIVOLTS);
+
+		return eHealthMillivolts(nextECG());
+	}
+
+#endif
+
+
+#if EHEALTH_USE_HEARTBEAT
+
+	//!******************************************************************************
+	//!		Name:	getRRInterval()													*
+	//!		Description: Returns the time between the last two heart beats.		*
+	//!		Param : void															*
+	//!		Returns: uint16_t with the RR interval in milliseconds					*
+	//!		Example: uint16_t rr = eHealth.getRRInterval();							*
+	//!******************************************************************************
 
-		// Convert to voltage
-		analog0 = (float)sensorValue * 5 / 1023.0;
+	uint16_t eHealthClassMock::getRRInterval(void)
+	{
+		EHEALTH_PROBE(GET_RR_INTERVAL);
 
-		return analog0;
+		return heartbeat.rrInterval();
 	}
 
+#endif
+
+
+#if EHEALTH_USE_EMG
 
 	//!******************************************************************************
 	//!		Name:	getEMG()														*
@@ -289,16 +498,38 @@
 
 	int eHealthClassMock::getEMG(void)
 	{
-		float analog0;
-		// Get random value
-		int sensorValue = random(1, 1024);
+		EHEALTH_PROBE(GET_EMG);
+
+		// Whole volts, truncated as the float conversion always did.
+		return getEMGMillivolts() / 1000;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	getEMGMillivolts()												*
+	//!		Description: Returns the EMG in millivolts, without floating point.	*
+	//!		Param : void															*
+	//!		Returns: uint16_t with the EMG value (0-5000 mV)						*
+	//!		Example: uint16_t millivolts = eHealth.getEMGMillivolts();				*
+	//!******************************************************************************
+
+	uint16_t eHealthClassMock::getEMGMillivolts(void)
+	{
+		EHEALTH_PROBE(GET_EMG_MILLIVOLTS);
 
-		// Convert to voltage
-		analog0 = (float)sensorValue * 5 / 1023.0;
+		// Get the next synthesized reading
+		uint16_t sensorValue;
+		if (!replayed(EHEALTH_EMG, sensorValue)) {
+			sensorValue = waveform.nextEMG();
+		}
 
-		return analog0;
+		return eHealthMillivolts(sensorValue);
 	}
 
+#endif
+
+
+#if EHEALTH_USE_POSITION
 
 	//!******************************************************************************
 	//!		Name:	getBodyPosition()												*
@@ -310,10 +541,22 @@
 
 	uint8_t eHealthClassMock::getBodyPosition(void)
 	{
+		EHEALTH_PROBE(GET_BODY_POSITION);
+
+		uint16_t value;
+
+		if (replayed(EHEALTH_POSITION, value)) {
+			return value;
+		}
 
-		return 125;
+		bodyPosition(NULL, (size_t)-1);
+		return bodyPos;
 	}
 
+#endif
+
+
+#if EHEALTH_USE_BLOOD_PRESSURE
 
 	//!******************************************************************************
 	//!		Name:	getSystolicPressure()											*
@@ -325,7 +568,9 @@
 
 	int eHealthClassMock::getSystolicPressure(int i)
 	{
-		return bloodPressureDataVector[i].systolic;
+		EHEALTH_PROBE(GET_SYSTOLIC_PRESSURE);
+
+		return getBloodPressureRecord(i).systolic;
 	}
 
 
@@ -339,9 +584,15 @@
 
 	int eHealthClassMock::getDiastolicPressure(int i)
 	{
-		return bloodPressureDataVector[i].diastolic;
+		EHEALTH_PROBE(GET_DIASTOLIC_PRESSURE);
+
+		return getBloodPressureRecord(i).diastolic;
 	}
 
+#endif
+
+
+#if EHEALTH_USE_AIRFLOW
 
 	//!******************************************************************************
 	//!		Name:	getAirFlow()													*
@@ -353,13 +604,24 @@
 
 	int eHealthClassMock::getAirFlow(void)
 	{
-		return 50;
+		EHEALTH_PROBE(GET_AIR_FLOW);
+
+		uint16_t value;
+
+		if (replayed(EHEALTH_AIRFLOW, value)) {
+			return value;
+		}
+		return waveform.nextAirFlow();
 	}
 
+#endif
+
+
+#if EHEALTH_USE_POSITION
 
 	//!******************************************************************************
 	//!		Name:	printPosition()													*
-	//!		Description: Returns an analogic value to represent the air flow.		*
+	//!		Description: Prints the name of a body position.						*
 	//!		Param : uint8_t position : the current body position. 					*
 	//!		Returns: void															*
 	//!		Example: eHealth.printPosition(position);								*
@@ -367,21 +629,16 @@
 
 	void eHealthClassMock::printPosition( uint8_t position )
 	{
-		if (position == 1) {
-			Serial.println("Prone position");
-		} else if (position == 2) {
-			Serial.println("Stand or sit position");
-		} else if (position == 3) {
-			Serial.println("Left lateral decubitus");
-		} else if (position == 4) {
-			Serial.println("Supine position");
-		} else if (position == 5) {
-			Serial.println("Rigth lateral decubitus");
-		} else  {
-			Serial.println("non-defined position");
-		}
+		EHEALTH_PROBE(PRINT_POSITION);
+
+		out->println(eHealthPositionName(position));
+		out->endRecord();
 	}
 
+#endif
+
+
+#if EHEALTH_USE_PULSIOXIMETER
 
 	//!******************************************************************************
 	//!		Name:	readPulsioximeter()												*
@@ -393,10 +650,16 @@
 
 	void eHealthClassMock::readPulsioximeter(void)
 	{
+		EHEALTH_PROBE(READ_PULSIOXIMETER);
+
 			SPO2 = 98;
 			BPM  = 75;
 	}
 
+#endif
+
+
+#if EHEALTH_USE_AIRFLOW
 
 	//!******************************************************************************
 	//!		Name: airflowWave()														*
@@ -408,15 +671,19 @@
 
 	void eHealthClassMock::airFlowWave(int air)
 	{
-		for (int i=0; i < (air / 5) ; i ++) {
-				Serial.print("..");
-		}
+		EHEALTH_PROBE(AIR_FLOW_WAVE);
 
-		Serial.print("..");
-		Serial.print("\n");
+		// One record per line: a single write instead of one per dot pair.
+		out->repeat("..", air / 5 > 0 ? air / 5 + 1 : 1);
+		out->print('\n');
+		out->endRecord();
 		delay(25);
 	}
 
+#endif
+
+
+#if EHEALTH_USE_GLUCOMETER
 
 	//!******************************************************************************
 	//!		Name: readGlucometer()													*
@@ -428,18 +695,23 @@
 
 	void eHealthClassMock::readGlucometer(void)
 	{
+		EHEALTH_PROBE(READ_GLUCOMETER);
 
-        length = 5;// The protocol sends the number of measures
+        eHealthHistory & history = glucoseHistory();
+        bool empty = history.size() == 0;
+        uint32_t newest = empty ? 0 : history.time(history.size() - 1);
+
+        uint8_t length = 5;// The protocol sends the number of measures
 
         for (int i = 0; i<length; i++) { // The protocol sends data in this order
-            glucoseDataVector[i].year = 2016;
-            glucoseDataVector[i].month = 10;
-            glucoseDataVector[i].day = 10;
-            glucoseDataVector[i].hour = 10;
-            glucoseDataVector[i].minutes = 10;
-
-            glucoseDataVector[i].glucose = 5;
-            glucoseDataVector[i].meridian = 4;
+            uint32_t minutes = eHealthMinutes(2016, 10, 10, 10, 10);
+            uint16_t glucose = 5;
+            uint8_t meridian = 4;
+
+            // The glucometer sends everything it stores: keep only what is new.
+            if (empty || minutes > newest) {
+                history.add(minutes, glucose | ((uint32_t)meridian << 10));
+            }
         }
 	}
 
@@ -453,9 +725,16 @@
 
 	uint8_t eHealthClassMock::getGlucometerLength(void)
 	{
-		return length;
+		EHEALTH_PROBE(GET_GLUCOMETER_LENGTH);
+
+		size_t length = glucoseHistory().size();
+		return length > 255 ? 255 : length;
 	}
 
+#endif
+
+#if EHEALTH_USE_BLOOD_PRESSURE
+
 	//!******************************************************************************
 	//!		Name: getBloodPressureLength()											*
 	//!		Description: it returns the number of data stored in					*
@@ -467,9 +746,119 @@
 
 	uint8_t eHealthClassMock::getBloodPressureLength(void)
 	{
-		return length;
+		EHEALTH_PROBE(GET_BLOOD_PRESSURE_LENGTH);
+
+		size_t length = bloodPressureHistory().size();
+		return length > 255 ? 255 : length;
+	}
+
+#endif
+
+
+#if EHEALTH_USE_GLUCOMETER
+
+	//!******************************************************************************
+	//!		Name: getGlucoseRecord()												*
+	//!		Description: Returns glucose record i, 0 being the oldest.				*
+	//!		Param : uint8_t i														*
+	//!		Returns: glucoseData with the record									*
+	//!		Example: uint8_t glucose = eHealth.getGlucoseRecord(0).glucose;			*
+	//!******************************************************************************
+
+	eHealthClassMock::glucoseData eHealthClassMock::getGlucoseRecord(uint8_t i)
+	{
+		EHEALTH_PROBE(GET_GLUCOSE_RECORD);
+
+		eHealthHistory & history = glucoseHistory();
+		glucoseData record;
+		uint32_t value = history.value(i);
+
+		eHealthMinutesToDate(history.time(i), record.year, record.month, record.day, record.hour, record.minutes);
+		record.glucose = value & 0x3FF;
+		record.meridian = value >> 10;
+		return record;
+	}
+
+
+	//!******************************************************************************
+	//!		Name: formatGlucoseRecord()												*
+	//!		Description: Writes a glucose record as text, without the heap.			*
+	//!		Param : uint8_t i : index; char * buffer, size_t size : the text		*
+	//!		Returns: size_t : the length of the text, size or more if cut short		*
+	//!		Example: char text[40]; eHealth.formatGlucoseRecord(0, text, 40);		*
+	//!******************************************************************************
+
+	size_t eHealthClassMock::formatGlucoseRecord(uint8_t i, char * buffer, size_t size)
+	{
+		EHEALTH_PROBE(FORMAT_GLUCOSE_RECORD);
+
+		glucoseData record = getGlucoseRecord(i);
+		eHealthTextWriter text(buffer, size);
+
+		printRecordDate(text, record.year, record.month, record.day, record.hour, record.minutes);
+		text.printNumber(record.glucose);
+		text.print(F(" mg/dL"));
+		return text.length();
+	}
+
+#endif
+
+
+#if EHEALTH_USE_BLOOD_PRESSURE
+
+	//!******************************************************************************
+	//!		Name: getBloodPressureRecord()											*
+	//!		Description: Returns blood pressure record i, 0 being the oldest.		*
+	//!		Param : uint8_t i														*
+	//!		Returns: bloodPressureData with the record								*
+	//!		Example: uint8_t pulse = eHealth.getBloodPressureRecord(0).pulse;		*
+	//!******************************************************************************
+
+	eHealthClassMock::bloodPressureData eHealthClassMock::getBloodPressureRecord(uint8_t i)
+	{
+		EHEALTH_PROBE(GET_BLOOD_PRESSURE_RECORD);
+
+		eHealthHistory & history = bloodPressureHistory();
+		bloodPressureData record;
+		uint32_t value = history.value(i);
+
+		eHealthMinutesToDate(history.time(i), record.year, record.month, record.day, record.hour, record.minutes);
+		record.systolic = value & 0x1FF;
+		record.diastolic = (value >> 9) & 0xFF;
+		record.pulse = (value >> 17) & 0xFF;
+		return record;
+	}
+
+
+	//!******************************************************************************
+	//!		Name: formatBloodPressureRecord()										*
+	//!		Description: Writes a blood pressure record as text, without the heap.	*
+	//!		Param : uint8_t i : index; char * buffer, size_t size : the text		*
+	//!		Returns: size_t : the length of the text, size or more if cut short		*
+	//!		Example: char text[48]; eHealth.formatBloodPressureRecord(0, text, 48);	*
+	//!******************************************************************************
+
+	size_t eHealthClassMock::formatBloodPressureRecord(uint8_t i, char * buffer, size_t size)
+	{
+		EHEALTH_PROBE(FORMAT_BLOOD_PRESSURE_RECORD);
+
+		bloodPressureData record = getBloodPressureRecord(i);
+		eHealthTextWriter text(buffer, size);
+
+		printRecordDate(text, record.year, record.month, record.day, record.hour, record.minutes);
+		text.printNumber(record.systolic);
+		text.print('/');
+		text.printNumber(record.diastolic);
+		text.print(F(" mmHg "));
+		text.printNumber(record.pulse);
+		text.print(F(" bpm"));
+		return text.length();
 	}
 
+#endif
+
+
+#if !EHEALTH_NO_HEAP
 
 	//!******************************************************************************
 	//!		Name: numberToMonth()													*
@@ -481,18 +870,31 @@
 
 	String eHealthClassMock::numberToMonth(int month)
 	{
-		if (month == 1)  return "January";
-		else if (month == 2)  return "February";
-		else if (month == 3)  return "March";
-		else if (month == 4)  return "April";
-		else if (month == 5)  return "May";
-		else if (month == 6)  return "June";
-		else if (month == 7)  return "July";
-		else if (month == 8)  return "August";
-		else if (month == 9)  return "September";
-		else if (month == 10) return "October";
-		else if (month == 11) return "November";
-		else return "December";
+		EHEALTH_PROBE(NUMBER_TO_MONTH);
+
+		char name[10];
+		numberToMonth(month, name, sizeof(name));
+		return name;
+	}
+
+#endif
+
+
+	//!******************************************************************************
+	//!		Name: numberToMonth()													*
+	//!		Description: Writes the month name into a caller buffer.				*
+	//!		Param : int month; char * buffer, size_t size : the name				*
+	//!		Returns: size_t : the length of the name, size or more if cut short		*
+	//!		Example: char name[10]; eHealth.numberToMonth(month, name, 10);			*
+	//!******************************************************************************
+
+	size_t eHealthClassMock::numberToMonth(int month, char * buffer, size_t size)
+	{
+		EHEALTH_PROBE(NUMBER_TO_MONTH_BUFFER);
+
+		eHealthTextWriter text(buffer, size);
+		text.print(eHealthMonthName(month >= 1 && month <= 12 ? month : 12));
+		return text.length();
 	}
 
 
@@ -510,32 +912,604 @@
 	}
 
 
+	//!******************************************************************************
+	//!		Name:	seed()															*
+	//!		Description: Seeds the random streams of this instance. Instances		*
+	//!		with different seeds produce independent readings.						*
+	//!		Param : unsigned long value with the seed								*
+	//!		Returns: void															*
+	//!		Example: eHealth.seed(42);												*
+	//!******************************************************************************
+
+	void eHealthClassMock::seed(unsigned long value)
+	{
+		EHEALTH_PROBE(SEED);
+
+	#if EHEALTH_USE_GSR
+		rng.seed(value);
+	#endif
+	#if EHEALTH_USE_POSITION
+		accelerometer.seed(value ^ 0xC2B2AE35UL);
+	#endif
+	#if EHEALTH_USE_WAVEFORM
+		waveform.seed(value ^ 0x85EBCA6BUL);
+	#endif
+	(void)value;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	seek()															*
+	//!		Description: Moves every channel to sample index of its stream.		*
+	//!		Param : uint64_t index													*
+	//!		Returns: void															*
+	//!		Example: eHealth.seek(250UL * 3600);									*
+	//!******************************************************************************
+
+	void eHealthClassMock::seek(uint64_t index)
+	{
+		EHEALTH_PROBE(SEEK);
+
+		// One draw per GSR reading.
+	#if EHEALTH_USE_GSR
+		rng.seek(index);
+	#endif
+	#if EHEALTH_USE_WAVEFORM
+		waveform.seek(index);
+	#endif
+	(void)index;
+	}
+
+
 //***************************************************************
-// Private Methods												*
+// Block Methods												*
 //***************************************************************
 
-	//! This function will read the p/l source register and
-	//!	print what direction the sensor is now facing */
 
-	void eHealthClassMock::portraitLandscapeHandler()
+#if EHEALTH_USE_ECG
+
+	//!******************************************************************************
+	//!		Name:	getECGBlock()													*
+	//!		Description: Reads count consecutive ECG values.						*
+	//!		Param : float * samples, size_t count									*
+	//!		Returns: void															*
+	//!		Example: eHealth.getECGBlock(buffer, 64);								*
+	//!******************************************************************************
+
+	void eHealthClassMock::getECGBlock(float * samples, size_t count)
+	{
+		EHEALTH_PROBE(GET_ECG_BLOCK);
+
+		readVoltageBlock(ANALOG_ECG, samples, count);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	getECGMillivoltsBlock()											*
+	//!		Description: Reads count consecutive ECG values in millivolts.			*
+	//!		Param : uint16_t * samples, size_t count								*
+	//!		Returns: void															*
+	//!		Example: eHealth.getECGMillivoltsBlock(buffer, 64);						*
+	//!******************************************************************************
+
+	void eHealthClassMock::getECGMillivoltsBlock(uint16_t * samples, size_t count)
+	{
+		EHEALTH_PROBE(GET_ECG_MILLIVOLTS_BLOCK);
+
+		readMillivoltBlock(ANALOG_ECG, samples, count);
+	}
+
+#endif
+
+
+#if EHEALTH_USE_EMG
+
+	//!******************************************************************************
+	//!		Name:	getEMGBlock()													*
+	//!		Description: Reads count consecutive EMG values.						*
+	//!		Param : float * samples, size_t count									*
+	//!		Returns: void															*
+	//!		Example: eHealth.getEMGBlock(buffer, 64);								*
+	//!******************************************************************************
+
+	void eHealthClassMock::getEMGBlock(float * samples, size_t count)
 	{
-        position[0] = 3;
+		EHEALTH_PROBE(GET_EMG_BLOCK);
 
-        position[1] = 0;
+		readVoltageBlock(ANALOG_EMG, samples, count);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	getEMGMillivoltsBlock()											*
+	//!		Description: Reads count consecutive EMG values in millivolts.			*
+	//!		Param : uint16_t * samples, size_t count								*
+	//!		Returns: void															*
+	//!		Example: eHealth.getEMGMillivoltsBlock(buffer, 64);						*
+	//!******************************************************************************
 
-        position[2] = 1;
+	void eHealthClassMock::getEMGMillivoltsBlock(uint16_t * samples, size_t count)
+	{
+		EHEALTH_PROBE(GET_EMG_MILLIVOLTS_BLOCK);
 
-		bodyPosition();
+		readMillivoltBlock(ANALOG_EMG, samples, count);
+	}
+
+#endif
+
+
+#if EHEALTH_USE_GSR
+
+	//!******************************************************************************
+	//!		Name:	getSkinConductanceVoltageBlock()								*
+	//!		Description: Reads count consecutive skin conductance voltages.		*
+	//!		Param : float * samples, size_t count									*
+	//!		Returns: void															*
+	//!		Example: eHealth.getSkinConductanceVoltageBlock(buffer, 64);			*
+	//!******************************************************************************
+
+	void eHealthClassMock::getSkinConductanceVoltageBlock(float * samples, size_t count)
+	{
+		EHEALTH_PROBE(GET_SKIN_CONDUCTANCE_VOLTAGE_BLOCK);
+
+		delay(2);
+		readVoltageBlock(ANALOG_GSR, samples, count);
+		delay(2);
+	}
+
+#endif
+
+
+#if EHEALTH_USE_AIRFLOW
+
+	//!******************************************************************************
+	//!		Name:	getAirFlowBlock()												*
+	//!		Description: Reads count consecutive air flow values.					*
+	//!		Param : int * samples, size_t count										*
+	//!		Returns: void															*
+	//!		Example: eHealth.getAirFlowBlock(buffer, 64);							*
+	//!******************************************************************************
+
+	void eHealthClassMock::getAirFlowBlock(int * samples, size_t count)
+	{
+		EHEALTH_PROBE(GET_AIR_FLOW_BLOCK);
+
+		uint16_t raw[BLOCK_CHUNK];
+
+		while (count) {
+			size_t n = count < BLOCK_CHUNK ? count : BLOCK_CHUNK;
+
+			readColumn(EHEALTH_AIRFLOW, raw, n);
+			for (size_t i = 0; i < n; i++) {
+				samples[i] = raw[i];
+			}
+
+			samples += n;
+			count -= n;
+		}
+	}
+
+#endif
+
+
+#if EHEALTH_USE_GSR
+
+	//!******************************************************************************
+	//!		Name:	getGSRBlock()													*
+	//!		Description: Reads count GSR readings with voltage, conductance and	*
+	//!		resistance computed together.											*
+	//!		Param : gsrSample * samples, size_t count								*
+	//!		Returns: void															*
+	//!		Example: eHealth.getGSRBlock(buffer, 16);								*
+	//!******************************************************************************
+
+	void eHealthClassMock::getGSRBlock(gsrSample * samples, size_t count)
+	{
+		EHEALTH_PROBE(GET_GSR_BLOCK);
+
+		uint16_t raw[BLOCK_CHUNK];
+		uint16_t millivolts[BLOCK_CHUNK];
+		int16_t conductance[BLOCK_CHUNK];
+		int32_t resistance[BLOCK_CHUNK];
+
+		// Same settling as getSkinResistance(), once for the whole block.
+		delay(8);
+
+		while (count) {
+			size_t n = count < BLOCK_CHUNK ? count : BLOCK_CHUNK;
+
+			readAnalogBlock(ANALOG_GSR, raw, n);
+			eHealthAdcToMillivolts(raw, millivolts, n);
+			eHealthMillivoltsToConductance(millivolts, conductance, n);
+			eHealthConductanceToOhms(conductance, resistance, n);
+
+			for (size_t i = 0; i < n; i++) {
+				samples[i].voltage = millivolts[i] * EHEALTH_VOLTS_PER_MILLIVOLT;
+				samples[i].conductance = conductance[i] * EHEALTH_MICROSIEMENS_PER_COUNT;
+				samples[i].resistance = resistance[i];
+			}
+
+			samples += n;
+			count -= n;
+		}
+	}
+
+#endif
+
+
+#if EHEALTH_USE_POSITION
+
+	//!******************************************************************************
+	//!		Name:	getBodyPositionBlock()											*
+	//!		Description: Classifies the samples waiting in the accelerometer.		*
+	//!		Param : uint8_t * positions, size_t count								*
+	//!		Returns: size_t with the number of samples classified.					*
+	//!		Example: n = eHealth.getBodyPositionBlock(buffer, 32);					*
+	//!******************************************************************************
+
+	size_t eHealthClassMock::getBodyPositionBlock(uint8_t * positions, size_t count)
+	{
+		EHEALTH_PROBE(GET_BODY_POSITION_BLOCK);
+
+		return bodyPosition(positions, count);
+	}
+
+#endif
+
+
+//***************************************************************
+// Streaming Methods											*
+//***************************************************************
+
+
+	//!******************************************************************************
+	//!		Name:	readChannel()													*
+	//!		Description: Returns the raw value of a channel.						*
+	//!		Param : uint8_t channel, an eHealthChannel								*
+	//!		Returns: uint16_t with the value (units in eHealthChannels.h)			*
+	//!		Example: uint16_t ecg = eHealth.readChannel(EHEALTH_ECG);				*
+	//!******************************************************************************
+
+	uint16_t eHealthClassMock::readChannel(uint8_t channel)
+	{
+		EHEALTH_PROBE(READ_CHANNEL);
+
+		return channelValue(channel);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	sampleAll()														*
+	//!		Description: Reads channels in one pass with a single timestamp.		*
+	//!		Param : eHealthSnapshot & snapshot, uint16_t channels					*
+	//!		Returns: uint16_t with the channels read								*
+	//!		Example: eHealth.sampleAll(snapshot);									*
+	//!******************************************************************************
+
+	uint16_t eHealthClassMock::sampleAll(eHealthSnapshot & snapshot, uint16_t channels)
+	{
+		EHEALTH_PROBE(SAMPLE_ALL);
+
+		channels &= EHEALTH_CHANNELS;
+		snapshot.timestamp = micros();
+		snapshot.channels = channels;
+
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			snapshot.values[channel] = (channels & EHEALTH_CHANNEL_BIT(channel)) ? channelValue(channel) : 0;
+		}
+		return channels;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	sampleAllBlock()												*
+	//!		Description: Reads count consecutive snapshots, one array per channel.	*
+	//!		Param : eHealthSnapshotBlock & block, size_t count						*
+	//!		Returns: uint16_t with the channels read								*
+	//!		Example: eHealth.sampleAllBlock(block, 64);								*
+	//!******************************************************************************
+
+	uint16_t eHealthClassMock::sampleAllBlock(eHealthSnapshotBlock & block, size_t count)
+	{
+		EHEALTH_PROBE(SAMPLE_ALL_BLOCK);
+
+		uint16_t channels = 0;
+
+		block.timestamp = micros();
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (!block.values[channel]) {
+				continue;
+			}
+			if (EHEALTH_CHANNELS & EHEALTH_CHANNEL_BIT(channel)) {
+				channels |= EHEALTH_CHANNEL_BIT(channel);
+			} else {
+				memset(block.values[channel], 0, count * sizeof(uint16_t));
+			}
+		}
+
+		// EMG and air flow have generators of their own, as has the ECG
+		// unless the BPM, which follows the beats read so far, is in the
+		// block: those are filled a column at a time.
+		uint16_t columns = EHEALTH_CHANNEL_BIT(EHEALTH_EMG) | EHEALTH_CHANNEL_BIT(EHEALTH_AIRFLOW);
+		if (!(channels & EHEALTH_CHANNEL_BIT(EHEALTH_BPM))) {
+			columns |= EHEALTH_CHANNEL_BIT(EHEALTH_ECG);
+		}
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (channels & columns & EHEALTH_CHANNEL_BIT(channel)) {
+				readColumn(channel, block.values[channel], count);
+			}
+		}
+
+		// The rest snapshot by snapshot, in channel order, as sampleAll() reads them.
+		uint16_t stepped = channels & ~columns;
+		for (size_t i = 0; stepped && i < count; i++) {
+			for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+				if (stepped & EHEALTH_CHANNEL_BIT(channel)) {
+					block.values[channel][i] = channelValue(channel);
+				}
+			}
+		}
+
+		block.channels = channels;
+		return channels;
+	}
+
+/*******************************************************************************************************/
+
+#if EHEALTH_USE_ECG
+
+	//! Returns the next ECG reading (0-1023), replayed or synthesized.
+
+	uint16_t eHealthClassMock::nextECG(void)
+	{
+		uint16_t value;
+
+		if (!replayed(EHEALTH_ECG, value)) {
+			value = waveform.nextECG();
+		}
+	#if EHEALTH_USE_HEARTBEAT
+		heartbeat.update(value);
+	#endif
+		return value;
 	}
 
 /*******************************************************************************************************/
 
+	//! Fills samples with the next count ECG readings.
+
+	void eHealthClassMock::fillECG(uint16_t * samples, size_t count)
+	{
+		if (count && replayed(EHEALTH_ECG, samples[0])) {
+			for (size_t i = 1; i < count; i++) {
+				replayed(EHEALTH_ECG, samples[i]);
+			}
+		} else {
+			waveform.fillECG(samples, count);
+		}
+	#if EHEALTH_USE_HEARTBEAT
+		heartbeat.process(samples, count);
+	#endif
+	}
+
+/*******************************************************************************************************/
+
+#endif
+
+	//! Returns the raw value of channel, readChannel() without the probe.
+
+	uint16_t eHealthClassMock::channelValue(uint8_t channel)
+	{
+		uint16_t value;
+
+		// Channels of the sensors compiled out read 0.
+		if (channel >= EHEALTH_CHANNEL_COUNT || !(EHEALTH_CHANNELS & EHEALTH_CHANNEL_BIT(channel))) {
+			return 0;
+		}
+
+		// The ECG replays through nextECG(), which also feeds heartbeat.
+		if (channel != EHEALTH_ECG && replayed(channel, value)) {
+			return value;
+		}
+
+		switch (channel) {
+		#if EHEALTH_USE_ECG
+			case EHEALTH_ECG:			return nextECG();
+		#endif
+		#if EHEALTH_USE_EMG
+			case EHEALTH_EMG:			return waveform.nextEMG();
+		#endif
+		#if EHEALTH_USE_AIRFLOW
+			case EHEALTH_AIRFLOW:		return waveform.nextAirFlow();
+		#endif
+		#if EHEALTH_USE_GSR
+			case EHEALTH_GSR:			return rng.uniform(1, 1024);
+		#endif
+		#if EHEALTH_USE_TEMPERATURE
+			case EHEALTH_TEMPERATURE:	return getTemperatureCentidegrees();
+		#endif
+		#if EHEALTH_USE_PULSIOXIMETER
+			case EHEALTH_SPO2:			return SPO2;
+			case EHEALTH_BPM:			return getBPM();
+		#endif
+		#if EHEALTH_USE_POSITION
+			case EHEALTH_POSITION:		return getBodyPosition();
+		#endif
+		#if EHEALTH_USE_BLOOD_PRESSURE
+			case EHEALTH_SYSTOLIC:		return systolic;
+			case EHEALTH_DIASTOLIC:		return diastolic;
+		#endif
+		#if EHEALTH_USE_GLUCOMETER
+			case EHEALTH_GLUCOSE:		return glucoseHistory().size() ? glucoseHistory().value(glucoseHistory().size() - 1) & 0x3FF : 0;
+		#endif
+			default:					return 0;
+		}
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	writeFrame()													*
+	//!		Description: Sends one snapshot of channels as a binary frame.			*
+	//!		Param : uint16_t channels, bitmap of EHEALTH_CHANNEL_BIT() values		*
+	//!		Returns: size_t with the bytes sent										*
+	//!		Example: eHealth.writeFrame(EHEALTH_CHANNEL_BIT(EHEALTH_ECG));			*
+	//!******************************************************************************
+
+	size_t eHealthClassMock::writeFrame(uint16_t channels)
+	{
+		EHEALTH_PROBE(WRITE_FRAME);
+
+		uint16_t values[EHEALTH_CHANNEL_COUNT];
+		uint8_t frame[EHEALTH_FRAME_HEADER_SIZE + 2 * EHEALTH_CHANNEL_COUNT + EHEALTH_FRAME_CRC_SIZE];
+		uint32_t timestamp = micros();
+		uint8_t n = 0;
+
+		channels &= EHEALTH_CHANNELS;
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (channels & EHEALTH_CHANNEL_BIT(channel)) {
+				values[n++] = readChannel(channel);
+			}
+		}
+
+		size_t size = frameEncoder.encode(channels, 1, timestamp, 0, values, frame, sizeof(frame));
+		if (size) {
+			out->write(frame, size);
+			if (!out->endRecord()) {
+				size = 0;
+			}
+		}
+		return size;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	setOutput()														*
+	//!		Description: Sends the text and frames of this instance to output.		*
+	//!		Param : eHealthOutput & output											*
+	//!		Returns: void															*
+	//!		Example: eHealth.setOutput(fileOutput);									*
+	//!******************************************************************************
+
+	void eHealthClassMock::setOutput(eHealthOutput & output)
+	{
+		out = &output;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	replay()														*
+	//!		Description: Serves the getters from source.							*
+	//!		Param : eHealthSource * source, NULL to stop replaying					*
+	//!		Returns: void															*
+	//!		Example: eHealth.replay(&trace);										*
+	//!******************************************************************************
+
+	void eHealthClassMock::replay(eHealthSource * replaySource)
+	{
+		source = replaySource;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	attachRing()													*
+	//!		Description: Selects the ring acquire() fills and its channels.			*
+	//!		Param : eHealthSampleRing * ring, uint16_t channels						*
+	//!		Returns: void															*
+	//!		Example: eHealth.attachRing(&ring, EHEALTH_CHANNEL_BIT(EHEALTH_ECG));	*
+	//!******************************************************************************
+
+	void eHealthClassMock::attachRing(eHealthSampleRing * sampleRing, uint16_t channels)
+	{
+		ring = sampleRing;
+		ringChannels = channels & EHEALTH_CHANNELS;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	acquire()														*
+	//!		Description: Reads one snapshot of the attached channels into the ring.	*
+	//!		Param : void															*
+	//!		Returns: bool, false if a sample was dropped							*
+	//!		Example: ISR(TIMER1_COMPA_vect) { eHealth.acquire(); }					*
+	//!******************************************************************************
+
+	bool eHealthClassMock::acquire(void)
+	{
+		EHEALTH_PROBE(ACQUIRE);
+
+		if (!ring) {
+			return false;
+		}
+
+		eHealthSample sample;
+		bool stored = true;
+
+		sample.timestamp = micros();
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (ringChannels & EHEALTH_CHANNEL_BIT(channel)) {
+				sample.channel = channel;
+				sample.value = readChannel(channel);
+				stored &= ring->push(sample);
+			}
+		}
+		return stored;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	printProfile()													*
+	//!		Description: Writes the statistics of the instrumented methods.			*
+	//!		Param : bool reset, clear them once written								*
+	//!		Returns: void															*
+	//!		Example: eHealth.printProfile(true);									*
+	//!******************************************************************************
+
+	void eHealthClassMock::printProfile(bool reset)
+	{
+	#if defined(EHEALTH_PROFILE)
+		eHealthProfilePrint(*out);
+		if (reset) {
+			eHealthProfileReset();
+		}
+	#else
+		(void)reset;
+	#endif
+	}
+
+
+//***************************************************************
+// Private Methods												*
+//***************************************************************
+
+#if EHEALTH_USE_POSITION
+
 	//! Initialize the MMA8452 registers.
 
 	void eHealthClassMock::initMMA8452(byte fsr, byte dataRate)
 	{
-		// Do nothing
+		// Must be in standby to change registers
+		MMA8452Standby();
+
+		// Set up the full scale range to 2, 4, or 8g.
+		if ((fsr == 2) || (fsr == 4) || (fsr == 8)) {
+			writeRegister(MMA8452_XYZ_DATA_CFG, fsr >> 2);
+		} else {
+			writeRegister(MMA8452_XYZ_DATA_CFG, 0);
+		}
+
+		// Setup the 3 data rate bits, from 0 to 7
+		writeRegister(MMA8452_CTRL_REG1, readRegister(MMA8452_CTRL_REG1) & ~(0x38));
+		if (dataRate <= 7) {
+			writeRegister(MMA8452_CTRL_REG1, readRegister(MMA8452_CTRL_REG1) | (dataRate << 3));
+		}
 
+		// Set up portrait/landscape registers
+		writeRegister(MMA8452_PL_CFG, 0x40);		// Enable P/L
+		writeRegister(MMA8452_PL_BF_ZCOMP, 0x44);	// 29deg z-lock
+		writeRegister(MMA8452_PL_THS_REG, 0x84);	// 45deg thresh, 14deg hyst
+		writeRegister(MMA8452_PL_COUNT, 0x05);		// debounce counter at 100ms
+
+		// Set to active to start reading
+		MMA8452Active();
 	}
 
 /*******************************************************************************************************/
@@ -544,7 +1518,8 @@
 
 	void eHealthClassMock::MMA8452Standby()
 	{
-		// Do nothing
+		byte c = readRegister(MMA8452_CTRL_REG1);
+		writeRegister(MMA8452_CTRL_REG1, c & ~(0x01));
 	}
 
 /*******************************************************************************************************/
@@ -553,7 +1528,8 @@
 
 	void eHealthClassMock::MMA8452Active()
 	{
-		// Do nothing
+		byte c = readRegister(MMA8452_CTRL_REG1);
+		writeRegister(MMA8452_CTRL_REG1, c | 0x01);
 	}
 
 /*******************************************************************************************************/
@@ -561,7 +1537,7 @@
 	//! Read i registers sequentially, starting at address into the dest byte array.
 	void eHealthClassMock::readRegisters(byte address, int i, byte * dest)
 	{
-		// Do nothing
+		accelerometer.readRegisters(address, i > 0 ? i : 0, dest);
 	}
 
 /*******************************************************************************************************/
@@ -570,9 +1546,7 @@
 
 	byte eHealthClassMock::readRegister(uint8_t address)
 	{
-		// Do nothing
-
-		return 1;
+		return accelerometer.readRegister(address);
 	}
 
 /*******************************************************************************************************/
@@ -580,20 +1554,57 @@
 	//! Writes a single byte (data) into address
 	void eHealthClassMock::writeRegister(unsigned char address, unsigned char data)
 	{
-		// Do nothing
+		accelerometer.writeRegister(address, data);
 	}
 
 /*******************************************************************************************************/
 
-	//! Assigns a value depending on body position.
+	//! Reads the samples waiting in the accelerometer, as many as F_STATUS
+	//! counts with the FIFO enabled or the latest one once ZYXDR is set, and
+	//! classifies them. Keeps the last one in accelCount and accel.
 
-	void eHealthClassMock::bodyPosition( void )
+	size_t eHealthClassMock::bodyPosition(uint8_t * positions, size_t count)
 	{
-        bodyPos = 6;
+		uint8_t status = readRegister(MMA8452_STATUS);
+		size_t waiting;
+
+		if (readRegister(MMA8452_F_SETUP) & 0xC0) {
+			waiting = status & 0x3F;
+		} else {
+			waiting = (status & 0x08) ? 1 : 0;
+		}
+		if (waiting > count) {
+			waiting = count;
+		}
+
+		byte data[6 * BLOCK_CHUNK];
+		int16_t counts[3 * BLOCK_CHUNK];
+		size_t done = 0;
+
+		while (done < waiting) {
+			size_t n = waiting - done < BLOCK_CHUNK ? waiting - done : BLOCK_CHUNK;
+
+			// In FIFO mode one burst read drains n samples.
+			readRegisters(MMA8452_OUT_X_MSB, 6 * n, data);
+			eHealthAccelUnpack(data, counts, n);
+			bodyPos = positionClassifier.classify(counts, n, positions ? positions + done : NULL);
+
+			memcpy(accelCount, counts + 3 * (n - 1), sizeof(accelCount));
+			done += n;
+		}
+
+		if (done) {
+			eHealthAccelToG(accelCount, accel, 3, scale);
+		}
+		return done;
 	}
 
 /*******************************************************************************************************/
 
+#endif
+
+#if EHEALTH_USE_BLOOD_PRESSURE
+
 	//! Converts from 7 segments to number.
 
 	uint8_t eHealthClassMock::segToNumber(uint8_t A, uint8_t B, uint8_t C, uint8_t D, uint8_t E, uint8_t F, uint8_t G )
@@ -614,6 +1625,138 @@
 
 /*******************************************************************************************************/
 
+#endif
+
+#if EHEALTH_USE_ANALOG_BLOCK
+
+	//! Fills samples with count readings of input converted to voltage.
+
+	void eHealthClassMock::readVoltageBlock(analogInput input, float * samples, size_t count)
+	{
+		uint16_t raw[BLOCK_CHUNK];
+
+		while (count) {
+			size_t n = count < BLOCK_CHUNK ? count : BLOCK_CHUNK;
+
+			readAnalogBlock(input, raw, n);
+			eHealthAdcToVoltage(raw, samples, n);
+
+			samples += n;
+			count -= n;
+		}
+	}
+
+/*******************************************************************************************************/
+
+	//! Fills samples with count readings of input converted to millivolts.
+
+	void eHealthClassMock::readMillivoltBlock(analogInput input, uint16_t * samples, size_t count)
+	{
+		uint16_t raw[BLOCK_CHUNK];
+
+		while (count) {
+			size_t n = count < BLOCK_CHUNK ? count : BLOCK_CHUNK;
+
+			readAnalogBlock(input, raw, n);
+			eHealthAdcToMillivolts(raw, samples, n);
+
+			samples += n;
+			count -= n;
+		}
+	}
+
+/*******************************************************************************************************/
+
+	//! Fills raw with count readings (0-1023) of input.
+
+	void eHealthClassMock::readAnalogBlock(analogInput input, uint16_t * raw, size_t count)
+	{
+		if (source && input != ANALOG_ECG) {
+			uint8_t channel = input == ANALOG_EMG ? EHEALTH_EMG : EHEALTH_GSR;
+
+			if (count && replayed(channel, raw[0])) {
+				for (size_t i = 1; i < count; i++) {
+					replayed(channel, raw[i]);
+				}
+				return;
+			}
+		}
+
+		switch (input) {
+		#if EHEALTH_USE_ECG
+			case ANALOG_ECG:
+				fillECG(raw, count);
+				break;
+		#endif
+		#if EHEALTH_USE_EMG
+			case ANALOG_EMG:
+				waveform.fillEMG(raw, count);
+				break;
+		#endif
+		#if EHEALTH_USE_GSR
+			case ANALOG_GSR:
+				for (size_t i = 0; i < count; i++) {
+					raw[i] = rng.uniform(1, 1024);
+				}
+				break;
+		#endif
+			default:
+				break;
+		}
+	}
+
+/*******************************************************************************************************/
+
+#endif
+
+	//! Fills column with count consecutive raw values of channel.
+
+	void eHealthClassMock::readColumn(uint8_t channel, uint16_t * column, size_t count)
+	{
+		if (channel != EHEALTH_ECG && count && replayed(channel, column[0])) {
+			for (size_t i = 1; i < count; i++) {
+				replayed(channel, column[i]);
+			}
+			return;
+		}
+
+		// The synthesized analog channels have block generators; the others
+		// change slowly and are read one value at a time.
+		switch (channel) {
+		#if EHEALTH_USE_ECG
+			case EHEALTH_ECG:
+				fillECG(column, count);
+				break;
+		#endif
+		#if EHEALTH_USE_EMG
+			case EHEALTH_EMG:
+				waveform.fillEMG(column, count);
+				break;
+		#endif
+		#if EHEALTH_USE_AIRFLOW
+			case EHEALTH_AIRFLOW:
+				waveform.fillAirFlow(column, count);
+				break;
+		#endif
+			default:
+				for (size_t i = 0; i < count; i++) {
+					column[i] = channelValue(channel);
+				}
+				break;
+		}
+	}
+
+/*******************************************************************************************************/
+
+	//! Reads channel from the replay source. False when not replaying it.
+
+	bool eHealthClassMock::replayed(uint8_t channel, uint16_t & value)
+	{
+		return source && source->read(channel, value);
+	}
+
+/*******************************************************************************************************/
+
 //***************************************************************
 // Preinstantiate Objects										*
 //***************************************************************
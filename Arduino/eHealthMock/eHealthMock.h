@@ -44,6 +44,22 @@
 #define eHealthClassMock_h
 
 #include "Arduino.h"
+#include "eHealthBeat.h"
+#include "eHealthChannels.h"
+#include "eHealthCodec.h"
+#include "eHealthConfig.h"
+#include "eHealthFrame.h"
+#include "eHealthHistory.h"
+#include "eHealthMMA8452.h"
+#include "eHealthOutput.h"
+#include "eHealthPosition.h"
+#include "eHealthProfile.h"
+#include "eHealthRandom.h"
+#include "eHealthSampleRing.h"
+#include "eHealthSnapshot.h"
+#include "eHealthSource.h"
+#include "eHealthText.h"
+#include "eHealthWaveform.h"
 
 // Library interface description
 class eHealthClassMock {
@@ -61,30 +77,45 @@ class eHealthClassMock {
 	// Public Methods												*
 	//***************************************************************
 
+	#if EHEALTH_USE_POSITION
 		//! Initializes the position sensor and configure some values.
 		/*!
 		\param void
 		\return void
 		*/	void initPositionSensor(void);
+	#endif
 
+	#if EHEALTH_USE_BLOOD_PRESSURE
 		//! Initializes the BloodPressureSensor sensor and configure some values
 		/*!
 		\param float parameter with correction value
 		\return void
 		*/	void readBloodPressureSensor(void);
+	#endif
 
+	#if EHEALTH_USE_PULSIOXIMETER
 		//! Initializes the pulsioximeter sensor and configure some values.
 		/*!
 		\param void
 		\return void
 		*/	void initPulsioximeter(void);
+	#endif
 
+	#if EHEALTH_USE_TEMPERATURE
 		//! Returns the corporal temperature.
 		/*!
 		\param void
 		\return float : The corporal temperature value.
 		*/	float getTemperature( void );
 
+		//! Returns the corporal temperature in hundredths of a degree.
+		/*!
+		\param void
+		\return int16_t : The temperature, 3750 for 37.5 degrees.
+		*/	int16_t getTemperatureCentidegrees(void);
+	#endif
+
+	#if EHEALTH_USE_PULSIOXIMETER
 		//! Returns the oxygen saturation in blood in percent.
 		/*!
 		\param void
@@ -93,10 +124,14 @@ class eHealthClassMock {
 
 		//! Returns the heart beats per minute.
 		/*!
+		 *  Once heartbeat has found the rate of the ECG read so far, that
+		 *  rate. Otherwise the pulsioximeter's.
 		\param void
 		\return int : The beats per minute.
 		*/	int getBPM(void);
+	#endif
 
+	#if EHEALTH_USE_GSR
 		//! Returns the value of skin conductance.
 		/*!
 		\param void
@@ -111,22 +146,71 @@ class eHealthClassMock {
 
 		//! Returns the value of skin conductance in voltage.
 		/*!
+		 *  Blocks for the 4 ms the sensor takes to settle. eHealthScheduler
+		 *  samples EHEALTH_GSR without blocking.
 		\param void
 		\return float : The skin conductance value in voltage (0-5v).
 		*/	float getSkinConductanceVoltage(void);
 
+		//! Returns the value of skin conductance in hundredths of a microsiemens.
+		/*!
+		 *  getSkinConductance() without floating point: the same value times 100.
+		\param void
+		\return int16_t : The skin conductance, -100 when the voltage is 0.
+		*/	int16_t getSkinConductanceHundredths(void);
+
+		//! Returns the value of skin resistance in ohms.
+		/*!
+		\param void
+		\return int32_t : The skin resistance, -1 when the conductance is not positive.
+		*/	int32_t getSkinResistanceOhms(void);
+
+		//! Returns the value of skin conductance in millivolts.
+		/*!
+		\param void
+		\return uint16_t : The skin conductance value in millivolts (0-5000).
+		*/	uint16_t getSkinConductanceMillivolts(void);
+	#endif
+
+	#if EHEALTH_USE_ECG
 		//! Returns an analogic value to represent the Electrocardiography.
 		/*!
 		\param void
 		\return float : The analogic value (0-5V).
 		*/	float getECG(void);
 
+		//! Returns the Electrocardiography in millivolts.
+		/*!
+		 *  getECG() without floating point, for sampling at high rates.
+		\param void
+		\return uint16_t : The analogic value (0-5000 mV).
+		*/	uint16_t getECGMillivolts(void);
+	#endif
+
+	#if EHEALTH_USE_HEARTBEAT
+		//! Returns the time between the last two heart beats of the ECG read.
+		/*!
+		\param void
+		\return uint16_t : The RR interval in milliseconds, 0 until heartbeat
+		 *  has found the rate.
+		*/	uint16_t getRRInterval(void);
+	#endif
+
+	#if EHEALTH_USE_EMG
 		//! Returns an analogic value to represent the Electromyography.
 		/*!
 		\param void
 		\return float : The analogic value (0-5V).
 		*/	int getEMG(void);
 
+		//! Returns the Electromyography in millivolts.
+		/*!
+		\param void
+		\return uint16_t : The analogic value (0-5000 mV).
+		*/	uint16_t getEMGMillivolts(void);
+	#endif
+
+	#if EHEALTH_USE_POSITION
 		//! Returns the body position.
 		/*!
 		\param void
@@ -136,8 +220,13 @@ class eHealthClassMock {
 		 *		3 == Rigth lateral decubitus.
 		 *		4 == Prone position.
 		 *		5 == Stand or sit position
+		 *		6 == non-defined position
+		 *  Classifies the samples the accelerometer produced since the last
+		 *  call (see eHealthPosition.h). Call initPositionSensor() first.
 		 */ uint8_t getBodyPosition(void);
+	#endif
 
+	#if EHEALTH_USE_BLOOD_PRESSURE
 		//! Returns the  value of the systolic pressure.
 		/*!
 		\param void
@@ -149,31 +238,43 @@ class eHealthClassMock {
 		\param void
 		\return int : The diastolic pressure.
 		*/	int getDiastolicPressure(int i);
+	#endif
 
+	#if EHEALTH_USE_AIRFLOW
 		//! Returns an analogic value to represent the air flow.
 		/*!
 		\param void
 		\return int : The value (0-1023) read from the analogic in.
 		*/	int getAirFlow(void);
+	#endif
 
+	#if EHEALTH_USE_POSITION
 		//! Prints the current body position
 		/*!
 		\param uint8_t position : the current body position.
 		\return void
 		*/	void printPosition( uint8_t position );
+	#endif
 
+	#if EHEALTH_USE_PULSIOXIMETER
 		//! It reads a value from pulsioximeter sensor.
 		/*!
 		\param void
 		\return void
 		*/	void readPulsioximeter(void);
+	#endif
 
+	#if EHEALTH_USE_AIRFLOW
 		//!  Prints air flow wave form in the serial monitor
 		/*!
+		 *  Paces itself with delay(25). To draw the wave without blocking,
+		 *  sample EHEALTH_AIRFLOW at 40 Hz with eHealthScheduler instead.
 		\param int air : analogic value to print.
 		\return void
 		*/	void airFlowWave(int air);
+	#endif
 
+	#if EHEALTH_USE_GLUCOMETER
 		//!  Read the values stored in the glucometer.
 		/*!
 		\param void
@@ -185,12 +286,15 @@ class eHealthClassMock {
 		\param void
 		\return int : length of data
 		*/	uint8_t getGlucometerLength(void);
+	#endif
 
+	#if EHEALTH_USE_BLOOD_PRESSURE
 		//!Returns the number of data stored in the blood pressure sensor.
 		/*!
 		\param void
 		\return int : length of data
 		*/	uint8_t getBloodPressureLength(void);
+	#endif
 
 		//!  Returns the library version
 		/*!
@@ -198,40 +302,319 @@ class eHealthClassMock {
 		\return int : The library version.
 		*/	int version(void);
 
+	#if !EHEALTH_NO_HEAP
 		//! Convert month variable from numeric to character.
 		/*!
+		 *  Allocates the String; not available with EHEALTH_NO_HEAP.
 		 \param int month in numerical format.
 		 \return String with the month characters (January, February...).
 		 */	String numberToMonth(int month);
+	#endif
+
+		//! Writes the month name into a caller buffer.
+		/*!
+		 \param int month in numerical format.
+		 \param char * buffer : the name, null terminated. 10 bytes fit any month.
+		 \param size_t size : size of buffer.
+		 \return size_t : length of the name; size or more if it was cut short.
+		 */	size_t numberToMonth(int month, char * buffer, size_t size);
+
+		//! Seeds the random streams of this instance.
+		/*!
+		 *  Instances own their random state, so differently seeded instances
+		 *  produce independent readings. The constructor seeds from micros().
+		\param unsigned long value : the seed.
+		\return void
+		*/	void seed(unsigned long value);
+
+		//! Moves every channel to sample index of its deterministic stream.
+		/*!
+		 *  The streams are counter based, so this is O(1). Two instances with
+		 *  the same seed can each produce a disjoint slice of the same run:
+		 *  seek(k) followed by n reads yields samples k to k + n - 1.
+		\param uint64_t index : sample index, counted per channel.
+		\return void
+		*/	void seek(uint64_t index);
+
+	//***************************************************************
+	// Block Methods												*
+	//***************************************************************
+
+	#if EHEALTH_USE_GSR
+		//!Struct to store one galvanic skin response reading.
+		struct gsrSample {
+			float voltage;
+			float conductance;
+			float resistance;
+		};
+	#endif
+
+	#if EHEALTH_USE_ECG
+		//! Fills samples with count consecutive ECG values.
+		/*!
+		\param float * samples : buffer for count values (0-5V).
+		\param size_t count : number of samples to read.
+		\return void
+		*/	void getECGBlock(float * samples, size_t count);
+
+		//! Fills samples with count consecutive ECG values in millivolts.
+		/*!
+		\param uint16_t * samples : buffer for count values (0-5000 mV).
+		\param size_t count : number of samples to read.
+		\return void
+		*/	void getECGMillivoltsBlock(uint16_t * samples, size_t count);
+	#endif
+
+	#if EHEALTH_USE_EMG
+		//! Fills samples with count consecutive EMG values.
+		/*!
+		 *  Unlike getEMG() the values are not truncated to int.
+		\param float * samples : buffer for count values (0-5V).
+		\param size_t count : number of samples to read.
+		\return void
+		*/	void getEMGBlock(float * samples, size_t count);
+
+		//! Fills samples with count consecutive EMG values in millivolts.
+		/*!
+		\param uint16_t * samples : buffer for count values (0-5000 mV).
+		\param size_t count : number of samples to read.
+		\return void
+		*/	void getEMGMillivoltsBlock(uint16_t * samples, size_t count);
+	#endif
+
+	#if EHEALTH_USE_GSR
+		//! Fills samples with count consecutive skin conductance voltages.
+		/*!
+		 *  The sensor settling delays are paid once per block, not per sample.
+		\param float * samples : buffer for count values (0-5V).
+		\param size_t count : number of samples to read.
+		\return void
+		*/	void getSkinConductanceVoltageBlock(float * samples, size_t count);
+	#endif
+
+	#if EHEALTH_USE_AIRFLOW
+		//! Fills samples with count consecutive air flow values.
+		/*!
+		\param int * samples : buffer for count values (0-1023).
+		\param size_t count : number of samples to read.
+		\return void
+		*/	void getAirFlowBlock(int * samples, size_t count);
+	#endif
 
+	#if EHEALTH_USE_GSR
+		//! Fills samples with count GSR readings carrying voltage, conductance and resistance.
+		/*!
+		 *  The sensor settling delays are paid once per block, not per sample.
+		\param gsrSample * samples : buffer for count readings.
+		\param size_t count : number of readings.
+		\return void
+		*/	void getGSRBlock(gsrSample * samples, size_t count);
+	#endif
+
+	#if EHEALTH_USE_POSITION
+		//! Classifies up to count samples waiting in the accelerometer.
+		/*!
+		 *  With its FIFO enabled (F_SETUP) the samples are drained with burst
+		 *  reads and classified as a block; otherwise only the latest output
+		 *  is waiting. getBodyPosition() returns the last position afterwards.
+		\param uint8_t * positions : buffer for count positions, or NULL.
+		\param size_t count : most samples to read.
+		\return size_t : samples classified.
+		*/	size_t getBodyPositionBlock(uint8_t * positions, size_t count);
+	#endif
+
+	//***************************************************************
+	// Streaming Methods											*
+	//***************************************************************
+
+		//! Returns the raw value of a channel.
+		/*!
+		 *  Analog channels are read without the settling delays of the getters.
+		\param uint8_t channel : an eHealthChannel.
+		\return uint16_t : the value, in the unit listed in eHealthChannels.h.
+		*/	uint16_t readChannel(uint8_t channel);
+
+		//! Reads channels in one pass, stamped with a single micros().
+		/*!
+		 *  No delay() is paid, unlike the getters, so the readings are not
+		 *  skewed by the settling times of the sensors read before them.
+		\param eHealthSnapshot & snapshot : receives the timestamp and values.
+		\param uint16_t channels : bitmap of EHEALTH_CHANNEL_BIT() values.
+		\return uint16_t : the channels read, those of channels compiled in.
+		*/	uint16_t sampleAll(eHealthSnapshot & snapshot, uint16_t channels = EHEALTH_ALL_CHANNELS);
+
+		//! Reads count consecutive snapshots of the channels block has arrays for.
+		/*!
+		 *  Gives the values of count sampleAll() calls. EMG, air flow and,
+		 *  unless the BPM is read along, the ECG are filled by the block
+		 *  readers; the other channels are read snapshot by snapshot, so
+		 *  the BPM follows the ECG within the block. Returns at once, as
+		 *  the other block methods do; the snapshots are stamped
+		 *  block.period apart.
+		\param eHealthSnapshotBlock & block : arrays of count values to fill.
+		 *  Receives the timestamp and the channels read.
+		\param size_t count : number of snapshots.
+		\return uint16_t : the channels read. Arrays of channels compiled out
+		 *  are filled with 0 and left out.
+		*/	uint16_t sampleAllBlock(eHealthSnapshotBlock & block, size_t count);
+
+		//! Reads one snapshot of channels and sends it to output() as a binary frame.
+		/*!
+		 *  A frame dropped by the rate limit of the output still uses a
+		 *  sequence number, so the receiver sees the gap.
+		\param uint16_t channels : bitmap of EHEALTH_CHANNEL_BIT() values.
+		\return size_t : bytes sent, 0 if channels is not a valid set or the
+		 *  frame was dropped.
+		*/	size_t writeFrame(uint16_t channels);
+
+		//! Sends the text and frames of this instance to output.
+		/*!
+		 *  By default they go to eHealthSerialOutput(), buffered to Serial.
+		\param eHealthOutput & output : the output to use.
+		\return void
+		*/	void setOutput(eHealthOutput & output);
+
+		//! Returns the output the text and frames of this instance go to.
+		eHealthOutput & output(void) { return *out; }
+
+		//! Serves the getters from source instead of the synthesized readings.
+		/*!
+		 *  Covers getECG(), getEMG(), getAirFlow(), getSkinConductanceVoltage()
+		 *  and the GSR getters built on it, getTemperature(),
+		 *  getOxygenSaturation(), getBPM(), getBodyPosition(), readChannel()
+		 *  and the block methods.
+		 *  Channels the source lacks keep their synthesized readings.
+		\param eHealthSource * source : the source, NULL to stop replaying.
+		\return void
+		*/	void replay(eHealthSource * source);
+
+		//! Selects the ring acquire() fills and the channels it reads.
+		/*!
+		\param eHealthSampleRing * ring : the ring, NULL to detach.
+		\param uint16_t channels : bitmap of EHEALTH_CHANNEL_BIT() values.
+		\return void
+		*/	void attachRing(eHealthSampleRing * ring, uint16_t channels);
+
+		//! Reads one snapshot of the attached channels into the ring.
+		/*!
+		 *  Meant to be called at a fixed rate from a timer interrupt (or a
+		 *  thread on the host) while loop() drains the ring with popBlock().
+		 *  Every sample carries the same micros() timestamp. No delay() is
+		 *  paid, so it is safe inside an ISR.
+		\param void
+		\return bool : false if the ring overflowed or none is attached.
+		*/	bool acquire(void);
+
+		//! Writes the statistics of the instrumented methods to output().
+		/*!
+		 *  Needs a build with EHEALTH_PROFILE defined, otherwise writes
+		 *  nothing. The statistics are shared by all instances (per thread on
+		 *  the host); see eHealthProfile.h for the format.
+		\param bool reset : clear the statistics once written.
+		\return void
+		*/	void printProfile(bool reset = false);
+
+	#if EHEALTH_USE_GLUCOMETER
 		//!Struct to store data of the glucometer.
 		struct glucoseData {
-			uint8_t year;
+			uint16_t year;
 			uint8_t month;
 			uint8_t day;
 			uint8_t hour;
 			uint8_t minutes;
-			uint8_t glucose;
+			uint16_t glucose;
 			uint8_t meridian;
 		};
 
-		//!Vector to store the glucometer measures and dates.
-		glucoseData glucoseDataVector[8];
+		//! Returns glucose record i, 0 being the oldest.
+		/*!
+		\param uint8_t i : index, below getGlucometerLength().
+		\return glucoseData : the record.
+		*/	glucoseData getGlucoseRecord(uint8_t i);
 
+		//! Writes glucose record i as text into a caller buffer.
+		/*!
+		 *  "17 October 2026 08:30 95 mg/dL". 40 bytes fit any record.
+		\param uint8_t i : index, below getGlucometerLength().
+		\param char * buffer : the text, null terminated.
+		\param size_t size : size of buffer.
+		\return size_t : length of the text; size or more if it was cut short.
+		*/	size_t formatGlucoseRecord(uint8_t i, char * buffer, size_t size);
+
+		//! Returns the history the glucometer records are kept in.
+		/*!
+		 *  Values pack glucose (mg/dL) in bits 0-9 and meridian in bits 10-15.
+		*/	eHealthHistory & glucoseHistory(void) { return glucoseStore ? *glucoseStore : ownGlucose; }
+
+		//! Keeps the glucometer records in history, NULL for the built-in one.
+		/*!
+		 *  The built-in histories hold EHEALTH_HISTORY_CAPACITY records. Use
+		 *  a larger store, with 2 value bytes, to keep more.
+		*/	void setGlucoseHistory(eHealthHistory * history) { glucoseStore = history; }
+	#endif
+
+	#if EHEALTH_USE_BLOOD_PRESSURE
 		//!Struct to store data of the blood pressure sensor.
 		struct bloodPressureData {
-			uint8_t year;
+			uint16_t year;
 			uint8_t month;
 			uint8_t day;
 			uint8_t hour;
 			uint8_t minutes;
-			uint8_t systolic;
+			uint16_t systolic;
 			uint8_t diastolic;
 			uint8_t pulse;
 		};
 
-		//!Vector to store the blood pressure measures and dates.
-		bloodPressureData bloodPressureDataVector[8];
+		//! Returns blood pressure record i, 0 being the oldest.
+		/*!
+		\param uint8_t i : index, below getBloodPressureLength().
+		\return bloodPressureData : the record.
+		*/	bloodPressureData getBloodPressureRecord(uint8_t i);
+
+		//! Writes blood pressure record i as text into a caller buffer.
+		/*!
+		 *  "17 October 2026 08:30 120/80 mmHg 72 bpm". 48 bytes fit any record.
+		\param uint8_t i : index, below getBloodPressureLength().
+		\param char * buffer : the text, null terminated.
+		\param size_t size : size of buffer.
+		\return size_t : length of the text; size or more if it was cut short.
+		*/	size_t formatBloodPressureRecord(uint8_t i, char * buffer, size_t size);
+
+		//! Returns the history the blood pressure records are kept in.
+		/*!
+		 *  Values pack systolic in bits 0-8, diastolic in bits 9-16 and pulse
+		 *  in bits 17-24.
+		*/	eHealthHistory & bloodPressureHistory(void) { return pressureStore ? *pressureStore : ownPressure; }
+
+		//! Keeps the blood pressure records in history (4 value bytes), NULL
+		//! for the built-in one.
+		void setBloodPressureHistory(eHealthHistory * history) { pressureStore = history; }
+	#endif
+
+	#if EHEALTH_USE_POSITION
+		//!Register-level emulation of the MMA8452 of the position sensor.
+		//!Set its gravity vector to move the patient, or drive its registers
+		//!directly to test accelerometer driver code.
+		eHealthMMA8452 accelerometer;
+
+		//!Turns the accelerometer samples into body positions. Use it to set
+		//!the debounce of getBodyPosition().
+		eHealthPositionClassifier positionClassifier;
+	#endif
+
+	#if EHEALTH_USE_HEARTBEAT
+		//!Finds the heart beats in every ECG reading, for getBPM() and
+		//!getRRInterval(). Set its sample rate when reading the ECG at other
+		//!than 250 Hz.
+		eHealthBeatDetector heartbeat;
+	#endif
+
+	#if EHEALTH_USE_WAVEFORM
+		//!Synthesizer behind the ECG, EMG and air flow readings.
+		//!Use it to set heart rate, respiration rate and amplitudes.
+		eHealthWaveform waveform;
+	#endif
 
 	private:
 
@@ -239,6 +622,7 @@ class eHealthClassMock {
 	// Private Methods												*
 	//***************************************************************
 
+	#if EHEALTH_USE_POSITION
 		//! Initialize the MMA8452 registers
 		void initMMA8452(byte fsr, byte dataRate);
 
@@ -257,13 +641,11 @@ class eHealthClassMock {
 		//! Writes a single byte (data) into address.
 		void writeRegister(unsigned char address, unsigned char data);
 
-		//! This function will read the p/l source register and
-		//! print what direction the sensor is now facing.
-		void portraitLandscapeHandler();
-
-		//! Assigns a value depending on body position.
-		void bodyPosition(void);
+		//! Reads and classifies up to count waiting accelerometer samples.
+		size_t bodyPosition(uint8_t * positions, size_t count);
+	#endif
 
+	#if EHEALTH_USE_BLOOD_PRESSURE
 		//! Converts from 7 segments to number.
 		uint8_t segToNumber(uint8_t A,
 							uint8_t B,
@@ -275,43 +657,101 @@ class eHealthClassMock {
 
 		//! Assigns a value depending on body position.
 		char swap(char _data);
+	#endif
+
+	#if EHEALTH_USE_ANALOG_BLOCK
+		//! Analog inputs served by readAnalogBlock().
+		enum analogInput { ANALOG_ECG, ANALOG_EMG, ANALOG_GSR };
+
+		//! Fills raw with count readings (0-1023) of input.
+		void readAnalogBlock(analogInput input, uint16_t * raw, size_t count);
+
+		//! Fills samples with count readings of input converted to voltage.
+		void readVoltageBlock(analogInput input, float * samples, size_t count);
+
+		//! Fills samples with count readings of input converted to millivolts.
+		void readMillivoltBlock(analogInput input, uint16_t * samples, size_t count);
+	#endif
+
+	#if EHEALTH_USE_ECG
+		//! Returns the next ECG reading (0-1023), replayed or synthesized,
+		//! after passing it to heartbeat.
+		uint16_t nextECG(void);
+
+		//! Fills samples with the next count ECG readings, as nextECG() does.
+		void fillECG(uint16_t * samples, size_t count);
+	#endif
+
+		//! Returns the raw value of channel, readChannel() without the probe.
+		uint16_t channelValue(uint8_t channel);
+
+		//! Fills column with count consecutive raw values of channel.
+		void readColumn(uint8_t channel, uint16_t * column, size_t count);
+
+		//! Reads channel from the replay source. False when not replaying it.
+		bool replayed(uint8_t channel, uint16_t & value);
 
 	//***************************************************************
 	// Private Variables											*
 	//***************************************************************
 
+	#if EHEALTH_USE_BLOOD_PRESSURE
 		//! It stores the systolic pressure value
 		int systolic;
 
 		//! It stores the diastolic pressure value
 		int diastolic;
+	#endif
 
+	#if EHEALTH_USE_PULSIOXIMETER
 		//! It stores the  beats per minute value.
 		int BPM;
 
 		//! It stores blood oxigen saturation value.
 		int SPO2;
+	#endif
 
+	#if EHEALTH_USE_POSITION
 		//! It stores current body position.
 		uint8_t bodyPos;
 
-		//! x/y/z accel register data store here.
-		byte data[6];
-
-		//! Stores the 12-bit signed value.
-		int accelCount[3];
+		//! Stores the 12-bit signed value of the latest sample.
+		int16_t accelCount[3];
 
 		//! Stores the real accel value in g's.
 		float accel[3];
-
-		//! Stores the body position in vector value.
-		uint8_t position[];
-
-		//!It stores the number of data of the glucometer.
-		uint8_t length;
+	#endif
+
+		//! Built-in histories, and the ones in use instead when set.
+	#if EHEALTH_USE_GLUCOMETER
+		eHealthHistoryN<EHEALTH_HISTORY_CAPACITY, 2> ownGlucose;
+		eHealthHistory * glucoseStore;
+	#endif
+	#if EHEALTH_USE_BLOOD_PRESSURE
+		eHealthHistoryN<EHEALTH_HISTORY_CAPACITY, 4> ownPressure;
+		eHealthHistory * pressureStore;
+	#endif
+
+	#if EHEALTH_USE_GSR
+		//! Random stream of the GSR readings.
+		eHealthRandom rng;
+	#endif
+
+		//! Numbers the frames sent by writeFrame().
+		eHealthFrameEncoder frameEncoder;
+
+		//! Where printPosition(), airFlowWave() and writeFrame() write.
+		eHealthOutput * out;
+
+		//! Replay source of the getters, NULL for synthesized readings.
+		eHealthSource * source;
+
+		//! Ring filled by acquire(), and the channels it reads.
+		eHealthSampleRing * ring;
+		uint16_t ringChannels;
 };
 
-extern eHealthClassMock eHealthMock;
+extern eHealthClassMock eHealth;
 
 #endif
 
@@ -0,0 +1,278 @@
+/*
+*=========================================================================================
+ *  Buffered output of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthOutput.h"
+
+
+//***************************************************************
+// Sinks														*
+//***************************************************************
+
+	size_t eHealthSerialSink::write(const uint8_t * data, size_t length)
+	{
+		return Serial.write(data, length);
+	}
+
+	// At namespace scope: the library is built with -fno-threadsafe-statics
+	// and host threads construct mocks, hence call eHealthSerialOutput(), at
+	// the same time. Taking its address before it is constructed is fine.
+	static eHealthSerialSink serialSink;
+	static eHealthOutput serialOutput(serialSink);
+
+	eHealthOutput & eHealthSerialOutput(void)
+	{
+		return serialOutput;
+	}
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	eHealthOutput::eHealthOutput(eHealthSink & output)
+		: sink(&output), filled(0), partial(false), rateLimit(0), credit(0), refilledAt(0),
+		  written(0), recordCount(0), droppedCount(0)
+	{
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	void eHealthOutput::setSink(eHealthSink & output)
+	{
+		if (filled) {
+			endRecord();
+		}
+		sink = &output;
+	}
+
+	void eHealthOutput::write(const uint8_t * data, size_t length)
+	{
+		while (length) {
+			if (filled == sizeof(buffer)) {
+				drain();
+			}
+			size_t n = sizeof(buffer) - filled;
+			if (n > length) {
+				n = length;
+			}
+			memcpy(buffer + filled, data, n);
+			filled += n;
+			data += n;
+			length -= n;
+		}
+	}
+
+	void eHealthOutput::write(uint8_t c)
+	{
+		if (filled == sizeof(buffer)) {
+			drain();
+		}
+		buffer[filled++] = c;
+	}
+
+	void eHealthOutput::print(const char * text)
+	{
+		write((const uint8_t *)text, strlen(text));
+	}
+
+	void eHealthOutput::print(const __FlashStringHelper * text)
+	{
+		const char * p = (const char *)text;
+
+		for (char c = pgm_read_byte(p); c; c = pgm_read_byte(++p)) {
+			write((uint8_t)c);
+		}
+	}
+
+	void eHealthOutput::print(char c)
+	{
+		write((uint8_t)c);
+	}
+
+	void eHealthOutput::print(long value, int base)
+	{
+		// Serial prints negative numbers in base 10 only.
+		if (value < 0 && base == DEC) {
+			write('-');
+			print((unsigned long)-(value + 1) + 1, base);
+		} else {
+			print((unsigned long)value, base);
+		}
+	}
+
+	void eHealthOutput::print(unsigned long value, int base)
+	{
+		char digits[8 * sizeof(unsigned long)];
+		uint8_t n = 0;
+
+		if (base < 2) {
+			base = DEC;
+		}
+		do {
+			uint8_t digit = value % base;
+			digits[n++] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+			value /= base;
+		} while (value);
+
+		while (n) {
+			write((uint8_t)digits[--n]);
+		}
+	}
+
+	void eHealthOutput::print(double value, int digits)
+	{
+		// Same rounding as Print::printFloat() of the Arduino core.
+		if (value != value) {
+			print("nan");
+			return;
+		}
+		if (value < 0) {
+			write('-');
+			value = -value;
+		}
+
+		double rounding = 0.5;
+		for (int i = 0; i < digits; i++) {
+			rounding /= 10.0;
+		}
+		value += rounding;
+
+		unsigned long integer = (unsigned long)value;
+		double remainder = value - (double)integer;
+		print(integer);
+
+		if (digits > 0) {
+			write('.');
+		}
+		while (digits-- > 0) {
+			remainder *= 10.0;
+			uint8_t digit = (uint8_t)remainder;
+			write((uint8_t)('0' + digit));
+			remainder -= digit;
+		}
+	}
+
+	void eHealthOutput::println(void)
+	{
+		write('\r');
+		write('\n');
+	}
+
+	void eHealthOutput::println(const char * text)
+	{
+		print(text);
+		println();
+	}
+
+	void eHealthOutput::println(const __FlashStringHelper * text)
+	{
+		print(text);
+		println();
+	}
+
+	void eHealthOutput::repeat(const char * text, int count)
+	{
+		size_t length = strlen(text);
+
+		for (int i = 0; i < count; i++) {
+			write((const uint8_t *)text, length);
+		}
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	endRecord()														*
+	//!		Description: Ends the current record and writes it to the sink.			*
+	//!		Param : void															*
+	//!		Returns: bool, false if the rate limit dropped the record				*
+	//!		Example: out.print(bpm); out.println(); out.endRecord();				*
+	//!******************************************************************************
+
+	bool eHealthOutput::endRecord(void)
+	{
+		bool sent = true;
+
+		if (rateLimit && !partial) {
+			refill();
+			if (credit < (uint64_t)filled * 1000000UL) {
+				filled = 0;
+				sent = false;
+			}
+		}
+
+		if (sent) {
+			drain();
+			recordCount++;
+		} else {
+			droppedCount++;
+		}
+		partial = false;
+		return sent;
+	}
+
+	void eHealthOutput::setRateLimit(uint32_t bytesPerSecond)
+	{
+		// Start with a full burst of credit.
+		rateLimit = bytesPerSecond;
+		credit = burst();
+		refilledAt = (uint32_t)micros();
+	}
+
+
+//***************************************************************
+// Private Methods												*
+//***************************************************************
+
+	void eHealthOutput::drain(void)
+	{
+		if (!filled) {
+			return;
+		}
+		if (rateLimit) {
+			refill();
+			uint64_t cost = (uint64_t)filled * 1000000UL;
+			credit = credit > cost ? credit - cost : 0;
+		}
+
+		written += sink->write(buffer, filled);
+		filled = 0;
+		partial = true;
+	}
+
+/*******************************************************************************************************/
+
+	void eHealthOutput::refill(void)
+	{
+		uint32_t now = (uint32_t)micros();
+
+		// Capping the elapsed time keeps the product in range.
+		uint32_t elapsed = now - refilledAt;
+		if (elapsed > 1000000UL) {
+			elapsed = 1000000UL;
+		}
+		refilledAt = now;
+
+		credit += (uint64_t)elapsed * rateLimit;
+		if (credit > burst()) {
+			credit = burst();
+		}
+	}
+
+/*******************************************************************************************************/
+
+	uint64_t eHealthOutput::burst(void) const
+	{
+		return ((uint64_t)rateLimit / 10 + EHEALTH_OUTPUT_BUFFER) * 1000000UL;
+	}
+
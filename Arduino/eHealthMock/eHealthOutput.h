@@ -0,0 +1,158 @@
+/*
+*=========================================================================================
+ *  Buffered output of the eHealth Mock.
+ *
+ *  The text and binary emitters of the library format each record (a line,
+ *  a frame) into a fixed buffer and hand it to a sink in one write when the
+ *  record ends, instead of issuing one Serial call per fragment. The output
+ *  counts what it sends and can cap the byte rate: a record that would
+ *  exceed the cap is dropped whole, never cut.
+ *
+ *  Sinks are pluggable. eHealthSerialSink writes to Serial; the host build
+ *  adds stdout, file, pipe and Unix socket sinks (host/eHealthSinks.h).
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthOutput_h
+#define eHealthOutput_h
+
+#include "Arduino.h"
+
+	//! Bytes an output buffers before a record is written in pieces.
+	#if defined(__AVR__)
+		#define EHEALTH_OUTPUT_BUFFER 64
+	#else
+		#define EHEALTH_OUTPUT_BUFFER 512
+	#endif
+
+
+//***************************************************************
+// Sinks														*
+//***************************************************************
+
+	//! Destination of an eHealthOutput.
+	class eHealthSink {
+
+		public:
+
+			//! Writes length bytes. Returns the number of bytes accepted.
+			virtual size_t write(const uint8_t * data, size_t length) = 0;
+
+		protected:
+
+			//! Sinks are not deleted through this interface.
+			~eHealthSink() {}
+	};
+
+	//! Sink writing to Serial.
+	class eHealthSerialSink : public eHealthSink {
+
+		public:
+
+			size_t write(const uint8_t * data, size_t length);
+	};
+
+
+//***************************************************************
+// Output														*
+//***************************************************************
+
+// Library interface description
+class eHealthOutput {
+
+	public:
+
+		//! Creates an output writing to sink.
+		explicit eHealthOutput(eHealthSink & sink);
+
+		//! Changes the sink. Any pending record is written to the old one first.
+		void setSink(eHealthSink & sink);
+
+		//! Appends raw bytes to the current record.
+		void write(const uint8_t * data, size_t length);
+
+		//! Appends one byte to the current record.
+		void write(uint8_t c);
+
+		//! Appends text to the current record. Text marked with F() is read
+		//! from program memory.
+		void print(const char * text);
+		void print(const __FlashStringHelper * text);
+		void print(char c);
+		void print(long value, int base = DEC);
+		void print(unsigned long value, int base = DEC);
+		void print(int value, int base = DEC) { print((long)value, base); }
+		void print(unsigned int value, int base = DEC) { print((unsigned long)value, base); }
+		void print(double value, int digits = 2);
+
+		//! Appends "\r\n", the line ending of Serial.println().
+		void println(void);
+
+		//! Appends text followed by "\r\n".
+		void println(const char * text);
+		void println(const __FlashStringHelper * text);
+
+		//! Appends text count times.
+		void repeat(const char * text, int count);
+
+		//! Ends the current record and writes it to the sink.
+		/*!
+		\param void
+		\return bool : false if the record was dropped by the rate limit.
+		*/	bool endRecord(void);
+
+		//! Caps the output rate. Records over the cap are dropped whole.
+		/*!
+		 *  Allows bursts of up to a tenth of a second plus one buffer.
+		\param uint32_t bytesPerSecond : the cap, 0 for none.
+		\return void
+		*/	void setRateLimit(uint32_t bytesPerSecond);
+
+		//! Returns the bytes handed to the sink.
+		uint32_t bytesWritten(void) const { return written; }
+
+		//! Returns the records written.
+		uint32_t records(void) const { return recordCount; }
+
+		//! Returns the records dropped by the rate limit.
+		uint32_t droppedRecords(void) const { return droppedCount; }
+
+	private:
+
+		//! Writes the buffered bytes of the current record.
+		void drain(void);
+
+		//! Adds the credit earned since the last record.
+		void refill(void);
+
+		//! Largest credit, in bytes * 1000000.
+		uint64_t burst(void) const;
+
+		eHealthSink * sink;
+
+		uint8_t buffer[EHEALTH_OUTPUT_BUFFER];
+		size_t filled;
+
+		//! Part of the current record already written: it can no longer be dropped.
+		bool partial;
+
+		//! Rate limit in bytes per second, and the credit in bytes * 1000000.
+		uint32_t rateLimit;
+		uint64_t credit;
+		uint32_t refilledAt;
+
+		uint32_t written;
+		uint32_t recordCount;
+		uint32_t droppedCount;
+};
+
+	//! Returns the output the library writes to by default, buffered to Serial.
+	eHealthOutput & eHealthSerialOutput(void);
+
+#endif
@@ -0,0 +1,209 @@
+/*
+*=========================================================================================
+ *  Body position classifier of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthPosition.h"
+
+	//! Samples the block path classifies per pass, bounded by the stack.
+	#if defined(__AVR__)
+		#define POSITION_CHUNK 8
+	#else
+		#define POSITION_CHUNK 64
+	#endif
+
+	//! Position entered by, and cones holding, one sample. A vector is within
+	//! 35 degrees of an axis when 3 a^2 >= 2 |v|^2 (cos^2 = 2/3), and within 60
+	//! degrees when 4 a^2 >= |v|^2 (cos^2 = 1/4). Only one axis can pass the
+	//! first test, and none does for a zero vector.
+	static inline void candidates(int32_t x, int32_t y, int32_t z, uint8_t & enter, uint8_t & hold)
+	{
+		int32_t xx = x * x;
+		int32_t yy = y * y;
+		int32_t zz = z * z;
+		int32_t m = xx + yy + zz;
+
+		// Bitwise rather than logical operators keep the kernel loop free of
+		// branches.
+		int nearX = 3 * xx >= 2 * m;
+		int nearY = 3 * yy >= 2 * m;
+		int nearZ = 3 * zz >= 2 * m;
+		int coneX = 4 * xx >= m;
+		int coneY = 4 * yy >= m;
+		int coneZ = 4 * zz >= m;
+		int xPositive = x > 0, xNegative = x < 0;
+		int yPositive = y > 0, yNegative = y < 0;
+		int zPositive = z > 0, zNegative = z < 0;
+
+		enter = (uint8_t)(
+			(nearZ & zPositive) * EHEALTH_SUPINE |
+			(nearY & yNegative) * EHEALTH_LEFT_LATERAL |
+			(nearY & yPositive) * EHEALTH_RIGHT_LATERAL |
+			(nearZ & zNegative) * EHEALTH_PRONE |
+			(nearX & xPositive) * EHEALTH_STANDING |
+			(nearX & xNegative) * EHEALTH_UNDEFINED_POSITION);
+
+		hold = (uint8_t)(
+			(coneZ & zPositive) << EHEALTH_SUPINE |
+			(coneY & yNegative) << EHEALTH_LEFT_LATERAL |
+			(coneY & yPositive) << EHEALTH_RIGHT_LATERAL |
+			(coneZ & zNegative) << EHEALTH_PRONE |
+			(coneX & xPositive) << EHEALTH_STANDING |
+			(coneX & xNegative) << EHEALTH_UNDEFINED_POSITION);
+	}
+
+
+//***************************************************************
+// Kernels														*
+//***************************************************************
+
+	void eHealthAccelUnpack(const uint8_t * __restrict__ registers, int16_t * __restrict__ counts, size_t count)
+	{
+		for (size_t i = 0; i < 3 * count; i++) {
+			counts[i] = (int16_t)((uint16_t)registers[2 * i] << 8 | registers[2 * i + 1]) >> 4;
+		}
+	}
+
+	void eHealthAccelToG(const int16_t * __restrict__ counts, float * __restrict__ accel, size_t count, uint8_t scale)
+	{
+		// 2048 counts span the full scale range.
+		float gPerCount = (float)scale / 2048.0f;
+
+		for (size_t i = 0; i < count; i++) {
+			accel[i] = counts[i] * gPerCount;
+		}
+	}
+
+	void eHealthPositionCandidates(const int16_t * __restrict__ x, const int16_t * __restrict__ y,
+		const int16_t * __restrict__ z, uint8_t * __restrict__ enter, uint8_t * __restrict__ hold, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			candidates(x[i], y[i], z[i], enter[i], hold[i]);
+		}
+	}
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	//! Function that handles the creation and setup of instances
+	eHealthPositionClassifier::eHealthPositionClassifier(void)
+	{
+		debounce = EHEALTH_POSITION_DEBOUNCE;
+		reset();
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	//!******************************************************************************
+	//!		Name:	reset()															*
+	//!		Description: Returns to the non-defined position.						*
+	//!		Param : void															*
+	//!		Returns: void															*
+	//!		Example: classifier.reset();											*
+	//!******************************************************************************
+
+	void eHealthPositionClassifier::reset(void)
+	{
+		current = EHEALTH_UNDEFINED_POSITION;
+		candidate = 0;
+		run = 0;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	update()														*
+	//!		Description: Classifies one accelerometer sample.						*
+	//!		Param : int16_t x, y, z: counts of each axis.							*
+	//!		Returns: uint8_t with the body position.								*
+	//!		Example: uint8_t position = classifier.update(x, y, z);				*
+	//!******************************************************************************
+
+	uint8_t eHealthPositionClassifier::update(int16_t x, int16_t y, int16_t z)
+	{
+		uint8_t enter;
+		uint8_t hold;
+
+		candidates(x, y, z, enter, hold);
+		return step(enter, hold);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	classify()														*
+	//!		Description: Classifies a block of accelerometer samples.				*
+	//!		Param : const int16_t * counts, size_t count, uint8_t * positions		*
+	//!		Returns: uint8_t with the body position after the last sample.			*
+	//!		Example: classifier.classify(counts, 32, positions);					*
+	//!******************************************************************************
+
+	uint8_t eHealthPositionClassifier::classify(const int16_t * counts, size_t count, uint8_t * positions)
+	{
+		int16_t x[POSITION_CHUNK];
+		int16_t y[POSITION_CHUNK];
+		int16_t z[POSITION_CHUNK];
+		uint8_t enter[POSITION_CHUNK];
+		uint8_t hold[POSITION_CHUNK];
+
+		while (count) {
+			size_t n = count < POSITION_CHUNK ? count : POSITION_CHUNK;
+
+			// Split the axes so the candidates kernel reads unit strides.
+			for (size_t i = 0; i < n; i++) {
+				x[i] = counts[3 * i];
+				y[i] = counts[3 * i + 1];
+				z[i] = counts[3 * i + 2];
+			}
+			eHealthPositionCandidates(x, y, z, enter, hold, n);
+
+			for (size_t i = 0; i < n; i++) {
+				uint8_t position = step(enter[i], hold[i]);
+				if (positions) {
+					*positions++ = position;
+				}
+			}
+
+			counts += 3 * n;
+			count -= n;
+		}
+		return current;
+	}
+
+
+//***************************************************************
+// Private Methods												*
+//***************************************************************
+
+	//! Keeps the current position while the sample is in its cone. Otherwise a
+	//! position the sample enters becomes the candidate, and is reported once
+	//! debounce consecutive samples entered it. A sample that enters no position
+	//! restarts the count.
+
+	uint8_t eHealthPositionClassifier::step(uint8_t enter, uint8_t hold)
+	{
+		if (hold & (1 << current)) {
+			run = 0;
+		} else if (enter) {
+			if (enter != candidate) {
+				candidate = enter;
+				run = 0;
+			}
+			if (++run >= debounce) {
+				current = candidate;
+				run = 0;
+			}
+		} else {
+			run = 0;
+		}
+		return current;
+	}
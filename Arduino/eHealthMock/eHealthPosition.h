@@ -0,0 +1,121 @@
+/*
+*=========================================================================================
+ *  Body position classifier of the eHealth Mock.
+ *
+ *  Maps the gravity vector the accelerometer sees to the positions returned
+ *  by getBodyPosition(). The sensor sits on the chest with x toward the head,
+ *  y toward the patient's left and z out of the chest:
+ *
+ *		1 == Supine position.			gravity along +z
+ *		2 == Left lateral decubitus.	gravity along -y
+ *		3 == Rigth lateral decubitus.	gravity along +y
+ *		4 == Prone position.			gravity along -z
+ *		5 == Stand or sit position		gravity along +x
+ *		6 == non-defined position		head down, or nothing decided yet
+ *
+ *  A sample enters a position when its vector is within 35 degrees of that
+ *  position's axis, and the position is kept until the vector leaves the 60
+ *  degree cone around it. A new position must also hold for a number of
+ *  consecutive samples (setDebounce()) before it is reported, so breathing
+ *  and noise do not make the output flicker. Only squared integer counts are
+ *  compared, so the classifier does not depend on the full scale range.
+ *
+ *  The block path splits the work in two: a branch free kernel computes, for
+ *  every sample, the position it enters and the cones it is in (the host
+ *  compiler vectorizes it), then a short scan over those bytes applies the
+ *  hysteresis.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthPosition_h
+#define eHealthPosition_h
+
+#include "Arduino.h"
+
+	//! Values returned by getBodyPosition().
+	enum eHealthBodyPosition {
+		EHEALTH_SUPINE = 1,
+		EHEALTH_LEFT_LATERAL = 2,
+		EHEALTH_RIGHT_LATERAL = 3,
+		EHEALTH_PRONE = 4,
+		EHEALTH_STANDING = 5,
+		EHEALTH_UNDEFINED_POSITION = 6
+	};
+
+	//! Consecutive samples a new position must hold before it is reported.
+	#ifndef EHEALTH_POSITION_DEBOUNCE
+		#define EHEALTH_POSITION_DEBOUNCE 3
+	#endif
+
+	//! Converts count samples of left-justified 12-bit MSB/LSB register
+	//! pairs, as a burst read of OUT_X_MSB returns them, to signed counts.
+	/*!
+	\param const uint8_t * registers : 6 * count bytes.
+	\param int16_t * counts : 3 * count counts, x, y, z of each sample.
+	\param size_t count : samples.
+	\return void
+	*/	void eHealthAccelUnpack(const uint8_t * __restrict__ registers, int16_t * __restrict__ counts, size_t count);
+
+	//! Converts count values of 12-bit counts to g at full scale range scale (2, 4 or 8).
+	void eHealthAccelToG(const int16_t * __restrict__ counts, float * __restrict__ accel, size_t count, uint8_t scale);
+
+	//! Computes, for count samples, the position each one enters (0 for none)
+	//! and the bitmap of the positions whose cone it is in (bit 1 << position).
+	/*!
+	\param const int16_t * x, y, z : count counts of each axis.
+	\param uint8_t * enter : count positions entered.
+	\param uint8_t * hold : count bitmaps of positions kept.
+	\param size_t count : samples.
+	\return void
+	*/	void eHealthPositionCandidates(const int16_t * __restrict__ x, const int16_t * __restrict__ y,
+			const int16_t * __restrict__ z, uint8_t * __restrict__ enter, uint8_t * __restrict__ hold, size_t count);
+
+// Library interface description
+class eHealthPositionClassifier {
+
+	public:
+
+		//! Class constructor. Starts in the non-defined position.
+		eHealthPositionClassifier(void);
+
+		//! Returns to the non-defined position and forgets any pending change.
+		void reset(void);
+
+		//! Sets the consecutive samples a new position must hold. 0 acts as 1.
+		void setDebounce(uint8_t samples) { debounce = samples ? samples : 1; }
+
+		//! Returns the position reported last.
+		uint8_t position(void) const { return current; }
+
+		//! Classifies one sample.
+		/*!
+		\param int16_t x, y, z : accelerometer counts, any full scale range.
+		\return uint8_t : the body position after this sample.
+		*/	uint8_t update(int16_t x, int16_t y, int16_t z);
+
+		//! Classifies count samples in one call.
+		/*!
+		\param const int16_t * counts : 3 * count counts, x, y, z of each sample.
+		\param size_t count : samples.
+		\param uint8_t * positions : the position after each sample, or NULL.
+		\return uint8_t : the body position after the last sample.
+		*/	uint8_t classify(const int16_t * counts, size_t count, uint8_t * positions);
+
+	private:
+
+		//! Applies the hysteresis to one sample's candidates.
+		uint8_t step(uint8_t enter, uint8_t hold);
+
+		uint8_t current;
+		uint8_t candidate;
+		uint8_t run;
+		uint8_t debounce;
+};
+
+#endif
@@ -0,0 +1,180 @@
+/*
+*=========================================================================================
+ *  Hot-path instrumentation of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthProfile.h"
+
+#if defined(EHEALTH_PROFILE)
+
+#if defined(__AVR__)
+	#include <util/atomic.h>
+#endif
+
+
+//***************************************************************
+// Statistics													*
+//***************************************************************
+
+	//! Per thread on the host, like the simulated clock.
+	#if defined(__AVR__)
+		static eHealthProbeStats probes[EHEALTH_PROBE_COUNT];
+	#else
+		static thread_local eHealthProbeStats probes[EHEALTH_PROBE_COUNT];
+	#endif
+
+	//! Probe names, in enum order, separated by '\0'.
+	static const char probeNames[] PROGMEM =
+		"initPositionSensor\0"
+		"readBloodPressureSensor\0"
+		"initPulsioximeter\0"
+		"getTemperature\0"
+		"getOxygenSaturation\0"
+		"getBPM\0"
+		"getSkinConductance\0"
+		"getSkinResistance\0"
+		"getSkinConductanceVoltage\0"
+		"getECG\0"
+		"getEMG\0"
+		"getBodyPosition\0"
+		"getSystolicPressure\0"
+		"getDiastolicPressure\0"
+		"getAirFlow\0"
+		"printPosition\0"
+		"readPulsioximeter\0"
+		"airFlowWave\0"
+		"readGlucometer\0"
+		"getGlucometerLength\0"
+		"getBloodPressureLength\0"
+		"numberToMonth\0"
+		"seed\0"
+		"seek\0"
+		"getECGBlock\0"
+		"getEMGBlock\0"
+		"getSkinConductanceVoltageBlock\0"
+		"getAirFlowBlock\0"
+		"getGSRBlock\0"
+		"getBodyPositionBlock\0"
+		"readChannel\0"
+		"writeFrame\0"
+		"acquire\0"
+		"getGlucoseRecord\0"
+		"getBloodPressureRecord\0"
+		"numberToMonthBuffer\0"
+		"formatGlucoseRecord\0"
+		"formatBloodPressureRecord\0"
+		"getTemperatureCentidegrees\0"
+		"getSkinConductanceHundredths\0"
+		"getSkinResistanceOhms\0"
+		"getSkinConductanceMillivolts\0"
+		"getECGMillivolts\0"
+		"getEMGMillivolts\0"
+		"getECGMillivoltsBlock\0"
+		"getEMGMillivoltsBlock\0"
+		"sampleAll\0"
+		"sampleAllBlock\0"
+		"getRRInterval";
+
+	//! Returns the histogram bucket of a latency.
+	static uint8_t bucketOf(uint32_t elapsed)
+	{
+		uint8_t bucket = 0;
+		while (elapsed && bucket < EHEALTH_PROFILE_BUCKETS - 1) {
+			elapsed >>= 1;
+			bucket++;
+		}
+		return bucket;
+	}
+
+	void eHealthProfileRecord(uint8_t probe, uint32_t elapsed)
+	{
+		if (probe >= EHEALTH_PROBE_COUNT) {
+			return;
+		}
+		uint8_t bucket = bucketOf(elapsed);
+
+		// acquire() is profiled from the timer interrupt too.
+		#if defined(__AVR__)
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		#endif
+		{
+			eHealthProbeStats & stats = probes[probe];
+
+			stats.calls++;
+			stats.totalMicros += elapsed;
+			if (elapsed > stats.maxMicros) {
+				stats.maxMicros = elapsed;
+			}
+			if (stats.buckets[bucket] != (eHealthProfileCount)-1) {
+				stats.buckets[bucket]++;
+			}
+		}
+	}
+
+	const eHealthProbeStats & eHealthProfileStats(uint8_t probe)
+	{
+		return probes[probe < EHEALTH_PROBE_COUNT ? probe : 0];
+	}
+
+	void eHealthProfileReset(void)
+	{
+		memset(probes, 0, sizeof(probes));
+	}
+
+
+//***************************************************************
+// Dump															*
+//***************************************************************
+
+	//! Writes the name of probe, read from program memory.
+	static void printName(eHealthOutput & output, uint8_t probe)
+	{
+		const char * name = probeNames;
+
+		while (probe) {
+			if (!pgm_read_byte(name++)) {
+				probe--;
+			}
+		}
+		for (char c = pgm_read_byte(name); c; c = pgm_read_byte(++name)) {
+			output.print(c);
+		}
+	}
+
+	void eHealthProfilePrint(eHealthOutput & output)
+	{
+		output.print("# probe calls totalMicros maxMicros buckets(<1us, 1us, 2-3us ... >=");
+		output.print(1UL << (EHEALTH_PROFILE_BUCKETS - 2));
+		output.print("us)");
+		output.println();
+		output.endRecord();
+
+		for (uint8_t probe = 0; probe < EHEALTH_PROBE_COUNT; probe++) {
+			const eHealthProbeStats & stats = probes[probe];
+			if (!stats.calls) {
+				continue;
+			}
+
+			printName(output, probe);
+			output.print(' ');
+			output.print(stats.calls);
+			output.print(' ');
+			output.print(stats.totalMicros);
+			output.print(' ');
+			output.print(stats.maxMicros);
+			for (uint8_t bucket = 0; bucket < EHEALTH_PROFILE_BUCKETS; bucket++) {
+				output.print(' ');
+				output.print((unsigned long)stats.buckets[bucket]);
+			}
+			output.println();
+			output.endRecord();
+		}
+	}
+
+#endif
@@ -0,0 +1,167 @@
+/*
+*=========================================================================================
+ *  Hot-path instrumentation of the eHealth Mock.
+ *
+ *  Built with EHEALTH_PROFILE defined (-DEHEALTH_PROFILE, or the CMake option
+ *  of the same name), every public method of eHealthClassMock counts its
+ *  calls, the time spent in it and a histogram of its latencies.
+ *  eHealthClassMock::printProfile() dumps them to the output. Without the
+ *  macro EHEALTH_PROBE() expands to nothing and the library is unchanged.
+ *
+ *  Times come from EHEALTH_PROFILE_CLOCK(), micros() by default. On the board
+ *  that is wall time. On the host it is the simulated clock, so it shows the
+ *  delay() calls and Serial stalls of a method and nothing else; define
+ *  EHEALTH_PROFILE_CLOCK=hostSteadyMicros to measure CPU time instead.
+ *
+ *  Times are inclusive: getSkinResistance() includes the
+ *  getSkinConductance() it calls, which is profiled on its own as well.
+ *
+ *  The statistics of all probes take about 1.5 KB of RAM, which suits a
+ *  Mega but not an Uno; lower EHEALTH_PROFILE_BUCKETS to save space. On the
+ *  host they are kept per thread, like the simulated clock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthProfile_h
+#define eHealthProfile_h
+
+#include "Arduino.h"
+
+#if defined(EHEALTH_PROFILE)
+
+#include "eHealthOutput.h"
+
+	//! Clock the probes read, in microseconds.
+	#ifndef EHEALTH_PROFILE_CLOCK
+		#define EHEALTH_PROFILE_CLOCK micros
+	#endif
+
+	//! Latency buckets per probe. Bucket 0 counts calls under 1 us, bucket b
+	//! calls of 2^(b-1) to 2^b - 1 us, and the last one everything longer.
+	#ifndef EHEALTH_PROFILE_BUCKETS
+		#define EHEALTH_PROFILE_BUCKETS 16
+	#endif
+
+	//! Instrumented methods, in the order of eHealthMock.h.
+	enum eHealthProbe {
+		EHEALTH_PROBE_INIT_POSITION_SENSOR = 0,
+		EHEALTH_PROBE_READ_BLOOD_PRESSURE_SENSOR,
+		EHEALTH_PROBE_INIT_PULSIOXIMETER,
+		EHEALTH_PROBE_GET_TEMPERATURE,
+		EHEALTH_PROBE_GET_OXYGEN_SATURATION,
+		EHEALTH_PROBE_GET_BPM,
+		EHEALTH_PROBE_GET_SKIN_CONDUCTANCE,
+		EHEALTH_PROBE_GET_SKIN_RESISTANCE,
+		EHEALTH_PROBE_GET_SKIN_CONDUCTANCE_VOLTAGE,
+		EHEALTH_PROBE_GET_ECG,
+		EHEALTH_PROBE_GET_EMG,
+		EHEALTH_PROBE_GET_BODY_POSITION,
+		EHEALTH_PROBE_GET_SYSTOLIC_PRESSURE,
+		EHEALTH_PROBE_GET_DIASTOLIC_PRESSURE,
+		EHEALTH_PROBE_GET_AIR_FLOW,
+		EHEALTH_PROBE_PRINT_POSITION,
+		EHEALTH_PROBE_READ_PULSIOXIMETER,
+		EHEALTH_PROBE_AIR_FLOW_WAVE,
+		EHEALTH_PROBE_READ_GLUCOMETER,
+		EHEALTH_PROBE_GET_GLUCOMETER_LENGTH,
+		EHEALTH_PROBE_GET_BLOOD_PRESSURE_LENGTH,
+		EHEALTH_PROBE_NUMBER_TO_MONTH,
+		EHEALTH_PROBE_SEED,
+		EHEALTH_PROBE_SEEK,
+		EHEALTH_PROBE_GET_ECG_BLOCK,
+		EHEALTH_PROBE_GET_EMG_BLOCK,
+		EHEALTH_PROBE_GET_SKIN_CONDUCTANCE_VOLTAGE_BLOCK,
+		EHEALTH_PROBE_GET_AIR_FLOW_BLOCK,
+		EHEALTH_PROBE_GET_GSR_BLOCK,
+		EHEALTH_PROBE_GET_BODY_POSITION_BLOCK,
+		EHEALTH_PROBE_READ_CHANNEL,
+		EHEALTH_PROBE_WRITE_FRAME,
+		EHEALTH_PROBE_ACQUIRE,
+		EHEALTH_PROBE_GET_GLUCOSE_RECORD,
+		EHEALTH_PROBE_GET_BLOOD_PRESSURE_RECORD,
+		EHEALTH_PROBE_NUMBER_TO_MONTH_BUFFER,
+		EHEALTH_PROBE_FORMAT_GLUCOSE_RECORD,
+		EHEALTH_PROBE_FORMAT_BLOOD_PRESSURE_RECORD,
+		EHEALTH_PROBE_GET_TEMPERATURE_CENTIDEGREES,
+		EHEALTH_PROBE_GET_SKIN_CONDUCTANCE_HUNDREDTHS,
+		EHEALTH_PROBE_GET_SKIN_RESISTANCE_OHMS,
+		EHEALTH_PROBE_GET_SKIN_CONDUCTANCE_MILLIVOLTS,
+		EHEALTH_PROBE_GET_ECG_MILLIVOLTS,
+		EHEALTH_PROBE_GET_EMG_MILLIVOLTS,
+		EHEALTH_PROBE_GET_ECG_MILLIVOLTS_BLOCK,
+		EHEALTH_PROBE_GET_EMG_MILLIVOLTS_BLOCK,
+		EHEALTH_PROBE_SAMPLE_ALL,
+		EHEALTH_PROBE_SAMPLE_ALL_BLOCK,
+		EHEALTH_PROBE_GET_RR_INTERVAL,
+		EHEALTH_PROBE_COUNT
+	};
+
+	//! Histogram counts: saturating 16 bits on the board, 32 on the host.
+	#if defined(__AVR__)
+		typedef uint16_t eHealthProfileCount;
+	#else
+		typedef uint32_t eHealthProfileCount;
+	#endif
+
+	//! What one probe has recorded.
+	struct eHealthProbeStats {
+		uint32_t calls;
+		//! Sum of the latencies, in microseconds. Wraps after 71 minutes.
+		uint32_t totalMicros;
+		uint32_t maxMicros;
+		eHealthProfileCount buckets[EHEALTH_PROFILE_BUCKETS];
+	};
+
+	//! Adds one call of elapsed microseconds to probe.
+	void eHealthProfileRecord(uint8_t probe, uint32_t elapsed);
+
+	//! Returns what probe has recorded.
+	const eHealthProbeStats & eHealthProfileStats(uint8_t probe);
+
+	//! Clears every probe.
+	void eHealthProfileReset(void);
+
+	//! Writes one line per probe that was called, to output.
+	/*!
+	 *  Each line reads "name calls totalMicros maxMicros" followed by the
+	 *  EHEALTH_PROFILE_BUCKETS histogram counts, separated by spaces. A
+	 *  header line starting with '#' names the columns.
+	\param eHealthOutput & output : where to write.
+	\return void
+	*/	void eHealthProfilePrint(eHealthOutput & output);
+
+	//! Times the scope it is declared in.
+	class eHealthProbeScope {
+
+		public:
+
+			explicit eHealthProbeScope(uint8_t probe)
+				: probe(probe), started(EHEALTH_PROFILE_CLOCK()) {}
+
+			~eHealthProbeScope()
+			{
+				eHealthProfileRecord(probe, (uint32_t)(EHEALTH_PROFILE_CLOCK() - started));
+			}
+
+		private:
+
+			uint8_t probe;
+			unsigned long started;
+	};
+
+	//! Profiles the enclosing method as EHEALTH_PROBE_<name>.
+	#define EHEALTH_PROBE(name) eHealthProbeScope ehealthProbeScope(EHEALTH_PROBE_##name)
+
+#else
+
+	#define EHEALTH_PROBE(name)
+
+#endif
+
+#endif
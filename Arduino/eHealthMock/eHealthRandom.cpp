@@ -0,0 +1,94 @@
+/*
+*=========================================================================================
+ *  Counter based random generator of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthRandom.h"
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	eHealthRandom::eHealthRandom(uint32_t value)
+	{
+		seed(value);
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	//!******************************************************************************
+	//!		Name:	seed()															*
+	//!		Description: Selects the stream for seed and rewinds it.				*
+	//!		Param : uint32_t value													*
+	//!		Returns: void															*
+	//!		Example: rng.seed(42);													*
+	//!******************************************************************************
+
+	void eHealthRandom::seed(uint32_t value)
+	{
+		// Squares wants a key with an irregular bit pattern in both halves:
+		// spread the seed with the splitmix64 finalizer and keep the key odd.
+		uint64_t z = value + 0x9E3779B97F4A7C15ULL;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z ^= z >> 31;
+
+		key = z | 1;
+		counter = 0;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	at()															*
+	//!		Description: Returns draw index of the stream (Squares, four rounds).	*
+	//!		Param : uint64_t index													*
+	//!		Returns: uint32_t														*
+	//!		Example: uint32_t r = rng.at(1000000);									*
+	//!******************************************************************************
+
+	uint32_t eHealthRandom::at(uint64_t index) const
+	{
+		uint64_t x = index * key;
+		uint64_t y = x;
+		uint64_t z = y + key;
+
+		x = x * x + y;
+		x = (x >> 32) | (x << 32);
+		x = x * x + z;
+		x = (x >> 32) | (x << 32);
+		x = x * x + y;
+		x = (x >> 32) | (x << 32);
+
+		return (uint32_t)((x * x + z) >> 32);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	uniform()														*
+	//!		Description: Returns the next draw mapped to [low, high).				*
+	//!		Param : uint16_t low, uint16_t high										*
+	//!		Returns: uint16_t														*
+	//!		Example: uint16_t adc = rng.uniform(1, 1024);							*
+	//!******************************************************************************
+
+	uint16_t eHealthRandom::uniform(uint16_t low, uint16_t high)
+	{
+		if (low >= high) {
+			return low;
+		}
+
+		// Multiply-shift: one draw per value, no division.
+		uint32_t range = high - low;
+		return low + (uint16_t)(((uint64_t)next() * range) >> 32);
+	}
+
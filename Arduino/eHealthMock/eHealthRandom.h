@@ -0,0 +1,62 @@
+/*
+*=========================================================================================
+ *  Counter based random generator of the eHealth Mock.
+ *
+ *  Implements the "Squares" generator (B. Widynski, 2020): draw i of a stream
+ *  is a pure function of (key, i), four rounds of squaring of i * key. The
+ *  generator therefore keeps no state beyond its key and a counter, so it can
+ *  jump to any draw in O(1) and independent readers of the same stream can
+ *  each produce a disjoint slice without sharing anything.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthRandom_h
+#define eHealthRandom_h
+
+#include "Arduino.h"
+
+// Library interface description
+class eHealthRandom {
+
+	public:
+
+		//! Class constructor. The stream is fully determined by seed.
+		eHealthRandom(uint32_t seed = 1);
+
+		//! Selects the stream for seed and rewinds it to draw 0.
+		void seed(uint32_t seed);
+
+		//! Moves to draw index of the stream. O(1).
+		void seek(uint64_t index) { counter = index; }
+
+		//! Skips count draws. O(1).
+		void skip(uint64_t count) { counter += count; }
+
+		//! Returns the index of the next draw.
+		uint64_t position(void) const { return counter; }
+
+		//! Returns draw index of the stream without moving.
+		uint32_t at(uint64_t index) const;
+
+		//! Returns the next draw.
+		uint32_t next(void) { return at(counter++); }
+
+		//! Returns the next draw mapped to [low, high).
+		uint16_t uniform(uint16_t low, uint16_t high);
+
+	private:
+
+		//! Stream key, derived from the seed.
+		uint64_t key;
+
+		//! Index of the next draw.
+		uint64_t counter;
+};
+
+#endif
@@ -0,0 +1,102 @@
+/*
+*=========================================================================================
+ *  Single producer, single consumer ring of timestamped samples.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthSampleRing.h"
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	eHealthSampleRing::eHealthSampleRing(eHealthSample * storage, size_t capacity)
+		: slots(storage)
+	{
+		size_t slotCount = 1;
+
+		head = 0;
+		tail = 0;
+		overflowCount = 0;
+
+		if (capacity > EHEALTH_RING_MAX_CAPACITY) {
+			capacity = EHEALTH_RING_MAX_CAPACITY;
+		}
+		while (slotCount * 2 <= capacity) {
+			slotCount *= 2;
+		}
+		mask = (eHealthRingIndex)(slotCount - 1);
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	//!******************************************************************************
+	//!		Name:	popBlock()														*
+	//!		Description: Removes up to count of the oldest samples.					*
+	//!		Param : eHealthSample * samples, size_t count							*
+	//!		Returns: size_t with the number of samples removed						*
+	//!		Example: n = ring.popBlock(batch, 16);									*
+	//!******************************************************************************
+
+	size_t eHealthSampleRing::popBlock(eHealthSample * samples, size_t count)
+	{
+		eHealthRingIndex t = loadTail();
+		size_t available = (eHealthRingIndex)(loadHead() - t);
+
+		if (count > available) {
+			count = available;
+		}
+		for (size_t i = 0; i < count; i++) {
+			samples[i] = slots[(eHealthRingIndex)(t + i) & mask];
+		}
+		storeTail((eHealthRingIndex)(t + count));
+		return count;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	size()															*
+	//!		Description: Returns the number of samples waiting.						*
+	//!		Param : void															*
+	//!		Returns: size_t															*
+	//!		Example: if (ring.size() >= 16) { ... }									*
+	//!******************************************************************************
+
+	size_t eHealthSampleRing::size(void) const
+	{
+		eHealthRingIndex t = loadTail();
+		return (eHealthRingIndex)(loadHead() - t);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	overflows()														*
+	//!		Description: Returns the number of samples dropped on a full ring.		*
+	//!		Param : void															*
+	//!		Returns: uint32_t														*
+	//!		Example: Serial.println(ring.overflows());								*
+	//!******************************************************************************
+
+	uint32_t eHealthSampleRing::overflows(void) const
+	{
+	#if defined(__AVR__)
+		// Four bytes written by the ISR: read them with interrupts off.
+		uint32_t count;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			count = overflowCount;
+		}
+		return count;
+	#else
+		return overflowCount.load(std::memory_order_relaxed);
+	#endif
+	}
+
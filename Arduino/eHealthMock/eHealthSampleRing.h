@@ -0,0 +1,176 @@
+/*
+*=========================================================================================
+ *  Single producer, single consumer ring of timestamped samples.
+ *
+ *  Decouples timed acquisition from transmission: the producer (a timer ISR
+ *  on the board, a thread on the host) pushes samples, the transmit loop
+ *  drains them in batches, and a blocking serial write no longer delays the
+ *  next reading. Neither side locks. The indices run freely and are masked
+ *  on access, so the capacity is a power of two and every slot is usable.
+ *
+ *  On AVR the indices are single bytes, which the core reads and writes
+ *  atomically, so the capacity is at most 128. On the host they are atomics
+ *  with acquire/release ordering, each on its own cache line.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthSampleRing_h
+#define eHealthSampleRing_h
+
+#include "Arduino.h"
+
+#if defined(__AVR__)
+	#include <util/atomic.h>
+
+	typedef uint8_t eHealthRingIndex;
+	#define EHEALTH_RING_MAX_CAPACITY 128
+#else
+	#include <atomic>
+
+	typedef uint32_t eHealthRingIndex;
+	#define EHEALTH_RING_MAX_CAPACITY 0x80000000UL
+#endif
+
+	//! One reading of one channel.
+	struct eHealthSample {
+		//! micros() when the value was read.
+		uint32_t timestamp;
+		//! Raw value, as returned by eHealthClassMock::readChannel().
+		uint16_t value;
+		//! The eHealthChannel read.
+		uint8_t channel;
+	};
+
+// Library interface description
+class eHealthSampleRing {
+
+	public:
+
+		//! Creates a ring over caller owned storage.
+		/*!
+		\param eHealthSample * storage : slots of the ring.
+		\param size_t capacity : number of slots. Rounded down to a power of
+		 *  two and to EHEALTH_RING_MAX_CAPACITY.
+		*/	eHealthSampleRing(eHealthSample * storage, size_t capacity);
+
+		//! Appends a sample. Producer side only; safe to call from an ISR.
+		/*!
+		\param const eHealthSample & sample : the sample to append.
+		\return bool : false if the ring was full. The sample is dropped and
+		 *  counted in overflows().
+		*/	bool push(const eHealthSample & sample);
+
+		//! Removes the oldest sample. Consumer side only.
+		/*!
+		\param eHealthSample & sample : receives the sample.
+		\return bool : false if the ring was empty.
+		*/	bool pop(eHealthSample & sample);
+
+		//! Removes up to count of the oldest samples. Consumer side only.
+		/*!
+		 *  The consumer index is published once for the whole batch.
+		\param eHealthSample * samples : receives the samples, oldest first.
+		\param size_t count : room in samples.
+		\return size_t : number of samples removed.
+		*/	size_t popBlock(eHealthSample * samples, size_t count);
+
+		//! Returns the number of samples waiting. Exact on the consumer side.
+		size_t size(void) const;
+
+		//! Returns true when no sample is waiting.
+		bool empty(void) const { return size() == 0; }
+
+		//! Returns the number of slots.
+		size_t capacity(void) const { return (size_t)mask + 1; }
+
+		//! Returns the number of samples dropped because the ring was full.
+		uint32_t overflows(void) const;
+
+	private:
+
+	#if defined(__AVR__)
+		volatile eHealthRingIndex head;
+		volatile eHealthRingIndex tail;
+		volatile uint32_t overflowCount;
+
+		eHealthRingIndex loadHead(void) const { return head; }
+		eHealthRingIndex loadTail(void) const { return tail; }
+		void storeHead(eHealthRingIndex value) { __asm__ __volatile__("" ::: "memory"); head = value; }
+		void storeTail(eHealthRingIndex value) { __asm__ __volatile__("" ::: "memory"); tail = value; }
+	#else
+		//! Written by the producer.
+		alignas(64) std::atomic<eHealthRingIndex> head;
+		std::atomic<uint32_t> overflowCount;
+		//! Written by the consumer.
+		alignas(64) std::atomic<eHealthRingIndex> tail;
+
+		eHealthRingIndex loadHead(void) const { return head.load(std::memory_order_acquire); }
+		eHealthRingIndex loadTail(void) const { return tail.load(std::memory_order_acquire); }
+		void storeHead(eHealthRingIndex value) { head.store(value, std::memory_order_release); }
+		void storeTail(eHealthRingIndex value) { tail.store(value, std::memory_order_release); }
+	#endif
+
+		eHealthSample * slots;
+		eHealthRingIndex mask;
+};
+
+
+	//! A ring that owns its storage of N slots, N a power of two.
+	template <size_t N>
+	class eHealthSampleRingN : public eHealthSampleRing {
+
+		public:
+
+			eHealthSampleRingN(void) : eHealthSampleRing(storage, N)
+			{
+				static_assert(N && (N & (N - 1)) == 0, "ring capacity must be a power of two");
+				static_assert(N <= EHEALTH_RING_MAX_CAPACITY, "ring capacity too large for this target");
+			}
+
+		private:
+
+			eHealthSample storage[N];
+	};
+
+
+//***************************************************************
+// Inline Methods												*
+//***************************************************************
+
+	inline bool eHealthSampleRing::push(const eHealthSample & sample)
+	{
+		eHealthRingIndex h = loadHead();
+
+		// The consumer only frees slots, so a stale tail is never unsafe.
+		if ((eHealthRingIndex)(h - loadTail()) > mask) {
+		#if defined(__AVR__)
+			overflowCount = overflowCount + 1;
+		#else
+			overflowCount.store(overflowCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		#endif
+			return false;
+		}
+		slots[h & mask] = sample;
+		storeHead(h + 1);
+		return true;
+	}
+
+	inline bool eHealthSampleRing::pop(eHealthSample & sample)
+	{
+		eHealthRingIndex t = loadTail();
+
+		if (t == loadHead()) {
+			return false;
+		}
+		sample = slots[t & mask];
+		storeTail(t + 1);
+		return true;
+	}
+
+#endif
@@ -0,0 +1,201 @@
+/*
+*=========================================================================================
+ *  Cooperative multi-rate acquisition scheduler of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthScheduler.h"
+
+
+	//! True when time a is at or after time b, across a micros() wrap.
+	static inline bool reached(uint32_t a, uint32_t b)
+	{
+		return (int32_t)(a - b) >= 0;
+	}
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	eHealthScheduler::eHealthScheduler(eHealthClassMock & source, eHealthSampleHandler handler, void * context)
+		: mock(source), sink(handler), sinkContext(context), enabled(0), earliest(0)
+	{
+		memset(tasks, 0, sizeof(tasks));
+		memset(filters, 0, sizeof(filters));
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	void eHealthScheduler::toRing(const eHealthSample & sample, void * ring)
+	{
+		((eHealthSampleRing *)ring)->push(sample);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	setRate()														*
+	//!		Description: Sets the sample rate of a channel, 0 disables it.			*
+	//!		Param : uint8_t channel, uint16_t hz									*
+	//!		Returns: bool, false if channel is not valid							*
+	//!		Example: scheduler.setRate(EHEALTH_ECG, 250);							*
+	//!******************************************************************************
+
+	bool eHealthScheduler::setRate(uint8_t channel, uint16_t hz)
+	{
+		if (channel >= EHEALTH_CHANNEL_COUNT) {
+			return false;
+		}
+
+		task & t = tasks[channel];
+		t.hz = hz;
+		t.fraction = 0;
+
+		if (hz == 0) {
+			enabled &= ~EHEALTH_CHANNEL_BIT(channel);
+		} else {
+			t.period = 1000000UL / hz;
+			t.remainder = (uint16_t)(1000000UL % hz);
+			t.deadline = (uint32_t)micros();
+			enabled |= EHEALTH_CHANNEL_BIT(channel);
+		}
+		updateEarliest();
+		return true;
+	}
+
+	uint16_t eHealthScheduler::rate(uint8_t channel) const
+	{
+		return channel < EHEALTH_CHANNEL_COUNT ? tasks[channel].hz : 0;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	setFilter()														*
+	//!		Description: Passes the readings of a channel through filter.			*
+	//!		Param : uint8_t channel, eHealthFilter * filter							*
+	//!		Returns: bool, false if channel is not valid							*
+	//!		Example: scheduler.setFilter(EHEALTH_ECG, &filter);						*
+	//!******************************************************************************
+
+	bool eHealthScheduler::setFilter(uint8_t channel, eHealthFilter * filter)
+	{
+		if (channel >= EHEALTH_CHANNEL_COUNT) {
+			return false;
+		}
+
+		filters[channel] = filter;
+		if (filter) {
+			filter->reset();
+		}
+		return true;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	poll()															*
+	//!		Description: Takes every sample that is due.							*
+	//!		Param : void															*
+	//!		Returns: uint8_t with the number of samples taken						*
+	//!		Example: void loop() { scheduler.poll(); }								*
+	//!******************************************************************************
+
+	uint8_t eHealthScheduler::poll(void)
+	{
+		uint32_t now = (uint32_t)micros();
+
+		if (!enabled || !reached(now, earliest)) {
+			return 0;
+		}
+
+		eHealthSample sample;
+		uint8_t taken = 0;
+
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			task & t = tasks[channel];
+
+			if (!(enabled & EHEALTH_CHANNEL_BIT(channel)) || !reached(now, t.deadline)) {
+				continue;
+			}
+
+			sample.timestamp = now;
+			sample.channel = channel;
+			sample.value = mock.readChannel(channel);
+			if (!filters[channel] || filters[channel]->push(sample.value, sample.value)) {
+				sink(sample, sinkContext);
+			}
+			taken++;
+
+			// Skip, and count, every period that went by without a sample.
+			advance(t);
+			while (reached(now, t.deadline)) {
+				advance(t);
+				t.missed++;
+			}
+		}
+
+		updateEarliest();
+		return taken;
+	}
+
+	uint32_t eHealthScheduler::misses(uint8_t channel) const
+	{
+		return channel < EHEALTH_CHANNEL_COUNT ? tasks[channel].missed : 0;
+	}
+
+	uint32_t eHealthScheduler::totalMisses(void) const
+	{
+		uint32_t total = 0;
+
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			total += tasks[channel].missed;
+		}
+		return total;
+	}
+
+	void eHealthScheduler::resetMisses(void)
+	{
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			tasks[channel].missed = 0;
+		}
+	}
+
+
+//***************************************************************
+// Private Methods												*
+//***************************************************************
+
+	void eHealthScheduler::advance(task & t)
+	{
+		t.deadline += t.period;
+		t.fraction += t.remainder;
+		if (t.fraction >= t.hz) {
+			t.fraction -= t.hz;
+			t.deadline++;
+		}
+	}
+
+/*******************************************************************************************************/
+
+	void eHealthScheduler::updateEarliest(void)
+	{
+		bool first = true;
+
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (!(enabled & EHEALTH_CHANNEL_BIT(channel))) {
+				continue;
+			}
+			if (first || reached(earliest, tasks[channel].deadline)) {
+				earliest = tasks[channel].deadline;
+				first = false;
+			}
+		}
+	}
+
@@ -0,0 +1,135 @@
+/*
+*=========================================================================================
+ *  Cooperative multi-rate acquisition scheduler of the eHealth Mock.
+ *
+ *  Samples each channel at its own rate from loop() without delay():
+ *
+ *    eHealthSampleRingN<64> ring;
+ *    eHealthScheduler scheduler(eHealth, eHealthScheduler::toRing, &ring);
+ *
+ *    scheduler.setRate(EHEALTH_ECG, 250);
+ *    scheduler.setRate(EHEALTH_GSR, 10);
+ *    scheduler.setRate(EHEALTH_TEMPERATURE, 1);
+ *
+ *    void loop() {
+ *      scheduler.poll();
+ *      // drain the ring, serve other work...
+ *    }
+ *
+ *  Deadlines are kept in micros(), wrap safe, and advance by exact periods
+ *  so rates that do not divide a second do not drift. The earliest deadline
+ *  is cached: a poll() with nothing due is a single compare. A channel that
+ *  falls a whole period behind skips the lost periods instead of bursting
+ *  to catch up, and counts them as deadline misses.
+ *
+ *  A channel can be passed through an eHealthFilter, configured for the
+ *  channel's rate. The handler then only sees the filtered samples, at the
+ *  filter's output rate:
+ *
+ *    filter.setSampleRate(1000);
+ *    filter.setDecimation(4);
+ *    scheduler.setRate(EHEALTH_ECG, 1000);
+ *    scheduler.setFilter(EHEALTH_ECG, &filter);	// 250 samples per second
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthScheduler_h
+#define eHealthScheduler_h
+
+#include "eHealthMock.h"
+#include "eHealthFilter.h"
+
+	//! Receives every sample the scheduler takes.
+	typedef void (*eHealthSampleHandler)(const eHealthSample & sample, void * context);
+
+// Library interface description
+class eHealthScheduler {
+
+	public:
+
+		//! Creates a scheduler reading source, with every channel disabled.
+		/*!
+		\param eHealthClassMock & source : the sensors to sample.
+		\param eHealthSampleHandler handler : called with each sample.
+		\param void * context : passed to handler.
+		*/	eHealthScheduler(eHealthClassMock & source, eHealthSampleHandler handler, void * context = NULL);
+
+		//! Handler that pushes samples into the eHealthSampleRing passed as context.
+		static void toRing(const eHealthSample & sample, void * ring);
+
+		//! Sets the sample rate of a channel. Its first sample is due now.
+		/*!
+		\param uint8_t channel : an eHealthChannel.
+		\param uint16_t hz : samples per second, 0 disables the channel.
+		\return bool : false if channel is not valid.
+		*/	bool setRate(uint8_t channel, uint16_t hz);
+
+		//! Returns the sample rate of a channel, 0 if disabled.
+		uint16_t rate(uint8_t channel) const;
+
+		//! Passes the readings of a channel through filter.
+		/*!
+		\param uint8_t channel : an eHealthChannel.
+		\param eHealthFilter * filter : set up for the channel's rate, or NULL
+		 *  to hand the readings over unfiltered.
+		\return bool : false if channel is not valid.
+		*/	bool setFilter(uint8_t channel, eHealthFilter * filter);
+
+		//! Takes every sample that is due. Call it as often as possible.
+		/*!
+		\param void
+		\return uint8_t : number of samples taken, including those a filter
+		 *  kept back.
+		*/	uint8_t poll(void);
+
+		//! Returns the micros() at which the next sample is due.
+		/*!
+		 *  Only meaningful while a channel is enabled. Lets a caller sleep
+		 *  until then instead of polling.
+		*/	uint32_t nextDeadline(void) const { return earliest; }
+
+		//! Returns the periods of a channel skipped because poll() came too late.
+		uint32_t misses(uint8_t channel) const;
+
+		//! Returns the periods skipped over every channel.
+		uint32_t totalMisses(void) const;
+
+		//! Clears the miss counters.
+		void resetMisses(void);
+
+	private:
+
+		//! Schedule of one channel. The period is 1000000 / hz microseconds
+		//! plus remainder / hz, carried in fraction.
+		struct task {
+			uint32_t deadline;
+			uint32_t period;
+			uint16_t remainder;
+			uint16_t fraction;
+			uint16_t hz;
+			uint32_t missed;
+		};
+
+		//! Moves the deadline of t one period ahead.
+		static void advance(task & t);
+
+		//! Recomputes the cached earliest deadline.
+		void updateEarliest(void);
+
+		eHealthClassMock & mock;
+		eHealthSampleHandler sink;
+		void * sinkContext;
+
+		task tasks[EHEALTH_CHANNEL_COUNT];
+		eHealthFilter * filters[EHEALTH_CHANNEL_COUNT];
+		uint16_t enabled;
+		uint32_t earliest;
+};
+
+#endif
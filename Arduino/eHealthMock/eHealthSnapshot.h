@@ -0,0 +1,58 @@
+/*
+*=========================================================================================
+ *  Snapshots of every channel of the eHealth Mock.
+ *
+ *  eHealthClassMock::sampleAll() reads a set of channels in one pass and
+ *  stamps them with a single micros(), so readings of different sensors can
+ *  be lined up. sampleAllBlock() takes many consecutive snapshots at once,
+ *  one array per channel (structure of arrays), the layout per channel
+ *  analysis and the block kernels want:
+ *
+ *    uint16_t ecg[64], airFlow[64];
+ *    eHealthSnapshotBlock block = {};
+ *    block.period = 4000;				// 250 Hz
+ *    block.values[EHEALTH_ECG] = ecg;
+ *    block.values[EHEALTH_AIRFLOW] = airFlow;
+ *    eHealth.sampleAllBlock(block, 64);
+ *
+ *  Values are raw, in the units listed in eHealthChannels.h, as
+ *  readChannel() returns them.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthSnapshot_h
+#define eHealthSnapshot_h
+
+#include "Arduino.h"
+#include "eHealthChannels.h"
+
+	//! One reading of a set of channels, taken at the same instant.
+	struct eHealthSnapshot {
+		//! micros() when the channels were read.
+		uint32_t timestamp;
+		//! Bitmap of the channels read.
+		uint16_t channels;
+		//! Raw value of each channel read, indexed by eHealthChannel.
+		uint16_t values[EHEALTH_CHANNEL_COUNT];
+	};
+
+	//! Consecutive snapshots of a set of channels, one array per channel.
+	struct eHealthSnapshotBlock {
+		//! micros() of the first snapshot.
+		uint32_t timestamp;
+		//! Microseconds between snapshots, set by the caller. Snapshot i is
+		//! stamped timestamp + i * period.
+		uint16_t period;
+		//! Bitmap of the channels read.
+		uint16_t channels;
+		//! Caller owned array of each channel to read, NULL for the others.
+		uint16_t * values[EHEALTH_CHANNEL_COUNT];
+	};
+
+#endif
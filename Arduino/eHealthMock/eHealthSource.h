@@ -0,0 +1,42 @@
+/*
+*=========================================================================================
+ *  Source of recorded readings for the replay mode of the eHealth Mock.
+ *
+ *  While a source is attached (eHealthClassMock::replay()), the getters and
+ *  readChannel() serve the channels the source provides from it, and fall
+ *  back to the synthesized readings for the others. The host build provides
+ *  eHealthTraceReplay, which plays back a memory-mapped trace file.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthSource_h
+#define eHealthSource_h
+
+#include "Arduino.h"
+#include "eHealthChannels.h"
+
+	class eHealthSource {
+
+		public:
+
+			//! Reads the current value of channel.
+			/*!
+			\param uint8_t channel : an eHealthChannel.
+			\param uint16_t & value : receives the raw value, in the unit listed
+			 *  in eHealthChannels.h.
+			\return bool : false if the source has no value for channel.
+			*/	virtual bool read(uint8_t channel, uint16_t & value) = 0;
+
+		protected:
+
+			//! Sources are not deleted through this interface.
+			~eHealthSource() {}
+	};
+
+#endif
@@ -0,0 +1,126 @@
+/*
+*=========================================================================================
+ *  Text of the eHealth Mock without the heap.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthText.h"
+
+
+//***************************************************************
+// Name tables													*
+//***************************************************************
+
+	static const char january[] PROGMEM = "January";
+	static const char february[] PROGMEM = "February";
+	static const char march[] PROGMEM = "March";
+	static const char april[] PROGMEM = "April";
+	static const char may[] PROGMEM = "May";
+	static const char june[] PROGMEM = "June";
+	static const char july[] PROGMEM = "July";
+	static const char august[] PROGMEM = "August";
+	static const char september[] PROGMEM = "September";
+	static const char october[] PROGMEM = "October";
+	static const char november[] PROGMEM = "November";
+	static const char december[] PROGMEM = "December";
+
+	static const char * const months[12] PROGMEM = {
+		january, february, march, april, may, june,
+		july, august, september, october, november, december
+	};
+
+	static const char supine[] PROGMEM = "Supine position";
+	static const char leftLateral[] PROGMEM = "Left lateral decubitus";
+	static const char rightLateral[] PROGMEM = "Rigth lateral decubitus";
+	static const char prone[] PROGMEM = "Prone position";
+	static const char standing[] PROGMEM = "Stand or sit position";
+	static const char undefinedPosition[] PROGMEM = "non-defined position";
+
+	//! Indexed by getBodyPosition() value; 0 and 6 are non-defined.
+	static const char * const positions[7] PROGMEM = {
+		undefinedPosition, supine, leftLateral, rightLateral, prone, standing, undefinedPosition
+	};
+
+	const __FlashStringHelper * eHealthMonthName(uint8_t month)
+	{
+		uint8_t index = (month >= 1 && month <= 12) ? month - 1 : 11;
+		return (const __FlashStringHelper *)pgm_read_ptr(&months[index]);
+	}
+
+	const __FlashStringHelper * eHealthPositionName(uint8_t position)
+	{
+		uint8_t index = position < 7 ? position : 0;
+		return (const __FlashStringHelper *)pgm_read_ptr(&positions[index]);
+	}
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	//! Function that handles the creation and setup of instances
+	eHealthTextWriter::eHealthTextWriter(char * text, size_t textSize)
+	{
+		buffer = text;
+		size = textSize;
+		used = 0;
+
+		if (size) {
+			buffer[0] = '\0';
+		}
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	void eHealthTextWriter::print(char c)
+	{
+		// The last byte is kept for the terminator.
+		if (used + 1 < size) {
+			buffer[used] = c;
+			buffer[used + 1] = '\0';
+		}
+		used++;
+	}
+
+	void eHealthTextWriter::print(const char * text)
+	{
+		while (*text) {
+			print(*text++);
+		}
+	}
+
+	void eHealthTextWriter::print(const __FlashStringHelper * text)
+	{
+		const char * p = (const char *)text;
+
+		for (char c = pgm_read_byte(p); c; c = pgm_read_byte(++p)) {
+			print(c);
+		}
+	}
+
+	void eHealthTextWriter::printNumber(unsigned long value, uint8_t width)
+	{
+		char digits[10];
+		uint8_t count = 0;
+
+		do {
+			digits[count++] = '0' + value % 10;
+			value /= 10;
+		} while (value);
+
+		while (width > count) {
+			print('0');
+			width--;
+		}
+		while (count) {
+			print(digits[--count]);
+		}
+	}
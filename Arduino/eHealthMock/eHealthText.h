@@ -0,0 +1,66 @@
+/*
+*=========================================================================================
+ *  Text of the eHealth Mock without the heap.
+ *
+ *  The month and body position names live in program memory (plain read-only
+ *  data on the host) and are handed out as F() strings, which Serial and
+ *  eHealthOutput print directly. eHealthTextWriter formats into a caller
+ *  supplied buffer, so records can be turned into text without String.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthText_h
+#define eHealthText_h
+
+#include "Arduino.h"
+
+	//! Returns the name of month (1-12) in program memory.
+	/*!
+	 *  Other values read as December, as numberToMonth() always did.
+	\param uint8_t month : the month, 1 for January.
+	\return const __FlashStringHelper * : the name.
+	*/	const __FlashStringHelper * eHealthMonthName(uint8_t month);
+
+	//! Returns the name of a getBodyPosition() value in program memory.
+	/*!
+	\param uint8_t position : the position, 1 to 5.
+	\return const __FlashStringHelper * : the name, "non-defined position" for others.
+	*/	const __FlashStringHelper * eHealthPositionName(uint8_t position);
+
+// Library interface description
+class eHealthTextWriter {
+
+	public:
+
+		//! Writes into buffer, which is kept null terminated.
+		/*!
+		\param char * buffer : the text, size bytes.
+		\param size_t size : size of buffer, may be 0.
+		*/	eHealthTextWriter(char * buffer, size_t size);
+
+		//! Appends text. What does not fit is counted but not written.
+		void print(const char * text);
+		void print(const __FlashStringHelper * text);
+		void print(char c);
+
+		//! Appends value in decimal, zero padded to width digits.
+		void printNumber(unsigned long value, uint8_t width = 0);
+
+		//! Returns the length of the whole text, written or not, as
+		//! snprintf() does. The text was cut short when it is size or more.
+		size_t length(void) const { return used; }
+
+	private:
+
+		char * buffer;
+		size_t size;
+		size_t used;
+};
+
+#endif
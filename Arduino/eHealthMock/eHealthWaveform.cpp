@@ -0,0 +1,336 @@
+/*
+*=========================================================================================
+ *  Synthetic waveform engine of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthWaveform.h"
+
+
+//***************************************************************
+// Templates													*
+//***************************************************************
+
+	//! Entries per template. Must be a power of two (index is the top 8 phase bits).
+	#define TEMPLATE_SIZE 256
+
+	//! Template values are Q12: 4096 is the nominal peak.
+	#define TEMPLATE_ONE 4096
+
+	//! One PQRST cycle, sum of five gaussians. R peak at 4096, S trough at -841.
+	static const int16_t ecgTemplate[TEMPLATE_SIZE] PROGMEM = {
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 1, 1, 2, 3, 6, 9, 14, 20,
+		30, 43, 60, 82, 109, 141, 179, 221, 267, 314, 361, 405,
+		443, 473, 493, 502, 498, 483, 456, 421, 379, 333, 285, 239,
+		195, 155, 121, 92, 68, 49, 35, 24, 16, 10, 7, 4,
+		3, 2, 1, 0, 0, 0, 0, 0, 0, 0, -1, -4,
+		-11, -30, -68, -132, -218, -306, -353, -304, -103, 299, 928, 1766,
+		2709, 3560, 4080, 4096, 3591, 2711, 1687, 732, -23, -529, -789, -841,
+		-742, -565, -376, -220, -114, -52, -21, -7, -2, 0, 0, 0,
+		0, 1, 1, 1, 1, 2, 3, 4, 5, 6, 9, 11,
+		15, 19, 24, 31, 39, 48, 60, 74, 91, 110, 133, 159,
+		190, 224, 262, 304, 350, 401, 456, 514, 575, 638, 703, 769,
+		835, 900, 962, 1021, 1076, 1124, 1167, 1201, 1228, 1246, 1254, 1253,
+		1243, 1223, 1195, 1159, 1115, 1065, 1010, 950, 887, 822, 756, 690,
+		625, 562, 502, 444, 391, 341, 295, 254, 216, 183, 154, 128,
+		106, 87, 71, 58, 46, 37, 29, 23, 18, 14, 11, 8,
+		6, 5, 3, 3, 2, 1, 1, 1, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 0, 0, 0,
+	};
+
+	//! One breath: raised cosine, inhale over the first 40% of the cycle.
+	static const int16_t breathTemplate[TEMPLATE_SIZE] PROGMEM = {
+		0, 1, 4, 9, 15, 24, 35, 47, 61, 78, 96, 116,
+		137, 161, 186, 213, 242, 272, 304, 338, 374, 411, 449, 489,
+		531, 573, 618, 663, 710, 759, 808, 858, 910, 963, 1017, 1072,
+		1127, 1184, 1241, 1299, 1358, 1418, 1478, 1538, 1599, 1661, 1723, 1785,
+		1847, 1910, 1973, 2035, 2098, 2161, 2224, 2286, 2349, 2411, 2472, 2533,
+		2594, 2655, 2714, 2773, 2832, 2889, 2946, 3002, 3057, 3112, 3165, 3217,
+		3268, 3318, 3367, 3414, 3460, 3505, 3548, 3591, 3631, 3670, 3708, 3744,
+		3778, 3811, 3842, 3872, 3899, 3925, 3950, 3972, 3993, 4011, 4028, 4043,
+		4057, 4068, 4077, 4085, 4090, 4094, 4096, 4096, 4095, 4093, 4090, 4087,
+		4083, 4077, 4071, 4064, 4057, 4048, 4039, 4028, 4017, 4005, 3993, 3979,
+		3965, 3950, 3934, 3917, 3899, 3881, 3862, 3842, 3822, 3800, 3778, 3755,
+		3732, 3708, 3683, 3657, 3631, 3604, 3577, 3548, 3520, 3490, 3460, 3430,
+		3398, 3367, 3334, 3301, 3268, 3234, 3200, 3165, 3129, 3094, 3057, 3021,
+		2984, 2946, 2908, 2870, 2832, 2793, 2754, 2714, 2674, 2634, 2594, 2554,
+		2513, 2472, 2431, 2390, 2349, 2307, 2265, 2224, 2182, 2140, 2098, 2056,
+		2014, 1973, 1931, 1889, 1847, 1806, 1764, 1723, 1681, 1640, 1599, 1559,
+		1518, 1478, 1437, 1398, 1358, 1319, 1280, 1241, 1203, 1165, 1127, 1090,
+		1053, 1017, 981, 945, 910, 876, 842, 808, 775, 742, 710, 679,
+		648, 618, 588, 559, 531, 503, 476, 449, 423, 398, 374, 350,
+		327, 304, 283, 262, 242, 222, 204, 186, 169, 153, 137, 123,
+		109, 96, 83, 72, 61, 52, 43, 35, 27, 21, 15, 11,
+		7, 4, 2, 0,
+	};
+
+	//! Fraction of an EMG cycle spent contracting, in 1/256.
+	#define EMG_BURST_DUTY 77
+
+	//! Resting EMG noise relative to the burst amplitude (shift right).
+	#define EMG_REST_SHIFT 3
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	eHealthWaveform::eHealthWaveform(void)
+	{
+		setECG(75, 300, EHEALTH_WAVEFORM_SAMPLE_RATE);
+		ecg.baseline = 400;
+
+		setAirFlow(15, 400, EHEALTH_WAVEFORM_SAMPLE_RATE);
+		airFlow.baseline = 20;
+
+		setEMG(12, 400, EHEALTH_WAVEFORM_SAMPLE_RATE);
+		emg.baseline = 512;
+
+		seek(0);
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	//!******************************************************************************
+	//!		Name:	setECG()														*
+	//!		Description: Configures heart rate, amplitude and sample rate.			*
+	//!		Param : uint8_t heartRate, uint16_t amplitude, uint16_t sampleRate		*
+	//!		Returns: void															*
+	//!		Example: eHealth.waveform.setECG(60, 300, 500);							*
+	//!******************************************************************************
+
+	void eHealthWaveform::setECG(uint8_t heartRate, uint16_t amplitude, uint16_t sampleRate)
+	{
+		tune(ecg, heartRate, sampleRate);
+		ecg.amplitude = amplitude;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	setAirFlow()													*
+	//!		Description: Configures respiration rate, amplitude and sample rate.	*
+	//!		Param : uint8_t respirationRate, uint16_t amplitude,					*
+	//!				uint16_t sampleRate												*
+	//!		Returns: void															*
+	//!		Example: eHealth.waveform.setAirFlow(15, 400, 50);						*
+	//!******************************************************************************
+
+	void eHealthWaveform::setAirFlow(uint8_t respirationRate, uint16_t amplitude, uint16_t sampleRate)
+	{
+		tune(airFlow, respirationRate, sampleRate);
+		airFlow.amplitude = amplitude;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	setEMG()														*
+	//!		Description: Configures contraction rate, amplitude and sample rate.	*
+	//!		Param : uint8_t burstRate, uint16_t amplitude, uint16_t sampleRate		*
+	//!		Returns: void															*
+	//!		Example: eHealth.waveform.setEMG(20, 400, 1000);						*
+	//!******************************************************************************
+
+	void eHealthWaveform::setEMG(uint8_t burstRate, uint16_t amplitude, uint16_t sampleRate)
+	{
+		tune(emg, burstRate, sampleRate);
+		emg.amplitude = amplitude;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	seed()															*
+	//!		Description: Seeds the EMG noise generator.								*
+	//!		Param : uint32_t value													*
+	//!		Returns: void															*
+	//!		Example: eHealth.waveform.seed(42);										*
+	//!******************************************************************************
+
+	void eHealthWaveform::seed(uint32_t value)
+	{
+		noiseSource.seed(value);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	seek()															*
+	//!		Description: Moves every channel to sample index. O(1).				*
+	//!		Param : uint64_t index													*
+	//!		Returns: void															*
+	//!		Example: eHealth.waveform.seek(250UL * 60);								*
+	//!******************************************************************************
+
+	void eHealthWaveform::seek(uint64_t index)
+	{
+		// Phase wraps modulo 2^32, so only the low word of the product matters.
+		ecg.phase = (uint32_t)index * ecg.increment;
+		airFlow.phase = (uint32_t)index * airFlow.increment;
+		emg.phase = (uint32_t)index * emg.increment;
+		noiseSource.seek(index);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	nextECG()														*
+	//!		Description: Returns the next ECG reading.								*
+	//!		Param : void															*
+	//!		Returns: uint16_t with the reading (0-1023)								*
+	//!		Example: uint16_t raw = eHealth.waveform.nextECG();						*
+	//!******************************************************************************
+
+	uint16_t eHealthWaveform::nextECG(void)
+	{
+		int16_t value = lookup(ecgTemplate, ecg.phase);
+		ecg.phase += ecg.increment;
+
+		return scale(ecg, value);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	nextAirFlow()													*
+	//!		Description: Returns the next air flow reading.						*
+	//!		Param : void															*
+	//!		Returns: uint16_t with the reading (0-1023)								*
+	//!		Example: uint16_t raw = eHealth.waveform.nextAirFlow();					*
+	//!******************************************************************************
+
+	uint16_t eHealthWaveform::nextAirFlow(void)
+	{
+		int16_t value = lookup(breathTemplate, airFlow.phase);
+		airFlow.phase += airFlow.increment;
+
+		return scale(airFlow, value);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	nextEMG()														*
+	//!		Description: Returns the next EMG reading.								*
+	//!		Param : void															*
+	//!		Returns: uint16_t with the reading (0-1023)								*
+	//!		Example: uint16_t raw = eHealth.waveform.nextEMG();						*
+	//!******************************************************************************
+
+	uint16_t eHealthWaveform::nextEMG(void)
+	{
+		int16_t value = noise();
+
+		// Full amplitude while contracting, a low resting floor otherwise.
+		if ((uint8_t)(emg.phase >> 24) >= EMG_BURST_DUTY) {
+			value >>= EMG_REST_SHIFT;
+		}
+		emg.phase += emg.increment;
+
+		return scale(emg, value);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	fillECG(), fillAirFlow(), fillEMG()								*
+	//!		Description: Fill a buffer with the next count readings.				*
+	//!		Param : uint16_t * samples, size_t count								*
+	//!		Returns: void															*
+	//!		Example: eHealth.waveform.fillECG(buffer, 64);							*
+	//!******************************************************************************
+
+	void eHealthWaveform::fillECG(uint16_t * samples, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			samples[i] = nextECG();
+		}
+	}
+
+	void eHealthWaveform::fillAirFlow(uint16_t * samples, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			samples[i] = nextAirFlow();
+		}
+	}
+
+	void eHealthWaveform::fillEMG(uint16_t * samples, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+			samples[i] = nextEMG();
+		}
+	}
+
+
+//***************************************************************
+// Private Methods												*
+//***************************************************************
+
+	//! Sets the phase increment for rate cycles per minute at sampleRate.
+
+	void eHealthWaveform::tune(oscillator & osc, uint8_t rate, uint16_t sampleRate)
+	{
+		if (sampleRate == 0) {
+			sampleRate = EHEALTH_WAVEFORM_SAMPLE_RATE;
+		}
+
+		// One cycle is 2^32 of phase. Configuration only, so float is fine here.
+		// A cycle per sample or faster cannot be shown anyway; clamp it below
+		// 2^32 so the conversion stays defined.
+		float increment = (float)rate / 60.0f / sampleRate * 4294967296.0f;
+
+		osc.increment = increment < 4294967296.0f ? (uint32_t)increment : 0xFFFFFFFFUL;
+	}
+
+/*******************************************************************************************************/
+
+	//! Interpolates template at phase: top 8 bits index, next 8 bits weight.
+
+	int16_t eHealthWaveform::lookup(const int16_t * table, uint32_t phase)
+	{
+		uint8_t index = phase >> 24;
+		uint8_t weight = phase >> 16;
+
+		int16_t a = (int16_t)pgm_read_word(&table[index]);
+		int16_t b = (int16_t)pgm_read_word(&table[(uint8_t)(index + 1)]);
+
+		return a + (int16_t)(((int32_t)(b - a) * weight) >> 8);
+	}
+
+/*******************************************************************************************************/
+
+	//! Scales a Q12 template value onto osc and clamps it to 0-1023.
+
+	uint16_t eHealthWaveform::scale(const oscillator & osc, int32_t value)
+	{
+		int32_t counts = osc.baseline + ((value * osc.amplitude) >> 12);
+
+		if (counts < 0) {
+			return 0;
+		}
+		if (counts > 1023) {
+			return 1023;
+		}
+		return (uint16_t)counts;
+	}
+
+/*******************************************************************************************************/
+
+	//! Sum of two uniform values: triangular noise in Q12 (-4096..4096).
+
+	int16_t eHealthWaveform::noise(void)
+	{
+		uint32_t draw = noiseSource.next();
+
+		int16_t a = (int16_t)(draw & 0x0FFF) - (TEMPLATE_ONE / 2);
+		int16_t b = (int16_t)((draw >> 16) & 0x0FFF) - (TEMPLATE_ONE / 2);
+
+		return a + b;
+	}
+
@@ -0,0 +1,139 @@
+/*
+*=========================================================================================
+ *  Synthetic waveform engine of the eHealth Mock.
+ *
+ *  Produces physiological looking analog readings (0-1023) instead of uniform
+ *  random values. Each channel is a phase accumulator stepping through a
+ *  one-cycle template held in flash:
+ *
+ *    ECG      PQRST complex, repeated at the heart rate.
+ *    Air flow Breathing curve (40% inhale, 60% exhale), at the respiration rate.
+ *    EMG      Noise whose envelope bursts at the contraction rate.
+ *
+ *  A sample costs a table lookup and one linear interpolation, so the engine
+ *  runs in a few bytes of RAM per channel on the board.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthWaveform_h
+#define eHealthWaveform_h
+
+#include "Arduino.h"
+#include "eHealthRandom.h"
+
+	//! Default sample rate of every channel, in Hz.
+	#define EHEALTH_WAVEFORM_SAMPLE_RATE 250
+
+// Library interface description
+class eHealthWaveform {
+
+	public:
+
+	//***************************************************************
+	// Constructor of the class										*
+	//***************************************************************
+
+		//! Class constructor. 75 bpm, 15 breaths and 12 bursts per minute.
+		eHealthWaveform(void);
+
+	//***************************************************************
+	// Public Methods												*
+	//***************************************************************
+
+		//! Configures the ECG channel.
+		/*!
+		\param uint8_t heartRate : beats per minute.
+		\param uint16_t amplitude : height of the R wave in ADC counts.
+		\param uint16_t sampleRate : samples per second produced by nextECG().
+		\return void
+		*/	void setECG(uint8_t heartRate, uint16_t amplitude, uint16_t sampleRate);
+
+		//! Configures the air flow channel.
+		/*!
+		\param uint8_t respirationRate : breaths per minute.
+		\param uint16_t amplitude : peak of the breathing curve in ADC counts.
+		\param uint16_t sampleRate : samples per second produced by nextAirFlow().
+		\return void
+		*/	void setAirFlow(uint8_t respirationRate, uint16_t amplitude, uint16_t sampleRate);
+
+		//! Configures the EMG channel.
+		/*!
+		\param uint8_t burstRate : muscle contractions per minute.
+		\param uint16_t amplitude : peak noise amplitude during a burst in ADC counts.
+		\param uint16_t sampleRate : samples per second produced by nextEMG().
+		\return void
+		*/	void setEMG(uint8_t burstRate, uint16_t amplitude, uint16_t sampleRate);
+
+		//! Seeds the EMG noise.
+		void seed(uint32_t value);
+
+		//! Moves every channel to sample index, as if index samples had been read. O(1).
+		void seek(uint64_t index);
+
+		//! Returns the next ECG reading (0-1023).
+		uint16_t nextECG(void);
+
+		//! Returns the next air flow reading (0-1023).
+		uint16_t nextAirFlow(void);
+
+		//! Returns the next EMG reading (0-1023).
+		uint16_t nextEMG(void);
+
+		//! Fills samples with the next count ECG readings.
+		void fillECG(uint16_t * samples, size_t count);
+
+		//! Fills samples with the next count air flow readings.
+		void fillAirFlow(uint16_t * samples, size_t count);
+
+		//! Fills samples with the next count EMG readings.
+		void fillEMG(uint16_t * samples, size_t count);
+
+	private:
+
+	//***************************************************************
+	// Private Types												*
+	//***************************************************************
+
+		//! Phase accumulator over a one-cycle template.
+		struct oscillator {
+			uint32_t phase;
+			uint32_t increment;
+			uint16_t amplitude;
+			uint16_t baseline;
+		};
+
+	//***************************************************************
+	// Private Methods												*
+	//***************************************************************
+
+		//! Sets the phase increment for rate cycles per minute at sampleRate.
+		static void tune(oscillator & osc, uint8_t rate, uint16_t sampleRate);
+
+		//! Interpolates template at the phase of osc, in template units (Q12).
+		static int16_t lookup(const int16_t * table, uint32_t phase);
+
+		//! Scales a Q12 template value onto osc and clamps it to 0-1023.
+		static uint16_t scale(const oscillator & osc, int32_t value);
+
+		//! Returns a triangular distributed noise value in Q12 (-4096..4096).
+		int16_t noise(void);
+
+	//***************************************************************
+	// Private Variables											*
+	//***************************************************************
+
+		oscillator ecg;
+		oscillator airFlow;
+		oscillator emg;
+
+		//! EMG noise: one draw per EMG sample.
+		eHealthRandom noiseSource;
+};
+
+#endif
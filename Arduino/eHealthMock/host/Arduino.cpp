@@ -0,0 +1,306 @@
+/*
+*=========================================================================================
+ *  Host (Linux) replacement for the Arduino core used by the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "Arduino.h"
+
+#include <time.h>
+
+
+//***************************************************************
+// Simulated clock												*
+//***************************************************************
+
+	//! Current simulated time in microseconds. Each thread has its own clock,
+	//! so simulations running on different threads do not share time.
+	static thread_local uint64_t clockMicros = 0;
+
+	unsigned long micros(void)
+	{
+		return (unsigned long)clockMicros;
+	}
+
+	unsigned long millis(void)
+	{
+		return (unsigned long)(clockMicros / 1000);
+	}
+
+	void delay(unsigned long ms)
+	{
+		clockMicros += (uint64_t)ms * 1000;
+	}
+
+	void delayMicroseconds(unsigned int us)
+	{
+		clockMicros += us;
+	}
+
+	void hostClockAdvance(uint64_t us)
+	{
+		clockMicros += us;
+	}
+
+	void hostClockSet(uint64_t us)
+	{
+		clockMicros = us;
+	}
+
+	uint64_t hostClockMicros(void)
+	{
+		return clockMicros;
+	}
+
+	unsigned long hostSteadyMicros(void)
+	{
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return (unsigned long)now.tv_sec * 1000000UL + (unsigned long)(now.tv_nsec / 1000);
+	}
+
+
+//***************************************************************
+// Random numbers												*
+//***************************************************************
+
+	//! Same generator as avr-libc random() (Park-Miller minimal standard),
+	//! so a given seed yields the same sequence as on the board.
+	static uint32_t randomContext = 1;
+
+	static int32_t nextRandom(void)
+	{
+		int32_t x = (int32_t)randomContext;
+
+		if (x == 0) {
+			x = 123459876L;
+		}
+
+		int32_t hi = x / 127773L;
+		int32_t lo = x % 127773L;
+
+		x = 16807L * lo - 2836L * hi;
+		if (x < 0) {
+			x += 0x7fffffffL;
+		}
+
+		randomContext = (uint32_t)x;
+		return x;
+	}
+
+	void randomSeed(unsigned long seed)
+	{
+		if (seed != 0) {
+			randomContext = (uint32_t)seed;
+		}
+	}
+
+	long random(long howbig)
+	{
+		if (howbig == 0) {
+			return 0;
+		}
+		return nextRandom() % howbig;
+	}
+
+	long random(long howsmall, long howbig)
+	{
+		if (howsmall >= howbig) {
+			return howsmall;
+		}
+		return random(howbig - howsmall) + howsmall;
+	}
+
+
+//***************************************************************
+// Digital pins													*
+//***************************************************************
+
+	void pinMode(uint8_t, uint8_t) {}
+	void digitalWrite(uint8_t, uint8_t) {}
+	int digitalRead(uint8_t) { return LOW; }
+
+
+//***************************************************************
+// String														*
+//***************************************************************
+
+	//! Formats an integer in the given base, as the Arduino core does.
+	static std::string formatNumber(unsigned long value, unsigned char base, bool negative)
+	{
+		if (base < 2) {
+			base = 10;
+		}
+
+		char digits[sizeof(unsigned long) * 8 + 2];
+		char * p = &digits[sizeof(digits) - 1];
+		*p = '\0';
+
+		do {
+			unsigned long d = value % base;
+			*--p = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+			value /= base;
+		} while (value);
+
+		if (negative) {
+			*--p = '-';
+		}
+		return std::string(p);
+	}
+
+	static std::string formatFloat(double value, unsigned char decimalPlaces)
+	{
+		char text[64];
+		snprintf(text, sizeof(text), "%.*f", decimalPlaces, value);
+		return std::string(text);
+	}
+
+	String::String(int value, unsigned char base)
+		: buffer(base == DEC && value < 0 ? formatNumber(-(long)value, base, true)
+			: formatNumber((unsigned int)value, base, false)) {}
+
+	String::String(unsigned int value, unsigned char base)
+		: buffer(formatNumber(value, base, false)) {}
+
+	String::String(long value, unsigned char base)
+		: buffer(base == DEC && value < 0 ? formatNumber(-(unsigned long)value, base, true)
+			: formatNumber((unsigned long)value, base, false)) {}
+
+	String::String(unsigned long value, unsigned char base)
+		: buffer(formatNumber(value, base, false)) {}
+
+	String::String(float value, unsigned char decimalPlaces)
+		: buffer(formatFloat(value, decimalPlaces)) {}
+
+	String::String(double value, unsigned char decimalPlaces)
+		: buffer(formatFloat(value, decimalPlaces)) {}
+
+	char String::charAt(unsigned int index) const
+	{
+		return index < buffer.length() ? buffer[index] : 0;
+	}
+
+	String operator + (const String & lhs, const String & rhs)
+	{
+		String result(lhs);
+		result += rhs;
+		return result;
+	}
+
+
+//***************************************************************
+// Serial														*
+//***************************************************************
+
+	//! Size of the transmit buffer of the board's HardwareSerial.
+	static const unsigned int SERIAL_TX_BUFFER_SIZE = 64;
+
+	HardwareSerial::HardwareSerial(void)
+		: stream(stdout), baud(0), drainedAt(0), written(0) {}
+
+	void HardwareSerial::begin(unsigned long rate)
+	{
+		baud = rate;
+		drainedAt = clockMicros;
+	}
+
+	void HardwareSerial::end(void)
+	{
+		baud = 0;
+	}
+
+	void HardwareSerial::setStream(FILE * out)
+	{
+		stream = out;
+	}
+
+	int HardwareSerial::available(void)
+	{
+		return 0;
+	}
+
+	int HardwareSerial::read(void)
+	{
+		return -1;
+	}
+
+	void HardwareSerial::flush(void)
+	{
+		if (baud && drainedAt > clockMicros) {
+			clockMicros = drainedAt;
+		}
+		if (stream) {
+			fflush(stream);
+		}
+	}
+
+	void HardwareSerial::pace(size_t size)
+	{
+		written += size;
+
+		if (!baud) {
+			return;
+		}
+
+		// 8N1 framing: 10 bits on the wire per byte.
+		uint64_t byteTime = 10000000ULL / baud;
+		uint64_t window = byteTime * SERIAL_TX_BUFFER_SIZE;
+
+		if (drainedAt < clockMicros) {
+			drainedAt = clockMicros;
+		}
+		drainedAt += byteTime * size;
+
+		// Block until the bytes that do not fit in the buffer are on the wire.
+		if (drainedAt > clockMicros + window) {
+			clockMicros = drainedAt - window;
+		}
+	}
+
+	size_t HardwareSerial::write(uint8_t c)
+	{
+		return write(&c, 1);
+	}
+
+	size_t HardwareSerial::write(const uint8_t * buffer, size_t size)
+	{
+		if (stream && size) {
+			fwrite(buffer, 1, size, stream);
+		}
+		pace(size);
+		return size;
+	}
+
+	size_t HardwareSerial::write(const char * str)
+	{
+		return str ? write((const uint8_t *)str, strlen(str)) : 0;
+	}
+
+	size_t HardwareSerial::print(const char * str)        { return write(str); }
+	size_t HardwareSerial::print(const String & str)      { return write(str.c_str()); }
+	size_t HardwareSerial::print(const __FlashStringHelper * str) { return write((const char *)str); }
+	size_t HardwareSerial::print(char c)                  { return write((uint8_t)c); }
+	size_t HardwareSerial::print(int value, int base)     { return print(String(value, (unsigned char)base)); }
+	size_t HardwareSerial::print(unsigned int value, int base)  { return print(String(value, (unsigned char)base)); }
+	size_t HardwareSerial::print(long value, int base)    { return print(String(value, (unsigned char)base)); }
+	size_t HardwareSerial::print(unsigned long value, int base) { return print(String(value, (unsigned char)base)); }
+	size_t HardwareSerial::print(double value, int digits)      { return print(String(value, (unsigned char)digits)); }
+
+	size_t HardwareSerial::println(void)                  { return write("\r\n"); }
+	size_t HardwareSerial::println(const char * str)      { return print(str) + println(); }
+	size_t HardwareSerial::println(const String & str)    { return print(str) + println(); }
+	size_t HardwareSerial::println(const __FlashStringHelper * str) { return print(str) + println(); }
+	size_t HardwareSerial::println(char c)                { return print(c) + println(); }
+	size_t HardwareSerial::println(int value, int base)   { return print(value, base) + println(); }
+	size_t HardwareSerial::println(unsigned int value, int base)  { return print(value, base) + println(); }
+	size_t HardwareSerial::println(long value, int base)  { return print(value, base) + println(); }
+	size_t HardwareSerial::println(unsigned long value, int base) { return print(value, base) + println(); }
+	size_t HardwareSerial::println(double value, int digits)      { return print(value, digits) + println(); }
+
+	HardwareSerial Serial;
+
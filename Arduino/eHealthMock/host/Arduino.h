@@ -0,0 +1,233 @@
+/*
+*=========================================================================================
+ *  Host (Linux) replacement for the Arduino core used by the eHealth Mock.
+ *
+ *  Provides just enough of "Arduino.h" for the mock library to build as a normal
+ *  static library: the basic types, String, Serial, random() and the timing
+ *  functions. Time is a simulated clock: delay() and delayMicroseconds() advance
+ *  it instantly instead of sleeping, so hours of acquisition run in seconds.
+ *  The clock is per thread.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <string>
+
+//***************************************************************
+// Basic types and constants									*
+//***************************************************************
+
+	typedef uint8_t byte;
+	typedef bool boolean;
+	typedef uint16_t word;
+
+	#define HIGH 0x1
+	#define LOW  0x0
+
+	#define INPUT  0x0
+	#define OUTPUT 0x1
+
+	#define DEC 10
+	#define HEX 16
+	#define OCT 8
+	#define BIN 2
+
+
+//***************************************************************
+// Program memory (plain memory on the host)					*
+//***************************************************************
+
+	#define PROGMEM
+	#define pgm_read_byte(address) (*(const uint8_t *)(address))
+	#define pgm_read_word(address) (*(const uint16_t *)(address))
+	#define pgm_read_dword(address) (*(const uint32_t *)(address))
+	#define pgm_read_ptr(address) (*(const void * const *)(address))
+	#define PSTR(string) (string)
+	#define strlen_P strlen
+	#define memcpy_P memcpy
+
+	//! Text in program memory, as F() marks it.
+	class __FlashStringHelper;
+	#define F(string) (reinterpret_cast<const __FlashStringHelper *>(PSTR(string)))
+
+
+//***************************************************************
+// Timing (simulated clock)										*
+//***************************************************************
+
+	//! Returns the simulated time in microseconds since start.
+	unsigned long micros(void);
+
+	//! Returns the simulated time in milliseconds since start.
+	unsigned long millis(void);
+
+	//! Advances the simulated clock by ms milliseconds. Returns immediately.
+	void delay(unsigned long ms);
+
+	//! Advances the simulated clock by us microseconds. Returns immediately.
+	void delayMicroseconds(unsigned int us);
+
+	//! Advances the simulated clock by us microseconds.
+	void hostClockAdvance(uint64_t us);
+
+	//! Sets the simulated clock to an absolute time in microseconds.
+	void hostClockSet(uint64_t us);
+
+	//! Returns the simulated time in microseconds, never wrapping.
+	uint64_t hostClockMicros(void);
+
+	//! Returns the real monotonic time in microseconds, for measuring CPU work.
+	unsigned long hostSteadyMicros(void);
+
+
+//***************************************************************
+// Random numbers												*
+//***************************************************************
+
+	//! Seeds the generator. A seed of 0 is ignored, as on the board.
+	void randomSeed(unsigned long seed);
+
+	//! Returns a pseudo random number in [0, howbig).
+	long random(long howbig);
+
+	//! Returns a pseudo random number in [howsmall, howbig).
+	long random(long howsmall, long howbig);
+
+
+//***************************************************************
+// Digital pins (no-ops on the host)							*
+//***************************************************************
+
+	void pinMode(uint8_t pin, uint8_t mode);
+	void digitalWrite(uint8_t pin, uint8_t val);
+	int digitalRead(uint8_t pin);
+
+
+//***************************************************************
+// String														*
+//***************************************************************
+
+	//! Minimal heap backed Arduino String.
+	class String {
+
+		public:
+
+			String(const char * str = "") : buffer(str ? str : "") {}
+			String(const std::string & str) : buffer(str) {}
+			String(char c) : buffer(1, c) {}
+			String(int value, unsigned char base = DEC);
+			String(unsigned int value, unsigned char base = DEC);
+			String(long value, unsigned char base = DEC);
+			String(unsigned long value, unsigned char base = DEC);
+			String(float value, unsigned char decimalPlaces = 2);
+			String(double value, unsigned char decimalPlaces = 2);
+
+			unsigned int length(void) const { return buffer.length(); }
+			const char * c_str(void) const { return buffer.c_str(); }
+			char charAt(unsigned int index) const;
+
+			bool concat(const String & str) { buffer += str.buffer; return true; }
+			String & operator += (const String & rhs) { buffer += rhs.buffer; return *this; }
+			friend String operator + (const String & lhs, const String & rhs);
+
+			bool equals(const String & str) const { return buffer == str.buffer; }
+			bool operator == (const String & rhs) const { return buffer == rhs.buffer; }
+			bool operator == (const char * rhs) const { return buffer == rhs; }
+			bool operator != (const String & rhs) const { return buffer != rhs.buffer; }
+
+			int toInt(void) const { return atoi(buffer.c_str()); }
+			float toFloat(void) const { return (float)atof(buffer.c_str()); }
+
+		private:
+
+			std::string buffer;
+	};
+
+
+//***************************************************************
+// Serial														*
+//***************************************************************
+
+	//! Serial port of the host build. Output goes to stdout unless redirected.
+	/*!
+	 *  After begin(baud) the port models the 64 byte transmit buffer of the
+	 *  board: once it is full, every byte written advances the simulated clock
+	 *  by one byte time (10 bits), as a blocking write would on the board.
+	 *  With no baud rate set, writes cost no simulated time.
+	 */
+	class HardwareSerial {
+
+		public:
+
+			HardwareSerial(void);
+
+			void begin(unsigned long baud);
+			void end(void);
+
+			//! Redirects the output to stream. NULL discards it.
+			void setStream(FILE * stream);
+
+			//! Returns the number of bytes written since start.
+			uint64_t bytesWritten(void) const { return written; }
+
+			int available(void);
+			int read(void);
+			void flush(void);
+
+			size_t write(uint8_t c);
+			size_t write(const uint8_t * buffer, size_t size);
+			size_t write(const char * str);
+
+			size_t print(const char * str);
+			size_t print(const String & str);
+			size_t print(const __FlashStringHelper * str);
+			size_t print(char c);
+			size_t print(int value, int base = DEC);
+			size_t print(unsigned int value, int base = DEC);
+			size_t print(long value, int base = DEC);
+			size_t print(unsigned long value, int base = DEC);
+			size_t print(double value, int digits = 2);
+
+			size_t println(void);
+			size_t println(const char * str);
+			size_t println(const String & str);
+			size_t println(const __FlashStringHelper * str);
+			size_t println(char c);
+			size_t println(int value, int base = DEC);
+			size_t println(unsigned int value, int base = DEC);
+			size_t println(long value, int base = DEC);
+			size_t println(unsigned long value, int base = DEC);
+			size_t println(double value, int digits = 2);
+
+			operator bool(void) const { return true; }
+
+		private:
+
+			//! Charges the simulated clock for size bytes of transmission.
+			void pace(size_t size);
+
+			FILE * stream;
+			unsigned long baud;
+			uint64_t drainedAt;
+			uint64_t written;
+	};
+
+	extern HardwareSerial Serial;
+
+#endif
+
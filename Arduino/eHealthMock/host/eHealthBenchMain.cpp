@@ -0,0 +1,525 @@
+/*
+*=========================================================================================
+ *  ehealth_bench: measures every getter, block method and encoder of the mock.
+ *
+ *  Usage: ehealth_bench [--filter TEXT] [--min-time S] [--repetitions N] [--out FILE]
+ *
+ *  Runs on the simulated clock, so delay() costs nothing and the figures are
+ *  the cost of the code itself. Each benchmark is calibrated to run for at
+ *  least --min-time, then repeated; the fastest and median repetitions are
+ *  reported. Results go to stdout, or FILE, as JSON:
+ *
+ *    { "schema": 1, "compiler": "...", "results": [
+ *      { "name": "getECG", "samples_per_call": 1, "iterations": 4194304,
+ *        "ns_per_call": 3.1, "ns_per_call_median": 3.2, "samples_per_second": 3.2e8,
+ *        "cycles_per_sample": 9.3 },
+ *      ... ] }
+ *
+ *  cycles_per_sample counts time stamp counter ticks (x86 only), which run
+ *  at the nominal clock whatever the core's current speed. The codec entries
+ *  add "compression_ratio": the size of the same snapshots as binary frames
+ *  over their size as codec packets, keyframes included.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthScheduler.h"
+#include "eHealthTrace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+#endif
+
+	//! Keeps the compiler from discarding a result.
+	template <class T>
+	static inline void keep(const T & value)
+	{
+		asm volatile("" : : "r,m"(value) : "memory");
+	}
+
+	//! Sink that discards everything, so output paths measure formatting only.
+	class nullSink : public eHealthSink {
+
+		public:
+
+			size_t write(const uint8_t *, size_t length) override { return length; }
+	};
+
+	struct benchmark {
+		std::string name;
+		//! Samples produced by one call, for samples per second.
+		unsigned samplesPerCall;
+		//! Runs the measured code n times.
+		std::function<void (uint64_t n)> run;
+		//! Frame bytes over codec bytes, 0 when it does not apply.
+		double ratio;
+	};
+
+	struct result {
+		std::string name;
+		unsigned samplesPerCall;
+		uint64_t iterations;
+		double best;
+		double median;
+		double ratio;
+	};
+
+	static double secondsOf(const benchmark & b, uint64_t n)
+	{
+		auto started = std::chrono::steady_clock::now();
+		b.run(n);
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+		return elapsed.count();
+	}
+
+	static result measure(const benchmark & b, double minTime, int repetitions)
+	{
+		// Double the iterations until one run lasts minTime.
+		uint64_t n = 1;
+		while (secondsOf(b, n) < minTime && n < (1ULL << 40)) {
+			n *= 2;
+		}
+
+		std::vector<double> perCall;
+		for (int i = 0; i < repetitions; i++) {
+			perCall.push_back(secondsOf(b, n) * 1e9 / n);
+		}
+		std::sort(perCall.begin(), perCall.end());
+
+		return result { b.name, b.samplesPerCall, n, perCall.front(), perCall[perCall.size() / 2], b.ratio };
+	}
+
+	//! Returns the time stamp counter ticks per nanosecond, 0 without one.
+	static double ticksPerNanosecond(void)
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		auto started = std::chrono::steady_clock::now();
+		uint64_t ticks = __rdtsc();
+		std::chrono::duration<double, std::nano> elapsed;
+		do {
+			elapsed = std::chrono::steady_clock::now() - started;
+		} while (elapsed.count() < 2e7);
+		return (__rdtsc() - ticks) / elapsed.count();
+#else
+		return 0;
+#endif
+	}
+
+	//! Returns the compression ratio of 64 packets of 32 snapshots of width
+	//! channels, taken in turn from the 256 snapshots at values.
+	static double codecRatio(uint16_t channels, uint8_t width, eHealthPredictor order, const uint16_t * values)
+	{
+		eHealthCodecEncoder encoder;
+		uint8_t packet[EHEALTH_PACKET_MAX_SIZE];
+		size_t stride = 32 * width;
+		size_t coded = 0;
+
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			encoder.setPredictor(channel, order);
+		}
+		for (int i = 0; i < 64; i++) {
+			coded += encoder.encode(channels, 32, 0, 4000, values + (i & 7) * stride, packet, sizeof(packet));
+		}
+		return coded ? 64.0 * eHealthFrameEncoder::frameSize(channels, 32) / coded : 0;
+	}
+
+
+//***************************************************************
+// Benchmarks													*
+//***************************************************************
+
+	static std::vector<benchmark> benchmarks(void)
+	{
+		static eHealthClassMock mock;
+		static nullSink discard;
+		static eHealthOutput output(discard);
+		static eHealthClassMock::gsrSample gsr[256];
+		static float voltages[256];
+		static int airFlow[256];
+		static uint16_t raw[256];
+		static uint16_t filtered[256];
+		static eHealthFilter filter;
+
+		mock.setOutput(output);
+		mock.waveform.fillECG(raw, 256);
+		filter.setSampleRate(1000);
+		filter.setNotch(50);
+		filter.setBandPass(0.5, 40);
+		filter.setDecimation(4);
+		mock.readPulsioximeter();
+		mock.readGlucometer();
+		mock.readBloodPressureSensor();
+
+		std::vector<benchmark> list;
+
+		auto add = [&](const char * name, unsigned samples, std::function<void (uint64_t)> run, double ratio = 0) {
+			list.push_back(benchmark { name, samples, run, ratio });
+		};
+
+		// Getters.
+		add("getTemperature", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getTemperature()); });
+		add("getOxygenSaturation", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getOxygenSaturation()); });
+		add("getBPM", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getBPM()); });
+		add("getSkinConductance", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getSkinConductance()); });
+		add("getSkinResistance", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getSkinResistance()); });
+		add("getSkinConductanceVoltage", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getSkinConductanceVoltage()); });
+		add("getECG", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getECG()); });
+		add("getEMG", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getEMG()); });
+		add("getECGMillivolts", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getECGMillivolts()); });
+		add("getEMGMillivolts", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getEMGMillivolts()); });
+		add("getSkinConductanceHundredths", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getSkinConductanceHundredths()); });
+		add("getSkinResistanceOhms", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getSkinResistanceOhms()); });
+		add("getAirFlow", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getAirFlow()); });
+		add("getBodyPosition", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getBodyPosition()); });
+		add("getSystolicPressure", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getSystolicPressure(i % 5)); });
+		add("getDiastolicPressure", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getDiastolicPressure(i % 5)); });
+		add("getGlucoseRecord", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.getGlucoseRecord(i % 5)); });
+		add("readGlucometer", 5, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) { mock.readGlucometer(); keep(mock.getGlucometerLength()); } });
+		add("readBloodPressureSensor", 5, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) { mock.readBloodPressureSensor(); keep(mock.getBloodPressureLength()); } });
+		add("readPulsioximeter", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) { mock.readPulsioximeter(); keep(mock.getBPM()); } });
+#if !EHEALTH_NO_HEAP
+		add("numberToMonth", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.numberToMonth(1 + i % 12).length()); });
+#endif
+		add("numberToMonth/buffer", 1, [](uint64_t n) { char name[10]; for (uint64_t i = 0; i < n; i++) keep(mock.numberToMonth(1 + i % 12, name, sizeof(name))); });
+		add("readChannel", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(mock.readChannel(i % EHEALTH_CHANNEL_COUNT)); });
+		add("sampleAll", EHEALTH_CHANNEL_COUNT, [](uint64_t n) { eHealthSnapshot snapshot; for (uint64_t i = 0; i < n; i++) keep(mock.sampleAll(snapshot)); });
+		add("sampleAllBlock/64x4", 256, [](uint64_t n) {
+			static uint16_t columns[4][64];
+			eHealthSnapshotBlock block = {};
+			for (uint8_t channel = EHEALTH_ECG; channel <= EHEALTH_GSR; channel++) block.values[channel] = columns[channel];
+			for (uint64_t i = 0; i < n; i++) { mock.sampleAllBlock(block, 64); keep(columns[0][0]); }
+		});
+
+		// Text and binary output, to a sink that discards it.
+		add("printPosition", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) mock.printPosition(1 + i % 6); });
+		add("formatGlucoseRecord", 1, [](uint64_t n) { char text[40]; for (uint64_t i = 0; i < n; i++) keep(mock.formatGlucoseRecord(i % 5, text, sizeof(text))); });
+		add("airFlowWave", 1, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) mock.airFlowWave(mock.getAirFlow()); });
+		add("writeFrame/analog", 4, [](uint64_t n) {
+			uint16_t channels = EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_EMG)
+				| EHEALTH_CHANNEL_BIT(EHEALTH_AIRFLOW) | EHEALTH_CHANNEL_BIT(EHEALTH_GSR);
+			for (uint64_t i = 0; i < n; i++) keep(mock.writeFrame(channels));
+		});
+
+		// Block methods.
+		add("getECGBlock/256", 256, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) { mock.getECGBlock(voltages, 256); keep(voltages[0]); } });
+		add("getECGMillivoltsBlock/256", 256, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) { mock.getECGMillivoltsBlock(raw, 256); keep(raw[0]); } });
+		add("getEMGBlock/256", 256, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) { mock.getEMGBlock(voltages, 256); keep(voltages[0]); } });
+		add("getAirFlowBlock/256", 256, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) { mock.getAirFlowBlock(airFlow, 256); keep(airFlow[0]); } });
+		add("getSkinConductanceVoltageBlock/256", 256, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) { mock.getSkinConductanceVoltageBlock(voltages, 256); keep(voltages[0]); } });
+		add("getGSRBlock/256", 256, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) { mock.getGSRBlock(gsr, 256); keep(gsr[0]); } });
+		add("waveform.fillECG/256", 256, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) { mock.waveform.fillECG(raw, 256); keep(raw[0]); } });
+		add("filter.push", 1, [](uint64_t n) { uint16_t out = 0; for (uint64_t i = 0; i < n; i++) { filter.push(raw[i & 255], out); keep(out); } });
+		add("filter.process/256", 256, [](uint64_t n) { for (uint64_t i = 0; i < n; i++) keep(filter.process(raw, 256, filtered)); });
+
+		// Heartbeat detection over 8192 samples of ECG, at the waveform's
+		// default rate and at the board's 800 Hz.
+		static uint16_t ecg250[8192];
+		static uint16_t ecg800[8192];
+		eHealthWaveform beatSource;
+		beatSource.setECG(75, 300, 250);
+		beatSource.fillECG(ecg250, 8192);
+		beatSource.setECG(75, 300, 800);
+		beatSource.fillECG(ecg800, 8192);
+
+		add("heartbeat.update", 1, [](uint64_t n) {
+			eHealthBeatDetector detector;
+			for (uint64_t i = 0; i < n; i++) keep(detector.update(ecg250[i & 8191]));
+		});
+		add("heartbeat.update/800Hz", 1, [](uint64_t n) {
+			eHealthBeatDetector detector;
+			detector.setSampleRate(800);
+			for (uint64_t i = 0; i < n; i++) keep(detector.update(ecg800[i & 8191]));
+		});
+		add("heartbeat.process/256", 256, [](uint64_t n) {
+			eHealthBeatDetector detector;
+			for (uint64_t i = 0; i < n; i++) keep(detector.process(ecg250 + 256 * (i & 31), 256));
+		});
+		add("heartbeat.process/256/800Hz", 256, [](uint64_t n) {
+			eHealthBeatDetector detector;
+			detector.setSampleRate(800);
+			for (uint64_t i = 0; i < n; i++) keep(detector.process(ecg800 + 256 * (i & 31), 256));
+		});
+
+		// Encoders and decoders.
+		add("frame.encode/32x4", 128, [](uint64_t n) {
+			eHealthFrameEncoder encoder;
+			uint8_t frame[EHEALTH_FRAME_MAX_SIZE];
+			for (uint64_t i = 0; i < n; i++) keep(encoder.encode(0x000F, 32, (uint32_t)i, 4000, raw, frame, sizeof(frame)));
+		});
+		add("frame.decode/32x4", 128, [](uint64_t n) {
+			eHealthFrameEncoder encoder;
+			eHealthFrameDecoder decoder;
+			uint8_t frame[EHEALTH_FRAME_MAX_SIZE];
+			size_t size = encoder.encode(0x000F, 32, 0, 4000, raw, frame, sizeof(frame));
+			for (uint64_t i = 0; i < n; i++) {
+				decoder.feed(frame, size);
+				decoder.frame().unpack(raw);
+				keep(raw[0]);
+			}
+		});
+
+		// Codec: ECG alone and the four analog channels, 32 snapshots a packet.
+		static uint16_t codecECG[256];
+		static uint16_t codecAnalog[4 * 256];
+		{
+			eHealthWaveform waveform;
+			uint16_t emg[256];
+			uint16_t airFlow[256];
+			waveform.fillECG(codecECG, 256);
+			waveform.fillEMG(emg, 256);
+			waveform.fillAirFlow(airFlow, 256);
+			for (int i = 0; i < 256; i++) {
+				uint16_t * snapshot = &codecAnalog[4 * i];
+				snapshot[0] = codecECG[i];
+				snapshot[1] = emg[i];
+				snapshot[2] = airFlow[i];
+				snapshot[3] = (uint16_t)(600 + i / 50);
+			}
+		}
+
+		auto addEncode = [&](const char * name, uint16_t channels, uint8_t width, const uint16_t * values, eHealthPredictor order) {
+			size_t stride = 32 * width;
+			add(name, (unsigned)stride, [=](uint64_t n) {
+				eHealthCodecEncoder encoder;
+				uint8_t packet[EHEALTH_PACKET_MAX_SIZE];
+				for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) encoder.setPredictor(channel, order);
+				for (uint64_t i = 0; i < n; i++) keep(encoder.encode(channels, 32, 0, 4000, values + (i & 7) * stride, packet, sizeof(packet)));
+			}, codecRatio(channels, width, order, values));
+		};
+		addEncode("codec.encode/32/raw", 0x0001, 1, codecECG, EHEALTH_PREDICT_NONE);
+		addEncode("codec.encode/32/delta", 0x0001, 1, codecECG, EHEALTH_PREDICT_DELTA);
+		addEncode("codec.encode/32/linear", 0x0001, 1, codecECG, EHEALTH_PREDICT_LINEAR);
+		addEncode("codec.encode/32x4/delta", 0x000F, 4, codecAnalog, EHEALTH_PREDICT_DELTA);
+		addEncode("codec.encode/32x4/linear", 0x000F, 4, codecAnalog, EHEALTH_PREDICT_LINEAR);
+		add("codec.decode/32x4", 128, [](uint64_t n) {
+			eHealthCodecEncoder encoder;
+			eHealthCodecDecoder decoder;
+			static uint8_t stream[8 * EHEALTH_PACKET_MAX_SIZE];
+			static uint16_t values[4 * 32];
+			size_t length = 0;
+			encoder.setKeyframeInterval(8);
+			for (int i = 0; i < 8; i++) {
+				length += encoder.encode(0x000F, 32, 0, 4000, &codecAnalog[4 * 32 * i], stream + length, EHEALTH_PACKET_MAX_SIZE);
+			}
+			// The stream repeats, keyframe first, so every packet decodes.
+			size_t at = 0;
+			for (uint64_t i = 0; i < n; i++) {
+				do {
+					at += decoder.feed(stream + at, length - at);
+					if (at == length) at = 0;
+				} while (!decoder.available());
+				decoder.decode(decoder.packet(), values);
+				keep(values[0]);
+			}
+		});
+		add("crc16/64", 64, [](uint64_t n) {
+			uint8_t bytes[64] = { 1, 2, 3 };
+			for (uint64_t i = 0; i < n; i++) keep(eHealthCrc16(0xFFFF, bytes, sizeof(bytes)));
+		});
+		add("output.print/float", 1, [](uint64_t n) {
+			for (uint64_t i = 0; i < n; i++) { output.print(36.6 + (double)(i & 7)); output.endRecord(); }
+		});
+
+		// Accelerometer: one 32-sample FIFO burst against 32 single reads.
+		add("accelerometer.burst/32", 32, [](uint64_t n) {
+			eHealthMMA8452 device;
+			uint8_t bytes[6 * 32];
+			device.writeRegister(MMA8452_F_SETUP, 0x40);
+			device.writeRegister(MMA8452_CTRL_REG1, 0x01);
+			for (uint64_t i = 0; i < n; i++) {
+				delay(40);
+				device.readRegisters(MMA8452_OUT_X_MSB, sizeof(bytes), bytes);
+				keep(bytes[0]);
+			}
+		});
+		add("accelerometer.poll/32", 32, [](uint64_t n) {
+			eHealthMMA8452 device;
+			uint8_t bytes[6];
+			device.writeRegister(MMA8452_CTRL_REG1, 0x01);
+			for (uint64_t i = 0; i < n; i++) {
+				for (int j = 0; j < 32; j++) {
+					delayMicroseconds(1250);
+					device.readRegisters(MMA8452_OUT_X_MSB, sizeof(bytes), bytes);
+					keep(bytes[0]);
+				}
+			}
+		});
+
+		// Body position: the classifier alone, per sample and per block, then
+		// a FIFO drained and classified by the mock.
+		static int16_t postureCounts[3 * 256];
+		eHealthMMA8452 postureSource;
+		postureSource.setGravity(900, 0, 400);
+		postureSource.generate(0, 256, postureCounts);
+
+		add("position.update", 1, [](uint64_t n) {
+			eHealthPositionClassifier classifier;
+			for (uint64_t i = 0; i < n; i++) {
+				const int16_t * c = postureCounts + 3 * (i & 255);
+				keep(classifier.update(c[0], c[1], c[2]));
+			}
+		});
+		add("position.classify/256", 256, [](uint64_t n) {
+			eHealthPositionClassifier classifier;
+			static uint8_t positions[256];
+			for (uint64_t i = 0; i < n; i++) {
+				keep(classifier.classify(postureCounts, 256, positions));
+			}
+		});
+		add("getBodyPositionBlock/32", 32, [](uint64_t n) {
+			eHealthClassMock patient;
+			uint8_t positions[32];
+			patient.initPositionSensor();
+			patient.accelerometer.writeRegister(MMA8452_CTRL_REG1, 0);
+			patient.accelerometer.writeRegister(MMA8452_F_SETUP, 0x40);
+			patient.accelerometer.writeRegister(MMA8452_CTRL_REG1, 0x01);
+			for (uint64_t i = 0; i < n; i++) {
+				delay(40);
+				keep(patient.getBodyPositionBlock(positions, 32));
+			}
+		});
+
+		// Acquisition plumbing.
+		add("ring.push+pop", 1, [](uint64_t n) {
+			static eHealthSampleRingN<256> ring;
+			eHealthSample sample = { 0, 0, 0 };
+			for (uint64_t i = 0; i < n; i++) { ring.push(sample); ring.pop(sample); keep(sample); }
+		});
+		add("scheduler.poll/idle", 0, [](uint64_t n) {
+			eHealthSampleRingN<64> ring;
+			eHealthScheduler scheduler(mock, eHealthScheduler::toRing, &ring);
+			scheduler.setRate(EHEALTH_ECG, 250);
+			scheduler.poll();
+			for (uint64_t i = 0; i < n; i++) keep(scheduler.poll());
+		});
+		add("history.add", 1, [](uint64_t n) {
+			static eHealthHistoryN<1024, 4> history;
+			for (uint64_t i = 0; i < n; i++) history.add((uint32_t)(i & 0xFFFFFF), (uint32_t)i);
+			keep(history.size());
+		});
+		add("history.range/1024", 0, [](uint64_t n) {
+			static eHealthHistoryN<1024, 4> history;
+			if (history.size() == 0) {
+				for (uint32_t i = 0; i < 1024; i++) history.add(i * 5, i);
+			}
+			size_t first;
+			for (uint64_t i = 0; i < n; i++) keep(history.range((uint32_t)(i % 5000), (uint32_t)(i % 5000) + 60, first));
+		});
+		add("traceReplay.read", 1, [](uint64_t n) {
+			static std::vector<uint8_t> trace;
+			static eHealthTraceReader reader;
+			if (trace.empty()) {
+				eHealthFrameEncoder encoder;
+				uint8_t frame[EHEALTH_FRAME_MAX_SIZE];
+				for (uint32_t i = 0; i < 4096; i++) {
+					size_t size = encoder.encode(0x0001, 32, i * 128000, 4000, raw, frame, sizeof(frame));
+					trace.insert(trace.end(), frame, frame + size);
+				}
+				reader.open(trace.data(), trace.size());
+			}
+			eHealthTraceReplay replay(reader);
+			replay.setSpeed(0);
+			replay.setLoop(true);
+			uint16_t value;
+			for (uint64_t i = 0; i < n; i++) { replay.read(EHEALTH_ECG, value); keep(value); }
+		});
+
+		return list;
+	}
+
+
+//***************************************************************
+// Main															*
+//***************************************************************
+
+	static void usage(void)
+	{
+		fprintf(stderr, "usage: ehealth_bench [--filter TEXT] [--min-time S] [--repetitions N] [--out FILE]\n");
+		exit(2);
+	}
+
+	int main(int argc, char ** argv)
+	{
+		const char * filter = "";
+		double minTime = 0.1;
+		int repetitions = 5;
+		const char * outPath = nullptr;
+
+		for (int i = 1; i < argc; i++) {
+			if (i + 1 >= argc) {
+				usage();
+			}
+			const char * option = argv[i];
+			const char * value = argv[++i];
+
+			if (!strcmp(option, "--filter")) {
+				filter = value;
+			} else if (!strcmp(option, "--min-time")) {
+				minTime = atof(value);
+			} else if (!strcmp(option, "--repetitions")) {
+				repetitions = std::max(1, atoi(value));
+			} else if (!strcmp(option, "--out")) {
+				outPath = value;
+			} else {
+				usage();
+			}
+		}
+
+		FILE * out = outPath ? fopen(outPath, "w") : stdout;
+		if (!out) {
+			perror(outPath);
+			return 1;
+		}
+
+		// Keep the Serial output of the measured code off the results.
+		Serial.setStream(NULL);
+
+		fprintf(out, "{\n  \"schema\": 1,\n  \"compiler\": \"%s\",\n  \"min_time\": %g,\n  \"repetitions\": %d,\n  \"results\": [",
+			__VERSION__, minTime, repetitions);
+
+		double ticks = ticksPerNanosecond();
+		const char * separator = "\n";
+		for (const benchmark & b : benchmarks()) {
+			if (!strstr(b.name.c_str(), filter)) {
+				continue;
+			}
+			result r = measure(b, minTime, repetitions);
+			double samplesPerSecond = r.best > 0 ? r.samplesPerCall * 1e9 / r.best : 0;
+
+			fprintf(out, "%s    { \"name\": \"%s\", \"samples_per_call\": %u, \"iterations\": %llu, "
+				"\"ns_per_call\": %.3f, \"ns_per_call_median\": %.3f, \"samples_per_second\": %.6g",
+				separator, r.name.c_str(), r.samplesPerCall, (unsigned long long)r.iterations,
+				r.best, r.median, samplesPerSecond);
+			if (ticks > 0 && r.samplesPerCall) {
+				fprintf(out, ", \"cycles_per_sample\": %.2f", r.best * ticks / r.samplesPerCall);
+			}
+			if (r.ratio > 0) {
+				fprintf(out, ", \"compression_ratio\": %.3f", r.ratio);
+			}
+			fprintf(out, " }");
+			fflush(out);
+			separator = ",\n";
+		}
+		fprintf(out, "\n  ]\n}\n");
+
+		if (out != stdout && fclose(out) != 0) {
+			perror(outPath);
+			return 1;
+		}
+		return 0;
+	}
+
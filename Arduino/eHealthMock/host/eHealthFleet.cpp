@@ -0,0 +1,326 @@
+/*
+*=========================================================================================
+ *  Multi-patient fleet simulator for the host build of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthFleet.h"
+
+#include <chrono>
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	eHealthFleet::eHealthFleet(const eHealthFleetConfig & fleetConfig)
+		: config(fleetConfig), patients(fleetConfig.patients)
+	{
+		if (config.shardSize == 0) {
+			config.shardSize = 1;
+		}
+
+		// Every patient gets its own stream and its own vital signs.
+		for (size_t i = 0; i < patients.size(); i++) {
+			setupPatient(patients[i], patientSeed(config.seed, i), config.ecgRate, config.emgRate, config.airFlowRate);
+		}
+
+		unsigned count = config.workers ? config.workers : std::thread::hardware_concurrency();
+		if (count == 0) {
+			count = 1;
+		}
+
+		for (unsigned i = 0; i < count; i++) {
+			workers.emplace_back(new worker());
+		}
+		for (unsigned i = 0; i < count; i++) {
+			workers[i]->thread = std::thread(&eHealthFleet::workerLoop, this, i);
+		}
+	}
+
+	eHealthFleet::~eHealthFleet()
+	{
+		{
+			std::lock_guard<std::mutex> guard(stateLock);
+			stopping = true;
+		}
+		wake.notify_all();
+
+		for (auto & w : workers) {
+			w->thread.join();
+		}
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	//!******************************************************************************
+	//!		Name:	run()															*
+	//!		Description: Simulates seconds of acquisition for every patient.		*
+	//!		Param : double seconds, consumer sink									*
+	//!		Returns: eHealthFleetReport												*
+	//!		Example: report = fleet.run(60.0);										*
+	//!******************************************************************************
+
+	eHealthFleetReport eHealthFleet::run(double seconds, const consumer & blockSink)
+	{
+		eHealthFleetReport report;
+		size_t shardCount = (patients.size() + config.shardSize - 1) / config.shardSize;
+
+		samples = 0;
+		steals = 0;
+
+		// The slice is published before any shard: a worker that takes a shard
+		// synchronizes on the queue lock, which orders these writes before it.
+		sliceStart = sliceEnd;
+		sliceEnd += (uint64_t)(seconds * 1e6);
+		sink = blockSink ? &blockSink : nullptr;
+		pendingShards = shardCount;
+
+		auto started = std::chrono::steady_clock::now();
+
+		for (size_t shard = 0; shard < shardCount; shard++) {
+			worker & w = *workers[shard % workers.size()];
+			std::lock_guard<std::mutex> guard(w.lock);
+			w.shards.push_back(shard);
+		}
+
+		{
+			std::unique_lock<std::mutex> guard(stateLock);
+			generation++;
+			wake.notify_all();
+			done.wait(guard, [this] { return pendingShards == 0; });
+		}
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+
+		report.samples = samples;
+		report.simulatedSeconds = (sliceEnd - sliceStart) / 1e6;
+		report.wallSeconds = elapsed.count();
+		report.samplesPerSecond = report.wallSeconds > 0 ? report.samples / report.wallSeconds : 0;
+		report.shards = shardCount;
+		report.steals = steals;
+		return report;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	patientSeed()													*
+	//!		Description: Derives the seed of patient i from the fleet seed.			*
+	//!		Param : uint32_t fleetSeed, size_t i									*
+	//!		Returns: uint32_t, never zero											*
+	//!		Example: uint32_t seed = eHealthFleet::patientSeed(1, 42);				*
+	//!******************************************************************************
+
+	uint32_t eHealthFleet::patientSeed(uint32_t fleetSeed, size_t i)
+	{
+		// splitmix64 finalizer over (seed, index).
+		uint64_t z = ((uint64_t)fleetSeed << 32) + i + 0x9E3779B97F4A7C15ULL;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		z ^= z >> 31;
+
+		uint32_t seed = (uint32_t)z;
+		return seed ? seed : 1;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	setupPatient()													*
+	//!		Description: Sets a mock up as the patient seed, at one rate.			*
+	//!		Param : eHealthClassMock & mock, uint32_t seed, uint16_t rate			*
+	//!		Returns: void															*
+	//!		Example: eHealthFleet::setupPatient(mock, seed, 250);					*
+	//!******************************************************************************
+
+	void eHealthFleet::setupPatient(eHealthClassMock & mock, uint32_t seed, uint16_t rate)
+	{
+		setupPatient(mock, seed, rate, rate, rate);
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	setupPatient()													*
+	//!		Description: Sets a mock up as the patient seed, a rate per waveform.	*
+	//!		Param : eHealthClassMock & mock, uint32_t seed, uint16_t ecgRate,		*
+	//!				uint16_t emgRate, uint16_t airFlowRate							*
+	//!		Returns: void															*
+	//!		Example: eHealthFleet::setupPatient(mock, seed, 250, 0, 25);			*
+	//!******************************************************************************
+
+	void eHealthFleet::setupPatient(eHealthClassMock & mock, uint32_t seed, uint16_t ecgRate,
+		uint16_t emgRate, uint16_t airFlowRate)
+	{
+		// Gravity in mg, in the order of the body positions.
+		static const int16_t postures[5][3] = {
+			{0, 0, 1000}, {0, -1000, 0}, {0, 1000, 0}, {0, 0, -1000}, {1000, 0, 0}
+		};
+
+		mock.seed(seed);
+		mock.readPulsioximeter();
+		mock.initPositionSensor();
+		mock.waveform.setECG(55 + seed % 46, 300, ecgRate);
+		mock.heartbeat.setSampleRate(ecgRate);
+		mock.waveform.setAirFlow(10 + (seed >> 8) % 11, 400, airFlowRate);
+		mock.waveform.setEMG(6 + (seed >> 16) % 13, 400, emgRate);
+
+		const int16_t * g = postures[(seed >> 24) % 5];
+		mock.accelerometer.setGravity(g[0], g[1], g[2]);
+	}
+
+
+//***************************************************************
+// Private Methods												*
+//***************************************************************
+
+	//! Waits for a run, then drains shards until none are left.
+
+	void eHealthFleet::workerLoop(unsigned self)
+	{
+		scratch buffers;
+		uint64_t seen = 0;
+
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> guard(stateLock);
+				wake.wait(guard, [&] { return stopping || generation != seen; });
+				if (stopping) {
+					return;
+				}
+				seen = generation;
+			}
+
+			size_t shard;
+			bool stolen;
+			while (takeShard(self, shard, stolen)) {
+				if (stolen) {
+					steals++;
+				}
+				runShard(shard, buffers);
+
+				if (--pendingShards == 0) {
+					std::lock_guard<std::mutex> guard(stateLock);
+					done.notify_all();
+				}
+			}
+		}
+	}
+
+/*******************************************************************************************************/
+
+	//! Pops from the worker's own queue, or steals from the front of another's.
+
+	bool eHealthFleet::takeShard(unsigned self, size_t & shard, bool & stolen)
+	{
+		{
+			worker & own = *workers[self];
+			std::lock_guard<std::mutex> guard(own.lock);
+			if (!own.shards.empty()) {
+				shard = own.shards.back();
+				own.shards.pop_back();
+				stolen = false;
+				return true;
+			}
+		}
+
+		for (size_t i = 1; i < workers.size(); i++) {
+			worker & victim = *workers[(self + i) % workers.size()];
+			std::lock_guard<std::mutex> guard(victim.lock);
+			if (!victim.shards.empty()) {
+				shard = victim.shards.front();
+				victim.shards.pop_front();
+				stolen = true;
+				return true;
+			}
+		}
+		return false;
+	}
+
+/*******************************************************************************************************/
+
+	//! Generates the current slice for every patient of shard.
+
+	void eHealthFleet::runShard(size_t shard, scratch & buffers)
+	{
+		size_t first = shard * config.shardSize;
+		size_t last = std::min(first + config.shardSize, patients.size());
+
+		size_t ecgCount = samplesDue(config.ecgRate);
+		size_t emgCount = samplesDue(config.emgRate);
+		size_t airFlowCount = samplesDue(config.airFlowRate);
+		size_t gsrCount = samplesDue(config.gsrRate);
+		size_t positionCount = samplesDue(config.positionRate);
+
+		// Accelerometer samples are counted from the fleet start, as the
+		// device counts them from power-on.
+		uint32_t positionIndex = (uint32_t)(config.positionRate * sliceStart / 1000000);
+
+		buffers.analog.resize(ecgCount + emgCount);
+		buffers.airFlow.resize(airFlowCount);
+		buffers.gsr.resize(gsrCount);
+		buffers.accel.resize(3 * positionCount);
+		buffers.position.resize(positionCount);
+
+		float * ecg = buffers.analog.data();
+		float * emg = ecg + ecgCount;
+
+		eHealthFleetBlock block;
+		block.ecg = ecg;
+		block.ecgCount = ecgCount;
+		block.emg = emg;
+		block.emgCount = emgCount;
+		block.airFlow = buffers.airFlow.data();
+		block.airFlowCount = airFlowCount;
+		block.gsr = buffers.gsr.data();
+		block.gsrCount = gsrCount;
+		block.position = buffers.position.data();
+		block.positionCount = positionCount;
+
+		for (size_t i = first; i < last; i++) {
+			eHealthClassMock & p = patients[i];
+
+			if (ecgCount) {
+				p.getECGBlock(ecg, ecgCount);
+			}
+			if (emgCount) {
+				p.getEMGBlock(emg, emgCount);
+			}
+			if (airFlowCount) {
+				p.getAirFlowBlock(buffers.airFlow.data(), airFlowCount);
+			}
+			if (gsrCount) {
+				p.getGSRBlock(buffers.gsr.data(), gsrCount);
+			}
+			if (positionCount) {
+				p.accelerometer.generate(positionIndex, positionCount, buffers.accel.data());
+				p.positionClassifier.classify(buffers.accel.data(), positionCount, buffers.position.data());
+			}
+
+			if (sink) {
+				block.patient = i;
+				block.bpm = p.heartbeat.bpm();
+				block.rrInterval = p.heartbeat.rrInterval();
+				(*sink)(block);
+			}
+		}
+
+		samples += (uint64_t)(last - first) * (ecgCount + emgCount + airFlowCount + gsrCount + positionCount);
+	}
+
+/*******************************************************************************************************/
+
+	//! Samples a channel at rate owes for the current slice. Counting from the
+	//! fleet start keeps fractional samples from being lost between runs.
+
+	size_t eHealthFleet::samplesDue(uint16_t rate) const
+	{
+		return (size_t)(rate * sliceEnd / 1000000 - rate * sliceStart / 1000000);
+	}
+
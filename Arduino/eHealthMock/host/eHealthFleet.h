@@ -0,0 +1,180 @@
+/*
+*=========================================================================================
+ *  Multi-patient fleet simulator for the host build of the eHealth Mock.
+ *
+ *  Owns N independent eHealthClassMock instances, one per simulated patient,
+ *  each with its own state, random stream and vital signs. A pool of worker
+ *  threads generates the patients' readings in shards; idle workers steal
+ *  shards from busy ones so uneven shards do not leave threads idle.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthFleet_h
+#define eHealthFleet_h
+
+#include "eHealthMock.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+	//! Configuration of a fleet.
+	struct eHealthFleetConfig {
+		//! Number of simulated patients.
+		size_t patients = 1000;
+		//! Worker threads. 0 uses one per hardware thread.
+		unsigned workers = 0;
+		//! Patients per unit of work handed to a worker.
+		size_t shardSize = 64;
+		//! Seed of the whole fleet. Patient i is seeded from (seed, i).
+		uint32_t seed = 1;
+		//! Sample rates in Hz. 0 disables the channel.
+		uint16_t ecgRate = 250;
+		uint16_t emgRate = 0;
+		uint16_t airFlowRate = 25;
+		uint16_t gsrRate = 10;
+		//! Accelerometer samples classified into body positions.
+		uint16_t positionRate = 50;
+	};
+
+	//! Readings of one patient for one slice of simulated time.
+	struct eHealthFleetBlock {
+		size_t patient;
+		const float * ecg;
+		size_t ecgCount;
+		const float * emg;
+		size_t emgCount;
+		const int * airFlow;
+		size_t airFlowCount;
+		const eHealthClassMock::gsrSample * gsr;
+		size_t gsrCount;
+		const uint8_t * position;
+		size_t positionCount;
+		//! Heart rate and RR interval in ms the patient's ECG shows so far,
+		//! 0 until found.
+		uint8_t bpm;
+		uint16_t rrInterval;
+	};
+
+	//! Result of eHealthFleet::run().
+	struct eHealthFleetReport {
+		uint64_t samples = 0;
+		double simulatedSeconds = 0;
+		double wallSeconds = 0;
+		double samplesPerSecond = 0;
+		uint64_t shards = 0;
+		uint64_t steals = 0;
+	};
+
+// Library interface description
+class eHealthFleet {
+
+	public:
+
+		//! Called by the workers with each patient's readings. Must be thread safe.
+		typedef std::function<void (const eHealthFleetBlock &)> consumer;
+
+		//! Creates the patients and starts the worker threads.
+		explicit eHealthFleet(const eHealthFleetConfig & config);
+
+		//! Stops the worker threads.
+		~eHealthFleet();
+
+		eHealthFleet(const eHealthFleet &) = delete;
+		eHealthFleet & operator = (const eHealthFleet &) = delete;
+
+		//! Simulates seconds of acquisition for every patient.
+		/*!
+		 *  Consecutive runs continue where the previous one stopped.
+		\param double seconds : simulated time to generate.
+		\param consumer sink : receives every patient's readings, may be empty.
+		\return eHealthFleetReport : samples generated and throughput.
+		*/	eHealthFleetReport run(double seconds, const consumer & sink = consumer());
+
+		//! Returns patient i.
+		eHealthClassMock & patient(size_t i) { return patients[i]; }
+
+		//! Returns the number of patients.
+		size_t size(void) const { return patients.size(); }
+
+		//! Returns the number of worker threads.
+		unsigned workerCount(void) const { return (unsigned)workers.size(); }
+
+		//! Returns the seed patient i was created with.
+		static uint32_t patientSeed(uint32_t fleetSeed, size_t i);
+
+		//! Sets mock up as the patient seed: its random stream, waveforms,
+		//! posture and heartbeat detector, every channel at rate samples per second.
+		static void setupPatient(eHealthClassMock & mock, uint32_t seed, uint16_t rate);
+
+		//! Sets mock up as the patient seed, with a rate per waveform.
+		/*!
+		 *  Fleet patient i is setupPatient(patient(i), patientSeed(fleetSeed, i), ...).
+		\param eHealthClassMock & mock : the patient.
+		\param uint32_t seed : its seed, usually from patientSeed().
+		\param uint16_t ecgRate : samples per second of the ECG and the heartbeat detector.
+		\param uint16_t emgRate : samples per second of the EMG.
+		\param uint16_t airFlowRate : samples per second of the air flow.
+		*/	static void setupPatient(eHealthClassMock & mock, uint32_t seed, uint16_t ecgRate,
+				uint16_t emgRate, uint16_t airFlowRate);
+
+	private:
+
+		//! Per worker queue of shard indices. The owner pops from the back,
+		//! thieves take from the front.
+		struct worker {
+			std::thread thread;
+			std::mutex lock;
+			std::deque<size_t> shards;
+		};
+
+		//! Buffers a worker reuses from shard to shard.
+		struct scratch {
+			std::vector<float> analog;
+			std::vector<int> airFlow;
+			std::vector<eHealthClassMock::gsrSample> gsr;
+			std::vector<int16_t> accel;
+			std::vector<uint8_t> position;
+		};
+
+		void workerLoop(unsigned self);
+		bool takeShard(unsigned self, size_t & shard, bool & stolen);
+		void runShard(size_t shard, scratch & buffers);
+
+		//! Samples a channel at rate owes for the current slice.
+		size_t samplesDue(uint16_t rate) const;
+
+		eHealthFleetConfig config;
+		std::vector<eHealthClassMock> patients;
+		std::vector<std::unique_ptr<worker>> workers;
+
+		std::mutex stateLock;
+		std::condition_variable wake;
+		std::condition_variable done;
+		uint64_t generation = 0;
+		bool stopping = false;
+
+		//! Current slice, in simulated microseconds since the fleet started.
+		uint64_t sliceStart = 0;
+		uint64_t sliceEnd = 0;
+		const consumer * sink = nullptr;
+
+		std::atomic<size_t> pendingShards{0};
+		std::atomic<unsigned> busyWorkers{0};
+		std::atomic<uint64_t> samples{0};
+		std::atomic<uint64_t> steals{0};
+};
+
+#endif
+
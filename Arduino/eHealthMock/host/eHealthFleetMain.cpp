@@ -0,0 +1,86 @@
+/*
+*=========================================================================================
+ *  ehealth_fleet: runs a fleet of simulated patients and reports throughput.
+ *
+ *  Usage: ehealth_fleet [--patients N] [--workers N] [--seconds S] [--runs N]
+ *                       [--seed N] [--ecg HZ] [--emg HZ] [--airflow HZ] [--gsr HZ]
+ *                       [--position HZ]
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthFleet.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+	static void usage(void)
+	{
+		fprintf(stderr,
+			"usage: ehealth_fleet [--patients N] [--workers N] [--seconds S] [--runs N]\n"
+			"                     [--seed N] [--ecg HZ] [--emg HZ] [--airflow HZ] [--gsr HZ]\n"
+			"                     [--position HZ]\n");
+		exit(2);
+	}
+
+	int main(int argc, char ** argv)
+	{
+		eHealthFleetConfig config;
+		config.patients = 10000;
+		double seconds = 10;
+		int runs = 3;
+
+		for (int i = 1; i < argc; i++) {
+			if (i + 1 >= argc) {
+				usage();
+			}
+			const char * option = argv[i];
+			const char * value = argv[++i];
+
+			if (!strcmp(option, "--patients")) {
+				config.patients = strtoul(value, NULL, 10);
+			} else if (!strcmp(option, "--workers")) {
+				config.workers = strtoul(value, NULL, 10);
+			} else if (!strcmp(option, "--seconds")) {
+				seconds = atof(value);
+			} else if (!strcmp(option, "--runs")) {
+				runs = atoi(value);
+			} else if (!strcmp(option, "--seed")) {
+				config.seed = strtoul(value, NULL, 10);
+			} else if (!strcmp(option, "--ecg")) {
+				config.ecgRate = atoi(value);
+			} else if (!strcmp(option, "--emg")) {
+				config.emgRate = atoi(value);
+			} else if (!strcmp(option, "--airflow")) {
+				config.airFlowRate = atoi(value);
+			} else if (!strcmp(option, "--gsr")) {
+				config.gsrRate = atoi(value);
+			} else if (!strcmp(option, "--position")) {
+				config.positionRate = atoi(value);
+			} else {
+				usage();
+			}
+		}
+
+		eHealthFleet fleet(config);
+
+		printf("patients %zu workers %u simulated %.1f s per run\n",
+			fleet.size(), fleet.workerCount(), seconds);
+
+		for (int run = 0; run < runs; run++) {
+			eHealthFleetReport report = fleet.run(seconds);
+
+			printf("run %d: %llu samples in %.3f s, %.1f M samples/s, %llu shards, %llu steals\n",
+				run + 1, (unsigned long long)report.samples, report.wallSeconds,
+				report.samplesPerSecond / 1e6, (unsigned long long)report.shards,
+				(unsigned long long)report.steals);
+		}
+		return 0;
+	}
+
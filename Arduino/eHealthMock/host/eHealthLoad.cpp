@@ -0,0 +1,271 @@
+/*
+*=========================================================================================
+ *  Rate-controlled load generator for the host build of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthLoad.h"
+#include "eHealthFleet.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <thread>
+#include <time.h>
+
+	//! Latencies in microseconds, in buckets 1/16 of a power of 2 wide:
+	//! exact below 32 us, within 6% above.
+	class latencyHistogram {
+
+		public:
+
+			void add(uint64_t value)
+			{
+				counts[bucket(value)]++;
+				total++;
+				largest = std::max(largest, value);
+			}
+
+			//! Returns the smallest value at or above fraction of the samples.
+			double percentile(double fraction) const
+			{
+				uint64_t rank = (uint64_t)ceil(fraction * total);
+				uint64_t seen = 0;
+
+				for (size_t i = 0; i < BUCKETS; i++) {
+					seen += counts[i];
+					if (seen && seen >= rank) {
+						return (double)std::min(lowest(i), largest);
+					}
+				}
+				return (double)largest;
+			}
+
+			uint64_t max(void) const { return largest; }
+
+		private:
+
+			static const size_t BUCKETS = 64 * 16;
+
+			static size_t bucket(uint64_t value)
+			{
+				if (value < 32) {
+					return (size_t)value;
+				}
+				unsigned shift = 64 - __builtin_clzll(value) - 5;
+				return (shift + 1) * 16 + (size_t)((value >> shift) - 16);
+			}
+
+			static uint64_t lowest(size_t index)
+			{
+				if (index < 32) {
+					return index;
+				}
+				return (uint64_t)(16 + index % 16) << (index / 16 - 1);
+			}
+
+			uint64_t counts[BUCKETS] = {};
+			uint64_t total = 0;
+			uint64_t largest = 0;
+	};
+
+	//! CPU time of the calling thread, in nanoseconds.
+	static uint64_t threadCpuNanos(void)
+	{
+		timespec now;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+		return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+	}
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	eHealthLoadGenerator::eHealthLoadGenerator(const eHealthLoadConfig & loadConfig)
+		: config(loadConfig), problem(nullptr), snapshotRate(0), period(0), channelCount(0), nextFrame(0)
+	{
+		config.channels &= EHEALTH_CHANNELS;
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			channelCount += (config.channels >> channel) & 1;
+		}
+
+		if (config.devices == 0 || channelCount == 0 || config.batch == 0) {
+			problem = "no devices, channels or snapshots per frame";
+			return;
+		}
+		if (eHealthFrameEncoder::frameSize(config.channels, config.batch) == 0) {
+			problem = "a frame cannot hold that many snapshots of those channels";
+			return;
+		}
+
+		snapshotRate = config.rate / ((double)channelCount * config.devices);
+		if (!(snapshotRate >= 16 && snapshotRate <= 65535)) {
+			problem = "the rate of each device must be between 16 Hz and 65 kHz";
+			return;
+		}
+		period = (uint16_t)lround(1e6 / snapshotRate);
+		uint16_t hz = (uint16_t)lround(snapshotRate);
+
+		devices.reserve(config.devices);
+		for (size_t i = 0; i < config.devices; i++) {
+			devices.emplace_back(new device());
+			eHealthFleet::setupPatient(devices.back()->mock, eHealthFleet::patientSeed(config.seed, i), hz);
+		}
+
+		columns.resize((size_t)EHEALTH_CHANNEL_COUNT * config.batch);
+		values.resize((size_t)channelCount * config.batch);
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	//!******************************************************************************
+	//!		Name:	run()															*
+	//!		Description: Generates seconds of paced load into sink.					*
+	//!		Param : double seconds, eHealthSink & sink								*
+	//!		Returns: eHealthLoadReport with throughput, drops and latency			*
+	//!		Example: eHealthLoadReport report = load.run(10, sink);					*
+	//!******************************************************************************
+
+	eHealthLoadReport eHealthLoadGenerator::run(double seconds, eHealthSink & sink)
+	{
+		typedef std::chrono::steady_clock clock;
+
+		eHealthLoadReport report;
+		if (problem) {
+			return report;
+		}
+
+		uint32_t perFrame = (uint32_t)channelCount * config.batch;
+		double frameRate = config.rate / perFrame;
+		uint64_t frames = (uint64_t)(seconds * frameRate);
+		auto maxLag = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(config.maxLag));
+
+		latencyHistogram latency;
+		std::vector<uint8_t> buffer;
+		std::vector<clock::time_point> pending;
+		bool open = true;
+
+		// Writes the buffered frames and records how late each one is.
+		auto flush = [&]() {
+			if (buffer.empty()) {
+				return;
+			}
+			size_t written = sink.write(buffer.data(), buffer.size());
+			clock::time_point now = clock::now();
+			report.writes++;
+
+			if (written < buffer.size()) {
+				report.dropped += pending.size() * perFrame;
+				open = false;
+			} else {
+				for (const clock::time_point & due : pending) {
+					latency.add((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - due).count());
+				}
+				report.samples += pending.size() * perFrame;
+				report.frames += pending.size();
+				report.bytes += written;
+			}
+			buffer.clear();
+			pending.clear();
+		};
+
+		clock::time_point start = clock::now();
+		uint64_t cpuStart = threadCpuNanos();
+		uint64_t k = 0;
+
+		for (; k < frames && open; k++) {
+			clock::time_point due = start + std::chrono::duration_cast<clock::duration>(
+				std::chrono::duration<double>(k / frameRate));
+			clock::time_point now = clock::now();
+
+			// Ahead of schedule: send what is waiting, then wait.
+			if (now < due) {
+				flush();
+				std::this_thread::sleep_until(due);
+			} else if (now - due > maxLag) {
+				// The device's clock moves on: the receiver sees the gap.
+				devices[nextFrame++ % devices.size()]->snapshots += config.batch;
+				report.dropped += perFrame;
+				continue;
+			}
+
+			emit(*devices[nextFrame++ % devices.size()], buffer);
+			pending.push_back(due);
+			if (buffer.size() >= config.flushBytes) {
+				flush();
+			}
+		}
+		flush();
+
+		// A closed sink drops whatever was still to come.
+		report.dropped += (frames - k) * perFrame;
+
+		report.wallSeconds = std::chrono::duration<double>(clock::now() - start).count();
+		report.targetRate = config.rate;
+		report.achievedRate = report.wallSeconds > 0 ? report.samples / report.wallSeconds : 0;
+		report.cpuNanosPerSample = report.samples ? (double)(threadCpuNanos() - cpuStart) / report.samples : 0;
+		report.latencyP50 = latency.percentile(0.5);
+		report.latencyP90 = latency.percentile(0.9);
+		report.latencyP99 = latency.percentile(0.99);
+		report.latencyP999 = latency.percentile(0.999);
+		report.latencyMax = (double)latency.max();
+		return report;
+	}
+
+
+//***************************************************************
+// Private Methods												*
+//***************************************************************
+
+	//! Reads the next batch of device d and appends its frame, or packets, to out.
+
+	void eHealthLoadGenerator::emit(device & d, std::vector<uint8_t> & out)
+	{
+		eHealthSnapshotBlock block = {};
+		block.period = period;
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (config.channels & EHEALTH_CHANNEL_BIT(channel)) {
+				block.values[channel] = &columns[(size_t)channel * config.batch];
+			}
+		}
+		d.mock.sampleAllBlock(block, config.batch);
+
+		// Columns to snapshot major, as the encoders take them.
+		uint8_t column = 0;
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (block.values[channel]) {
+				for (uint8_t i = 0; i < config.batch; i++) {
+					values[(size_t)i * channelCount + column] = block.values[channel][i];
+				}
+				column++;
+			}
+		}
+
+		uint32_t timestamp = d.snapshots * (uint32_t)period;
+		d.snapshots += config.batch;
+
+		size_t size = out.size();
+		if (!config.compress) {
+			out.resize(size + EHEALTH_FRAME_MAX_SIZE);
+			out.resize(size + d.frames.encode(config.channels, config.batch, timestamp, period,
+				values.data(), &out[size], EHEALTH_FRAME_MAX_SIZE));
+			return;
+		}
+
+		// Noise can take more than one packet.
+		for (uint8_t done = 0, used = 0; done < config.batch; done += used) {
+			out.resize(size + EHEALTH_PACKET_MAX_SIZE);
+			size += d.packets.encodeSome(config.channels, config.batch - done, timestamp + (uint32_t)done * period,
+				period, &values[(size_t)done * channelCount], &out[size], EHEALTH_PACKET_MAX_SIZE, used);
+			out.resize(size);
+		}
+	}
@@ -0,0 +1,134 @@
+/*
+*=========================================================================================
+ *  Rate-controlled load generator for the host build of the eHealth Mock.
+ *
+ *  Drives N eHealthClassMock devices at a target aggregate rate in samples
+ *  per second and writes their binary frames (or codec packets) to a sink,
+ *  to size whatever ingests them. The devices take turns: frame k comes
+ *  from device k % N and is due k / frameRate seconds after the start.
+ *
+ *  Pacing is open loop. The schedule never waits for the sink, so a slow
+ *  reader shows up as latency instead of a lower offered rate. Latency runs
+ *  from the moment a frame was due to the moment the write holding it
+ *  returned; frames are written together when flushBytes have accumulated
+ *  or the generator is ahead of schedule. A frame that falls more than
+ *  maxLag behind schedule is dropped, not sent late.
+ *
+ *  Samples are read with sampleAllBlock(), which pays none of the getters'
+ *  settling delays, so a single thread offers millions of samples a second.
+ *  The frames of all devices share one stream; each device numbers its own.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthLoad_h
+#define eHealthLoad_h
+
+#include "eHealthMock.h"
+
+#include <memory>
+#include <vector>
+
+	//! Configuration of a load run.
+	struct eHealthLoadConfig {
+		//! Number of virtual devices.
+		size_t devices = 100;
+		//! Aggregate samples per second over every device and channel.
+		double rate = 1e6;
+		//! Channels each device sends (EHEALTH_CHANNEL_BIT).
+		uint16_t channels = EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_EMG)
+			| EHEALTH_CHANNEL_BIT(EHEALTH_AIRFLOW) | EHEALTH_CHANNEL_BIT(EHEALTH_GSR);
+		//! Snapshots per frame.
+		uint8_t batch = 16;
+		//! Send codec packets (eHealthCodec.h) instead of frames.
+		bool compress = false;
+		//! Bytes collected before a write. 0 writes every frame on its own.
+		size_t flushBytes = 0;
+		//! Seconds behind schedule after which frames are dropped.
+		double maxLag = 0.1;
+		//! Seed of the devices. Device i is seeded as fleet patient i.
+		uint32_t seed = 1;
+	};
+
+	//! Result of eHealthLoadGenerator::run().
+	struct eHealthLoadReport {
+		uint64_t samples = 0;
+		uint64_t dropped = 0;
+		uint64_t frames = 0;
+		uint64_t bytes = 0;
+		uint64_t writes = 0;
+		double wallSeconds = 0;
+		double targetRate = 0;
+		double achievedRate = 0;
+		//! CPU time of the generating thread per sample sent.
+		double cpuNanosPerSample = 0;
+		//! Due to written, in microseconds.
+		double latencyP50 = 0;
+		double latencyP90 = 0;
+		double latencyP99 = 0;
+		double latencyP999 = 0;
+		double latencyMax = 0;
+	};
+
+// Library interface description
+class eHealthLoadGenerator {
+
+	public:
+
+		//! Creates and seeds the devices.
+		explicit eHealthLoadGenerator(const eHealthLoadConfig & config);
+
+		//! Returns false, with the reason in error(), if the configuration
+		//! cannot be run: no devices or channels, or a frame that cannot hold
+		//! batch snapshots, or a device rate outside 16 Hz to 65 kHz.
+		bool valid(void) const { return !problem; }
+
+		//! Returns why the configuration is not valid.
+		const char * error(void) const { return problem; }
+
+		//! Returns the snapshots per second of each device.
+		double deviceRate(void) const { return snapshotRate; }
+
+		//! Generates seconds of load into sink.
+		/*!
+		 *  Consecutive runs continue the devices' streams. The run stops early
+		 *  when the sink stops taking bytes; the rest counts as dropped.
+		\param double seconds : time to run for.
+		\param eHealthSink & sink : receives the frames.
+		\return eHealthLoadReport : what was sent, and how late.
+		*/	eHealthLoadReport run(double seconds, eHealthSink & sink);
+
+	private:
+
+		//! One virtual device: the mock, its encoders and its position in time.
+		struct device {
+			eHealthClassMock mock;
+			eHealthFrameEncoder frames;
+			eHealthCodecEncoder packets;
+			uint32_t snapshots = 0;
+		};
+
+		//! Reads the next batch of device d and appends its frame, or packets,
+		//! to out.
+		void emit(device & d, std::vector<uint8_t> & out);
+
+		eHealthLoadConfig config;
+		const char * problem;
+		double snapshotRate;
+		uint16_t period;
+		uint8_t channelCount;
+
+		std::vector<std::unique_ptr<device>> devices;
+		uint64_t nextFrame;
+
+		//! Column per channel for sampleAllBlock(), and the same snapshot major.
+		std::vector<uint16_t> columns;
+		std::vector<uint16_t> values;
+};
+
+#endif
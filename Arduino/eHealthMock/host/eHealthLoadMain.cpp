@@ -0,0 +1,172 @@
+/*
+*=========================================================================================
+ *  ehealth_load: offers a paced stream of frames from many devices and
+ *  reports the rate achieved, the latency and the samples dropped.
+ *
+ *  Usage: ehealth_load [--devices N] [--rate SAMPLES/S] [--channels LIST]
+ *                      [--batch N] [--format frame|packet] [--seconds S]
+ *                      [--flush BYTES] [--max-lag MS] [--seed N]
+ *                      [--out FILE | --socket PATH]
+ *
+ *  --channels takes names separated by commas (ecg,emg,airflow,gsr,
+ *  temperature,spo2,bpm,position,systolic,diastolic,glucose). --out writes
+ *  to a file or a named pipe, - for stdout; --socket connects to a Unix
+ *  stream socket. Without either the stream is discarded, which measures
+ *  the generator alone. The report goes to stderr:
+ *
+ *    ehealth_load --devices 1000 --rate 1000000 --seconds 10 --socket /tmp/ingest
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthLoad.h"
+#include "eHealthSinks.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+	static const char * const channelNames[EHEALTH_CHANNEL_COUNT] = {
+		"ecg", "emg", "airflow", "gsr", "temperature", "spo2", "bpm", "position",
+		"systolic", "diastolic", "glucose"
+	};
+
+	//! Sink that keeps nothing.
+	class discardSink : public eHealthSink {
+		public:
+			size_t write(const uint8_t *, size_t length) override { return length; }
+	};
+
+	static void usage(void)
+	{
+		fprintf(stderr,
+			"usage: ehealth_load [--devices N] [--rate SAMPLES/S] [--channels LIST]\n"
+			"                    [--batch N] [--format frame|packet] [--seconds S]\n"
+			"                    [--flush BYTES] [--max-lag MS] [--seed N]\n"
+			"                    [--out FILE | --socket PATH]\n");
+		exit(2);
+	}
+
+	//! Parses a comma separated list of channel names into a bitmap, 0 if one is unknown.
+	static uint16_t parseChannels(const char * list)
+	{
+		uint16_t channels = 0;
+
+		while (*list) {
+			size_t length = strcspn(list, ",");
+			uint8_t channel = 0;
+			while (channel < EHEALTH_CHANNEL_COUNT
+				&& (strlen(channelNames[channel]) != length || strncmp(channelNames[channel], list, length))) {
+				channel++;
+			}
+			if (channel == EHEALTH_CHANNEL_COUNT) {
+				return 0;
+			}
+			channels |= EHEALTH_CHANNEL_BIT(channel);
+			list += length + (list[length] == ',');
+		}
+		return channels;
+	}
+
+	//! Opens the socket, or else the file, - for stdout.
+	static eHealthFdSink openOutput(const char * outPath, const char * socketPath)
+	{
+		if (socketPath) {
+			return eHealthFdSink::connectUnix(socketPath);
+		}
+		if (!strcmp(outPath, "-")) {
+			return eHealthFdSink(STDOUT_FILENO);
+		}
+		return eHealthFdSink(open(outPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644), true);
+	}
+
+	int main(int argc, char ** argv)
+	{
+		eHealthLoadConfig config;
+		double seconds = 10;
+		const char * outPath = nullptr;
+		const char * socketPath = nullptr;
+
+		// A reader that exits early, on a pipe as on a socket, stops the run
+		// with EPIPE: the rest is reported as dropped.
+		signal(SIGPIPE, SIG_IGN);
+
+		for (int i = 1; i < argc; i++) {
+			if (i + 1 >= argc) {
+				usage();
+			}
+			const char * option = argv[i];
+			const char * value = argv[++i];
+
+			if (!strcmp(option, "--devices")) {
+				config.devices = strtoul(value, NULL, 10);
+			} else if (!strcmp(option, "--rate")) {
+				config.rate = atof(value);
+			} else if (!strcmp(option, "--channels")) {
+				config.channels = parseChannels(value);
+			} else if (!strcmp(option, "--batch")) {
+				int batch = atoi(value);
+				config.batch = (uint8_t)(batch < 0 || batch > 255 ? 0 : batch);
+			} else if (!strcmp(option, "--format")) {
+				if (strcmp(value, "frame") && strcmp(value, "packet")) {
+					usage();
+				}
+				config.compress = !strcmp(value, "packet");
+			} else if (!strcmp(option, "--seconds")) {
+				seconds = atof(value);
+			} else if (!strcmp(option, "--flush")) {
+				config.flushBytes = strtoul(value, NULL, 10);
+			} else if (!strcmp(option, "--max-lag")) {
+				config.maxLag = atof(value) / 1000;
+			} else if (!strcmp(option, "--seed")) {
+				config.seed = strtoul(value, NULL, 10);
+			} else if (!strcmp(option, "--out")) {
+				outPath = value;
+			} else if (!strcmp(option, "--socket")) {
+				socketPath = value;
+			} else {
+				usage();
+			}
+		}
+		if (outPath && socketPath) {
+			usage();
+		}
+
+		eHealthLoadGenerator load(config);
+		if (!load.valid()) {
+			fprintf(stderr, "ehealth_load: %s\n", load.error());
+			return 2;
+		}
+
+		discardSink discard;
+		eHealthFdSink descriptor = outPath || socketPath ? openOutput(outPath, socketPath) : eHealthFdSink(-1);
+		if ((outPath || socketPath) && !descriptor.isOpen()) {
+			perror(socketPath ? socketPath : outPath);
+			return 1;
+		}
+		eHealthSink & sink = outPath || socketPath ? (eHealthSink &)descriptor : discard;
+
+		fprintf(stderr, "%zu devices at %.1f Hz, %.0f samples/s offered for %.1f s\n",
+			config.devices, load.deviceRate(), config.rate, seconds);
+
+		eHealthLoadReport report = load.run(seconds, sink);
+
+		fprintf(stderr, "sent %llu samples in %llu %s, %llu bytes, %llu writes, in %.3f s\n",
+			(unsigned long long)report.samples, (unsigned long long)report.frames,
+			config.compress ? "batches" : "frames", (unsigned long long)report.bytes,
+			(unsigned long long)report.writes, report.wallSeconds);
+		fprintf(stderr, "rate %.0f samples/s of %.0f (%.1f%%), dropped %llu samples\n",
+			report.achievedRate, report.targetRate, 100 * report.achievedRate / report.targetRate,
+			(unsigned long long)report.dropped);
+		fprintf(stderr, "latency us p50 %.0f p90 %.0f p99 %.0f p99.9 %.0f max %.0f\n",
+			report.latencyP50, report.latencyP90, report.latencyP99, report.latencyP999, report.latencyMax);
+		fprintf(stderr, "cpu %.1f ns per sample\n", report.cpuNanosPerSample);
+		return 0;
+	}
@@ -0,0 +1,118 @@
+/*
+*=========================================================================================
+ *  ehealth_pty: plays an eHealth board on a pseudo-terminal, so serial
+ *  readers such as ArduinoConnector.py can be run without the hardware.
+ *
+ *  Usage: ehealth_pty [--baud N] [--format text|frame] [--rate RECORDS/S]
+ *                     [--seconds S] [--link PATH] [--seed N]
+ *
+ *  Prints the path of the port, then waits for a reader to open it. Text
+ *  lines are "<bpm> <skin conductance>\r\n"; frames carry ECG, EMG, air
+ *  flow, GSR and BPM. Without --rate, records go back to back at the baud
+ *  rate (9600 to 2000000). With --seconds the emulator runs that long once
+ *  the reader opens the port and exits; without, it serves each reader
+ *  until it closes the port. A report of each run goes to stderr:
+ *
+ *    ehealth_pty --baud 1000000 --link /tmp/ttyEHEALTH0 &
+ *    python3 ArduinoConnector.py /tmp/ttyEHEALTH0 1000000
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthSerialPty.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+	static const char * linkPath = nullptr;
+
+	//! Removes the link on SIGINT and SIGTERM, which end a run at any point.
+	static void stop(int)
+	{
+		if (linkPath) {
+			unlink(linkPath);
+		}
+		_exit(0);
+	}
+
+	static void usage(void)
+	{
+		fprintf(stderr,
+			"usage: ehealth_pty [--baud N] [--format text|frame] [--rate RECORDS/S]\n"
+			"                   [--seconds S] [--link PATH] [--seed N]\n");
+		exit(2);
+	}
+
+	static void report(const eHealthPtyReport & run, bool frames)
+	{
+		fprintf(stderr, "sent %llu %s, %llu bytes in %.3f s: %.0f %s/s, %.0f bytes/s, line %.1f%% busy\n",
+			(unsigned long long)run.records, frames ? "frames" : "lines", (unsigned long long)run.bytes,
+			run.wallSeconds, run.recordRate, frames ? "frames" : "lines", run.byteRate, 100 * run.lineLoad);
+		fprintf(stderr, "overrun %llu bytes, cpu %.3f s%s\n", (unsigned long long)run.overrun, run.cpuSeconds,
+			run.hangup ? ", reader closed the port" : "");
+	}
+
+	int main(int argc, char ** argv)
+	{
+		eHealthPtyConfig config;
+		double seconds = 0;
+
+		for (int i = 1; i < argc; i++) {
+			if (i + 1 >= argc) {
+				usage();
+			}
+			const char * option = argv[i];
+			const char * value = argv[++i];
+
+			if (!strcmp(option, "--baud")) {
+				config.baud = strtoul(value, NULL, 10);
+			} else if (!strcmp(option, "--format")) {
+				if (strcmp(value, "text") && strcmp(value, "frame")) {
+					usage();
+				}
+				config.frames = !strcmp(value, "frame");
+			} else if (!strcmp(option, "--rate")) {
+				config.rate = atof(value);
+			} else if (!strcmp(option, "--seconds")) {
+				seconds = atof(value);
+			} else if (!strcmp(option, "--link")) {
+				linkPath = value;
+			} else if (!strcmp(option, "--seed")) {
+				config.seed = strtoul(value, NULL, 10);
+			} else {
+				usage();
+			}
+		}
+
+		eHealthSerialPty pty(config);
+		if (!pty.open() || (linkPath && !pty.link(linkPath))) {
+			fprintf(stderr, "ehealth_pty: %s\n", pty.error());
+			return 1;
+		}
+
+		struct sigaction action = {};
+		action.sa_handler = stop;
+		sigaction(SIGINT, &action, NULL);
+		sigaction(SIGTERM, &action, NULL);
+
+		// Writes after the reader is gone fail, they do not kill the emulator.
+		signal(SIGPIPE, SIG_IGN);
+
+		printf("%s\n", linkPath ? linkPath : pty.path());
+		fflush(stdout);
+		fprintf(stderr, "%s at %lu baud, %.1f %s/s\n", pty.path(), (unsigned long)config.baud,
+			pty.sampleRate(), config.frames ? "frames" : "lines");
+
+		do {
+			pty.waitForReader(-1);
+			report(pty.run(seconds), config.frames);
+		} while (seconds <= 0);
+		return 0;
+	}
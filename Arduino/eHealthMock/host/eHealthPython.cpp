@@ -0,0 +1,447 @@
+/*
+*=========================================================================================
+ *  ehealthmock: Python binding of the host build of the eHealth Mock.
+ *
+ *  A Mock is one eHealthClassMock. Its block methods fill any writable,
+ *  C-contiguous buffer in place: a NumPy array, an array.array or a
+ *  memoryview. Given a count instead, they return a new memoryview of that
+ *  many samples, which numpy.asarray() views without a copy. No Python
+ *  object is made per sample, and the GIL is released while the samples
+ *  are generated, so other threads run meanwhile.
+ *
+ *    import array, ehealthmock
+ *    mock = ehealthmock.Mock(seed=7, rate=500)
+ *    ecg = array.array('f', bytes(4 * 100000))
+ *    mock.ecg(ecg)                    # volts; an int16 buffer gets millivolts
+ *    rows = mock.block(1000, ehealthmock.ECG | ehealthmock.AIRFLOW)
+ *
+ *  A Mock serves one call at a time; concurrent calls on it wait. The
+ *  simulated clock is per thread, as in the rest of the host build.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <pythread.h>
+
+#include "eHealthFleet.h"
+#include "eHealthMock.h"
+
+#include <math.h>
+#include <new>
+#include <string.h>
+
+	//! Python object holding one mock.
+	struct mockObject {
+		PyObject_HEAD
+		eHealthClassMock * mock;
+		PyThread_type_lock lock;
+		uint16_t rate;
+	};
+
+	//! Element types of the buffers filled, as bits of a set.
+	enum sampleType {
+		SAMPLE_FLOAT = 1,	// float32, "f"
+		SAMPLE_INT16 = 2,	// int16 or uint16, "h" or "H"
+		SAMPLE_INT32 = 4	// int32, "i"
+	};
+
+	//! Returns the sampleType of view, 0 for any other element type.
+	static unsigned typeOf(const Py_buffer & view)
+	{
+		const char * format = view.format ? view.format : "B";
+
+		// Native and little-endian standard sizes are the same on the host.
+		if (*format == '@' || *format == '=' || *format == '<') {
+			format++;
+		}
+		if (!strcmp(format, "f") && view.itemsize == 4) {
+			return SAMPLE_FLOAT;
+		}
+		if ((!strcmp(format, "h") || !strcmp(format, "H")) && view.itemsize == 2) {
+			return SAMPLE_INT16;
+		}
+		if ((!strcmp(format, "i") || !strcmp(format, "I")) && view.itemsize == 4) {
+			return SAMPLE_INT32;
+		}
+		return 0;
+	}
+
+	//! Returns false, with a Python error set, if self was never initialized.
+	static bool ready(mockObject * self)
+	{
+		if (!self->mock) {
+			PyErr_SetString(PyExc_RuntimeError, "Mock.__init__() was not called");
+			return false;
+		}
+		return true;
+	}
+
+	//! Takes the lock of self, letting other threads run while it waits.
+	static void acquire(mockObject * self)
+	{
+		if (!PyThread_acquire_lock(self->lock, NOWAIT_LOCK)) {
+			Py_BEGIN_ALLOW_THREADS
+			PyThread_acquire_lock(self->lock, WAIT_LOCK);
+			Py_END_ALLOW_THREADS
+		}
+	}
+
+	//! Signature of the generators: fill count samples of type at data.
+	typedef void (*blockFill)(eHealthClassMock & mock, unsigned type, void * data, size_t count);
+
+	//! Fills the buffer arg, or a new array of arg samples of type fresh, with fill.
+	/*!
+	 *  Returns the count filled for a buffer and the new memoryview for a
+	 *  count. Buffers of other types than those in types are refused.
+	*/
+	static PyObject * fillBlock(mockObject * self, PyObject * arg, unsigned types, unsigned fresh, blockFill fill)
+	{
+		if (!ready(self)) {
+			return NULL;
+		}
+		if (PyLong_Check(arg)) {
+			Py_ssize_t count = PyLong_AsSsize_t(arg);
+			if (count < 0) {
+				return PyErr_Occurred() ? NULL : PyErr_Format(PyExc_ValueError, "count cannot be negative");
+			}
+			size_t size = fresh == SAMPLE_INT16 ? 2 : 4;
+			PyObject * bytes = PyByteArray_FromStringAndSize(NULL, count * size);
+			if (!bytes) {
+				return NULL;
+			}
+			void * data = PyByteArray_AS_STRING(bytes);
+			acquire(self);
+			Py_BEGIN_ALLOW_THREADS
+			fill(*self->mock, fresh, data, count);
+			Py_END_ALLOW_THREADS
+			PyThread_release_lock(self->lock);
+
+			PyObject * view = PyMemoryView_FromObject(bytes);
+			Py_DECREF(bytes);
+			if (!view) {
+				return NULL;
+			}
+			PyObject * samples = PyObject_CallMethod(view, "cast", "s",
+				fresh == SAMPLE_FLOAT ? "f" : fresh == SAMPLE_INT16 ? "H" : "i");
+			Py_DECREF(view);
+			return samples;
+		}
+
+		Py_buffer view;
+		if (PyObject_GetBuffer(arg, &view, PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE | PyBUF_FORMAT)) {
+			return NULL;
+		}
+		unsigned type = typeOf(view);
+		if (!(type & types)) {
+			PyBuffer_Release(&view);
+			return PyErr_Format(PyExc_TypeError, "expected a count or a buffer of %s%s%s",
+				types & SAMPLE_FLOAT ? "float32 " : "", types & SAMPLE_INT16 ? "int16 " : "",
+				types & SAMPLE_INT32 ? "int32 " : "");
+		}
+
+		size_t count = view.len / view.itemsize;
+		acquire(self);
+		Py_BEGIN_ALLOW_THREADS
+		fill(*self->mock, type, view.buf, count);
+		Py_END_ALLOW_THREADS
+		PyThread_release_lock(self->lock);
+		PyBuffer_Release(&view);
+		return PyLong_FromSize_t(count);
+	}
+
+
+//***************************************************************
+// Generators													*
+//***************************************************************
+
+	static void fillECG(eHealthClassMock & mock, unsigned type, void * data, size_t count)
+	{
+		if (type == SAMPLE_FLOAT) {
+			mock.getECGBlock((float *)data, count);
+		} else {
+			mock.getECGMillivoltsBlock((uint16_t *)data, count);
+		}
+	}
+
+	static void fillEMG(eHealthClassMock & mock, unsigned type, void * data, size_t count)
+	{
+		if (type == SAMPLE_FLOAT) {
+			mock.getEMGBlock((float *)data, count);
+		} else {
+			mock.getEMGMillivoltsBlock((uint16_t *)data, count);
+		}
+	}
+
+	static void fillGSR(eHealthClassMock & mock, unsigned, void * data, size_t count)
+	{
+		mock.getSkinConductanceVoltageBlock((float *)data, count);
+	}
+
+	//! Air flow comes as int: other types are converted a chunk at a time.
+	static void fillAirFlow(eHealthClassMock & mock, unsigned type, void * data, size_t count)
+	{
+		if (type == SAMPLE_INT32) {
+			mock.getAirFlowBlock((int *)data, count);
+			return;
+		}
+		int chunk[256];
+		for (size_t done = 0; done < count;) {
+			size_t n = count - done < 256 ? count - done : 256;
+			mock.getAirFlowBlock(chunk, n);
+			for (size_t i = 0; i < n; i++) {
+				if (type == SAMPLE_FLOAT) {
+					((float *)data)[done + i] = (float)chunk[i];
+				} else {
+					((uint16_t *)data)[done + i] = (uint16_t)chunk[i];
+				}
+			}
+			done += n;
+		}
+	}
+
+
+//***************************************************************
+// Mock methods													*
+//***************************************************************
+
+	static PyObject * mockECG(PyObject * self, PyObject * arg)
+	{
+		return fillBlock((mockObject *)self, arg, SAMPLE_FLOAT | SAMPLE_INT16, SAMPLE_FLOAT, fillECG);
+	}
+
+	static PyObject * mockEMG(PyObject * self, PyObject * arg)
+	{
+		return fillBlock((mockObject *)self, arg, SAMPLE_FLOAT | SAMPLE_INT16, SAMPLE_FLOAT, fillEMG);
+	}
+
+	static PyObject * mockGSR(PyObject * self, PyObject * arg)
+	{
+		return fillBlock((mockObject *)self, arg, SAMPLE_FLOAT, SAMPLE_FLOAT, fillGSR);
+	}
+
+	static PyObject * mockAirFlow(PyObject * self, PyObject * arg)
+	{
+		return fillBlock((mockObject *)self, arg, SAMPLE_FLOAT | SAMPLE_INT16 | SAMPLE_INT32, SAMPLE_INT32, fillAirFlow);
+	}
+
+	//! block(out, channels): snapshots of channels, one row of out per channel.
+	static PyObject * mockBlock(PyObject * object, PyObject * args)
+	{
+		mockObject * self = (mockObject *)object;
+		PyObject * out;
+		unsigned long channels;
+
+		if (!ready(self) || !PyArg_ParseTuple(args, "Ok", &out, &channels)) {
+			return NULL;
+		}
+		channels &= EHEALTH_CHANNELS;
+		Py_ssize_t rows = 0;
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			rows += (channels >> channel) & 1;
+		}
+		if (rows == 0) {
+			return PyErr_Format(PyExc_ValueError, "no channels to read");
+		}
+
+		PyObject * fresh = NULL;
+		if (PyLong_Check(out)) {
+			Py_ssize_t count = PyLong_AsSsize_t(out);
+			if (count < 0) {
+				return PyErr_Occurred() ? NULL : PyErr_Format(PyExc_ValueError, "count cannot be negative");
+			}
+			// A memoryview cannot have a dimension of 0.
+			if (count == 0) {
+				return PyErr_Format(PyExc_ValueError, "count must be at least 1 to return rows");
+			}
+			fresh = out = PyByteArray_FromStringAndSize(NULL, rows * count * 2);
+			if (!fresh) {
+				return NULL;
+			}
+		}
+
+		Py_buffer view;
+		if (PyObject_GetBuffer(out, &view, PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE | PyBUF_FORMAT)) {
+			Py_XDECREF(fresh);
+			return NULL;
+		}
+		if (!fresh && typeOf(view) != SAMPLE_INT16) {
+			PyBuffer_Release(&view);
+			return PyErr_Format(PyExc_TypeError, "expected a count or a buffer of uint16");
+		}
+		size_t count = view.len / 2 / rows;
+
+		// Rows in channel order, each the column sampleAllBlock() fills.
+		eHealthSnapshotBlock block = {};
+		block.period = (uint16_t)lround(1e6 / self->rate);
+		uint16_t * row = (uint16_t *)view.buf;
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (channels & EHEALTH_CHANNEL_BIT(channel)) {
+				block.values[channel] = row;
+				row += count;
+			}
+		}
+
+		acquire(self);
+		Py_BEGIN_ALLOW_THREADS
+		self->mock->sampleAllBlock(block, count);
+		Py_END_ALLOW_THREADS
+		PyThread_release_lock(self->lock);
+		PyBuffer_Release(&view);
+
+		if (!fresh) {
+			return PyLong_FromSize_t(count);
+		}
+		PyObject * bytes = PyMemoryView_FromObject(fresh);
+		Py_DECREF(fresh);
+		if (!bytes) {
+			return NULL;
+		}
+		PyObject * samples = PyObject_CallMethod(bytes, "cast", "s(nn)", "H", rows, (Py_ssize_t)count);
+		Py_DECREF(bytes);
+		return samples;
+	}
+
+	static PyObject * mockBPM(PyObject * object, PyObject *)
+	{
+		mockObject * self = (mockObject *)object;
+
+		if (!ready(self)) {
+			return NULL;
+		}
+		acquire(self);
+		int bpm = self->mock->getBPM();
+		PyThread_release_lock(self->lock);
+		return PyLong_FromLong(bpm);
+	}
+
+	static PyObject * mockRRInterval(PyObject * object, PyObject *)
+	{
+		mockObject * self = (mockObject *)object;
+
+		if (!ready(self)) {
+			return NULL;
+		}
+		acquire(self);
+		uint16_t interval = self->mock->getRRInterval();
+		PyThread_release_lock(self->lock);
+		return PyLong_FromLong(interval);
+	}
+
+	//! Mock(seed=1, rate=250): a patient seeded as fleet patient seed,
+	//! with its waveforms and heartbeat detector at rate samples per second.
+	static int mockInit(PyObject * object, PyObject * args, PyObject * kwargs)
+	{
+		static const char * keywords[] = { "seed", "rate", NULL };
+		mockObject * self = (mockObject *)object;
+		unsigned long seed = 1;
+		unsigned int rate = 250;
+
+		if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|kI", (char **)keywords, &seed, &rate)) {
+			return -1;
+		}
+		if (rate < 16 || rate > 65535) {
+			PyErr_Format(PyExc_ValueError, "the rate must be between 16 and 65535 samples per second");
+			return -1;
+		}
+		if (!self->mock) {
+			self->mock = new (std::nothrow) eHealthClassMock();
+			self->lock = PyThread_allocate_lock();
+			if (!self->mock || !self->lock) {
+				PyErr_NoMemory();
+				return -1;
+			}
+		}
+
+		self->rate = (uint16_t)rate;
+		eHealthFleet::setupPatient(*self->mock, (uint32_t)seed, self->rate);
+		return 0;
+	}
+
+	static void mockDealloc(PyObject * object)
+	{
+		mockObject * self = (mockObject *)object;
+		PyTypeObject * type = Py_TYPE(object);
+
+		delete self->mock;
+		if (self->lock) {
+			PyThread_free_lock(self->lock);
+		}
+		type->tp_free(object);
+		Py_DECREF(type);
+	}
+
+	static PyMethodDef mockMethods[] = {
+		{ "ecg", mockECG, METH_O,
+			"ecg(out) -> count: fills out with ECG samples, float32 volts or int16 millivolts.\n"
+			"ecg(count) -> memoryview of count float32 volts." },
+		{ "emg", mockEMG, METH_O,
+			"emg(out) -> count: fills out with EMG samples, float32 volts or int16 millivolts.\n"
+			"emg(count) -> memoryview of count float32 volts." },
+		{ "airflow", mockAirFlow, METH_O,
+			"airflow(out) -> count: fills out with air flow readings (0-1023), int32, int16 or float32.\n"
+			"airflow(count) -> memoryview of count int32 readings." },
+		{ "gsr", mockGSR, METH_O,
+			"gsr(out) -> count: fills out with float32 skin conductance voltages.\n"
+			"gsr(count) -> memoryview of count float32 volts." },
+		{ "block", mockBlock, METH_VARARGS,
+			"block(out, channels) -> count: fills out with count snapshots of channels, raw uint16,\n"
+			"one row of count values per channel in channel order.\n"
+			"block(count, channels) -> memoryview of shape (channels, count), count at least 1." },
+		{ "bpm", mockBPM, METH_NOARGS, "bpm() -> heart rate found in the ECG read so far." },
+		{ "rr_interval", mockRRInterval, METH_NOARGS, "rr_interval() -> milliseconds between the last two beats." },
+		{ NULL, NULL, 0, NULL }
+	};
+
+	static PyType_Slot mockSlots[] = {
+		{ Py_tp_doc, (void *)"Mock(seed=1, rate=250): one simulated eHealth shield." },
+		{ Py_tp_new, (void *)PyType_GenericNew },
+		{ Py_tp_init, (void *)mockInit },
+		{ Py_tp_dealloc, (void *)mockDealloc },
+		{ Py_tp_methods, mockMethods },
+		{ 0, NULL }
+	};
+
+	static PyType_Spec mockSpec = {
+		"ehealthmock.Mock", sizeof(mockObject), 0, Py_TPFLAGS_DEFAULT, mockSlots
+	};
+
+
+//***************************************************************
+// Module														*
+//***************************************************************
+
+	static struct PyModuleDef moduleDef = {
+		PyModuleDef_HEAD_INIT, "ehealthmock",
+		"Block sample buffers from the eHealth Mock, filled without the GIL.", -1,
+		NULL, NULL, NULL, NULL, NULL
+	};
+
+	PyMODINIT_FUNC PyInit_ehealthmock(void)
+	{
+		static const char * const channelNames[EHEALTH_CHANNEL_COUNT] = {
+			"ECG", "EMG", "AIRFLOW", "GSR", "TEMPERATURE", "SPO2", "BPM", "POSITION",
+			"SYSTOLIC", "DIASTOLIC", "GLUCOSE"
+		};
+
+		PyObject * module = PyModule_Create(&moduleDef);
+		if (!module) {
+			return NULL;
+		}
+		PyObject * type = PyType_FromSpec(&mockSpec);
+		if (!type || PyModule_AddObject(module, "Mock", type)) {
+			Py_XDECREF(type);
+			Py_DECREF(module);
+			return NULL;
+		}
+		// Channel bits for block(), as EHEALTH_CHANNEL_BIT() gives them.
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			PyModule_AddIntConstant(module, channelNames[channel], EHEALTH_CHANNEL_BIT(channel));
+		}
+		return module;
+	}
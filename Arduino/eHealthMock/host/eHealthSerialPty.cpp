@@ -0,0 +1,325 @@
+/*
+*=========================================================================================
+ *  Serial port emulator of the host build of the eHealth Mock.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthSerialPty.h"
+#include "eHealthFleet.h"
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+	//! Bytes of a typical text line, "75 12.34\r\n".
+	static const size_t TEXT_LINE_SIZE = 10;
+
+	//! CPU time of the calling thread, in seconds.
+	static double threadCpuSeconds(void)
+	{
+		timespec now;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+		return now.tv_sec + now.tv_nsec * 1e-9;
+	}
+
+
+//***************************************************************
+// Constructor of the class										*
+//***************************************************************
+
+	eHealthSerialPty::eHealthSerialPty(const eHealthPtyConfig & ptyConfig)
+		: config(ptyConfig), problem(nullptr), recordsPerSecond(0), master(-1), output(record)
+	{
+		config.channels &= EHEALTH_CHANNELS;
+
+		if (config.baud < EHEALTH_PTY_MIN_BAUD || config.baud > EHEALTH_PTY_MAX_BAUD) {
+			problem = "the baud rate must be between 9600 and 2000000";
+			return;
+		}
+		size_t recordSize = config.frames ? eHealthFrameEncoder::frameSize(config.channels, 1) : TEXT_LINE_SIZE;
+		if (recordSize == 0) {
+			problem = "no channels to send";
+			return;
+		}
+		if (config.rate < 0) {
+			problem = "the record rate cannot be negative";
+			return;
+		}
+
+		// Back to back records come as fast as the line carries them.
+		recordsPerSecond = config.rate > 0 ? config.rate : config.baud / 10.0 / recordSize;
+		uint16_t hz = (uint16_t)std::min(65535L, std::max(1L, lround(recordsPerSecond)));
+
+		eHealthFleet::setupPatient(mock, config.seed, hz);
+		mock.setOutput(output);
+	}
+
+	eHealthSerialPty::~eHealthSerialPty()
+	{
+		if (!linkPath.empty()) {
+			unlink(linkPath.c_str());
+		}
+		if (master >= 0) {
+			close(master);
+		}
+	}
+
+
+//***************************************************************
+// Public Methods												*
+//***************************************************************
+
+	//!******************************************************************************
+	//!		Name:	open()															*
+	//!		Description: Creates the pseudo-terminal, in raw mode.					*
+	//!		Param : void															*
+	//!		Returns: bool: false if the port could not be created					*
+	//!		Example: if (!pty.open()) puts(pty.error());							*
+	//!******************************************************************************
+
+	bool eHealthSerialPty::open(void)
+	{
+		if (problem || master >= 0) {
+			return !problem;
+		}
+
+		master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+		if (master < 0 || grantpt(master) || unlockpt(master) || !ptsname(master)) {
+			problem = "cannot create a pseudo-terminal";
+			return false;
+		}
+		slavePath = ptsname(master);
+
+		// No echo, no line editing, no CR/LF translation: the bytes as sent.
+		// Opening the port once also makes it read as hung up until a reader
+		// opens it; a port never opened does not.
+		int slave = ::open(slavePath.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+		termios mode;
+		if (slave < 0 || tcgetattr(slave, &mode)) {
+			problem = "cannot set up the pseudo-terminal";
+			return false;
+		}
+		cfmakeraw(&mode);
+		tcsetattr(slave, TCSANOW, &mode);
+		close(slave);
+
+		// The emulator never waits for the reader.
+		fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+		return true;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	link()															*
+	//!		Description: Makes linkPath a symbolic link to the port.				*
+	//!		Param : const char * linkPath											*
+	//!		Returns: bool: false if the link could not be made						*
+	//!		Example: pty.link("/tmp/ttyEHEALTH0");									*
+	//!******************************************************************************
+
+	bool eHealthSerialPty::link(const char * path)
+	{
+		char target[256];
+
+		if (master < 0) {
+			problem = "the port is not open";
+			return false;
+		}
+		// Replace a stale link, never a file.
+		if (readlink(path, target, sizeof(target)) >= 0) {
+			unlink(path);
+		}
+		if (symlink(slavePath.c_str(), path)) {
+			problem = "cannot create the link";
+			return false;
+		}
+		linkPath = path;
+		return true;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	waitForReader()													*
+	//!		Description: Waits for a reader to open the port.						*
+	//!		Param : double seconds: longest wait, negative for no limit				*
+	//!		Returns: bool: true once the port is open								*
+	//!		Example: pty.waitForReader(-1);											*
+	//!******************************************************************************
+
+	bool eHealthSerialPty::waitForReader(double seconds)
+	{
+		typedef std::chrono::steady_clock clock;
+
+		clock::time_point start = clock::now();
+
+		while (master >= 0 && hungUp()) {
+			if (seconds >= 0 && std::chrono::duration<double>(clock::now() - start).count() >= seconds) {
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return master >= 0;
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	run()															*
+	//!		Description: Sends seconds of records to the reader.					*
+	//!		Param : double seconds: time to run for, 0 until the reader closes		*
+	//!		Returns: eHealthPtyReport with what was sent and lost					*
+	//!		Example: eHealthPtyReport report = pty.run(10);							*
+	//!******************************************************************************
+
+	eHealthPtyReport eHealthSerialPty::run(double seconds)
+	{
+		typedef std::chrono::steady_clock clock;
+		typedef std::chrono::duration<double> secondsOf;
+
+		eHealthPtyReport report;
+		if (master < 0) {
+			return report;
+		}
+
+		double byteTime = 10.0 / config.baud;
+		clock::time_point start = clock::now();
+		clock::time_point end = seconds > 0
+			? start + std::chrono::duration_cast<clock::duration>(secondsOf(seconds)) : clock::time_point::max();
+		clock::time_point lineFree = start;
+		uint64_t clockStart = hostClockMicros();
+		double cpuStart = threadCpuSeconds();
+		uint64_t k = 0;
+
+		while (!report.hangup) {
+			clock::time_point now = clock::now();
+
+			// A record starts when it is due and the line is free. Bytes held
+			// up by a short stall of the emulator are made up for; after a
+			// longer one the line is taken to have idled.
+			clock::time_point at = std::max(lineFree, now - std::chrono::milliseconds(20));
+			if (config.rate > 0) {
+				at = std::max(at, start + std::chrono::duration_cast<clock::duration>(secondsOf(k / config.rate)));
+			}
+			if (at >= end) {
+				break;
+			}
+			if (hungUp()) {
+				report.hangup = true;
+				break;
+			}
+			drainInput();
+			std::this_thread::sleep_until(at);
+
+			// The mock's clock follows the line, for the frames' timestamps.
+			uint64_t elapsed = clockStart + (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(at - start).count();
+			hostClockSet(std::max(hostClockMicros(), elapsed));
+			nextRecord();
+			k++;
+
+			// Byte i leaves the wire (i + 1) byte times after the record starts.
+			const std::vector<uint8_t> & bytes = record.bytes;
+			size_t sent = 0;
+			while (sent < bytes.size()) {
+				double onLine = secondsOf(clock::now() - at).count();
+				size_t due = std::min(bytes.size(), (size_t)(onLine / byteTime));
+				if (due <= sent) {
+					std::this_thread::sleep_until(at + std::chrono::duration_cast<clock::duration>(secondsOf((sent + 1) * byteTime)));
+					continue;
+				}
+
+				ssize_t n = write(master, &bytes[sent], due - sent);
+				if (n < 0 && errno == EINTR) {
+					continue;
+				}
+				if (n < 0 && errno != EAGAIN) {
+					report.hangup = true;
+					break;
+				}
+				// What the pseudo-terminal has no room for is lost, as from a UART.
+				n = std::max<ssize_t>(n, 0);
+				report.bytes += n;
+				report.overrun += due - sent - n;
+				sent = due;
+			}
+			lineFree = at + std::chrono::duration_cast<clock::duration>(secondsOf(bytes.size() * byteTime));
+			report.records++;
+		}
+
+		report.wallSeconds = secondsOf(clock::now() - start).count();
+		report.cpuSeconds = threadCpuSeconds() - cpuStart;
+		if (report.wallSeconds > 0) {
+			report.byteRate = report.bytes / report.wallSeconds;
+			report.recordRate = report.records / report.wallSeconds;
+			report.lineLoad = (report.bytes + report.overrun) * byteTime / report.wallSeconds;
+		}
+		return report;
+	}
+
+
+//***************************************************************
+// Private Methods												*
+//***************************************************************
+
+	//! Keeps the bytes of the record being formatted.
+
+	size_t eHealthSerialPty::recordSink::write(const uint8_t * data, size_t length)
+	{
+		bytes.insert(bytes.end(), data, data + length);
+		return length;
+	}
+
+	/*******************************************************************************/
+
+	//! Formats the next record into record.bytes: a frame, or the line of the
+	//! sketch ArduinoConnector.py reads, which samples the ECG on every pass.
+
+	void eHealthSerialPty::nextRecord(void)
+	{
+		record.bytes.clear();
+
+		if (config.frames) {
+			mock.writeFrame(config.channels);
+			return;
+		}
+		mock.getECG();
+		output.print(mock.getBPM());
+		output.print(' ');
+		output.print(mock.getSkinConductance(), 2);
+		output.println();
+		output.endRecord();
+	}
+
+	/*******************************************************************************/
+
+	//! Returns true when no reader has the port open.
+
+	bool eHealthSerialPty::hungUp(void) const
+	{
+		pollfd port = { master, 0, 0 };
+
+		return poll(&port, 1, 0) > 0 && (port.revents & POLLHUP);
+	}
+
+	/*******************************************************************************/
+
+	//! Discards what the reader wrote to the port: the board has no input.
+
+	void eHealthSerialPty::drainInput(void)
+	{
+		uint8_t discard[256];
+
+		while (read(master, discard, sizeof(discard)) > 0) {
+		}
+	}
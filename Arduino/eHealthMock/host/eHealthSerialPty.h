@@ -0,0 +1,155 @@
+/*
+*=========================================================================================
+ *  Serial port emulator of the host build of the eHealth Mock.
+ *
+ *  Creates a pseudo-terminal and plays a board on its master side: a mock
+ *  sends either the text lines of the sketch ArduinoConnector.py reads,
+ *  "<bpm> <skin conductance>\r\n", or binary frames (writeFrame()). The
+ *  slave side is a tty that serial.Serial, screen or any program opening
+ *  /dev/ttyACM0 can open in its place.
+ *
+ *  Bytes are paced as the wire would carry them at the baud rate, 8N1, ten
+ *  bits a byte: no byte reaches the reader before its time on the line.
+ *  Like a UART without flow control, the emulator never waits for the
+ *  reader. Bytes the pseudo-terminal cannot take because the reader fell
+ *  behind are lost and counted as overrun.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthSerialPty_h
+#define eHealthSerialPty_h
+
+#include "eHealthMock.h"
+
+#include <string>
+#include <vector>
+
+	//! Slowest and fastest baud rates emulated.
+	#define EHEALTH_PTY_MIN_BAUD 9600
+	#define EHEALTH_PTY_MAX_BAUD 2000000
+
+	//! Configuration of the emulated board.
+	struct eHealthPtyConfig {
+		//! Line rate in bits per second.
+		uint32_t baud = 115200;
+		//! Send binary frames instead of text lines.
+		bool frames = false;
+		//! Records (lines or frames) per second. 0 sends them back to back,
+		//! as fast as the line carries them.
+		double rate = 0;
+		//! Channels of each frame (EHEALTH_CHANNEL_BIT).
+		uint16_t channels = EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_EMG)
+			| EHEALTH_CHANNEL_BIT(EHEALTH_AIRFLOW) | EHEALTH_CHANNEL_BIT(EHEALTH_GSR)
+			| EHEALTH_CHANNEL_BIT(EHEALTH_BPM);
+		//! Seed of the patient the mock is set up as, see eHealthFleet::setupPatient().
+		uint32_t seed = 1;
+	};
+
+	//! Result of eHealthSerialPty::run().
+	struct eHealthPtyReport {
+		uint64_t records = 0;
+		//! Bytes the reader was given.
+		uint64_t bytes = 0;
+		//! Bytes lost because the reader did not keep up.
+		uint64_t overrun = 0;
+		double wallSeconds = 0;
+		//! Bytes and records per second the reader was given.
+		double byteRate = 0;
+		double recordRate = 0;
+		//! Share of the line's capacity in use, overrun included.
+		double lineLoad = 0;
+		//! CPU time of the emulating thread.
+		double cpuSeconds = 0;
+		//! Set when the reader closed the port before the end of the run.
+		bool hangup = false;
+	};
+
+// Library interface description
+class eHealthSerialPty {
+
+	public:
+
+		//! Seeds the mock. Call open() to create the port.
+		explicit eHealthSerialPty(const eHealthPtyConfig & config);
+
+		//! Closes the port and removes the link, if any.
+		~eHealthSerialPty();
+
+		eHealthSerialPty(const eHealthSerialPty &) = delete;
+		eHealthSerialPty & operator = (const eHealthSerialPty &) = delete;
+
+		//! Creates the pseudo-terminal, in raw mode.
+		/*!
+		\param void
+		\return bool : false, with the reason in error(), if the configuration
+		 *  is not valid or the port could not be created.
+		*/	bool open(void);
+
+		//! Returns why open() or link() failed.
+		const char * error(void) const { return problem; }
+
+		//! Returns the path of the port readers open, empty before open().
+		const char * path(void) const { return slavePath.c_str(); }
+
+		//! Makes linkPath a symbolic link to the port, for a stable name.
+		/*!
+		 *  An existing link at linkPath is replaced; a file is not.
+		\param const char * linkPath : path of the link.
+		\return bool : false if the link could not be made.
+		*/	bool link(const char * linkPath);
+
+		//! Waits for a reader to open the port.
+		/*!
+		\param double seconds : longest wait, negative for no limit.
+		\return bool : true once the port is open.
+		*/	bool waitForReader(double seconds);
+
+		//! Sends seconds of records to the reader.
+		/*!
+		 *  Stops early when the reader closes the port. Consecutive runs
+		 *  continue the stream.
+		\param double seconds : time to run for, 0 until the reader closes.
+		\return eHealthPtyReport : what was sent, and what was lost.
+		*/	eHealthPtyReport run(double seconds);
+
+		//! Returns the records per second the mock is sampled at.
+		double sampleRate(void) const { return recordsPerSecond; }
+
+	private:
+
+		//! Collects one record of the mock's output.
+		class recordSink : public eHealthSink {
+			public:
+				size_t write(const uint8_t * data, size_t length) override;
+				std::vector<uint8_t> bytes;
+		};
+
+		//! Formats the next record into record.bytes.
+		void nextRecord(void);
+
+		//! Returns true when no reader has the port open.
+		bool hungUp(void) const;
+
+		//! Discards what the reader wrote to the port.
+		void drainInput(void);
+
+		eHealthPtyConfig config;
+		const char * problem;
+		double recordsPerSecond;
+
+		int master;
+		std::string slavePath;
+		std::string linkPath;
+
+		eHealthClassMock mock;
+		recordSink record;
+		eHealthOutput output;
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*
+*=========================================================================================
+ *  Output sinks of the host build: stdout, files, pipes and Unix sockets.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthSinks.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+//***************************************************************
+// File sink													*
+//***************************************************************
+
+	size_t eHealthFileSink::write(const uint8_t * data, size_t length)
+	{
+		size_t n = fwrite(data, 1, length, stream);
+
+		if (flushEach) {
+			fflush(stream);
+		}
+		return n;
+	}
+
+
+//***************************************************************
+// Descriptor sink												*
+//***************************************************************
+
+	eHealthFdSink eHealthFdSink::connectUnix(const char * path)
+	{
+		sockaddr_un address = {};
+		address.sun_family = AF_UNIX;
+
+		if (strlen(path) >= sizeof(address.sun_path)) {
+			return eHealthFdSink(-1);
+		}
+		strcpy(address.sun_path, path);
+
+		int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (fd >= 0 && connect(fd, (const sockaddr *)&address, sizeof(address)) != 0) {
+			close(fd);
+			fd = -1;
+		}
+		return eHealthFdSink(fd, true);
+	}
+
+	eHealthFdSink::eHealthFdSink(eHealthFdSink && other) noexcept
+		: fd(other.fd), owned(other.owned), plainWrite(other.plainWrite)
+	{
+		other.fd = -1;
+		other.owned = false;
+	}
+
+	eHealthFdSink::~eHealthFdSink()
+	{
+		if (owned && fd >= 0) {
+			close(fd);
+		}
+	}
+
+	size_t eHealthFdSink::write(const uint8_t * data, size_t length)
+	{
+		size_t done = 0;
+
+		while (fd >= 0 && done < length) {
+			ssize_t n;
+			if (plainWrite) {
+				n = ::write(fd, data + done, length - done);
+			} else {
+				n = ::send(fd, data + done, length - done, MSG_NOSIGNAL);
+				if (n < 0 && errno == ENOTSOCK) {
+					plainWrite = true;
+					continue;
+				}
+			}
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				// A non-blocking descriptor is full: wait for the reader to catch up.
+				pollfd out = { fd, POLLOUT, 0 };
+				if (poll(&out, 1, -1) >= 0 || errno == EINTR) {
+					continue;
+				}
+				break;
+			}
+			if (n == 0 || (n < 0 && (errno == EPIPE || errno == ECONNRESET))) {
+				// The reader went away: drop the rest of the output.
+				if (owned) {
+					close(fd);
+				}
+				fd = -1;
+				break;
+			}
+			if (n < 0) {
+				// Any other error loses this write only.
+				break;
+			}
+			done += n;
+		}
+		return done;
+	}
+
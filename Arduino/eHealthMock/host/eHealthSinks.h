@@ -0,0 +1,74 @@
+/*
+*=========================================================================================
+ *  Output sinks of the host build: stdout, files, pipes and Unix sockets.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthSinks_h
+#define eHealthSinks_h
+
+#include "eHealthOutput.h"
+
+#include <stdio.h>
+
+	//! Sink writing to a stdio stream: stdout, a file, or a popen() pipe.
+	class eHealthFileSink : public eHealthSink {
+
+		public:
+
+			//! Writes to stream, which the caller keeps open.
+			explicit eHealthFileSink(FILE * output) : stream(output) {}
+
+			//! Flushes the stream after each record when set, for live readers.
+			void setFlushEachRecord(bool flush) { flushEach = flush; }
+
+			size_t write(const uint8_t * data, size_t length) override;
+
+		private:
+
+			FILE * stream;
+			bool flushEach = false;
+	};
+
+	//! Sink writing to a file descriptor: a pipe, a socket or a tty.
+	class eHealthFdSink : public eHealthSink {
+
+		public:
+
+			//! Writes to fd. The sink closes it on destruction if owned.
+			explicit eHealthFdSink(int descriptor, bool owns = false) : fd(descriptor), owned(owns) {}
+
+			//! Connects to the Unix stream socket at path. Check isOpen().
+			static eHealthFdSink connectUnix(const char * path);
+
+			~eHealthFdSink();
+
+			eHealthFdSink(eHealthFdSink && other) noexcept;
+			eHealthFdSink(const eHealthFdSink &) = delete;
+			eHealthFdSink & operator = (const eHealthFdSink &) = delete;
+
+			//! Returns true when the descriptor is valid.
+			bool isOpen(void) const { return fd >= 0; }
+
+			//! Writes every byte, retrying short writes and waiting on a full
+			//! non-blocking descriptor. Once the reader is gone the sink
+			//! discards its output; on sockets without a SIGPIPE, on pipes
+			//! once the program ignores SIGPIPE, as the host tools do.
+			size_t write(const uint8_t * data, size_t length) override;
+
+		private:
+
+			int fd;
+			bool owned;
+
+			//! Set once send() reports that fd is not a socket.
+			bool plainWrite = false;
+	};
+
+#endif
@@ -0,0 +1,312 @@
+/*
+*=========================================================================================
+ *  Trace files of the host build: record, map and replay sensor frames.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthTrace.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+	static const char traceMagic[7] = { 'E', 'H', 'T', 'R', 'A', 'C', 'E' };
+
+
+//***************************************************************
+// Writer														*
+//***************************************************************
+
+	eHealthTraceWriter::~eHealthTraceWriter()
+	{
+		close();
+	}
+
+	bool eHealthTraceWriter::open(const char * path)
+	{
+		close();
+
+		file = fopen(path, "wb");
+		if (!file) {
+			return false;
+		}
+
+		uint8_t header[EHEALTH_TRACE_HEADER_SIZE] = {};
+		memcpy(header, traceMagic, sizeof(traceMagic));
+		header[7] = EHEALTH_TRACE_VERSION;
+		header[8] = EHEALTH_TRACE_HEADER_SIZE;
+
+		failed = fwrite(header, 1, sizeof(header), file) != sizeof(header);
+		written = 0;
+		return !failed;
+	}
+
+	bool eHealthTraceWriter::close(void)
+	{
+		if (!file) {
+			return !failed;
+		}
+		failed |= fclose(file) != 0;
+		file = nullptr;
+		return !failed;
+	}
+
+	size_t eHealthTraceWriter::record(uint16_t channels, uint8_t count, uint32_t timestamp, uint16_t period,
+		const uint16_t * values)
+	{
+		uint8_t frame[EHEALTH_FRAME_MAX_SIZE];
+		size_t size = encoder.encode(channels, count, timestamp, period, values, frame, sizeof(frame));
+
+		return size ? write(frame, size) : 0;
+	}
+
+	size_t eHealthTraceWriter::write(const uint8_t * data, size_t size)
+	{
+		if (!file) {
+			return 0;
+		}
+
+		size_t n = fwrite(data, 1, size, file);
+		failed |= n != size;
+		written += n;
+		return n;
+	}
+
+
+//***************************************************************
+// Reader														*
+//***************************************************************
+
+	eHealthTraceReader::~eHealthTraceReader()
+	{
+		close();
+	}
+
+	bool eHealthTraceReader::open(const char * path)
+	{
+		close();
+
+		int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			return false;
+		}
+
+		struct stat info;
+		if (fstat(fd, &info) != 0) {
+			::close(fd);
+			return false;
+		}
+
+		if (info.st_size > 0) {
+			void * map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (map == MAP_FAILED) {
+				::close(fd);
+				return false;
+			}
+			// Indexing reads the file front to back.
+			madvise(map, info.st_size, MADV_SEQUENTIAL);
+			base = (const uint8_t *)map;
+			length = info.st_size;
+			mapped = true;
+		}
+		::close(fd);
+
+		buildIndex();
+		return true;
+	}
+
+	void eHealthTraceReader::open(const uint8_t * data, size_t size)
+	{
+		close();
+
+		base = data;
+		length = size;
+		buildIndex();
+	}
+
+	void eHealthTraceReader::close(void)
+	{
+		if (mapped) {
+			munmap((void *)base, length);
+		}
+		base = nullptr;
+		length = 0;
+		mapped = false;
+		index.clear();
+		channelSet = 0;
+		spanMicros = 0;
+		dropped = 0;
+	}
+
+/*******************************************************************************************************/
+
+	//! Finds every valid frame, skipping the header and anything between frames.
+
+	void eHealthTraceReader::buildIndex(void)
+	{
+		size_t offset = 0;
+
+		if (length >= EHEALTH_TRACE_HEADER_SIZE && !memcmp(base, traceMagic, sizeof(traceMagic))) {
+			uint32_t headerLength = base[8] | (base[9] << 8) | (base[10] << 16) | ((uint32_t)base[11] << 24);
+			offset = headerLength < length ? headerLength : length;
+		}
+
+		eHealthFrame frame;
+
+		while (offset < length) {
+			const uint8_t * sync = (const uint8_t *)memchr(base + offset, EHEALTH_FRAME_SYNC0, length - offset);
+			if (!sync) {
+				dropped += length - offset;
+				break;
+			}
+			dropped += sync - (base + offset);
+			offset = sync - base;
+
+			size_t size = eHealthFrameParse(sync, length - offset, frame);
+			if (!size) {
+				dropped++;
+				offset++;
+				continue;
+			}
+
+			index.push_back(frame);
+			channelSet |= frame.channels;
+			offset += size;
+
+			uint32_t end = frame.timestamp + (uint32_t)(frame.count - 1) * frame.period - index[0].timestamp;
+			if (end > spanMicros) {
+				spanMicros = end;
+			}
+		}
+	}
+
+
+//***************************************************************
+// Replay														*
+//***************************************************************
+
+	eHealthTraceReplay::eHealthTraceReplay(const eHealthTraceReader & reader)
+		: trace(reader)
+	{
+		start();
+	}
+
+	void eHealthTraceReplay::setSpeed(double speed)
+	{
+		rate = speed > 0 ? speed : 0;
+		start();
+	}
+
+	void eHealthTraceReplay::start(void)
+	{
+		startedAt = micros();
+		ended = 0;
+
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			cursors[channel].started = false;
+			seekFrom(cursors[channel], channel, 0);
+		}
+	}
+
+	bool eHealthTraceReplay::finished(void) const
+	{
+		return ended == trace.channels();
+	}
+
+
+	//!******************************************************************************
+	//!		Name:	read()															*
+	//!		Description: Serves the current value of channel from the trace.		*
+	//!		Param : uint8_t channel, uint16_t & value								*
+	//!		Returns: bool, false if the trace does not hold channel					*
+	//!		Example: eHealth.replay(&replay); eHealth.getECG();						*
+	//!******************************************************************************
+
+	bool eHealthTraceReplay::read(uint8_t channel, uint16_t & value)
+	{
+		if (channel >= EHEALTH_CHANNEL_COUNT || !(trace.channels() & EHEALTH_CHANNEL_BIT(channel))) {
+			return false;
+		}
+
+		cursor & c = cursors[channel];
+
+		if (rate == 0) {
+			// Unthrottled: every read takes the next value.
+			if (c.started && !step(c, channel)) {
+				if (looping) {
+					seekFrom(c, channel, 0);
+				} else {
+					ended |= EHEALTH_CHANNEL_BIT(channel);
+				}
+			}
+		} else {
+			// Past 2^32 microseconds of trace the time is held at the end,
+			// rather than wrapping back to the start.
+			double at = (micros() - startedAt) * rate;
+
+			if (looping) {
+				at = fmod(at, trace.span() + 1.0);
+			}
+			uint32_t target = at < UINT32_MAX ? (uint32_t)at : UINT32_MAX;
+
+			if (looping && timeOf(c) > target) {
+				seekFrom(c, channel, 0);
+			}
+
+			// Hold the last value recorded at or before the replay time.
+			cursor next = c;
+			bool more;
+			while ((more = step(next, channel)) && timeOf(next) <= target) {
+				c = next;
+			}
+			if (!more && !looping && timeOf(c) <= target) {
+				ended |= EHEALTH_CHANNEL_BIT(channel);
+			}
+		}
+
+		c.started = true;
+		value = trace.frame(c.frame).value(c.snapshot, channel);
+		servedCount++;
+		return true;
+	}
+
+/*******************************************************************************************************/
+
+	bool eHealthTraceReplay::seekFrom(cursor & c, uint8_t channel, size_t frame) const
+	{
+		for (; frame < trace.frames(); frame++) {
+			if (trace.frame(frame).has(channel)) {
+				c.frame = frame;
+				c.snapshot = 0;
+				return true;
+			}
+		}
+		return false;
+	}
+
+/*******************************************************************************************************/
+
+	bool eHealthTraceReplay::step(cursor & c, uint8_t channel) const
+	{
+		if (c.snapshot + 1 < trace.frame(c.frame).count) {
+			c.snapshot++;
+			return true;
+		}
+		return seekFrom(c, channel, c.frame + 1);
+	}
+
+/*******************************************************************************************************/
+
+	uint32_t eHealthTraceReplay::timeOf(const cursor & c) const
+	{
+		const eHealthFrame & frame = trace.frame(c.frame);
+		return frame.timestamp + (uint32_t)c.snapshot * frame.period - trace.origin();
+	}
+
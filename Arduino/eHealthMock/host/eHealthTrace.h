@@ -0,0 +1,215 @@
+/*
+*=========================================================================================
+ *  Trace files of the host build: record sensor frames, map them back and
+ *  replay them through eHealthClassMock.
+ *
+ *  A trace is a 16 byte header followed by binary frames (eHealthFrame.h),
+ *  each one a self-contained, CRC checked chunk of snapshots:
+ *
+ *    offset  size  field
+ *         0     7  magic "EHTRACE"
+ *         7     1  version (1)
+ *         8     4  header length, little endian (16)
+ *        12     4  reserved, 0
+ *        16        frames
+ *
+ *  A raw capture of a board's binary output (writeFrame()) is also a valid
+ *  trace without the header: the reader skips anything between frames.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+// Ensure this library description is only included once
+#ifndef eHealthTrace_h
+#define eHealthTrace_h
+
+#include "eHealthFrame.h"
+#include "eHealthOutput.h"
+#include "eHealthSource.h"
+
+#include <stdio.h>
+#include <vector>
+
+	#define EHEALTH_TRACE_VERSION 1
+	#define EHEALTH_TRACE_HEADER_SIZE 16
+
+
+//***************************************************************
+// Writer														*
+//***************************************************************
+
+	//! Writes a trace file. As a sink it records an output verbatim, so
+	//! eHealthClassMock::writeFrame() can record straight into a trace.
+	class eHealthTraceWriter : public eHealthSink {
+
+		public:
+
+			eHealthTraceWriter(void) = default;
+			~eHealthTraceWriter();
+
+			eHealthTraceWriter(const eHealthTraceWriter &) = delete;
+			eHealthTraceWriter & operator = (const eHealthTraceWriter &) = delete;
+
+			//! Creates path and writes the header. Returns false on error.
+			bool open(const char * path);
+
+			//! Flushes and closes the file. Returns false if a write failed.
+			bool close(void);
+
+			//! Encodes count snapshots of channels as one frame of the trace.
+			/*!
+			\param see eHealthFrameEncoder::encode().
+			\return size_t : bytes written, 0 if the frame is invalid.
+			*/	size_t record(uint16_t channels, uint8_t count, uint32_t timestamp, uint16_t period,
+					const uint16_t * values);
+
+			//! Appends bytes that already hold frames.
+			size_t write(const uint8_t * data, size_t length) override;
+
+			//! Returns the bytes written after the header.
+			uint64_t bytesWritten(void) const { return written; }
+
+		private:
+
+			FILE * file = nullptr;
+			bool failed = false;
+			uint64_t written = 0;
+			eHealthFrameEncoder encoder;
+	};
+
+
+//***************************************************************
+// Reader														*
+//***************************************************************
+
+	//! Maps a trace file read-only and indexes its frames in one pass.
+	//! Frames point into the mapping: nothing is copied.
+	class eHealthTraceReader {
+
+		public:
+
+			eHealthTraceReader(void) = default;
+			~eHealthTraceReader();
+
+			eHealthTraceReader(const eHealthTraceReader &) = delete;
+			eHealthTraceReader & operator = (const eHealthTraceReader &) = delete;
+
+			//! Maps path and indexes it. Returns false if it cannot be mapped.
+			bool open(const char * path);
+
+			//! Indexes a trace already in memory, which must outlive the reader.
+			void open(const uint8_t * data, size_t size);
+
+			//! Unmaps the file.
+			void close(void);
+
+			//! Returns the number of valid frames.
+			size_t frames(void) const { return index.size(); }
+
+			//! Returns frame i.
+			const eHealthFrame & frame(size_t i) const { return index[i]; }
+
+			//! Returns the bytes of frame i, sync word to CRC.
+			const uint8_t * frameData(size_t i) const { return index[i].payload - EHEALTH_FRAME_HEADER_SIZE; }
+
+			//! Returns the channels found in the trace.
+			uint16_t channels(void) const { return channelSet; }
+
+			//! Returns the timestamp of the first frame. Trace time counts from it.
+			uint32_t origin(void) const { return index.empty() ? 0 : index[0].timestamp; }
+
+			//! Returns the trace time of the last snapshot, in microseconds.
+			uint32_t span(void) const { return spanMicros; }
+
+			//! Returns the bytes that were not part of a valid frame.
+			uint64_t droppedBytes(void) const { return dropped; }
+
+			//! Returns the whole mapping.
+			const uint8_t * data(void) const { return base; }
+			size_t size(void) const { return length; }
+
+		private:
+
+			void buildIndex(void);
+
+			const uint8_t * base = nullptr;
+			size_t length = 0;
+			bool mapped = false;
+
+			std::vector<eHealthFrame> index;
+			uint16_t channelSet = 0;
+			uint32_t spanMicros = 0;
+			uint64_t dropped = 0;
+	};
+
+
+//***************************************************************
+// Replay														*
+//***************************************************************
+
+	//! Plays a trace back as an eHealthSource.
+	/*!
+	 *  Timed replay serves, for each channel, the last value recorded at or
+	 *  before the replay time, which runs speed times faster than micros()
+	 *  since start(). Unthrottled replay (speed 0) serves the next recorded
+	 *  value of the channel on every read, as fast as it is asked.
+	 */
+	class eHealthTraceReplay : public eHealthSource {
+
+		public:
+
+			//! Replays trace, which must outlive the replay, at 1x.
+			explicit eHealthTraceReplay(const eHealthTraceReader & trace);
+
+			//! Sets the replay speed: 1 for real time, N for N times faster,
+			//! 0 for unthrottled. Restarts the replay.
+			void setSpeed(double speed);
+
+			//! Starts over when the end of the trace is reached, instead of
+			//! holding the last values.
+			void setLoop(bool loop) { looping = loop; }
+
+			//! Rewinds to the start of the trace, anchored at micros() now.
+			void start(void);
+
+			//! Returns true once every channel has served its last value.
+			bool finished(void) const;
+
+			//! Returns the number of values served.
+			uint64_t served(void) const { return servedCount; }
+
+			bool read(uint8_t channel, uint16_t & value) override;
+
+		private:
+
+			//! Position of a channel: a frame and a snapshot in it.
+			struct cursor {
+				size_t frame;
+				uint8_t snapshot;
+				bool started;
+			};
+
+			//! Moves c to the first frame at or after frame holding channel.
+			bool seekFrom(cursor & c, uint8_t channel, size_t frame) const;
+
+			//! Moves c to the next value of channel. False at the end.
+			bool step(cursor & c, uint8_t channel) const;
+
+			//! Microseconds from the first snapshot of the trace to c.
+			uint32_t timeOf(const cursor & c) const;
+
+			const eHealthTraceReader & trace;
+			double rate = 1;
+			bool looping = false;
+			unsigned long startedAt = 0;
+			uint64_t servedCount = 0;
+
+			cursor cursors[EHEALTH_CHANNEL_COUNT];
+			uint16_t ended = 0;
+	};
+
+#endif
@@ -0,0 +1,374 @@
+/*
+*=========================================================================================
+ *  ehealth_trace: records, inspects and replays eHealth trace files.
+ *
+ *  Usage: ehealth_trace record FILE [--seconds S] [--seed N] [--rate HZ] [--frame N]
+ *         ehealth_trace capture FILE < /dev/ttyACM0
+ *         ehealth_trace info FILE
+ *         ehealth_trace replay FILE [--speed X] [--socket PATH]
+ *         ehealth_trace compress FILE OUT [--predictor 0|1|2] [--keyframe N]
+ *         ehealth_trace expand FILE OUT
+ *
+ *  record synthesizes a patient: ECG, EMG, air flow and GSR at --rate, packed
+ *  --frame snapshots per frame, and the slow channels once a second. capture
+ *  stores a board's binary output as it arrives. replay sends the frames to
+ *  stdout or a Unix socket, paced by their timestamps at --speed (0 sends
+ *  them as fast as the reader takes them and reports the throughput).
+ *  compress writes the frames of a trace as codec packets (eHealthCodec.h),
+ *  the stream a board sends, and reports the compression ratio. expand
+ *  decodes such a stream, for example a capture, back into a trace.
+ *========================================================================================
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthSinks.h"
+#include "eHealthTrace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+
+	static const uint16_t fastChannels = EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_EMG)
+		| EHEALTH_CHANNEL_BIT(EHEALTH_AIRFLOW) | EHEALTH_CHANNEL_BIT(EHEALTH_GSR);
+
+	static const uint16_t slowChannels = EHEALTH_CHANNEL_BIT(EHEALTH_TEMPERATURE) | EHEALTH_CHANNEL_BIT(EHEALTH_SPO2)
+		| EHEALTH_CHANNEL_BIT(EHEALTH_BPM) | EHEALTH_CHANNEL_BIT(EHEALTH_POSITION);
+
+	static void usage(void)
+	{
+		fprintf(stderr,
+			"usage: ehealth_trace record FILE [--seconds S] [--seed N] [--rate HZ] [--frame N]\n"
+			"       ehealth_trace capture FILE\n"
+			"       ehealth_trace info FILE\n"
+			"       ehealth_trace replay FILE [--speed X] [--socket PATH]\n"
+			"       ehealth_trace compress FILE OUT [--predictor 0|1|2] [--keyframe N]\n"
+			"       ehealth_trace expand FILE OUT\n");
+		exit(2);
+	}
+
+	//! Reads the values of every channel in mask, in channel order.
+	static uint8_t readSnapshot(eHealthClassMock & mock, uint16_t mask, uint16_t * values)
+	{
+		uint8_t n = 0;
+
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (mask & EHEALTH_CHANNEL_BIT(channel)) {
+				values[n++] = mock.readChannel(channel);
+			}
+		}
+		return n;
+	}
+
+	static int record(const char * path, double seconds, uint32_t seed, uint16_t rate, uint8_t perFrame)
+	{
+		eHealthTraceWriter writer;
+		if (!writer.open(path)) {
+			perror(path);
+			return 1;
+		}
+
+		eHealthClassMock mock;
+		mock.seed(seed);
+		mock.readPulsioximeter();
+		mock.initPositionSensor();
+		mock.waveform.setECG(75, 300, rate);
+		mock.waveform.setAirFlow(15, 400, rate);
+		mock.waveform.setEMG(12, 400, rate);
+
+		uint16_t period = (uint16_t)(1000000UL / rate);
+		uint64_t snapshots = (uint64_t)(seconds * rate);
+		std::vector<uint16_t> values(4 * (size_t)perFrame);
+		uint16_t slow[EHEALTH_CHANNEL_COUNT];
+
+		for (uint64_t done = 0; done < snapshots;) {
+			uint8_t count = (uint8_t)std::min<uint64_t>(perFrame, snapshots - done);
+			uint32_t timestamp = (uint32_t)(done * period);
+
+			for (uint8_t i = 0; i < count; i++) {
+				readSnapshot(mock, fastChannels, &values[4 * i]);
+			}
+			writer.record(fastChannels, count, timestamp, period, values.data());
+
+			// The slow channels, once a second.
+			if (done / rate != (done + count) / rate || done == 0) {
+				readSnapshot(mock, slowChannels, slow);
+				writer.record(slowChannels, 1, timestamp, 0, slow);
+			}
+			done += count;
+		}
+
+		if (!writer.close()) {
+			perror(path);
+			return 1;
+		}
+		printf("%llu snapshots, %llu bytes\n", (unsigned long long)snapshots,
+			(unsigned long long)writer.bytesWritten() + EHEALTH_TRACE_HEADER_SIZE);
+		return 0;
+	}
+
+	static int capture(const char * path)
+	{
+		eHealthTraceWriter writer;
+		if (!writer.open(path)) {
+			perror(path);
+			return 1;
+		}
+
+		uint8_t buffer[4096];
+		ssize_t n;
+		while ((n = read(STDIN_FILENO, buffer, sizeof(buffer))) > 0) {
+			writer.write(buffer, n);
+		}
+		return writer.close() ? 0 : 1;
+	}
+
+	static int info(const char * path)
+	{
+		eHealthTraceReader reader;
+		if (!reader.open(path)) {
+			perror(path);
+			return 1;
+		}
+
+		uint64_t samples[EHEALTH_CHANNEL_COUNT] = {};
+		for (size_t i = 0; i < reader.frames(); i++) {
+			const eHealthFrame & frame = reader.frame(i);
+			for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+				samples[channel] += frame.has(channel) ? frame.count : 0;
+			}
+		}
+
+		printf("%zu bytes, %zu frames, %llu bytes skipped, %.3f s\n", reader.size(), reader.frames(),
+			(unsigned long long)reader.droppedBytes(), reader.span() / 1e6);
+
+		static const char * const names[EHEALTH_CHANNEL_COUNT] = {
+			"ecg", "emg", "airflow", "gsr", "temperature", "spo2", "bpm", "position",
+			"systolic", "diastolic", "glucose"
+		};
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			if (samples[channel]) {
+				printf("  %-12s %llu samples\n", names[channel], (unsigned long long)samples[channel]);
+			}
+		}
+		return 0;
+	}
+
+	static int replay(const char * path, double speed, const char * socketPath)
+	{
+		eHealthTraceReader reader;
+		if (!reader.open(path)) {
+			perror(path);
+			return 1;
+		}
+
+		eHealthFdSink sink = socketPath ? eHealthFdSink::connectUnix(socketPath) : eHealthFdSink(STDOUT_FILENO);
+		if (!sink.isOpen()) {
+			perror(socketPath);
+			return 1;
+		}
+
+		auto started = std::chrono::steady_clock::now();
+		uint64_t bytes = 0;
+
+		for (size_t i = 0; i < reader.frames() && sink.isOpen(); i++) {
+			const eHealthFrame & frame = reader.frame(i);
+
+			if (speed > 0) {
+				// Send each frame when its last snapshot is due.
+				uint32_t due = frame.timestamp + (uint32_t)(frame.count - 1) * frame.period - reader.origin();
+				std::this_thread::sleep_until(started + std::chrono::microseconds((uint64_t)(due / speed)));
+			}
+
+			size_t size = eHealthFrameEncoder::frameSize(frame.channels, frame.count);
+			bytes += sink.write(reader.frameData(i), size);
+		}
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+		fprintf(stderr, "%zu frames, %llu bytes in %.3f s, %.1f MB/s\n", reader.frames(),
+			(unsigned long long)bytes, elapsed.count(), elapsed.count() > 0 ? bytes / elapsed.count() / 1e6 : 0);
+		return 0;
+	}
+
+	static int compress(const char * path, const char * outPath, int predictor, int keyframe)
+	{
+		eHealthTraceReader reader;
+		if (!reader.open(path)) {
+			perror(path);
+			return 1;
+		}
+
+		FILE * out = fopen(outPath, "wb");
+		if (!out) {
+			perror(outPath);
+			return 1;
+		}
+
+		eHealthCodecEncoder encoder;
+		encoder.setKeyframeInterval((uint16_t)keyframe);
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			encoder.setPredictor(channel, (eHealthPredictor)predictor);
+		}
+
+		std::vector<uint16_t> values;
+		uint8_t packet[EHEALTH_PACKET_MAX_SIZE];
+		uint64_t frameBytes = 0;
+		uint64_t packetBytes = 0;
+
+		for (size_t i = 0; i < reader.frames(); i++) {
+			const eHealthFrame & frame = reader.frame(i);
+			values.resize(frame.count * frame.channelCount);
+			frame.unpack(values.data());
+
+			// Noise can take more than one packet.
+			for (uint8_t done = 0, used = 0; done < frame.count; done += used) {
+				size_t size = encoder.encodeSome(frame.channels, frame.count - done, frame.timestamp + (uint32_t)done * frame.period,
+					frame.period, &values[(size_t)done * frame.channelCount], packet, sizeof(packet), used);
+				fwrite(packet, 1, size, out);
+				packetBytes += size;
+			}
+			frameBytes += eHealthFrameEncoder::frameSize(frame.channels, frame.count);
+		}
+
+		if (fclose(out) != 0) {
+			perror(outPath);
+			return 1;
+		}
+		printf("%zu frames, %llu bytes as frames, %llu as packets, ratio %.3f\n", reader.frames(),
+			(unsigned long long)frameBytes, (unsigned long long)packetBytes,
+			packetBytes ? (double)frameBytes / packetBytes : 0.0);
+		return 0;
+	}
+
+	static int expand(const char * path, const char * outPath)
+	{
+		eHealthTraceReader reader;
+		if (!reader.open(path)) {
+			perror(path);
+			return 1;
+		}
+
+		eHealthTraceWriter writer;
+		if (!writer.open(outPath)) {
+			perror(outPath);
+			return 1;
+		}
+
+		eHealthCodecDecoder decoder;
+		std::vector<uint16_t> values;
+		const uint8_t * data = reader.data();
+		size_t left = reader.size();
+		uint64_t written = 0;
+
+		while (left) {
+			size_t used = decoder.feed(data, left);
+			data += used;
+			left -= used;
+
+			if (decoder.available()) {
+				const eHealthPacket & packet = decoder.packet();
+				values.resize(packet.count * packet.channelCount);
+				if (decoder.decode(packet, values.data())) {
+					writer.record(packet.channels, packet.count, packet.timestamp, packet.period, values.data());
+					written++;
+				}
+			}
+		}
+
+		if (!writer.close()) {
+			perror(outPath);
+			return 1;
+		}
+		printf("%u packets, %llu frames written, %u skipped, %u CRC errors\n", decoder.packets(),
+			(unsigned long long)written, decoder.skipped(), decoder.crcErrors());
+		return 0;
+	}
+
+	int main(int argc, char ** argv)
+	{
+		if (argc < 3) {
+			usage();
+		}
+
+		// replay to a pipe whose reader exits ends with EPIPE, and its report.
+		signal(SIGPIPE, SIG_IGN);
+
+		const char * command = argv[1];
+		const char * path = argv[2];
+		double seconds = 60;
+		uint32_t seed = 1;
+		uint16_t rate = 250;
+		int perFrame = 32;
+		double speed = 1;
+		const char * socketPath = nullptr;
+		int predictor = EHEALTH_PREDICT_DELTA;
+		int keyframe = EHEALTH_CODEC_KEYFRAME_INTERVAL;
+
+		// compress and expand write a second file.
+		bool converts = !strcmp(command, "compress") || !strcmp(command, "expand");
+		if (converts && argc < 4) {
+			usage();
+		}
+		const char * outPath = converts ? argv[3] : nullptr;
+
+		for (int i = converts ? 4 : 3; i < argc; i++) {
+			if (i + 1 >= argc) {
+				usage();
+			}
+			const char * option = argv[i];
+			const char * value = argv[++i];
+
+			if (!strcmp(option, "--seconds")) {
+				seconds = atof(value);
+			} else if (!strcmp(option, "--seed")) {
+				seed = strtoul(value, NULL, 10);
+			} else if (!strcmp(option, "--rate")) {
+				rate = atoi(value);
+			} else if (!strcmp(option, "--frame")) {
+				perFrame = atoi(value);
+			} else if (!strcmp(option, "--speed")) {
+				speed = atof(value);
+			} else if (!strcmp(option, "--socket")) {
+				socketPath = value;
+			} else if (!strcmp(option, "--predictor")) {
+				predictor = atoi(value);
+			} else if (!strcmp(option, "--keyframe")) {
+				keyframe = atoi(value);
+			} else {
+				usage();
+			}
+		}
+
+		if (!strcmp(command, "record")) {
+			// A frame carries at most 255 bytes of payload: 51 snapshots of 40 bits.
+			if (rate == 0 || perFrame < 1 || perFrame > 51) {
+				usage();
+			}
+			return record(path, seconds, seed, rate, (uint8_t)perFrame);
+		} else if (!strcmp(command, "capture")) {
+			return capture(path);
+		} else if (!strcmp(command, "info")) {
+			return info(path);
+		} else if (!strcmp(command, "replay")) {
+			return replay(path, speed, socketPath);
+		} else if (!strcmp(command, "compress")) {
+			if (predictor < EHEALTH_PREDICT_NONE || predictor > EHEALTH_PREDICT_LINEAR || keyframe < 1 || keyframe > 65535) {
+				usage();
+			}
+			return compress(path, outPath, predictor, keyframe);
+		} else if (!strcmp(command, "expand")) {
+			return expand(path, outPath);
+		}
+		usage();
+		return 2;
+	}
+
@@ -0,0 +1,15 @@
+/*
+*=========================================================================================
+ *  Host stand-in for the eHealth "utils/i2c.h" bus helpers.
+ *
+ *  The mock never talks to a real I2C bus, so there is nothing to declare here.
+ *  The file only exists so eHealthMock.cpp builds unchanged on the host.
+ *========================================================================================
+ */
+
+
+#ifndef i2c_h
+#define i2c_h
+
+#endif
+
@@ -0,0 +1,182 @@
+/*
+*=========================================================================================
+ *  Tests for the heartbeat detector.
+ *========================================================================================
+ */
+
+
+#include "eHealthBeat.h"
+#include "eHealthRandom.h"
+#include "eHealthTest.h"
+#include "eHealthWaveform.h"
+
+#include <vector>
+
+
+	//! Feeds seconds of the synthesized ECG at bpm and rate to detector,
+	//! with uniform noise of up to noise counts added. Returns the beats found.
+	static size_t feed(eHealthBeatDetector & detector, uint8_t bpm, uint16_t rate, uint16_t seconds, uint16_t noise = 0)
+	{
+		eHealthWaveform waveform;
+		eHealthRandom rng;
+		size_t found = 0;
+
+		waveform.setECG(bpm, 300, rate);
+		detector.setSampleRate(rate);
+		for (uint32_t i = 0; i < (uint32_t)seconds * rate; i++) {
+			int32_t sample = waveform.nextECG();
+			if (noise) {
+				sample += (int32_t)rng.uniform(0, 2 * noise + 1) - noise;
+			}
+			found += detector.update(sample < 0 ? 0 : sample > 1023 ? 1023 : (uint16_t)sample);
+		}
+		return found;
+	}
+
+
+//***************************************************************
+// Detection													*
+//***************************************************************
+
+	EH_TEST(test_nothing_is_reported_before_two_beats)
+	{
+		eHealthBeatDetector detector;
+
+		EH_CHECK_EQUAL(250, detector.sampleRate());
+		EH_CHECK_EQUAL(0, detector.bpm());
+		EH_CHECK_EQUAL(0, detector.rrInterval());
+		EH_CHECK_EQUAL(0u, detector.beats());
+	}
+
+	EH_TEST(test_rate_follows_the_ecg_at_250_hz)
+	{
+		const uint8_t rates[] = { 45, 60, 75, 120, 180 };
+
+		for (size_t r = 0; r < sizeof(rates); r++) {
+			eHealthBeatDetector detector;
+			feed(detector, rates[r], 250, 12);
+			EH_CHECK_NEAR(rates[r], detector.bpm(), 1);
+			EH_CHECK_NEAR(60000.0 / rates[r], detector.rrInterval(), 8);
+		}
+	}
+
+	EH_TEST(test_rate_follows_the_ecg_at_high_sample_rates)
+	{
+		const uint16_t sampleRates[] = { 100, 360, 500, 800, 1000, 2000 };
+
+		for (size_t r = 0; r < sizeof(sampleRates) / sizeof(sampleRates[0]); r++) {
+			eHealthBeatDetector detector;
+			feed(detector, 72, sampleRates[r], 12);
+			EH_CHECK_NEAR(72, detector.bpm(), 1);
+		}
+	}
+
+	EH_TEST(test_every_beat_after_learning_is_found)
+	{
+		eHealthBeatDetector detector;
+
+		// 2 s of learning, then 18 s at one beat per second.
+		size_t found = feed(detector, 60, 800, 20);
+		EH_CHECK_NEAR(18, found, 1);
+		EH_CHECK_EQUAL(found, detector.beats());
+	}
+
+	EH_TEST(test_noise_does_not_add_or_drop_beats)
+	{
+		eHealthBeatDetector detector;
+
+		size_t found = feed(detector, 90, 500, 20, 40);
+		EH_CHECK_NEAR(27, found, 1);
+		EH_CHECK_NEAR(90, detector.bpm(), 1);
+	}
+
+	EH_TEST(test_rate_changes_are_tracked)
+	{
+		eHealthBeatDetector detector;
+		eHealthWaveform waveform;
+
+		waveform.setECG(60, 300, 250);
+		for (uint32_t i = 0; i < 10 * 250; i++) {
+			detector.update(waveform.nextECG());
+		}
+		EH_CHECK_NEAR(60, detector.bpm(), 1);
+
+		waveform.setECG(100, 300, 250);
+		for (uint32_t i = 0; i < 10 * 250; i++) {
+			detector.update(waveform.nextECG());
+		}
+		EH_CHECK_NEAR(100, detector.bpm(), 1);
+	}
+
+	EH_TEST(test_flat_line_drops_the_rate)
+	{
+		eHealthBeatDetector detector;
+
+		feed(detector, 75, 250, 10);
+		EH_CHECK(detector.bpm() > 0);
+
+		for (uint32_t i = 0; i < 4 * 250; i++) {
+			detector.update(512);
+		}
+		EH_CHECK_EQUAL(0, detector.bpm());
+		EH_CHECK_EQUAL(0, detector.rrInterval());
+	}
+
+
+//***************************************************************
+// Configuration												*
+//***************************************************************
+
+	EH_TEST(test_sample_rate_out_of_range_stops_the_detector)
+	{
+		eHealthBeatDetector detector;
+
+		EH_CHECK(!detector.setSampleRate(50));
+		EH_CHECK_EQUAL(0, detector.sampleRate());
+		EH_CHECK(!detector.setSampleRate(4000));
+		EH_CHECK(detector.setSampleRate(0));
+
+		for (uint32_t i = 0; i < 5000; i++) {
+			EH_CHECK(!detector.update(i % 250 < 10 ? 800 : 512));
+		}
+		EH_CHECK_EQUAL(0u, detector.beats());
+	}
+
+	EH_TEST(test_block_matches_samples)
+	{
+		eHealthWaveform waveform;
+		eHealthBeatDetector single;
+		eHealthBeatDetector block;
+		std::vector<uint16_t> samples(8000);
+
+		waveform.setECG(66, 300, 800);
+		waveform.fillECG(samples.data(), samples.size());
+		single.setSampleRate(800);
+		block.setSampleRate(800);
+
+		size_t found = 0;
+		for (size_t i = 0; i < samples.size(); i++) {
+			found += single.update(samples[i]);
+		}
+		size_t blockFound = 0;
+		for (size_t i = 0; i < samples.size(); i += 100) {
+			blockFound += block.process(samples.data() + i, 100);
+		}
+		EH_CHECK_EQUAL(found, blockFound);
+		EH_CHECK_EQUAL(single.bpm(), block.bpm());
+		EH_CHECK_EQUAL(single.rrInterval(), block.rrInterval());
+	}
+
+	EH_TEST(test_reset_forgets_the_beats)
+	{
+		eHealthBeatDetector detector;
+
+		feed(detector, 75, 250, 6);
+		EH_CHECK(detector.beats() > 0);
+		detector.reset();
+		EH_CHECK_EQUAL(0u, detector.beats());
+		EH_CHECK_EQUAL(0, detector.bpm());
+		EH_CHECK_EQUAL(250, detector.sampleRate());
+	}
+
+EH_TEST_MAIN()
@@ -0,0 +1,330 @@
+/*
+*=========================================================================================
+ *  Tests for the lossless waveform codec.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthCodec.h"
+#include "eHealthTest.h"
+
+#include <vector>
+
+
+	static const uint16_t ANALOG = EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_EMG)
+		| EHEALTH_CHANNEL_BIT(EHEALTH_AIRFLOW) | EHEALTH_CHANNEL_BIT(EHEALTH_GSR);
+
+	//! count snapshots of the four analog channels at 250 Hz, snapshot major.
+	static std::vector<uint16_t> analogSnapshots(size_t count)
+	{
+		eHealthWaveform waveform;
+		std::vector<uint16_t> ecg(count), emg(count), airFlow(count);
+		std::vector<uint16_t> values(4 * count);
+
+		waveform.fillECG(ecg.data(), count);
+		waveform.fillEMG(emg.data(), count);
+		waveform.fillAirFlow(airFlow.data(), count);
+
+		for (size_t i = 0; i < count; i++) {
+			values[4 * i] = ecg[i];
+			values[4 * i + 1] = emg[i];
+			values[4 * i + 2] = airFlow[i];
+			values[4 * i + 3] = (uint16_t)(600 + i / 50);
+		}
+		return values;
+	}
+
+	//! Feeds data in pieces of step bytes and decodes every packet, in order.
+	//! Packets that cannot be decoded come back empty.
+	static std::vector<std::vector<uint16_t> > decodeAll(eHealthCodecDecoder & decoder,
+		const uint8_t * data, size_t length, size_t step)
+	{
+		std::vector<std::vector<uint16_t> > packets;
+
+		while (length) {
+			size_t piece = length < step ? length : step;
+			size_t used = decoder.feed(data, piece);
+			data += used;
+			length -= used;
+
+			if (decoder.available()) {
+				const eHealthPacket & packet = decoder.packet();
+				std::vector<uint16_t> values(packet.count * packet.channelCount);
+				if (!decoder.decode(packet, values.data())) {
+					values.clear();
+				}
+				packets.push_back(values);
+			}
+		}
+		return packets;
+	}
+
+
+//***************************************************************
+// Round trips													*
+//***************************************************************
+
+	EH_TEST(test_waveforms_round_trip_with_every_predictor)
+	{
+		std::vector<uint16_t> values = analogSnapshots(32 * 40);
+
+		for (uint8_t order = EHEALTH_PREDICT_NONE; order <= EHEALTH_PREDICT_LINEAR; order++) {
+			eHealthCodecEncoder encoder;
+			eHealthCodecDecoder decoder;
+			std::vector<uint8_t> stream;
+			uint8_t packet[EHEALTH_PACKET_MAX_SIZE];
+
+			for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+				encoder.setPredictor(channel, (eHealthPredictor)order);
+			}
+			for (size_t i = 0; i < 40; i++) {
+				size_t size = encoder.encode(ANALOG, 32, (uint32_t)i * 128000, 4000, &values[4 * 32 * i], packet, sizeof(packet));
+				EH_CHECK(size > 0);
+				stream.insert(stream.end(), packet, packet + size);
+			}
+
+			std::vector<std::vector<uint16_t> > decoded = decodeAll(decoder, stream.data(), stream.size(), 7);
+
+			EH_CHECK_EQUAL(40U, decoded.size());
+			EH_CHECK_EQUAL(0U, decoder.skipped());
+			for (size_t i = 0; i < decoded.size(); i++) {
+				EH_CHECK(decoded[i] == std::vector<uint16_t>(&values[4 * 32 * i], &values[4 * 32 * (i + 1)]));
+			}
+		}
+	}
+
+	EH_TEST(test_prediction_compresses_the_waveforms)
+	{
+		std::vector<uint16_t> values = analogSnapshots(32 * 64);
+		size_t bytes[3] = {};
+
+		for (uint8_t order = EHEALTH_PREDICT_NONE; order <= EHEALTH_PREDICT_LINEAR; order++) {
+			eHealthCodecEncoder encoder;
+			uint8_t packet[EHEALTH_PACKET_MAX_SIZE];
+
+			for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+				encoder.setPredictor(channel, (eHealthPredictor)order);
+			}
+			for (size_t i = 0; i < 64; i++) {
+				bytes[order] += encoder.encode(ANALOG, 32, 0, 4000, &values[4 * 32 * i], packet, sizeof(packet));
+			}
+		}
+
+		// Frames of the same snapshots take 64 * 175 bytes.
+		size_t frames = 64 * eHealthFrameEncoder::frameSize(ANALOG, 32);
+		EH_CHECK(bytes[EHEALTH_PREDICT_DELTA] * 3 < frames * 2);
+		EH_CHECK(bytes[EHEALTH_PREDICT_DELTA] < bytes[EHEALTH_PREDICT_NONE]);
+		EH_CHECK(bytes[EHEALTH_PREDICT_LINEAR] < bytes[EHEALTH_PREDICT_NONE]);
+	}
+
+	EH_TEST(test_full_scale_values_round_trip)
+	{
+		eHealthCodecEncoder encoder;
+		eHealthCodecDecoder decoder;
+		eHealthRandom random(7);
+		uint8_t packet[EHEALTH_PACKET_MAX_SIZE];
+		uint16_t values[11 * 12];
+		uint16_t decoded[11 * 12];
+
+		encoder.setPredictor(EHEALTH_TEMPERATURE, EHEALTH_PREDICT_LINEAR);
+		encoder.setPredictor(EHEALTH_SPO2, EHEALTH_PREDICT_NONE);
+
+		// Noise across the whole width of every channel wraps the residuals.
+		for (int round = 0; round < 20; round++) {
+			for (int i = 0; i < 11 * 12; i++) {
+				uint8_t width = eHealthFrameChannelBits(i % 11);
+				values[i] = (uint16_t)(random.next() & ((1UL << width) - 1));
+			}
+
+			size_t size = encoder.encode(EHEALTH_ALL_CHANNELS, 12, 0, 1000, values, packet, sizeof(packet));
+			EH_CHECK(size > 0);
+			EH_CHECK_EQUAL(size, decoder.feed(packet, size));
+			EH_CHECK(decoder.available());
+			EH_CHECK(decoder.decode(decoder.packet(), decoded));
+			EH_CHECK(std::vector<uint16_t>(values, values + 11 * 12) == std::vector<uint16_t>(decoded, decoded + 11 * 12));
+		}
+	}
+
+	EH_TEST(test_channels_may_come_and_go)
+	{
+		eHealthCodecEncoder encoder;
+		eHealthCodecDecoder decoder;
+		uint8_t packet[EHEALTH_PACKET_MAX_SIZE];
+		uint16_t ecg = EHEALTH_CHANNEL_BIT(EHEALTH_ECG);
+		uint16_t slow = EHEALTH_CHANNEL_BIT(EHEALTH_TEMPERATURE) | EHEALTH_CHANNEL_BIT(EHEALTH_BPM);
+		uint16_t values[8];
+		uint16_t decoded[8];
+
+		for (uint16_t i = 0; i < 30; i++) {
+			bool both = i % 5 == 2;
+			uint16_t channels = both ? (uint16_t)(ecg | slow) : ecg;
+			uint8_t count = both ? 2 : 8;
+
+			for (int j = 0; j < 8; j++) {
+				values[j] = (uint16_t)(100 + i * 3 + j);
+			}
+			size_t size = encoder.encode(channels, count, 0, 4000, values, packet, sizeof(packet));
+			eHealthPacket parsed;
+			EH_CHECK_EQUAL(size, eHealthPacketParse(packet, size, parsed));
+			EH_CHECK(decoder.decode(parsed, decoded));
+			EH_CHECK(std::vector<uint16_t>(values, values + parsed.count * parsed.channelCount)
+				== std::vector<uint16_t>(decoded, decoded + parsed.count * parsed.channelCount));
+		}
+	}
+
+
+//***************************************************************
+// Keyframes and errors											*
+//***************************************************************
+
+	EH_TEST(test_decoder_resumes_at_the_next_keyframe)
+	{
+		std::vector<uint16_t> values = analogSnapshots(16 * 12);
+		eHealthCodecEncoder encoder;
+		eHealthCodecDecoder decoder;
+		std::vector<uint8_t> stream;
+		uint8_t packet[EHEALTH_PACKET_MAX_SIZE];
+
+		encoder.setKeyframeInterval(4);
+		for (size_t i = 0; i < 12; i++) {
+			size_t size = encoder.encode(ANALOG, 16, 0, 4000, &values[4 * 16 * i], packet, sizeof(packet));
+			// Packet 5 is lost on the way.
+			if (i != 5) {
+				stream.insert(stream.end(), packet, packet + size);
+			}
+			EH_CHECK_EQUAL(i % 4 == 0, (packet[13] & EHEALTH_PACKET_KEYFRAME) != 0);
+		}
+
+		std::vector<std::vector<uint16_t> > decoded = decodeAll(decoder, stream.data(), stream.size(), 64);
+
+		EH_CHECK_EQUAL(11U, decoded.size());
+		EH_CHECK_EQUAL(2U, decoder.skipped());
+		for (size_t i = 0; i < 12; i++) {
+			size_t at = i < 5 ? i : i - 1;
+			if (i == 5) {
+				continue;
+			}
+			if (i == 6 || i == 7) {
+				EH_CHECK(decoded[at].empty());
+			} else {
+				EH_CHECK(decoded[at] == std::vector<uint16_t>(&values[4 * 16 * i], &values[4 * 16 * (i + 1)]));
+			}
+		}
+	}
+
+	EH_TEST(test_decoder_waits_for_the_first_keyframe)
+	{
+		eHealthCodecEncoder encoder;
+		eHealthCodecDecoder decoder;
+		uint8_t packet[EHEALTH_PACKET_MAX_SIZE];
+		uint16_t values[4] = { 1, 2, 3, 4 };
+		uint16_t decoded[4];
+		eHealthPacket parsed;
+
+		encoder.encode(EHEALTH_CHANNEL_BIT(EHEALTH_ECG), 4, 0, 4000, values, packet, sizeof(packet));
+		size_t size = encoder.encode(EHEALTH_CHANNEL_BIT(EHEALTH_ECG), 4, 0, 4000, values, packet, sizeof(packet));
+		EH_CHECK(eHealthPacketParse(packet, size, parsed));
+		EH_CHECK(!decoder.decode(parsed, decoded));
+
+		encoder.forceKeyframe();
+		size = encoder.encode(EHEALTH_CHANNEL_BIT(EHEALTH_ECG), 4, 0, 4000, values, packet, sizeof(packet));
+		EH_CHECK(eHealthPacketParse(packet, size, parsed));
+		EH_CHECK(parsed.keyframe());
+		EH_CHECK(decoder.decode(parsed, decoded));
+		EH_CHECK_EQUAL(4, decoded[3]);
+	}
+
+	EH_TEST(test_packet_too_large_leaves_the_encoder_unchanged)
+	{
+		std::vector<uint16_t> values = analogSnapshots(64);
+		eHealthCodecEncoder encoder;
+		eHealthCodecDecoder decoder;
+		uint8_t packet[EHEALTH_PACKET_MAX_SIZE];
+		uint16_t decoded[4 * 32];
+		eHealthPacket parsed;
+
+		EH_CHECK_EQUAL(0U, encoder.encode(ANALOG, 32, 0, 4000, values.data(), packet, 40));
+		EH_CHECK_EQUAL(0, encoder.sequence());
+		EH_CHECK_EQUAL(0U, encoder.encode(0, 32, 0, 4000, values.data(), packet, sizeof(packet)));
+
+		for (int i = 0; i < 2; i++) {
+			size_t size = encoder.encode(ANALOG, 32, 0, 4000, &values[4 * 32 * i], packet, sizeof(packet));
+			EH_CHECK_EQUAL(size, eHealthPacketParse(packet, size, parsed));
+			EH_CHECK(decoder.decode(parsed, decoded));
+			EH_CHECK(std::vector<uint16_t>(decoded, decoded + 4 * 32) == std::vector<uint16_t>(&values[4 * 32 * i], &values[4 * 32 * (i + 1)]));
+		}
+	}
+
+	EH_TEST(test_noise_is_split_over_packets)
+	{
+		eHealthCodecEncoder encoder;
+		eHealthCodecDecoder decoder;
+		eHealthRandom random(3);
+		std::vector<uint16_t> values(11 * 255);
+		std::vector<uint8_t> stream;
+		uint8_t packet[EHEALTH_PACKET_MAX_SIZE];
+
+		for (size_t i = 0; i < values.size(); i++) {
+			values[i] = (uint16_t)(random.next() & ((1UL << eHealthFrameChannelBits(i % 11)) - 1));
+		}
+
+		// About 15 bytes of noise a snapshot: 255 of them take 15 packets.
+		EH_CHECK_EQUAL(0U, encoder.encode(EHEALTH_ALL_CHANNELS, 255, 0, 1000, values.data(), packet, sizeof(packet)));
+		size_t packets = 0;
+		for (uint8_t done = 0, used = 0; done < 255; done += used) {
+			eHealthCodecEncoder before = encoder;
+			size_t size = encoder.encodeSome(EHEALTH_ALL_CHANNELS, 255 - done, done * 1000, 1000,
+				&values[11 * done], packet, sizeof(packet), used);
+			EH_CHECK(size > 0 && used > 0);
+			stream.insert(stream.end(), packet, packet + size);
+			packets++;
+
+			// The packet holds the most that fit: one more snapshot does not.
+			uint8_t scratch[EHEALTH_PACKET_MAX_SIZE];
+			EH_CHECK(done + used == 255 || before.encode(EHEALTH_ALL_CHANNELS, used + 1, 0, 1000, &values[11 * done],
+				scratch, sizeof(scratch)) == 0);
+		}
+		EH_CHECK_EQUAL(15U, packets);
+
+		std::vector<std::vector<uint16_t> > decoded = decodeAll(decoder, stream.data(), stream.size(), 64);
+		EH_CHECK_EQUAL(packets, decoded.size());
+		std::vector<uint16_t> all;
+		for (const std::vector<uint16_t> & p : decoded) {
+			all.insert(all.end(), p.begin(), p.end());
+		}
+		EH_CHECK(all == values);
+	}
+
+	EH_TEST(test_frames_and_packets_share_a_stream)
+	{
+		eHealthCodecEncoder codec;
+		eHealthFrameEncoder framer;
+		eHealthCodecDecoder packets;
+		eHealthFrameDecoder frames;
+		std::vector<uint8_t> stream;
+		uint8_t buffer[EHEALTH_PACKET_MAX_SIZE];
+		uint16_t values[8] = { 500, 510, 520, 530, 540, 550, 560, 570 };
+
+		for (int i = 0; i < 3; i++) {
+			size_t size = codec.encode(EHEALTH_CHANNEL_BIT(EHEALTH_ECG), 8, 0, 4000, values, buffer, sizeof(buffer));
+			stream.insert(stream.end(), buffer, buffer + size);
+			size = framer.encode(EHEALTH_CHANNEL_BIT(EHEALTH_ECG), 8, 0, 4000, values, buffer, sizeof(buffer));
+			stream.insert(stream.end(), buffer, buffer + size);
+		}
+
+		// A damaged packet is dropped by its CRC.
+		stream[20] ^= 0x10;
+
+		EH_CHECK_EQUAL(2U, decodeAll(packets, stream.data(), stream.size(), 5).size());
+		EH_CHECK_EQUAL(1U, packets.crcErrors());
+
+		size_t found = 0;
+		for (size_t used = 0; used < stream.size();) {
+			used += frames.feed(&stream[used], stream.size() - used);
+			found += frames.available();
+		}
+		EH_CHECK_EQUAL(3U, found);
+	}
+
+EH_TEST_MAIN()
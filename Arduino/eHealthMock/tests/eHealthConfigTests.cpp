@@ -0,0 +1,112 @@
+/*
+*=========================================================================================
+ *  Tests for the build-time configuration, built with only ECG and SpO2.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthTest.h"
+
+#include <string>
+
+
+	//! Keeps everything written.
+	class stringSink : public eHealthSink {
+
+		public:
+
+			size_t write(const uint8_t * data, size_t length) override
+			{
+				text.append((const char *)data, length);
+				return length;
+			}
+
+			std::string text;
+	};
+
+	EH_TEST(test_channels_follow_enabled_sensors)
+	{
+		uint16_t expected = EHEALTH_CHANNEL_BIT(EHEALTH_ECG)
+			| EHEALTH_CHANNEL_BIT(EHEALTH_SPO2) | EHEALTH_CHANNEL_BIT(EHEALTH_BPM);
+
+		EH_CHECK_EQUAL(expected, EHEALTH_CHANNELS);
+	}
+
+	EH_TEST(test_histories_are_compiled_out)
+	{
+		// Without the two histories the class is smaller than either of them.
+		EH_CHECK(sizeof(eHealthClassMock) < sizeof(eHealthHistoryN<EHEALTH_HISTORY_CAPACITY, 2>));
+	}
+
+	EH_TEST(test_disabled_channels_read_zero)
+	{
+		eHealthClassMock mock;
+
+		mock.readPulsioximeter();
+
+		EH_CHECK_EQUAL(0, mock.readChannel(EHEALTH_GSR));
+		EH_CHECK_EQUAL(0, mock.readChannel(EHEALTH_GLUCOSE));
+		EH_CHECK_EQUAL(75, mock.readChannel(EHEALTH_BPM));
+		EH_CHECK(mock.getECG() > 0);
+	}
+
+	EH_TEST(test_bpm_comes_from_the_pulsioximeter_without_heartbeat)
+	{
+		eHealthClassMock mock;
+		static float ecg[2500];
+
+		mock.readPulsioximeter();
+		mock.waveform.setECG(96, 300, 250);
+		mock.getECGBlock(ecg, 2500);
+
+		EH_CHECK_EQUAL(75, mock.getBPM());
+	}
+
+	EH_TEST(test_frames_leave_out_disabled_channels)
+	{
+		eHealthClassMock mock;
+		stringSink sink;
+		eHealthOutput output(sink);
+		eHealthFrame frame;
+
+		mock.setOutput(output);
+		size_t size = mock.writeFrame(EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_GSR));
+
+		EH_CHECK_EQUAL(size, eHealthFrameParse((const uint8_t *)sink.text.data(), sink.text.size(), frame));
+		EH_CHECK(frame.has(EHEALTH_ECG));
+		EH_CHECK(!frame.has(EHEALTH_GSR));
+	}
+
+	EH_TEST(test_frames_of_only_disabled_channels_are_not_sent)
+	{
+		eHealthClassMock mock;
+		stringSink sink;
+		eHealthOutput output(sink);
+
+		mock.setOutput(output);
+
+		EH_CHECK_EQUAL(0U, mock.writeFrame(EHEALTH_CHANNEL_BIT(EHEALTH_GSR)));
+		EH_CHECK(sink.text.empty());
+	}
+
+	EH_TEST(test_snapshots_leave_out_disabled_channels)
+	{
+		eHealthClassMock mock;
+		eHealthSnapshot snapshot;
+		eHealthSnapshotBlock block = {};
+		uint16_t ecg[8];
+		uint16_t gsr[8] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+		EH_CHECK_EQUAL(EHEALTH_CHANNEL_BIT(EHEALTH_ECG), mock.sampleAll(snapshot,
+			EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_GSR)));
+		EH_CHECK_EQUAL(0, snapshot.values[EHEALTH_GSR]);
+
+		block.values[EHEALTH_ECG] = ecg;
+		block.values[EHEALTH_GSR] = gsr;
+		EH_CHECK_EQUAL(EHEALTH_CHANNEL_BIT(EHEALTH_ECG), mock.sampleAllBlock(block, 8));
+		EH_CHECK_EQUAL(0, gsr[7]);
+		EH_CHECK(ecg[7] > 0);
+	}
+
+EH_TEST_MAIN()
@@ -0,0 +1,154 @@
+/*
+*=========================================================================================
+ *  Tests for the streaming filter and decimator.
+ *========================================================================================
+ */
+
+
+#include "eHealthFilter.h"
+#include "eHealthTest.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+
+	//! ADC counts of a sine of amplitude counts and frequency hz, sample i at rate.
+	static uint16_t sine(double amplitude, double hz, uint32_t i, uint16_t rate)
+	{
+		return (uint16_t)lround(512 + amplitude * sin(2 * M_PI * hz * i / rate));
+	}
+
+	//! Pushes count samples of a sine and returns the largest output
+	//! deviation from 512 over the last quarter.
+	static int settledAmplitude(eHealthFilter & filter, double amplitude, double hz, uint32_t count)
+	{
+		int peak = 0;
+		uint32_t produced = 0;
+		uint32_t expected = count / filter.decimation();
+
+		for (uint32_t i = 0; i < count; i++) {
+			uint16_t out;
+			if (filter.push(sine(amplitude, hz, i, 1000), out) && ++produced > expected * 3 / 4) {
+				int deviation = abs((int)out - 512);
+				peak = deviation > peak ? deviation : peak;
+			}
+		}
+		return peak;
+	}
+
+
+//***************************************************************
+// Sections														*
+//***************************************************************
+
+	EH_TEST(test_default_passes_samples_through)
+	{
+		eHealthFilter filter;
+		uint16_t out = 0;
+
+		EH_CHECK(filter.push(700, out));
+		EH_CHECK_EQUAL(700, out);
+		EH_CHECK(filter.push(2000, out));
+		EH_CHECK_EQUAL(1023, out);
+		EH_CHECK_EQUAL(250, filter.outputRate());
+	}
+
+	EH_TEST(test_notch_removes_mains_and_keeps_the_signal)
+	{
+		eHealthFilter filter;
+		filter.setSampleRate(1000);
+
+		EH_CHECK(filter.setNotch(50));
+		EH_CHECK(settledAmplitude(filter, 300, 50, 4000) <= 3);
+
+		filter.reset();
+		EH_CHECK_NEAR(300, settledAmplitude(filter, 300, 10, 4000), 6);
+
+		EH_CHECK(filter.setNotch(60));
+		EH_CHECK(settledAmplitude(filter, 300, 60, 4000) <= 3);
+		// 60 Hz is past half of 100 Hz: the notch is dropped.
+		EH_CHECK(!filter.setSampleRate(100));
+	}
+
+	EH_TEST(test_band_pass_removes_the_baseline_without_an_offset)
+	{
+		eHealthFilter filter;
+		filter.setSampleRate(1000);
+		EH_CHECK(filter.setBandPass(0.5, 40));
+
+		uint16_t out = 0;
+		bool settled = true;
+		for (uint32_t i = 0; i < 30000; i++) {
+			filter.push(800, out);
+			if (i >= 29000) {
+				settled &= out == 512;
+			}
+		}
+		EH_CHECK(settled);
+
+		filter.reset();
+		EH_CHECK_NEAR(300, settledAmplitude(filter, 300, 10, 4000), 9);
+		filter.reset();
+		EH_CHECK(settledAmplitude(filter, 300, 150, 4000) < 30);
+		EH_CHECK(!filter.setBandPass(0.5, 600));
+	}
+
+
+//***************************************************************
+// Decimation													*
+//***************************************************************
+
+	EH_TEST(test_decimation_keeps_the_band_and_rejects_aliases)
+	{
+		eHealthFilter filter;
+		filter.setSampleRate(1000);
+		EH_CHECK(filter.setDecimation(4));
+		EH_CHECK_EQUAL(250, filter.outputRate());
+
+		EH_CHECK_NEAR(300, settledAmplitude(filter, 300, 10, 4000), 6);
+		filter.reset();
+		// 200 Hz would fold onto 50 Hz at 250 samples per second.
+		EH_CHECK(settledAmplitude(filter, 300, 200, 4000) <= 2);
+		EH_CHECK(!filter.setDecimation(0));
+	}
+
+	EH_TEST(test_blocks_match_single_pushes)
+	{
+		eHealthFilter single;
+		eHealthFilter block;
+		std::vector<uint16_t> in(1001);
+		std::vector<uint16_t> expected;
+		std::vector<uint16_t> out(1001 / 3 + 4);
+
+		for (size_t i = 0; i < in.size(); i++) {
+			in[i] = sine(200, 7, i, 500) + sine(50, 50, i, 500) - 512;
+		}
+
+		eHealthFilter * filters[2] = { &single, &block };
+		for (int f = 0; f < 2; f++) {
+			filters[f]->setSampleRate(500);
+			filters[f]->setNotch(50);
+			filters[f]->setBandPass(0.5, 40);
+			filters[f]->setDecimation(3);
+		}
+
+		for (size_t i = 0; i < in.size(); i++) {
+			uint16_t value;
+			if (single.push(in[i], value)) {
+				expected.push_back(value);
+			}
+		}
+
+		size_t produced = 0;
+		for (size_t i = 0; i < in.size(); i += 64) {
+			size_t n = in.size() - i < 64 ? in.size() - i : 64;
+			produced += block.process(&in[i], n, &out[produced]);
+		}
+
+		EH_CHECK_EQUAL(333U, expected.size());
+		EH_CHECK_EQUAL(expected.size(), produced);
+		EH_CHECK(std::equal(expected.begin(), expected.end(), out.begin()));
+	}
+
+EH_TEST_MAIN()
@@ -0,0 +1,131 @@
+/*
+*=========================================================================================
+ *  Tests for the multi-patient fleet simulator.
+ *========================================================================================
+ */
+
+
+#include "eHealthFleet.h"
+#include "eHealthTest.h"
+
+#include <vector>
+
+
+	//! Runs a fleet and returns a checksum of every patient's readings.
+	static std::vector<double> fleetChecksums(unsigned workers, size_t shardSize)
+	{
+		eHealthFleetConfig config;
+		config.patients = 300;
+		config.workers = workers;
+		config.shardSize = shardSize;
+		config.seed = 99;
+		config.emgRate = 500;
+
+		std::vector<double> sums(config.patients, 0);
+		eHealthFleet fleet(config);
+
+		for (int run = 0; run < 3; run++) {
+			fleet.run(0.7, [&](const eHealthFleetBlock & block) {
+				double sum = 0;
+				for (size_t i = 0; i < block.ecgCount; i++) sum += block.ecg[i] * (i + 1);
+				for (size_t i = 0; i < block.emgCount; i++) sum += block.emg[i];
+				for (size_t i = 0; i < block.airFlowCount; i++) sum += block.airFlow[i];
+				for (size_t i = 0; i < block.gsrCount; i++) sum += block.gsr[i].voltage;
+				for (size_t i = 0; i < block.positionCount; i++) sum += block.position[i] * (i + 1);
+				// Each patient is handled by one worker per run.
+				sums[block.patient] += sum;
+			});
+		}
+		return sums;
+	}
+
+	EH_TEST(test_fleet_is_independent_of_scheduling)
+	{
+		std::vector<double> serial = fleetChecksums(1, 300);
+		std::vector<double> parallel = fleetChecksums(4, 7);
+
+		EH_CHECK_EQUAL(serial.size(), parallel.size());
+		for (size_t i = 0; i < serial.size(); i++) {
+			EH_CHECK_EQUAL(serial[i], parallel[i]);
+		}
+		// Differently seeded patients do not produce the same readings.
+		EH_CHECK(serial[0] != serial[1]);
+	}
+
+	EH_TEST(test_fleet_counts_samples_without_drift)
+	{
+		eHealthFleetConfig config;
+		config.patients = 10;
+		config.workers = 2;
+		config.ecgRate = 250;
+		config.airFlowRate = 25;
+		config.gsrRate = 10;
+		config.positionRate = 50;
+
+		eHealthFleet fleet(config);
+		uint64_t total = 0;
+
+		// 0.13 s slices do not divide evenly into samples.
+		for (int run = 0; run < 100; run++) {
+			eHealthFleetReport report = fleet.run(0.13);
+			total += report.samples;
+			EH_CHECK_EQUAL(report.shards, 1U);
+		}
+
+		EH_CHECK_EQUAL(10U * 13 * (250 + 25 + 10 + 50), total);
+	}
+
+	EH_TEST(test_fleet_classifies_each_patient_posture)
+	{
+		eHealthFleetConfig config;
+		config.patients = 20;
+		config.workers = 2;
+
+		std::vector<size_t> counts(config.patients, 0);
+		std::vector<uint8_t> last(config.patients, 0);
+		eHealthFleet fleet(config);
+
+		fleet.run(1.0, [&](const eHealthFleetBlock & block) {
+			counts[block.patient] = block.positionCount;
+			last[block.patient] = block.position[block.positionCount - 1];
+		});
+
+		// Patients lie in the posture their seed picks, one of the five.
+		for (size_t i = 0; i < last.size(); i++) {
+			uint32_t seed = eHealthFleet::patientSeed(config.seed, i);
+			EH_CHECK_EQUAL(50U, counts[i]);
+			EH_CHECK_EQUAL(1 + (seed >> 24) % 5, (uint32_t)last[i]);
+		}
+	}
+
+	EH_TEST(test_fleet_detects_each_patient_heart_rate)
+	{
+		eHealthFleetConfig config;
+		config.patients = 20;
+		config.workers = 2;
+		config.ecgRate = 800;
+
+		std::vector<uint8_t> bpm(config.patients, 0);
+		eHealthFleet fleet(config);
+
+		for (int run = 0; run < 10; run++) {
+			fleet.run(1.0, [&](const eHealthFleetBlock & block) {
+				bpm[block.patient] = block.bpm;
+			});
+		}
+
+		// The ECG of each patient beats at the rate its seed picks.
+		for (size_t i = 0; i < bpm.size(); i++) {
+			uint32_t seed = eHealthFleet::patientSeed(config.seed, i);
+			EH_CHECK_NEAR(55 + seed % 46, bpm[i], 1);
+		}
+	}
+
+	EH_TEST(test_patient_seeds_are_distinct)
+	{
+		EH_CHECK(eHealthFleet::patientSeed(1, 0) != eHealthFleet::patientSeed(1, 1));
+		EH_CHECK(eHealthFleet::patientSeed(1, 0) != eHealthFleet::patientSeed(2, 0));
+		EH_CHECK(eHealthFleet::patientSeed(1, 5) == eHealthFleet::patientSeed(1, 5));
+	}
+
+EH_TEST_MAIN()
@@ -0,0 +1,155 @@
+/*
+*=========================================================================================
+ *  Tests for the binary frame encoder and decoder.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthFrame.h"
+#include "eHealthTest.h"
+
+#include <vector>
+
+
+	static const uint16_t ANALOG = EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_EMG)
+		| EHEALTH_CHANNEL_BIT(EHEALTH_AIRFLOW) | EHEALTH_CHANNEL_BIT(EHEALTH_GSR);
+
+	//! Feeds data in pieces of step bytes and collects the decoded frames.
+	static std::vector<std::vector<uint16_t> > decodeAll(eHealthFrameDecoder & decoder,
+		const uint8_t * data, size_t length, size_t step)
+	{
+		std::vector<std::vector<uint16_t> > frames;
+
+		while (length) {
+			size_t piece = length < step ? length : step;
+			size_t used = decoder.feed(data, piece);
+			data += used;
+			length -= used;
+
+			if (decoder.available()) {
+				const eHealthFrame & frame = decoder.frame();
+				std::vector<uint16_t> values(frame.count * frame.channelCount);
+				frame.unpack(values.data());
+				frames.push_back(values);
+			}
+		}
+		return frames;
+	}
+
+	EH_TEST(test_crc_matches_ccitt_false_check_value)
+	{
+		EH_CHECK_EQUAL(0x29B1, eHealthCrc16(0xFFFF, (const uint8_t *)"123456789", 9));
+	}
+
+	EH_TEST(test_analog_samples_pack_into_ten_bits)
+	{
+		uint16_t ecg = EHEALTH_CHANNEL_BIT(EHEALTH_ECG);
+
+		EH_CHECK_EQUAL(55U, eHealthFrameEncoder::frameSize(ecg, 32));
+		EH_CHECK_EQUAL(20U, eHealthFrameEncoder::frameSize(ANALOG, 1));
+		EH_CHECK_EQUAL(0U, eHealthFrameEncoder::frameSize(0, 1));
+		EH_CHECK_EQUAL(0U, eHealthFrameEncoder::frameSize(ecg, 0));
+		EH_CHECK_EQUAL(0U, eHealthFrameEncoder::frameSize(0x8000, 1));
+	}
+
+	EH_TEST(test_frames_round_trip)
+	{
+		eHealthFrameEncoder encoder;
+		eHealthFrameDecoder decoder;
+		uint16_t channels = EHEALTH_ALL_CHANNELS;
+		uint16_t values[11 * 9];
+		uint8_t frame[EHEALTH_FRAME_MAX_SIZE];
+
+		for (int i = 0; i < 11 * 9; i++) {
+			values[i] = (uint16_t)(i * 37 % 256);
+		}
+
+		size_t size = encoder.encode(channels, 9, 0x12345678UL, 4000, values, frame, sizeof(frame));
+		EH_CHECK(size > 0);
+
+		EH_CHECK_EQUAL(size, decoder.feed(frame, size));
+		EH_CHECK(decoder.available());
+
+		const eHealthFrame & decoded = decoder.frame();
+		uint16_t unpacked[11 * 9];
+		decoded.unpack(unpacked);
+
+		EH_CHECK_EQUAL(channels, decoded.channels);
+		EH_CHECK_EQUAL(9, decoded.count);
+		EH_CHECK_EQUAL(11, decoded.channelCount);
+		EH_CHECK_EQUAL(0x12345678UL, decoded.timestamp);
+		EH_CHECK_EQUAL(4000, decoded.period);
+		EH_CHECK_EQUAL(0, decoded.sequence);
+		for (int i = 0; i < 11 * 9; i++) {
+			EH_CHECK_EQUAL(values[i], unpacked[i]);
+		}
+		EH_CHECK_EQUAL(1, encoder.sequence());
+	}
+
+	EH_TEST(test_decoder_resynchronizes_after_noise_and_corruption)
+	{
+		eHealthFrameEncoder encoder;
+		std::vector<uint8_t> stream;
+		uint8_t frame[64];
+
+		const uint8_t noise[] = { 0x00, 0xA5, 0x11, 0xA5, 0x5A, 0xFF, 0xA5 };
+		stream.insert(stream.end(), noise, noise + sizeof(noise));
+
+		for (uint16_t i = 0; i < 20; i++) {
+			uint16_t values[4] = { i, (uint16_t)(1023 - i), 512, 7 };
+			size_t size = encoder.encode(ANALOG, 1, i, 0, values, frame, sizeof(frame));
+
+			// Corrupt every fifth frame.
+			if (i % 5 == 4) {
+				frame[size / 2] ^= 0x40;
+			}
+			stream.insert(stream.end(), frame, frame + size);
+		}
+
+		for (size_t step = 1; step <= 64; step *= 4) {
+			eHealthFrameDecoder decoder;
+			std::vector<std::vector<uint16_t> > frames = decodeAll(decoder, stream.data(), stream.size(), step);
+
+			EH_CHECK_EQUAL(16U, frames.size());
+			EH_CHECK_EQUAL(16U, decoder.frames());
+			EH_CHECK_EQUAL(4U, decoder.crcErrors());
+			for (size_t i = 0; i < frames.size(); i++) {
+				uint16_t expected = (uint16_t)(i + i / 4);
+				EH_CHECK_EQUAL(expected, frames[i][0]);
+				EH_CHECK_EQUAL(1023 - expected, frames[i][1]);
+			}
+		}
+	}
+
+	EH_TEST(test_mock_writes_decodable_frames)
+	{
+		eHealthClassMock mock;
+		eHealthFrameDecoder decoder;
+		char * text = NULL;
+		size_t length = 0;
+		FILE * capture = open_memstream(&text, &length);
+
+		mock.readPulsioximeter();
+		hostClockSet(1000);
+
+		Serial.setStream(capture);
+		size_t sent = mock.writeFrame(EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_BPM)
+			| EHEALTH_CHANNEL_BIT(EHEALTH_TEMPERATURE));
+		Serial.setStream(stdout);
+		fclose(capture);
+
+		EH_CHECK_EQUAL(sent, length);
+		EH_CHECK_EQUAL(length, decoder.feed((const uint8_t *)text, length));
+		EH_CHECK(decoder.available());
+
+		uint16_t values[3];
+		decoder.frame().unpack(values);
+		EH_CHECK_EQUAL(1000U, decoder.frame().timestamp);
+		EH_CHECK_EQUAL(400, values[0]);
+		EH_CHECK_EQUAL(3750, values[1]);
+		EH_CHECK_EQUAL(75, values[2]);
+		free(text);
+	}
+
+EH_TEST_MAIN()
@@ -0,0 +1,166 @@
+/*
+*=========================================================================================
+ *  Tests for the measurement history store.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthHistory.h"
+#include "eHealthTest.h"
+
+#include <vector>
+
+
+	EH_TEST(test_minutes_round_trip_through_dates)
+	{
+		EH_CHECK_EQUAL(0U, eHealthMinutes(2000, 1, 1, 0, 0));
+		EH_CHECK_EQUAL(59U * 1440 + 61, eHealthMinutes(2000, 2, 29, 1, 1));
+		EH_CHECK_EQUAL(60U * 1440, eHealthMinutes(2000, 3, 1, 0, 0));
+
+		bool same = true;
+		for (uint32_t minutes = 0; minutes < 60UL * 1440 * 366 * 40; minutes += 1440 * 7 + 61) {
+			uint16_t year;
+			uint8_t month, day, hour, minute;
+			eHealthMinutesToDate(minutes, year, month, day, hour, minute);
+			same &= eHealthMinutes(year, month, day, hour, minute) == minutes;
+		}
+		EH_CHECK(same);
+
+		uint16_t year;
+		uint8_t month, day, hour, minute;
+		eHealthMinutesToDate(eHealthMinutes(2016, 10, 10, 10, 10), year, month, day, hour, minute);
+		EH_CHECK_EQUAL(2016, year);
+		EH_CHECK_EQUAL(10, month);
+		EH_CHECK_EQUAL(10, day);
+		EH_CHECK_EQUAL(10, hour);
+		EH_CHECK_EQUAL(10, minute);
+	}
+
+	EH_TEST(test_records_are_packed_and_the_oldest_evicted)
+	{
+		uint8_t storage[5 * 10 + 3];
+		eHealthHistory history(storage, sizeof(storage), 2);
+
+		EH_CHECK_EQUAL(10U, history.capacity());
+		EH_CHECK(!history.add(100, 0x10000));
+
+		for (uint32_t i = 0; i < 25; i++) {
+			EH_CHECK(history.add(1000 + i * 60, i));
+		}
+		EH_CHECK_EQUAL(10U, history.size());
+		EH_CHECK_EQUAL(15U, history.evicted());
+		EH_CHECK_EQUAL(1000U + 15 * 60, history.time(0));
+		EH_CHECK_EQUAL(15U, history.value(0));
+		EH_CHECK_EQUAL(24U, history.value(9));
+
+		// Older than every record of a full store.
+		EH_CHECK(!history.add(1000, 1));
+		EH_CHECK(!history.add(999, 1));
+		EH_CHECK(!history.add(1000 + EHEALTH_HISTORY_MAX_SPAN + 1, 1));
+	}
+
+	EH_TEST(test_late_records_are_inserted_in_time_order)
+	{
+		eHealthHistoryN<8, 1> history;
+
+		history.add(10, 1);
+		history.add(30, 3);
+		history.add(20, 2);
+		history.add(30, 4);
+		history.add(15, 9);
+
+		const uint32_t times[] = { 10, 15, 20, 30, 30 };
+		const uint32_t values[] = { 1, 9, 2, 3, 4 };
+		EH_CHECK_EQUAL(5U, history.size());
+		for (size_t i = 0; i < 5; i++) {
+			EH_CHECK_EQUAL(times[i], history.time(i));
+			EH_CHECK_EQUAL(values[i], history.value(i));
+		}
+	}
+
+	EH_TEST(test_records_older_than_the_first_move_the_zero_back)
+	{
+		eHealthHistoryN<8, 1> history;
+
+		// Newest first, as some meters download them.
+		EH_CHECK(history.add(3000, 3));
+		EH_CHECK(history.add(2000, 2));
+		EH_CHECK(history.add(1000, 1));
+
+		const uint32_t times[] = { 1000, 2000, 3000 };
+		EH_CHECK_EQUAL(3U, history.size());
+		for (size_t i = 0; i < 3; i++) {
+			EH_CHECK_EQUAL(times[i], history.time(i));
+			EH_CHECK_EQUAL(i + 1, history.value(i));
+		}
+
+		// The span counts from the newest record too.
+		EH_CHECK(history.add(1000 + EHEALTH_HISTORY_MAX_SPAN, 4));
+		EH_CHECK(!history.add(999, 9));
+		EH_CHECK_EQUAL(4U, history.size());
+		EH_CHECK_EQUAL(1000U, history.time(0));
+		EH_CHECK_EQUAL(1000U + EHEALTH_HISTORY_MAX_SPAN, history.time(3));
+	}
+
+	EH_TEST(test_range_queries_across_the_ring_wrap)
+	{
+		std::vector<uint8_t> storage(1000000 * EHEALTH_HISTORY_RECORD_BYTES(4));
+		eHealthHistory history(storage.data(), storage.size(), 4);
+
+		// A million records, every 5 minutes, after 300000 evictions.
+		for (uint32_t i = 0; i < 1300000; i++) {
+			history.add(i * 5, i);
+		}
+		EH_CHECK_EQUAL(1000000U, history.size());
+		EH_CHECK_EQUAL(300000U, history.evicted());
+
+		size_t first;
+		EH_CHECK_EQUAL(12U, history.range(5000001, 5000061, first));
+		EH_CHECK_EQUAL(1000001U, history.value(first));
+		EH_CHECK_EQUAL(0U, history.range(0, 1000, first));
+		EH_CHECK_EQUAL(0U, first);
+		EH_CHECK_EQUAL(history.size(), history.lowerBound(1300000 * 5));
+		EH_CHECK_EQUAL(0U, history.range(50, 40, first));
+	}
+
+	EH_TEST(test_devices_keep_separate_counts_and_full_years)
+	{
+		eHealthClassMock mock;
+
+		mock.readGlucometer();
+		EH_CHECK_EQUAL(5, mock.getGlucometerLength());
+		EH_CHECK_EQUAL(0, mock.getBloodPressureLength());
+
+		mock.readBloodPressureSensor();
+		mock.readBloodPressureSensor();
+		EH_CHECK_EQUAL(5, mock.getGlucometerLength());
+		EH_CHECK_EQUAL(5, mock.getBloodPressureLength());
+
+		eHealthClassMock::glucoseData glucose = mock.getGlucoseRecord(4);
+		EH_CHECK_EQUAL(2016, glucose.year);
+		EH_CHECK_EQUAL(10, glucose.minutes);
+		EH_CHECK_EQUAL(5, glucose.glucose);
+		EH_CHECK_EQUAL(4, glucose.meridian);
+		EH_CHECK_EQUAL(5, mock.readChannel(EHEALTH_GLUCOSE));
+
+		eHealthClassMock::bloodPressureData pressure = mock.getBloodPressureRecord(0);
+		EH_CHECK_EQUAL(2016, pressure.year);
+		EH_CHECK_EQUAL(120, pressure.systolic);
+		EH_CHECK_EQUAL(80, pressure.diastolic);
+		EH_CHECK_EQUAL(65, pressure.pulse);
+
+		// A larger history can be plugged in; copies keep their own records.
+		eHealthHistoryN<1000, 2> large;
+		mock.setGlucoseHistory(&large);
+		mock.readGlucometer();
+		EH_CHECK_EQUAL(1000U, mock.glucoseHistory().capacity());
+
+		eHealthClassMock copy(mock);
+		mock.setBloodPressureHistory(NULL);
+		mock.bloodPressureHistory().clear();
+		EH_CHECK_EQUAL(5, copy.getBloodPressureLength());
+		EH_CHECK_EQUAL(80, copy.getDiastolicPressure(4));
+	}
+
+EH_TEST_MAIN()
@@ -0,0 +1,306 @@
+/*
+*=========================================================================================
+ *  Tests for the rate-controlled load generator.
+ *========================================================================================
+ */
+
+
+#include "eHealthFleet.h"
+#include "eHealthLoad.h"
+#include "eHealthSinks.h"
+#include "eHealthTest.h"
+
+#include <chrono>
+#include <signal.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+
+	//! Sink keeping every byte, optionally slow, optionally closing after limit bytes.
+	class captureSink : public eHealthSink {
+
+		public:
+
+			size_t write(const uint8_t * data, size_t length) override
+			{
+				if (bytes.size() + length > limit) {
+					return 0;
+				}
+				if (delayMicros) {
+					std::this_thread::sleep_for(std::chrono::microseconds(delayMicros));
+				}
+				bytes.insert(bytes.end(), data, data + length);
+				return length;
+			}
+
+			std::vector<uint8_t> bytes;
+			unsigned delayMicros = 0;
+			size_t limit = (size_t)-1;
+	};
+
+
+//***************************************************************
+// Configuration												*
+//***************************************************************
+
+	EH_TEST(test_unrunnable_configurations_are_refused)
+	{
+		eHealthLoadConfig config;
+
+		config.devices = 0;
+		EH_CHECK(!eHealthLoadGenerator(config).valid());
+
+		// 255 snapshots of four 10-bit channels do not fit in a frame.
+		config.devices = 10;
+		config.batch = 255;
+		EH_CHECK(!eHealthLoadGenerator(config).valid());
+
+		// 1000 samples/s over 100 devices and 4 channels is 2.5 Hz each.
+		config.batch = 16;
+		config.devices = 100;
+		config.rate = 1000;
+		eHealthLoadGenerator slow(config);
+		EH_CHECK(!slow.valid());
+		EH_CHECK(slow.error() != NULL);
+
+		config.rate = 1e6;
+		eHealthLoadGenerator fine(config);
+		EH_CHECK(fine.valid());
+		EH_CHECK_NEAR(2500, fine.deviceRate(), 1e-9);
+	}
+
+	EH_TEST(test_devices_are_the_fleet_patients)
+	{
+		eHealthLoadConfig config;
+		config.devices = 2;
+		config.channels = EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_POSITION);
+		config.rate = 2 * 2 * 500;
+		config.batch = 10;
+		config.maxLag = 10;
+		captureSink sink;
+
+		eHealthLoadGenerator(config).run(0.02, sink);
+
+		eHealthFrameDecoder decoder;
+		size_t at = 0;
+		for (size_t i = 0; i < config.devices; i++) {
+			while (!decoder.available() && at < sink.bytes.size()) {
+				at += decoder.feed(&sink.bytes[at], sink.bytes.size() - at);
+			}
+			EH_CHECK(decoder.available());
+
+			eHealthClassMock patient;
+			eHealthFleet::setupPatient(patient, eHealthFleet::patientSeed(config.seed, i), 500);
+			uint16_t ecg[10];
+			uint16_t position[10];
+			eHealthSnapshotBlock block = {};
+			block.period = 2000;
+			block.values[EHEALTH_ECG] = ecg;
+			block.values[EHEALTH_POSITION] = position;
+			patient.sampleAllBlock(block, 10);
+
+			for (uint8_t j = 0; j < 10; j++) {
+				EH_CHECK_EQUAL(ecg[j], decoder.frame().value(j, EHEALTH_ECG));
+				EH_CHECK_EQUAL(position[j], decoder.frame().value(j, EHEALTH_POSITION));
+			}
+			at += decoder.feed(NULL, 0);
+		}
+	}
+
+
+//***************************************************************
+// Pacing														*
+//***************************************************************
+
+	EH_TEST(test_offered_rate_is_achieved)
+	{
+		eHealthLoadConfig config;
+		config.devices = 50;
+		config.rate = 400000;
+		// Never drop, however busy the machine running the test is.
+		config.maxLag = 10;
+		captureSink sink;
+
+		eHealthLoadGenerator load(config);
+		eHealthLoadReport report = load.run(0.25, sink);
+
+		// 0.25 s at 400k samples/s, in frames of 16 snapshots of 4 channels.
+		EH_CHECK_EQUAL(100000u / 64 * 64, report.samples);
+		EH_CHECK_EQUAL(0u, report.dropped);
+		EH_CHECK_EQUAL(report.samples / 64, report.frames);
+		EH_CHECK_EQUAL(sink.bytes.size(), report.bytes);
+		EH_CHECK_EQUAL(report.frames, report.writes);
+
+		// The last frame is due 0.2497 s in, and is never sent early. Late
+		// is only bounded loosely: the test may share the machine.
+		EH_CHECK(report.wallSeconds >= 0.2497);
+		EH_CHECK(report.achievedRate <= 400300);
+		EH_CHECK(report.achievedRate > 200000);
+		EH_CHECK(report.latencyP50 <= report.latencyP99);
+		EH_CHECK(report.latencyP99 <= report.latencyMax);
+		EH_CHECK(report.cpuNanosPerSample > 0);
+	}
+
+	EH_TEST(test_devices_take_turns_in_one_stream)
+	{
+		eHealthLoadConfig config;
+		config.devices = 3;
+		config.rate = 3 * 4 * 1000;
+		config.batch = 10;
+		config.maxLag = 10;
+		captureSink sink;
+
+		eHealthLoadGenerator load(config);
+		eHealthLoadReport report = load.run(0.1, sink);
+		EH_CHECK_EQUAL(30u, report.frames);
+
+		eHealthFrameDecoder decoder;
+		const uint8_t * data = sink.bytes.data();
+		size_t left = sink.bytes.size();
+		uint32_t n = 0;
+
+		while (left) {
+			size_t used = decoder.feed(data, left);
+			data += used;
+			left -= used;
+			if (decoder.available()) {
+				const eHealthFrame & frame = decoder.frame();
+				// Each device numbers its frames and keeps its own clock: 10 ms per frame.
+				EH_CHECK_EQUAL(n / 3, frame.sequence);
+				EH_CHECK_EQUAL(n / 3 * 10000, frame.timestamp);
+				EH_CHECK_EQUAL(1000, frame.period);
+				EH_CHECK_EQUAL(10, frame.count);
+				n++;
+			}
+		}
+		EH_CHECK_EQUAL(30u, n);
+	}
+
+	EH_TEST(test_flushes_collect_frames)
+	{
+		eHealthLoadConfig config;
+		config.devices = 10;
+		config.rate = 200000;
+		config.flushBytes = 4096;
+		config.maxLag = 10;
+		captureSink sink;
+		sink.delayMicros = 20000;
+
+		eHealthLoadGenerator load(config);
+		eHealthLoadReport report = load.run(0.1, sink);
+
+		// A frame is due every 0.32 ms; 20 ms a write keeps the generator
+		// behind, so the frames wait for 4096 bytes, about 43 of them.
+		EH_CHECK_EQUAL(0u, report.dropped);
+		EH_CHECK(report.writes * 10 < report.frames);
+		EH_CHECK_EQUAL(sink.bytes.size(), report.bytes);
+	}
+
+	EH_TEST(test_late_frames_are_dropped)
+	{
+		eHealthLoadConfig config;
+		config.devices = 10;
+		config.rate = 200000;
+		config.maxLag = 0.005;
+		captureSink sink;
+		sink.delayMicros = 2000;
+
+		eHealthLoadGenerator load(config);
+		eHealthLoadReport report = load.run(0.2, sink);
+
+		// 2 ms a write against a frame due every 0.32 ms.
+		EH_CHECK(report.dropped > 0);
+		EH_CHECK_EQUAL(40000u / 64 * 64, report.samples + report.dropped);
+		EH_CHECK(report.achievedRate < 150000);
+		EH_CHECK(report.latencyMax >= 2000);
+	}
+
+	EH_TEST(test_closed_sink_stops_the_run)
+	{
+		eHealthLoadConfig config;
+		config.devices = 10;
+		config.rate = 200000;
+		captureSink sink;
+		sink.limit = 1000;
+
+		eHealthLoadGenerator load(config);
+		eHealthLoadReport report = load.run(0.2, sink);
+
+		// Without the early stop the run lasts until the last frame is due, 0.1997 s.
+		EH_CHECK(report.wallSeconds < 0.19);
+		EH_CHECK(report.samples < 1000);
+		EH_CHECK_EQUAL(40000u / 64 * 64, report.samples + report.dropped);
+	}
+
+	EH_TEST(test_pipe_without_reader_stops_the_run)
+	{
+		// As ehealth_load does: EPIPE instead of the signal.
+		signal(SIGPIPE, SIG_IGN);
+
+		int pipeFds[2];
+		EH_CHECK_EQUAL(0, pipe(pipeFds));
+		close(pipeFds[0]);
+
+		eHealthLoadConfig config;
+		config.devices = 10;
+		config.rate = 200000;
+		eHealthFdSink sink(pipeFds[1], true);
+
+		eHealthLoadReport report = eHealthLoadGenerator(config).run(0.2, sink);
+
+		EH_CHECK(!sink.isOpen());
+		EH_CHECK_EQUAL(0u, report.samples);
+		EH_CHECK_EQUAL(40000u / 64 * 64, report.dropped);
+		EH_CHECK(report.wallSeconds < 0.19);
+	}
+
+
+//***************************************************************
+// Formats														*
+//***************************************************************
+
+	EH_TEST(test_packets_decode_to_the_frames_values)
+	{
+		eHealthLoadConfig config;
+		config.devices = 1;
+		config.rate = 4 * 500;
+		config.batch = 25;
+		config.maxLag = 10;
+		captureSink frames;
+		captureSink packets;
+
+		eHealthLoadGenerator(config).run(0.2, frames);
+		config.compress = true;
+		eHealthLoadGenerator(config).run(0.2, packets);
+		EH_CHECK(packets.bytes.size() < frames.bytes.size());
+
+		std::vector<uint16_t> expected;
+		eHealthFrameDecoder frameDecoder;
+		for (size_t at = 0; at < frames.bytes.size();) {
+			at += frameDecoder.feed(&frames.bytes[at], frames.bytes.size() - at);
+			if (frameDecoder.available()) {
+				const eHealthFrame & frame = frameDecoder.frame();
+				size_t size = expected.size();
+				expected.resize(size + frame.count * frame.channelCount);
+				frame.unpack(&expected[size]);
+			}
+		}
+
+		std::vector<uint16_t> decoded;
+		eHealthCodecDecoder packetDecoder;
+		for (size_t at = 0; at < packets.bytes.size();) {
+			at += packetDecoder.feed(&packets.bytes[at], packets.bytes.size() - at);
+			if (packetDecoder.available()) {
+				const eHealthPacket & packet = packetDecoder.packet();
+				size_t size = decoded.size();
+				decoded.resize(size + packet.count * packet.channelCount);
+				EH_CHECK(packetDecoder.decode(packet, &decoded[size]));
+			}
+		}
+
+		EH_CHECK_EQUAL(100u, expected.size() / 4);
+		EH_CHECK(expected == decoded);
+	}
+
+EH_TEST_MAIN()
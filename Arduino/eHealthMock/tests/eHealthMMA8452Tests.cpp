@@ -0,0 +1,253 @@
+/*
+*=========================================================================================
+ *  Tests for the MMA8452 register emulation.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthTest.h"
+
+
+	//! Sign-extends the left-justified 12-bit sample of an MSB/LSB pair.
+	static int16_t sampleOf(uint8_t msb, uint8_t lsb)
+	{
+		return (int16_t)((uint16_t)msb << 8 | lsb) >> 4;
+	}
+
+	//! Active at data rate dr (100 Hz for 3) with the given F_SETUP.
+	static void start(eHealthMMA8452 & device, uint8_t dr, uint8_t fifoSetup)
+	{
+		device.setMotion(0, 0);
+		device.writeRegister(MMA8452_F_SETUP, fifoSetup);
+		device.writeRegister(MMA8452_CTRL_REG1, (dr << 3) | 0x01);
+	}
+
+
+//***************************************************************
+// Modes														*
+//***************************************************************
+
+	EH_TEST(test_powers_up_in_standby)
+	{
+		eHealthMMA8452 device;
+
+		EH_CHECK_EQUAL(MMA8452_DEVICE_ID, device.readRegister(MMA8452_WHO_AM_I));
+		EH_CHECK_EQUAL(0, device.readRegister(MMA8452_SYSMOD));
+
+		delay(100);
+
+		EH_CHECK_EQUAL(0U, device.samples());
+	}
+
+	EH_TEST(test_configuration_is_ignored_while_active)
+	{
+		eHealthMMA8452 device;
+
+		start(device, 3, 0);
+		device.writeRegister(MMA8452_XYZ_DATA_CFG, 0x02);
+		device.writeRegister(MMA8452_CTRL_REG1, (7 << 3) | 0x01);
+
+		EH_CHECK_EQUAL(1, device.readRegister(MMA8452_SYSMOD));
+		EH_CHECK_EQUAL(0, device.readRegister(MMA8452_XYZ_DATA_CFG));
+		EH_CHECK_EQUAL(10000U, device.samplePeriod());
+
+		device.writeRegister(MMA8452_CTRL_REG1, 0);
+		device.writeRegister(MMA8452_XYZ_DATA_CFG, 0x02);
+
+		EH_CHECK_EQUAL(0, device.readRegister(MMA8452_SYSMOD));
+		EH_CHECK_EQUAL(2, device.readRegister(MMA8452_XYZ_DATA_CFG));
+	}
+
+	EH_TEST(test_samples_follow_the_data_rate)
+	{
+		eHealthMMA8452 device;
+
+		start(device, 3, 0x40);
+		delay(1000);
+
+		EH_CHECK_EQUAL(100U, device.samples());
+
+		device.writeRegister(MMA8452_CTRL_REG1, 0);
+		device.writeRegister(MMA8452_CTRL_REG1, (7 << 3) | 0x01);
+		delay(6400);
+
+		EH_CHECK_EQUAL(110U, device.samples());
+	}
+
+
+//***************************************************************
+// Outputs														*
+//***************************************************************
+
+	EH_TEST(test_outputs_scale_with_the_range)
+	{
+		eHealthMMA8452 device;
+		uint8_t out[6];
+
+		device.writeRegister(MMA8452_XYZ_DATA_CFG, 0x02);
+		device.setGravity(500, -250, 1000);
+		start(device, 0, 0);
+		delay(2);
+		device.readRegisters(MMA8452_OUT_X_MSB, 6, out);
+
+		EH_CHECK_EQUAL(128, sampleOf(out[0], out[1]));
+		EH_CHECK_EQUAL(-64, sampleOf(out[2], out[3]));
+		EH_CHECK_EQUAL(256, sampleOf(out[4], out[5]));
+	}
+
+	EH_TEST(test_data_ready_flags_clear_when_read)
+	{
+		eHealthMMA8452 device;
+		uint8_t out[6];
+
+		start(device, 3, 0);
+
+		EH_CHECK_EQUAL(0, device.readRegister(MMA8452_STATUS));
+
+		delay(25);
+
+		EH_CHECK_EQUAL(0xFF, device.readRegister(MMA8452_STATUS));
+
+		device.readRegisters(MMA8452_OUT_X_MSB, 6, out);
+
+		EH_CHECK_EQUAL(0, device.readRegister(MMA8452_STATUS));
+	}
+
+	EH_TEST(test_fast_read_skips_the_lsbs)
+	{
+		eHealthMMA8452 device;
+		uint8_t out[4];
+
+		device.setMotion(0, 0);
+		device.setGravity(0, 0, 1000);
+		device.writeRegister(MMA8452_CTRL_REG1, 0x03);
+		delay(2);
+		device.readRegisters(MMA8452_OUT_X_MSB, 4, out);
+
+		EH_CHECK_EQUAL(0, out[0]);
+		EH_CHECK_EQUAL(0, out[1]);
+		EH_CHECK_EQUAL(1024 >> 4, out[2]);
+		// The address wraps from OUT_Z_MSB to STATUS.
+		EH_CHECK_EQUAL(0, out[3]);
+	}
+
+	EH_TEST(test_portrait_landscape_status_tracks_gravity)
+	{
+		eHealthMMA8452 device;
+
+		device.writeRegister(MMA8452_PL_CFG, 0x40);
+		device.setGravity(0, 0, -1000);
+		start(device, 0, 0);
+		delay(2);
+
+		// Back facing and locked out, with the new orientation flag once.
+		EH_CHECK_EQUAL(0xC1, device.readRegister(MMA8452_PL_STATUS));
+		EH_CHECK_EQUAL(0x41, device.readRegister(MMA8452_PL_STATUS));
+
+		device.setGravity(1000, 0, 0);
+		delay(2);
+
+		EH_CHECK_EQUAL(0x84, device.readRegister(MMA8452_PL_STATUS));
+	}
+
+
+//***************************************************************
+// FIFO															*
+//***************************************************************
+
+	EH_TEST(test_burst_read_drains_the_fifo)
+	{
+		eHealthMMA8452 device;
+		uint8_t out[6 * 32];
+
+		device.setGravity(0, 0, 1000);
+		start(device, 3, 0x40 | 20);
+		delay(250);
+
+		uint8_t status = device.readRegister(MMA8452_STATUS);
+
+		EH_CHECK_EQUAL(25, status & 0x3F);
+		EH_CHECK(status & 0x40);
+		EH_CHECK(!(status & 0x80));
+
+		device.readRegisters(MMA8452_OUT_X_MSB, 6 * 25, out);
+
+		for (int i = 0; i < 25; i++) {
+			EH_CHECK_EQUAL(0, sampleOf(out[6 * i], out[6 * i + 1]));
+			EH_CHECK_EQUAL(1024, sampleOf(out[6 * i + 4], out[6 * i + 5]));
+		}
+		EH_CHECK_EQUAL(0, device.fifoCount());
+	}
+
+	EH_TEST(test_circular_fifo_keeps_the_newest_samples)
+	{
+		eHealthMMA8452 device;
+		uint8_t out[6 * 32];
+
+		device.setGravity(0, 0, 1000);
+		start(device, 3, 0x40);
+		delay(395);
+		device.setGravity(0, 0, 500);
+		delay(10);
+
+		// 40 samples: overflowed, the flag clears once read.
+		EH_CHECK_EQUAL(0xA0, device.readRegister(MMA8452_STATUS));
+		EH_CHECK_EQUAL(0x20, device.readRegister(MMA8452_STATUS));
+
+		device.readRegisters(MMA8452_OUT_X_MSB, sizeof(out), out);
+
+		EH_CHECK_EQUAL(1024, sampleOf(out[4], out[5]));
+		EH_CHECK_EQUAL(512, sampleOf(out[6 * 31 + 4], out[6 * 31 + 5]));
+		EH_CHECK_EQUAL(0, device.fifoCount());
+	}
+
+	EH_TEST(test_fill_fifo_keeps_the_oldest_samples)
+	{
+		eHealthMMA8452 device;
+		uint8_t out[6];
+
+		device.setGravity(0, 0, 1000);
+		start(device, 3, 0x80);
+		delay(10);
+		device.setGravity(0, 0, 500);
+		delay(1000);
+
+		EH_CHECK_EQUAL(0xA0, device.readRegister(MMA8452_STATUS));
+
+		device.readRegisters(MMA8452_OUT_X_MSB, 6, out);
+
+		EH_CHECK_EQUAL(1024, sampleOf(out[4], out[5]));
+		EH_CHECK_EQUAL(31, device.fifoCount());
+	}
+
+	EH_TEST(test_changing_fifo_mode_empties_it)
+	{
+		eHealthMMA8452 device;
+
+		start(device, 3, 0x40);
+		delay(100);
+		device.writeRegister(MMA8452_CTRL_REG1, 0);
+		device.writeRegister(MMA8452_F_SETUP, 0x80);
+
+		EH_CHECK_EQUAL(0, device.fifoCount());
+	}
+
+
+//***************************************************************
+// Mock															*
+//***************************************************************
+
+	EH_TEST(test_init_position_sensor_configures_the_device)
+	{
+		eHealthClassMock mock;
+
+		mock.initPositionSensor();
+
+		EH_CHECK_EQUAL(1, mock.accelerometer.readRegister(MMA8452_SYSMOD));
+		EH_CHECK_EQUAL((EHEALTH_ACCEL_DATA_RATE << 3) | 0x01, mock.accelerometer.readRegister(MMA8452_CTRL_REG1));
+		EH_CHECK_EQUAL(EHEALTH_ACCEL_SCALE >> 2, mock.accelerometer.readRegister(MMA8452_XYZ_DATA_CFG));
+		EH_CHECK_EQUAL(0x40, mock.accelerometer.readRegister(MMA8452_PL_CFG));
+	}
+
+EH_TEST_MAIN()
@@ -0,0 +1,334 @@
+/*
+*=========================================================================================
+ *  Tests for the host build of the eHealth Mock.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthKernels.h"
+#include "eHealthTest.h"
+
+
+//***************************************************************
+// Simulated clock												*
+//***************************************************************
+
+	EH_TEST(test_delay_advances_simulated_clock)
+	{
+		delay(25);
+		delayMicroseconds(7);
+
+		EH_CHECK_EQUAL(25007UL, micros());
+		EH_CHECK_EQUAL(25UL, millis());
+	}
+
+	EH_TEST(test_skin_resistance_costs_simulated_time_only)
+	{
+		eHealth.getSkinResistance();
+
+		// getSkinConductanceVoltage() 2+2, getSkinConductance() 1+1, then 2 ms.
+		EH_CHECK_EQUAL(8000UL, micros());
+	}
+
+	EH_TEST(test_air_flow_wave_costs_simulated_time_only)
+	{
+		Serial.setStream(NULL);
+		eHealth.airFlowWave(eHealth.getAirFlow());
+		Serial.setStream(stdout);
+
+		EH_CHECK_EQUAL(25000UL, micros());
+	}
+
+	EH_TEST(test_serial_blocks_once_transmit_buffer_is_full)
+	{
+		uint8_t bytes[100] = { 0 };
+
+		Serial.setStream(NULL);
+		Serial.begin(9600);
+		Serial.write(bytes, sizeof(bytes));
+		Serial.end();
+		Serial.setStream(stdout);
+
+		// 1041 us per byte at 9600 baud, the first 64 bytes are buffered.
+		EH_CHECK_EQUAL((100UL - 64) * 1041, micros());
+	}
+
+
+//***************************************************************
+// Random numbers												*
+//***************************************************************
+
+	EH_TEST(test_random_matches_avr_libc_sequence)
+	{
+		randomSeed(1);
+
+		// avr-libc random() yields 16807 for a seed of 1.
+		EH_CHECK_EQUAL(16807 % 1023 + 1, random(1, 1024));
+		EH_CHECK_EQUAL(5, random(5, 5));
+	}
+
+
+//***************************************************************
+// Getters														*
+//***************************************************************
+
+	EH_TEST(test_analog_getters_stay_in_range)
+	{
+		for (int i = 0; i < 1000; i++) {
+			float ecg = eHealth.getECG();
+			float voltage = eHealth.getSkinConductanceVoltage();
+
+			EH_CHECK(ecg >= 0 && ecg <= 5.0);
+			EH_CHECK(voltage >= 0 && voltage <= 5.0);
+		}
+	}
+
+	EH_TEST(test_records_fill_requested_length)
+	{
+		eHealth.readBloodPressureSensor();
+
+		EH_CHECK_EQUAL(5, eHealth.getBloodPressureLength());
+		EH_CHECK_EQUAL(120, eHealth.getSystolicPressure(0));
+		EH_CHECK_EQUAL(80, eHealth.getDiastolicPressure(4));
+	}
+
+
+//***************************************************************
+// Block Methods												*
+//***************************************************************
+
+	EH_TEST(test_ecg_block_matches_single_reads)
+	{
+		eHealthClassMock blockReader;
+		eHealthClassMock singleReader;
+		float block[100];
+
+		blockReader.getECGBlock(block, 100);
+
+		for (int i = 0; i < 100; i++) {
+			EH_CHECK_NEAR(singleReader.getECG(), block[i], 1e-5);
+		}
+	}
+
+	EH_TEST(test_air_flow_block_matches_single_reads)
+	{
+		eHealthClassMock blockReader;
+		eHealthClassMock singleReader;
+		int block[200];
+
+		blockReader.getAirFlowBlock(block, 200);
+
+		for (int i = 0; i < 200; i++) {
+			EH_CHECK_EQUAL(singleReader.getAirFlow(), block[i]);
+		}
+	}
+
+	EH_TEST(test_gsr_block_matches_single_reads_and_settles_once)
+	{
+		eHealthClassMock blockReader;
+		eHealthClassMock singleReader;
+		eHealthClassMock::gsrSample block[200];
+
+		blockReader.getGSRBlock(block, 200);
+
+		EH_CHECK_EQUAL(8000UL, micros());
+		for (int i = 0; i < 200; i++) {
+			uint16_t millivolts = singleReader.getSkinConductanceMillivolts();
+			int16_t conductance = eHealthConductance(millivolts);
+
+			EH_CHECK_EQUAL(millivolts * 0.001f, block[i].voltage);
+			EH_CHECK_NEAR(20 * (block[i].voltage - 0.5f), block[i].conductance, 1e-4);
+			EH_CHECK_EQUAL((float)eHealthOhms(conductance), block[i].resistance);
+			if (conductance > 0) {
+				EH_CHECK_NEAR(1000000.0 / block[i].conductance, block[i].resistance, 0.5 + block[i].resistance * 1e-5);
+			} else {
+				EH_CHECK_EQUAL(-1.0f, block[i].resistance);
+			}
+		}
+	}
+
+
+//***************************************************************
+// Fixed Point													*
+//***************************************************************
+
+	EH_TEST(test_millivolts_round_every_reading)
+	{
+		bool exact = true;
+		for (uint32_t adc = 0; adc < 1024; adc++) {
+			exact &= eHealthMillivolts(adc) == (adc * 5000 + 511) / 1023;
+		}
+		EH_CHECK(exact);
+		EH_CHECK_EQUAL(5000, eHealthMillivolts(1023));
+
+		EH_CHECK_EQUAL(-100, eHealthConductance(0));
+		EH_CHECK_EQUAL(-990, eHealthConductance(5));
+		EH_CHECK_EQUAL(9000, eHealthConductance(5000));
+		EH_CHECK_EQUAL(-1, eHealthOhms(0));
+		EH_CHECK_EQUAL(11111, eHealthOhms(9000));
+		EH_CHECK_EQUAL(50000000, eHealthOhms(2));
+
+		// The block kernel divides differently on the host; it must agree.
+		static int16_t conductance[9101];
+		static int32_t ohms[9101];
+		for (int i = 0; i < 9101; i++) {
+			conductance[i] = i - 100;
+		}
+		eHealthConductanceToOhms(conductance, ohms, 9101);
+
+		bool same = true;
+		for (int i = 0; i < 9101; i++) {
+			same &= ohms[i] == eHealthOhms(conductance[i]);
+		}
+		EH_CHECK(same);
+	}
+
+	EH_TEST(test_float_getters_wrap_the_fixed_point_ones)
+	{
+		eHealthClassMock fixed;
+		eHealthClassMock floating;
+
+		for (int i = 0; i < 100; i++) {
+			EH_CHECK_EQUAL(fixed.getECGMillivolts() * 0.001f, floating.getECG());
+			EH_CHECK_EQUAL(fixed.getEMGMillivolts() / 1000, floating.getEMG());
+			EH_CHECK_EQUAL(fixed.getSkinConductanceHundredths() * 0.01f, floating.getSkinConductance());
+			EH_CHECK_EQUAL((float)fixed.getSkinResistanceOhms(), floating.getSkinResistance());
+		}
+		EH_CHECK_EQUAL(3750, fixed.getTemperatureCentidegrees());
+		EH_CHECK_EQUAL(37.5f, floating.getTemperature());
+
+		uint16_t block[100];
+		eHealthClassMock blockReader;
+		eHealthClassMock single;
+		blockReader.getECGMillivoltsBlock(block, 100);
+		for (int i = 0; i < 100; i++) {
+			EH_CHECK_EQUAL(single.getECGMillivolts(), block[i]);
+		}
+	}
+
+
+//***************************************************************
+// Snapshots													*
+//***************************************************************
+
+	EH_TEST(test_sample_all_reads_every_channel_at_one_instant)
+	{
+		eHealthClassMock snapshotReader;
+		eHealthClassMock channelReader;
+		eHealthSnapshot snapshot;
+
+		snapshotReader.readPulsioximeter();
+		channelReader.readPulsioximeter();
+		delay(3);
+
+		EH_CHECK_EQUAL(EHEALTH_CHANNELS, snapshotReader.sampleAll(snapshot));
+		EH_CHECK_EQUAL(EHEALTH_CHANNELS, snapshot.channels);
+		// No settling delays: the clock did not move.
+		EH_CHECK_EQUAL(micros(), snapshot.timestamp);
+		EH_CHECK_EQUAL(3000UL, micros());
+
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			EH_CHECK_EQUAL(channelReader.readChannel(channel), snapshot.values[channel]);
+		}
+
+		uint16_t ecgAndBpm = EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_BPM);
+		EH_CHECK_EQUAL(ecgAndBpm, snapshotReader.sampleAll(snapshot, ecgAndBpm | 0x8000));
+		EH_CHECK_EQUAL(0, snapshot.values[EHEALTH_EMG]);
+		EH_CHECK_EQUAL(channelReader.readChannel(EHEALTH_ECG), snapshot.values[EHEALTH_ECG]);
+	}
+
+	EH_TEST(test_sample_all_block_matches_single_snapshots)
+	{
+		eHealthClassMock blockReader;
+		eHealthClassMock singleReader;
+		eHealthSnapshotBlock block = {};
+		static uint16_t columns[EHEALTH_CHANNEL_COUNT][100];
+		eHealthSnapshot snapshot;
+
+		delay(1);
+		block.period = 4000;
+		for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+			block.values[channel] = columns[channel];
+		}
+		// A channel without an array is left alone.
+		block.values[EHEALTH_EMG] = NULL;
+		uint16_t channels = EHEALTH_CHANNELS & ~EHEALTH_CHANNEL_BIT(EHEALTH_EMG);
+
+		EH_CHECK_EQUAL(channels, blockReader.sampleAllBlock(block, 100));
+		EH_CHECK_EQUAL(channels, block.channels);
+		EH_CHECK_EQUAL(1000UL, block.timestamp);
+		EH_CHECK_EQUAL(1000UL, micros());
+
+		for (int i = 0; i < 100; i++) {
+			singleReader.sampleAll(snapshot, channels);
+			for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+				if (channels & EHEALTH_CHANNEL_BIT(channel)) {
+					EH_CHECK_EQUAL(snapshot.values[channel], columns[channel][i]);
+				}
+			}
+		}
+	}
+
+
+	EH_TEST(test_sample_all_block_follows_the_bpm_within_the_block)
+	{
+		eHealthClassMock blockReader;
+		eHealthClassMock singleReader;
+		eHealthSnapshotBlock block = {};
+		static uint16_t ecg[2500];
+		static uint16_t bpm[2500];
+		eHealthSnapshot snapshot;
+		uint16_t channels = EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_BPM);
+
+		blockReader.readPulsioximeter();
+		blockReader.waveform.setECG(96, 300, 250);
+		singleReader.readPulsioximeter();
+		singleReader.waveform.setECG(96, 300, 250);
+		block.period = 4000;
+		block.values[EHEALTH_ECG] = ecg;
+		block.values[EHEALTH_BPM] = bpm;
+
+		EH_CHECK_EQUAL(channels, blockReader.sampleAllBlock(block, 2500));
+
+		// The detector only locks on after a few beats.
+		EH_CHECK_EQUAL(75, bpm[0]);
+		EH_CHECK_NEAR(96, bpm[2499], 1);
+
+		for (int i = 0; i < 2500; i++) {
+			singleReader.sampleAll(snapshot, channels);
+			EH_CHECK_EQUAL(snapshot.values[EHEALTH_ECG], ecg[i]);
+			EH_CHECK_EQUAL(snapshot.values[EHEALTH_BPM], bpm[i]);
+		}
+	}
+
+
+//***************************************************************
+// Heartbeat													*
+//***************************************************************
+
+	EH_TEST(test_bpm_follows_the_ecg_read)
+	{
+		eHealthClassMock mock;
+		static float ecg[2500];
+
+		mock.readPulsioximeter();
+		mock.waveform.setECG(96, 300, 250);
+		EH_CHECK_EQUAL(75, mock.getBPM());
+		EH_CHECK_EQUAL(0, mock.getRRInterval());
+
+		mock.getECGBlock(ecg, 2500);
+		EH_CHECK_NEAR(96, mock.getBPM(), 1);
+		EH_CHECK_EQUAL(mock.getBPM(), mock.readChannel(EHEALTH_BPM));
+		EH_CHECK_NEAR(625, mock.getRRInterval(), 8);
+
+		// Single readings feed the detector as well.
+		mock.waveform.setECG(60, 300, 250);
+		for (int i = 0; i < 2500; i++) {
+			mock.getECG();
+		}
+		EH_CHECK_NEAR(60, mock.getBPM(), 1);
+	}
+
+EH_TEST_MAIN()
+
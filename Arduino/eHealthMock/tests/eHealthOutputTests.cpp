@@ -0,0 +1,219 @@
+/*
+*=========================================================================================
+ *  Tests for the buffered output and its sinks.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthSinks.h"
+#include "eHealthTest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+	//! Keeps every write separately.
+	class memorySink : public eHealthSink {
+
+		public:
+
+			size_t write(const uint8_t * data, size_t length) override
+			{
+				writes.push_back(std::string((const char *)data, length));
+				return length;
+			}
+
+			std::string text(void) const
+			{
+				std::string all;
+				for (const std::string & w : writes) {
+					all += w;
+				}
+				return all;
+			}
+
+			std::vector<std::string> writes;
+	};
+
+	EH_TEST(test_air_flow_wave_is_one_write_per_line)
+	{
+		eHealthClassMock mock;
+		memorySink sink;
+		eHealthOutput output(sink);
+
+		mock.setOutput(output);
+		mock.airFlowWave(50);
+		mock.airFlowWave(-3);
+
+		EH_CHECK_EQUAL(2U, sink.writes.size());
+		EH_CHECK(sink.writes[0] == std::string(22, '.') + "\n");
+		EH_CHECK(sink.writes[1] == "..\n");
+		EH_CHECK_EQUAL(2U, output.records());
+		EH_CHECK_EQUAL(26U, output.bytesWritten());
+	}
+
+	EH_TEST(test_print_position_is_one_write_per_message)
+	{
+		eHealthClassMock mock;
+		memorySink sink;
+		eHealthOutput output(sink);
+
+		mock.setOutput(output);
+		mock.printPosition(EHEALTH_SUPINE);
+
+		EH_CHECK_EQUAL(1U, sink.writes.size());
+		EH_CHECK(sink.writes[0] == "Supine position\r\n");
+	}
+
+	EH_TEST(test_numbers_format_like_serial)
+	{
+		memorySink sink;
+		eHealthOutput output(sink);
+
+		output.print(0);
+		output.print(' ');
+		output.print(-1234);
+		output.print(' ');
+		output.print(255, HEX);
+		output.print(' ');
+		output.print(4294967295UL);
+		output.print(' ');
+		output.print(-2147483647L - 1);
+		output.print(' ');
+		output.print(36.585);
+		output.print(' ');
+		output.print(-0.125, 3);
+		output.print(' ');
+		output.print(2.5, 0);
+		output.endRecord();
+
+		EH_CHECK(sink.text() == "0 -1234 FF 4294967295 -2147483648 36.59 -0.125 3");
+	}
+
+	EH_TEST(test_long_records_are_written_in_pieces)
+	{
+		memorySink sink;
+		eHealthOutput output(sink);
+		std::string record(EHEALTH_OUTPUT_BUFFER * 2 + 10, 'x');
+
+		output.print(record.c_str());
+		EH_CHECK_EQUAL(2U, sink.writes.size());
+		EH_CHECK(output.endRecord());
+		EH_CHECK_EQUAL(3U, sink.writes.size());
+		EH_CHECK(sink.text() == record);
+	}
+
+	EH_TEST(test_rate_limit_drops_whole_records)
+	{
+		memorySink sink;
+		eHealthOutput output(sink);
+		const uint32_t limit = 2000;
+
+		output.setRateLimit(limit);
+
+		// 100 byte records every 10 ms: 10000 B/s offered for 10 s.
+		for (int i = 0; i < 1000; i++) {
+			output.repeat("0123456789", 10);
+			output.endRecord();
+			hostClockAdvance(10000);
+		}
+
+		uint32_t burst = limit / 10 + EHEALTH_OUTPUT_BUFFER;
+		EH_CHECK(output.bytesWritten() <= limit * 10 + burst);
+		EH_CHECK(output.bytesWritten() >= limit * 10 - 100);
+		EH_CHECK_EQUAL(1000U, output.records() + output.droppedRecords());
+		EH_CHECK_EQUAL(output.records(), sink.writes.size());
+		for (const std::string & w : sink.writes) {
+			EH_CHECK_EQUAL(100U, w.size());
+		}
+	}
+
+	EH_TEST(test_fd_sink_writes_to_pipes_and_sockets)
+	{
+		int pipeFds[2];
+		EH_CHECK_EQUAL(0, pipe(pipeFds));
+		{
+			eHealthFdSink sink(pipeFds[1], true);
+			eHealthOutput output(sink);
+			output.println("pipe");
+			output.endRecord();
+		}
+		char text[16] = { 0 };
+		EH_CHECK_EQUAL(6, read(pipeFds[0], text, sizeof(text)));
+		EH_CHECK(std::string(text) == "pipe\r\n");
+		close(pipeFds[0]);
+
+		char path[] = "/tmp/ehealth-sink-XXXXXX";
+		EH_CHECK(mkdtemp(path) != NULL);
+		std::string socketPath = std::string(path) + "/out.sock";
+
+		sockaddr_un address = {};
+		address.sun_family = AF_UNIX;
+		strcpy(address.sun_path, socketPath.c_str());
+		int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		EH_CHECK_EQUAL(0, bind(listener, (const sockaddr *)&address, sizeof(address)));
+		EH_CHECK_EQUAL(0, listen(listener, 1));
+
+		eHealthFdSink sink = eHealthFdSink::connectUnix(socketPath.c_str());
+		EH_CHECK(sink.isOpen());
+		int peer = accept(listener, NULL, NULL);
+
+		eHealthOutput output(sink);
+		output.print(75);
+		EH_CHECK(output.endRecord());
+		memset(text, 0, sizeof(text));
+		EH_CHECK_EQUAL(2, read(peer, text, sizeof(text)));
+		EH_CHECK(std::string(text) == "75");
+
+		// A vanished reader stops the sink without a SIGPIPE.
+		close(peer);
+		output.print("lost");
+		output.endRecord();
+		output.print("lost");
+		output.endRecord();
+		EH_CHECK(!sink.isOpen());
+
+		EH_CHECK(!eHealthFdSink::connectUnix((std::string(path) + "/none").c_str()).isOpen());
+
+		close(listener);
+		unlink(socketPath.c_str());
+		rmdir(path);
+	}
+
+	EH_TEST(test_fd_sink_waits_on_a_full_non_blocking_pipe)
+	{
+		int pipeFds[2];
+		EH_CHECK_EQUAL(0, pipe(pipeFds));
+		fcntl(pipeFds[1], F_SETFL, fcntl(pipeFds[1], F_GETFL) | O_NONBLOCK);
+
+		// Far more than the pipe holds, read after a pause.
+		std::vector<uint8_t> data(1 << 20, 'x');
+		size_t received = 0;
+		std::thread reader([&]() {
+			usleep(50000);
+			char buffer[4096];
+			ssize_t n;
+			while ((n = read(pipeFds[0], buffer, sizeof(buffer))) > 0) {
+				received += n;
+			}
+		});
+
+		{
+			eHealthFdSink sink(pipeFds[1], true);
+			EH_CHECK_EQUAL(data.size(), sink.write(data.data(), data.size()));
+			EH_CHECK(sink.isOpen());
+		}
+		reader.join();
+		EH_CHECK_EQUAL(data.size(), received);
+		close(pipeFds[0]);
+	}
+
+EH_TEST_MAIN()
@@ -0,0 +1,217 @@
+/*
+*=========================================================================================
+ *  Tests for the body position classifier.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthTest.h"
+
+#include <math.h>
+#include <string>
+
+
+	//! Keeps everything written.
+	class stringSink : public eHealthSink {
+
+		public:
+
+			size_t write(const uint8_t * data, size_t length) override
+			{
+				text.append((const char *)data, length);
+				return length;
+			}
+
+			std::string text;
+	};
+
+	//! Feeds the classifier a 1 g vector tilted degrees from +z toward -y.
+	static uint8_t tilt(eHealthPositionClassifier & classifier, double degrees)
+	{
+		double radians = degrees * M_PI / 180;
+		return classifier.update(0, (int16_t)(-1024 * sin(radians)), (int16_t)(1024 * cos(radians)));
+	}
+
+
+//***************************************************************
+// Classifier													*
+//***************************************************************
+
+	EH_TEST(test_each_axis_maps_to_its_position)
+	{
+		eHealthPositionClassifier classifier;
+		classifier.setDebounce(1);
+
+		EH_CHECK_EQUAL(EHEALTH_SUPINE, classifier.update(0, 0, 1024));
+		EH_CHECK_EQUAL(EHEALTH_LEFT_LATERAL, classifier.update(0, -1024, 0));
+		EH_CHECK_EQUAL(EHEALTH_RIGHT_LATERAL, classifier.update(0, 1024, 0));
+		EH_CHECK_EQUAL(EHEALTH_PRONE, classifier.update(0, 0, -1024));
+		EH_CHECK_EQUAL(EHEALTH_STANDING, classifier.update(1024, 0, 0));
+		EH_CHECK_EQUAL(EHEALTH_UNDEFINED_POSITION, classifier.update(-1024, 0, 0));
+	}
+
+	EH_TEST(test_starts_undefined_and_debounces)
+	{
+		eHealthPositionClassifier classifier;
+
+		EH_CHECK_EQUAL(EHEALTH_UNDEFINED_POSITION, classifier.position());
+		EH_CHECK_EQUAL(EHEALTH_UNDEFINED_POSITION, classifier.update(0, 0, 1024));
+		// Free fall says nothing and restarts the count.
+		EH_CHECK_EQUAL(EHEALTH_UNDEFINED_POSITION, classifier.update(0, 0, 0));
+
+		for (int i = 1; i < EHEALTH_POSITION_DEBOUNCE; i++) {
+			EH_CHECK_EQUAL(EHEALTH_UNDEFINED_POSITION, classifier.update(0, 0, 1024));
+		}
+		EH_CHECK_EQUAL(EHEALTH_SUPINE, classifier.update(0, 0, 1024));
+	}
+
+	EH_TEST(test_positions_are_kept_with_hysteresis)
+	{
+		eHealthPositionClassifier classifier;
+		classifier.setDebounce(1);
+
+		EH_CHECK_EQUAL(EHEALTH_SUPINE, tilt(classifier, 0));
+		// Past the 45 degree midpoint but within the 60 degree cone.
+		EH_CHECK_EQUAL(EHEALTH_SUPINE, tilt(classifier, 55));
+		EH_CHECK_EQUAL(EHEALTH_LEFT_LATERAL, tilt(classifier, 70));
+		// On the way back the new position is kept just the same.
+		EH_CHECK_EQUAL(EHEALTH_LEFT_LATERAL, tilt(classifier, 35));
+		EH_CHECK_EQUAL(EHEALTH_SUPINE, tilt(classifier, 20));
+	}
+
+	EH_TEST(test_ambiguous_samples_restart_the_debounce)
+	{
+		const int16_t supine[9] = { 0, 0, 1024, 0, 0, 1024, 0, 0, 1024 };
+		eHealthPositionClassifier classifier;
+		classifier.setDebounce(3);
+
+		EH_CHECK_EQUAL(EHEALTH_SUPINE, classifier.classify(supine, 3, NULL));
+
+		EH_CHECK_EQUAL(EHEALTH_SUPINE, tilt(classifier, 70));
+		EH_CHECK_EQUAL(EHEALTH_SUPINE, tilt(classifier, 70));
+		// Between the head and the left side: no cone, no position entered.
+		EH_CHECK_EQUAL(EHEALTH_SUPINE, classifier.update(700, -700, 200));
+		EH_CHECK_EQUAL(EHEALTH_SUPINE, tilt(classifier, 70));
+		EH_CHECK_EQUAL(EHEALTH_SUPINE, tilt(classifier, 70));
+		EH_CHECK_EQUAL(EHEALTH_LEFT_LATERAL, tilt(classifier, 70));
+	}
+
+	EH_TEST(test_block_matches_sample_by_sample)
+	{
+		eHealthMMA8452 device;
+		eHealthPositionClassifier one;
+		eHealthPositionClassifier block;
+		static int16_t counts[3 * 1000];
+		uint8_t positions[1000];
+
+		// Rolls through every position, with noise near each boundary.
+		device.setMotion(50, 150);
+		for (int i = 0; i < 10; i++) {
+			double a = i * M_PI / 5;
+			device.setGravity((int16_t)(400 * sin(a / 2)), (int16_t)(1000 * sin(a)), (int16_t)(1000 * cos(a)));
+			device.generate(100 * i, 100, counts + 300 * i);
+		}
+
+		EH_CHECK_EQUAL(block.classify(counts, 1000, positions), positions[999]);
+
+		int changes = 0;
+		for (int i = 0; i < 1000; i++) {
+			EH_CHECK_EQUAL(one.update(counts[3 * i], counts[3 * i + 1], counts[3 * i + 2]), positions[i]);
+			changes += i > 0 && positions[i] != positions[i - 1];
+		}
+		EH_CHECK(changes >= 4);
+	}
+
+	EH_TEST(test_registers_unpack_to_counts_and_g)
+	{
+		const uint8_t registers[6] = { 0x40, 0x00, 0xC0, 0x00, 0x7F, 0xF0 };
+		int16_t counts[3];
+		float accel[3];
+
+		eHealthAccelUnpack(registers, counts, 1);
+
+		EH_CHECK_EQUAL(1024, counts[0]);
+		EH_CHECK_EQUAL(-1024, counts[1]);
+		EH_CHECK_EQUAL(2047, counts[2]);
+
+		eHealthAccelToG(counts, accel, 3, 2);
+
+		EH_CHECK_NEAR(1.0, accel[0], 1e-6);
+		EH_CHECK_NEAR(-1.0, accel[1], 1e-6);
+
+		eHealthAccelToG(counts, accel, 3, 8);
+
+		EH_CHECK_NEAR(8.0 * 2047 / 2048, accel[2], 1e-5);
+	}
+
+
+//***************************************************************
+// Mock															*
+//***************************************************************
+
+	EH_TEST(test_body_position_follows_the_accelerometer)
+	{
+		eHealthClassMock mock;
+
+		EH_CHECK_EQUAL(EHEALTH_UNDEFINED_POSITION, mock.getBodyPosition());
+
+		mock.initPositionSensor();
+		mock.accelerometer.setGravity(0, 1000, 0);
+
+		uint8_t position = 0;
+		for (int i = 0; i < EHEALTH_POSITION_DEBOUNCE; i++) {
+			delay(10);
+			position = mock.getBodyPosition();
+		}
+
+		EH_CHECK_EQUAL(EHEALTH_RIGHT_LATERAL, position);
+		EH_CHECK_EQUAL(EHEALTH_RIGHT_LATERAL, mock.readChannel(EHEALTH_POSITION));
+	}
+
+	EH_TEST(test_position_block_drains_the_fifo)
+	{
+		eHealthClassMock mock;
+		uint8_t positions[64];
+
+		mock.initPositionSensor();
+		mock.accelerometer.writeRegister(MMA8452_CTRL_REG1, 0);
+		mock.accelerometer.writeRegister(MMA8452_F_SETUP, 0x40);
+		mock.accelerometer.writeRegister(MMA8452_CTRL_REG1, 0x01);
+		mock.accelerometer.setGravity(0, 0, -1000);
+		delay(20);
+
+		// 800 Hz: 16 samples waiting.
+		EH_CHECK_EQUAL(16U, mock.getBodyPositionBlock(positions, 64));
+		EH_CHECK_EQUAL(EHEALTH_UNDEFINED_POSITION, positions[EHEALTH_POSITION_DEBOUNCE - 2]);
+		EH_CHECK_EQUAL(EHEALTH_PRONE, positions[EHEALTH_POSITION_DEBOUNCE - 1]);
+		EH_CHECK_EQUAL(EHEALTH_PRONE, positions[15]);
+		EH_CHECK_EQUAL(0, mock.accelerometer.fifoCount());
+
+		delay(5);
+
+		EH_CHECK_EQUAL(2U, mock.getBodyPositionBlock(positions, 2));
+		EH_CHECK_EQUAL(2, mock.accelerometer.fifoCount());
+		EH_CHECK_EQUAL(EHEALTH_PRONE, mock.getBodyPosition());
+		EH_CHECK_EQUAL(0, mock.accelerometer.fifoCount());
+	}
+
+	EH_TEST(test_print_position_names_the_classified_position)
+	{
+		eHealthClassMock mock;
+		stringSink sink;
+		eHealthOutput output(sink);
+
+		mock.setOutput(output);
+		mock.initPositionSensor();
+		mock.accelerometer.setGravity(0, -1000, 0);
+		for (int i = 0; i < EHEALTH_POSITION_DEBOUNCE; i++) {
+			delay(10);
+			mock.getBodyPosition();
+		}
+		mock.printPosition(mock.getBodyPosition());
+
+		EH_CHECK(sink.text == "Left lateral decubitus\r\n");
+	}
+
+EH_TEST_MAIN()
@@ -0,0 +1,107 @@
+/*
+*=========================================================================================
+ *  Tests for the hot-path instrumentation, built with EHEALTH_PROFILE.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthTest.h"
+
+#include <string>
+
+
+	//! Keeps everything written.
+	class stringSink : public eHealthSink {
+
+		public:
+
+			size_t write(const uint8_t * data, size_t length) override
+			{
+				text.append((const char *)data, length);
+				return length;
+			}
+
+			std::string text;
+	};
+
+	EH_TEST(test_latencies_fall_in_log2_buckets)
+	{
+		eHealthProfileReset();
+
+		eHealthProfileRecord(EHEALTH_PROBE_GET_ECG, 0);
+		eHealthProfileRecord(EHEALTH_PROBE_GET_ECG, 1);
+		eHealthProfileRecord(EHEALTH_PROBE_GET_ECG, 3);
+		eHealthProfileRecord(EHEALTH_PROBE_GET_ECG, 4);
+		eHealthProfileRecord(EHEALTH_PROBE_GET_ECG, 0xFFFFFFFF);
+
+		const eHealthProbeStats & stats = eHealthProfileStats(EHEALTH_PROBE_GET_ECG);
+
+		EH_CHECK_EQUAL(5U, stats.calls);
+		EH_CHECK_EQUAL(0xFFFFFFFFU, stats.maxMicros);
+		EH_CHECK_EQUAL(1U, stats.buckets[0]);
+		EH_CHECK_EQUAL(1U, stats.buckets[1]);
+		EH_CHECK_EQUAL(1U, stats.buckets[2]);
+		EH_CHECK_EQUAL(1U, stats.buckets[3]);
+		EH_CHECK_EQUAL(1U, stats.buckets[EHEALTH_PROFILE_BUCKETS - 1]);
+	}
+
+	EH_TEST(test_skin_resistance_exposes_its_delays)
+	{
+		eHealthClassMock mock;
+
+		eHealthProfileReset();
+		mock.getSkinResistance();
+
+		const eHealthProbeStats & resistance = eHealthProfileStats(EHEALTH_PROBE_GET_SKIN_RESISTANCE);
+		const eHealthProbeStats & conductance = eHealthProfileStats(EHEALTH_PROBE_GET_SKIN_CONDUCTANCE_HUNDREDTHS);
+		const eHealthProbeStats & voltage = eHealthProfileStats(EHEALTH_PROBE_GET_SKIN_CONDUCTANCE_MILLIVOLTS);
+
+		EH_CHECK_EQUAL(1U, resistance.calls);
+		EH_CHECK_EQUAL(8000U, resistance.totalMicros);
+		EH_CHECK_EQUAL(1U, resistance.buckets[13]);
+		EH_CHECK_EQUAL(6000U, conductance.totalMicros);
+		EH_CHECK_EQUAL(4000U, voltage.totalMicros);
+		// The float getter only wraps the fixed point ones.
+		EH_CHECK_EQUAL(1U, eHealthProfileStats(EHEALTH_PROBE_GET_SKIN_RESISTANCE_OHMS).calls);
+	}
+
+	EH_TEST(test_air_flow_wave_exposes_serial_stalls)
+	{
+		eHealthClassMock mock;
+
+		Serial.setStream(NULL);
+		Serial.begin(9600);
+		eHealthProfileReset();
+
+		// 205 ".." and a newline: all but the 64 buffered bytes stall.
+		mock.airFlowWave(1023);
+
+		Serial.end();
+		Serial.setStream(stdout);
+
+		const eHealthProbeStats & wave = eHealthProfileStats(EHEALTH_PROBE_AIR_FLOW_WAVE);
+
+		EH_CHECK_EQUAL(1U, wave.calls);
+		EH_CHECK_EQUAL(25000U + (411U - 64) * 1041, wave.totalMicros);
+	}
+
+	EH_TEST(test_print_profile_lists_called_methods)
+	{
+		eHealthClassMock mock;
+		stringSink sink;
+		eHealthOutput output(sink);
+
+		mock.setOutput(output);
+		eHealthProfileReset();
+		mock.getBPM();
+		mock.getBPM();
+		mock.printProfile(true);
+
+		EH_CHECK_EQUAL(0U, sink.text.find("# probe calls totalMicros maxMicros"));
+		EH_CHECK(sink.text.find("\r\ngetBPM 2 0 0 2 0 ") != std::string::npos);
+		EH_CHECK(sink.text.find("getECG") == std::string::npos);
+		EH_CHECK_EQUAL(0U, eHealthProfileStats(EHEALTH_PROBE_GET_BPM).calls);
+	}
+
+EH_TEST_MAIN()
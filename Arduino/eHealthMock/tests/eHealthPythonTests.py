@@ -0,0 +1,116 @@
+"""Tests for the ehealthmock Python binding.
+
+Run with the directory of the built module on PYTHONPATH, as ctest does."""
+
+import array
+import threading
+import time
+import unittest
+
+import ehealthmock
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+
+class BlockTests(unittest.TestCase):
+
+    def test_count_returns_a_float32_view(self):
+        ecg = ehealthmock.Mock().ecg(1000)
+        self.assertIsInstance(ecg, memoryview)
+        self.assertEqual('f', ecg.format)
+        self.assertEqual(1000, len(ecg))
+        self.assertTrue(all(0 <= v <= 5 for v in ecg))
+
+    def test_buffers_are_filled_in_place(self):
+        samples = array.array('f', bytes(4 * 500))
+        self.assertEqual(500, ehealthmock.Mock(seed=3).ecg(samples))
+        self.assertEqual(list(ehealthmock.Mock(seed=3).ecg(500)), list(samples))
+
+    def test_int16_buffers_get_millivolts(self):
+        volts = ehealthmock.Mock(seed=5).emg(300)
+        millivolts = array.array('H', bytes(2 * 300))
+        ehealthmock.Mock(seed=5).emg(millivolts)
+        for v, mv in zip(volts, millivolts):
+            self.assertAlmostEqual(v * 1000, mv, delta=5)
+
+    def test_airflow_is_the_same_in_every_type(self):
+        expected = list(ehealthmock.Mock(seed=9).airflow(700))
+        for code in 'ihf':
+            samples = array.array(code, bytes(array.array(code).itemsize * 700))
+            ehealthmock.Mock(seed=9).airflow(samples)
+            self.assertEqual(expected, [int(v) for v in samples])
+
+    def test_block_has_a_row_per_channel(self):
+        mock = ehealthmock.Mock(rate=500)
+        rows = mock.block(400, ehealthmock.ECG | ehealthmock.AIRFLOW | ehealthmock.BPM)
+        self.assertEqual((3, 400), rows.shape)
+        self.assertTrue(all(v < 1024 for v in rows.tolist()[0]))
+
+        out = array.array('H', bytes(2 * 3 * 100))
+        self.assertEqual(100, mock.block(out, ehealthmock.ECG | ehealthmock.EMG | ehealthmock.GSR))
+
+    def test_other_buffers_are_refused(self):
+        mock = ehealthmock.Mock()
+        self.assertRaises(TypeError, mock.ecg, bytearray(64))
+        self.assertRaises(TypeError, mock.gsr, array.array('h', bytes(64)))
+        self.assertRaises(BufferError, mock.ecg, bytes(64))
+        self.assertRaises(ValueError, mock.ecg, -1)
+        self.assertRaises(ValueError, mock.block, 10, 0)
+        self.assertRaises(ValueError, mock.block, 0, ehealthmock.ECG)
+        self.assertRaises(ValueError, ehealthmock.Mock, rate=4)
+
+    @unittest.skipIf(numpy is None, 'numpy is not installed')
+    def test_numpy_arrays_are_filled_and_viewed_without_copies(self):
+        mock = ehealthmock.Mock()
+        samples = numpy.zeros(10000, dtype=numpy.float32)
+        self.assertEqual(10000, mock.ecg(samples))
+        self.assertTrue(samples.any())
+
+        view = mock.ecg(10000)
+        self.assertTrue(numpy.shares_memory(numpy.asarray(view), view))
+
+        rows = numpy.zeros((2, 256), dtype=numpy.uint16)
+        self.assertEqual(256, mock.block(rows, ehealthmock.ECG | ehealthmock.EMG))
+        self.assertTrue(rows[0].any() and rows[1].any())
+
+        # NumPy refuses strided arrays itself.
+        self.assertRaises(ValueError, mock.ecg, samples[::2])
+
+    def test_heart_rate_comes_from_the_ecg(self):
+        mock = ehealthmock.Mock(seed=1, rate=500)
+        mock.ecg(500 * 12)
+        self.assertAlmostEqual(56, mock.bpm(), delta=1)
+        self.assertAlmostEqual(60000 / 56, mock.rr_interval(), delta=20)
+
+
+class ThreadTests(unittest.TestCase):
+
+    def test_other_threads_run_during_generation(self):
+        samples = array.array('f', bytes(4 * 20000000))
+        mock = ehealthmock.Mock()
+        took = []
+
+        def generate():
+            start = time.monotonic()
+            mock.ecg(samples)
+            took.append(time.monotonic() - start)
+
+        worker = threading.Thread(target=generate)
+        last = time.monotonic()
+        longest = 0
+        worker.start()
+        while worker.is_alive():
+            now = time.monotonic()
+            longest = max(longest, now - last)
+            last = now
+        worker.join()
+
+        # Holding the GIL would stall this thread for the whole call.
+        self.assertLess(longest, took[0] / 2)
+
+
+if __name__ == '__main__':
+    unittest.main()
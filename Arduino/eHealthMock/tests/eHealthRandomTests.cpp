@@ -0,0 +1,105 @@
+/*
+*=========================================================================================
+ *  Tests for the counter based random generator.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthRandom.h"
+#include "eHealthTest.h"
+
+
+	EH_TEST(test_draws_depend_only_on_index)
+	{
+		eHealthRandom sequential(5);
+		eHealthRandom random(5);
+
+		for (uint64_t i = 0; i < 1000; i++) {
+			EH_CHECK_EQUAL(random.at(i), sequential.next());
+		}
+		EH_CHECK_EQUAL(1000U, sequential.position());
+	}
+
+	EH_TEST(test_seek_and_skip_jump_in_constant_time)
+	{
+		eHealthRandom a(7);
+		eHealthRandom b(7);
+
+		a.seek(1ULL << 40);
+		EH_CHECK_EQUAL(b.at(1ULL << 40), a.next());
+
+		b.skip(12345);
+		b.skip(1);
+		EH_CHECK_EQUAL(a.at(12346), b.next());
+	}
+
+	EH_TEST(test_seeds_select_different_streams)
+	{
+		eHealthRandom a(1);
+		eHealthRandom b(2);
+		int equal = 0;
+
+		for (int i = 0; i < 1000; i++) {
+			equal += a.next() == b.next();
+		}
+		EH_CHECK(equal < 2);
+	}
+
+	EH_TEST(test_uniform_covers_range_evenly)
+	{
+		eHealthRandom random(3);
+		long buckets[8] = { 0 };
+
+		for (int i = 0; i < 80000; i++) {
+			uint16_t value = random.uniform(1, 1024);
+			EH_CHECK(value >= 1 && value < 1024);
+			buckets[(value - 1) / 128]++;
+		}
+		for (int i = 0; i < 8; i++) {
+			// 10000 expected per bucket (the last one holds 127 values).
+			EH_CHECK_NEAR(10000, buckets[i], 400);
+		}
+		EH_CHECK_EQUAL(9, random.uniform(9, 9));
+	}
+
+	EH_TEST(test_mock_slices_match_one_sequential_run)
+	{
+		eHealthClassMock sequential;
+		eHealthClassMock firstHalf;
+		eHealthClassMock secondHalf;
+		float all[400];
+		float slices[400];
+
+		sequential.seed(11);
+		firstHalf.seed(11);
+		secondHalf.seed(11);
+
+		sequential.getEMGBlock(all, 400);
+		secondHalf.seek(150);
+		secondHalf.getEMGBlock(slices + 150, 250);
+		firstHalf.getEMGBlock(slices, 150);
+
+		for (int i = 0; i < 400; i++) {
+			EH_CHECK_EQUAL(all[i], slices[i]);
+		}
+
+		sequential.getECGBlock(all, 400);
+		secondHalf.seek(150);
+		secondHalf.getECGBlock(slices + 150, 250);
+		firstHalf.seek(0);
+		firstHalf.getECGBlock(slices, 150);
+
+		for (int i = 0; i < 400; i++) {
+			EH_CHECK_EQUAL(all[i], slices[i]);
+		}
+
+		sequential.seek(0);
+		secondHalf.seek(150);
+		for (int i = 0; i < 150; i++) {
+			sequential.getSkinConductanceVoltage();
+		}
+		EH_CHECK_EQUAL(sequential.getSkinConductanceVoltage(), secondHalf.getSkinConductanceVoltage());
+	}
+
+EH_TEST_MAIN()
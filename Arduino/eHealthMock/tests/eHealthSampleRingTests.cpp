@@ -0,0 +1,141 @@
+/*
+*=========================================================================================
+ *  Tests for the single producer, single consumer sample ring.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthSampleRing.h"
+#include "eHealthTest.h"
+
+#include <thread>
+
+
+	static eHealthSample makeSample(uint32_t i)
+	{
+		eHealthSample sample;
+		sample.timestamp = i;
+		sample.value = (uint16_t)i;
+		sample.channel = (uint8_t)(i % EHEALTH_CHANNEL_COUNT);
+		return sample;
+	}
+
+	EH_TEST(test_capacity_rounds_down_to_power_of_two)
+	{
+		eHealthSample storage[100];
+		eHealthSampleRing ring(storage, 100);
+
+		EH_CHECK_EQUAL(64U, ring.capacity());
+		EH_CHECK(ring.empty());
+	}
+
+	EH_TEST(test_every_slot_is_usable_and_overflow_is_counted)
+	{
+		eHealthSampleRingN<8> ring;
+		eHealthSample sample;
+
+		for (uint32_t i = 0; i < 8; i++) {
+			EH_CHECK(ring.push(makeSample(i)));
+		}
+		EH_CHECK(!ring.push(makeSample(8)));
+		EH_CHECK(!ring.push(makeSample(9)));
+		EH_CHECK_EQUAL(8U, ring.size());
+		EH_CHECK_EQUAL(2U, ring.overflows());
+
+		// The oldest samples are kept, the newest dropped.
+		EH_CHECK(ring.pop(sample));
+		EH_CHECK_EQUAL(0U, sample.timestamp);
+		EH_CHECK(ring.push(makeSample(10)));
+		EH_CHECK_EQUAL(8U, ring.size());
+	}
+
+	EH_TEST(test_pop_block_drains_in_order_across_the_wrap)
+	{
+		eHealthSampleRingN<16> ring;
+		eHealthSample batch[16];
+		uint32_t next = 0;
+		uint32_t expected = 0;
+
+		for (int round = 0; round < 50; round++) {
+			while (ring.push(makeSample(next))) {
+				next++;
+			}
+			size_t n = ring.popBlock(batch, 5 + round % 7);
+			for (size_t i = 0; i < n; i++) {
+				EH_CHECK_EQUAL(expected, batch[i].timestamp);
+				expected++;
+			}
+		}
+		EH_CHECK_EQUAL(next - expected, ring.size());
+		EH_CHECK_EQUAL(0U, ring.popBlock(batch, 0));
+	}
+
+	EH_TEST(test_producer_thread_and_consumer_agree)
+	{
+		const uint32_t total = 1000000;
+		eHealthSampleRingN<256> ring;
+		uint32_t dropped = 0;
+
+		std::thread producer([&] {
+			for (uint32_t i = 0; i < total; i++) {
+				while (!ring.push(makeSample(i))) {
+					dropped++;
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		eHealthSample batch[32];
+		uint32_t expected = 0;
+		bool ordered = true;
+
+		while (expected < total) {
+			size_t n = ring.popBlock(batch, 32);
+			if (n == 0) {
+				std::this_thread::yield();
+			}
+			for (size_t i = 0; i < n; i++) {
+				ordered &= batch[i].timestamp == expected && batch[i].value == (uint16_t)expected;
+				expected++;
+			}
+		}
+		producer.join();
+
+		EH_CHECK(ordered);
+		EH_CHECK(ring.empty());
+		EH_CHECK_EQUAL(dropped, ring.overflows());
+	}
+
+	EH_TEST(test_acquire_fills_the_ring_with_timestamped_snapshots)
+	{
+		eHealthClassMock mock;
+		eHealthSampleRingN<8> ring;
+		eHealthSample batch[8];
+
+		EH_CHECK(!mock.acquire());
+
+		mock.readPulsioximeter();
+		mock.attachRing(&ring, EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_BPM));
+
+		hostClockSet(4000);
+		EH_CHECK(mock.acquire());
+		hostClockSet(8000);
+		EH_CHECK(mock.acquire());
+
+		EH_CHECK_EQUAL(4U, ring.popBlock(batch, 8));
+		EH_CHECK_EQUAL(EHEALTH_ECG, batch[0].channel);
+		EH_CHECK_EQUAL(EHEALTH_BPM, batch[1].channel);
+		EH_CHECK_EQUAL(75, batch[1].value);
+		EH_CHECK_EQUAL(4000U, batch[1].timestamp);
+		EH_CHECK_EQUAL(8000U, batch[2].timestamp);
+
+		// A full ring drops samples and says so.
+		for (int i = 0; i < 4; i++) {
+			EH_CHECK(mock.acquire());
+		}
+		EH_CHECK(!mock.acquire());
+		EH_CHECK_EQUAL(2U, ring.overflows());
+	}
+
+EH_TEST_MAIN()
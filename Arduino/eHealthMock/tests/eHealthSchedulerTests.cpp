@@ -0,0 +1,151 @@
+/*
+*=========================================================================================
+ *  Tests for the cooperative acquisition scheduler.
+ *========================================================================================
+ */
+
+
+#include "eHealthScheduler.h"
+#include "eHealthTest.h"
+
+#include <vector>
+
+
+	static void collect(const eHealthSample & sample, void * samples)
+	{
+		((std::vector<eHealthSample> *)samples)->push_back(sample);
+	}
+
+	static size_t countChannel(const std::vector<eHealthSample> & samples, uint8_t channel)
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < samples.size(); i++) {
+			count += samples[i].channel == channel;
+		}
+		return count;
+	}
+
+	EH_TEST(test_each_channel_runs_at_its_own_rate)
+	{
+		eHealthClassMock mock;
+		std::vector<eHealthSample> samples;
+		eHealthScheduler scheduler(mock, collect, &samples);
+
+		scheduler.setRate(EHEALTH_ECG, 250);
+		scheduler.setRate(EHEALTH_GSR, 10);
+		scheduler.setRate(EHEALTH_TEMPERATURE, 1);
+		scheduler.setRate(EHEALTH_AIRFLOW, 3);
+
+		// Ten simulated seconds, polled every 100 us.
+		while (micros() < 10000000UL) {
+			scheduler.poll();
+			hostClockAdvance(100);
+		}
+
+		EH_CHECK_EQUAL(2500U, countChannel(samples, EHEALTH_ECG));
+		EH_CHECK_EQUAL(100U, countChannel(samples, EHEALTH_GSR));
+		EH_CHECK_EQUAL(10U, countChannel(samples, EHEALTH_TEMPERATURE));
+		EH_CHECK_EQUAL(30U, countChannel(samples, EHEALTH_AIRFLOW));
+		EH_CHECK_EQUAL(0U, countChannel(samples, EHEALTH_EMG));
+		EH_CHECK_EQUAL(0U, scheduler.totalMisses());
+
+		// Consecutive ECG samples are one period apart, to the poll granularity.
+		uint32_t previous = 0;
+		bool paced = true;
+		for (size_t i = 0, n = 0; i < samples.size(); i++) {
+			if (samples[i].channel != EHEALTH_ECG) {
+				continue;
+			}
+			if (n++) {
+				paced &= samples[i].timestamp - previous == 4000;
+			}
+			previous = samples[i].timestamp;
+		}
+		EH_CHECK(paced);
+	}
+
+	EH_TEST(test_filtered_channel_hands_over_decimated_samples)
+	{
+		eHealthClassMock mock;
+		std::vector<eHealthSample> samples;
+		eHealthScheduler scheduler(mock, collect, &samples);
+		eHealthFilter filter;
+
+		filter.setSampleRate(1000);
+		filter.setBandPass(0.5, 40);
+		filter.setDecimation(4);
+		scheduler.setRate(EHEALTH_ECG, 1000);
+		scheduler.setRate(EHEALTH_GSR, 10);
+		EH_CHECK(scheduler.setFilter(EHEALTH_ECG, &filter));
+		EH_CHECK(!scheduler.setFilter(EHEALTH_CHANNEL_COUNT, &filter));
+
+		uint32_t taken = 0;
+		while (micros() < 2000000UL) {
+			taken += scheduler.poll();
+			hostClockAdvance(100);
+		}
+
+		EH_CHECK_EQUAL(2020U, taken);
+		EH_CHECK_EQUAL(500U, countChannel(samples, EHEALTH_ECG));
+		EH_CHECK_EQUAL(20U, countChannel(samples, EHEALTH_GSR));
+	}
+
+	EH_TEST(test_idle_poll_takes_nothing_and_reports_the_next_deadline)
+	{
+		eHealthClassMock mock;
+		std::vector<eHealthSample> samples;
+		eHealthScheduler scheduler(mock, collect, &samples);
+
+		EH_CHECK_EQUAL(0, scheduler.poll());
+
+		scheduler.setRate(EHEALTH_ECG, 500);
+		scheduler.setRate(EHEALTH_GSR, 10);
+		EH_CHECK_EQUAL(2, scheduler.poll());
+		EH_CHECK_EQUAL(0, scheduler.poll());
+		EH_CHECK_EQUAL(2000U, scheduler.nextDeadline());
+
+		scheduler.setRate(EHEALTH_ECG, 0);
+		EH_CHECK_EQUAL(100000U, scheduler.nextDeadline());
+		EH_CHECK(!scheduler.setRate(EHEALTH_CHANNEL_COUNT, 10));
+	}
+
+	EH_TEST(test_late_polls_skip_and_count_missed_periods)
+	{
+		eHealthClassMock mock;
+		std::vector<eHealthSample> samples;
+		eHealthScheduler scheduler(mock, collect, &samples);
+
+		scheduler.setRate(EHEALTH_ECG, 250);
+		scheduler.setRate(EHEALTH_GSR, 10);
+		scheduler.poll();
+
+		// A 10 ms stall: ECG was due at 4 and 8 ms, one sample is taken late.
+		hostClockSet(10000);
+		EH_CHECK_EQUAL(1, scheduler.poll());
+		EH_CHECK_EQUAL(1U, scheduler.misses(EHEALTH_ECG));
+		EH_CHECK_EQUAL(0U, scheduler.misses(EHEALTH_GSR));
+		EH_CHECK_EQUAL(12000U, scheduler.nextDeadline());
+
+		scheduler.resetMisses();
+		EH_CHECK_EQUAL(0U, scheduler.totalMisses());
+	}
+
+	EH_TEST(test_deadlines_survive_the_micros_wrap)
+	{
+		eHealthClassMock mock;
+		eHealthSampleRingN<64> ring;
+		eHealthScheduler scheduler(mock, eHealthScheduler::toRing, &ring);
+
+		hostClockSet(0xFFFFFFFFULL - 5000);
+		scheduler.setRate(EHEALTH_ECG, 1000);
+
+		for (int i = 0; i < 200; i++) {
+			scheduler.poll();
+			hostClockAdvance(250);
+		}
+
+		EH_CHECK_EQUAL(50U, ring.size());
+		EH_CHECK_EQUAL(0U, scheduler.totalMisses());
+	}
+
+EH_TEST_MAIN()
@@ -0,0 +1,231 @@
+/*
+*=========================================================================================
+ *  Tests for the pseudo-terminal serial port emulator.
+ *========================================================================================
+ */
+
+
+#include "eHealthSerialPty.h"
+#include "eHealthTest.h"
+
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+
+	//! Reads from the port, as a serial reader would, while pty runs for seconds.
+	//! Each read is kept with the time it returned, in seconds from the start.
+	struct capture {
+		std::vector<uint8_t> bytes;
+		std::vector<std::pair<double, size_t>> reads;
+		eHealthPtyReport report;
+	};
+
+	static capture readRun(eHealthSerialPty & pty, double seconds)
+	{
+		typedef std::chrono::steady_clock clock;
+
+		capture got;
+		int port = open(pty.path(), O_RDONLY | O_NOCTTY | O_NONBLOCK);
+		EH_CHECK(port >= 0);
+		EH_CHECK(pty.waitForReader(1));
+
+		clock::time_point start = clock::now();
+		std::thread board([&]() { got.report = pty.run(seconds); });
+
+		for (;;) {
+			pollfd in = { port, POLLIN, 0 };
+			poll(&in, 1, 50);
+			uint8_t buffer[4096];
+			ssize_t n = read(port, buffer, sizeof(buffer));
+			if (n > 0) {
+				got.bytes.insert(got.bytes.end(), buffer, buffer + n);
+				got.reads.emplace_back(std::chrono::duration<double>(clock::now() - start).count(), got.bytes.size());
+			} else if (std::chrono::duration<double>(clock::now() - start).count() > seconds + 0.2) {
+				break;
+			}
+		}
+		board.join();
+		close(port);
+		return got;
+	}
+
+
+//***************************************************************
+// Configuration												*
+//***************************************************************
+
+	EH_TEST(test_baud_rates_out_of_range_are_refused)
+	{
+		eHealthPtyConfig config;
+
+		config.baud = 4800;
+		eHealthSerialPty slow(config);
+		EH_CHECK(!slow.open());
+		EH_CHECK(slow.error() != NULL);
+
+		config.baud = 3000000;
+		EH_CHECK(!eHealthSerialPty(config).open());
+
+		config.baud = 2000000;
+		eHealthSerialPty fast(config);
+		EH_CHECK(fast.open());
+		EH_CHECK(fast.path()[0] == '/');
+	}
+
+	EH_TEST(test_no_reader_is_waited_for_until_the_timeout)
+	{
+		eHealthSerialPty pty(eHealthPtyConfig{});
+
+		EH_CHECK(pty.open());
+		EH_CHECK(!pty.waitForReader(0.05));
+
+		int port = open(pty.path(), O_RDONLY | O_NOCTTY);
+		EH_CHECK(pty.waitForReader(0.05));
+		close(port);
+	}
+
+
+//***************************************************************
+// Streams														*
+//***************************************************************
+
+	EH_TEST(test_text_lines_carry_bpm_and_conductance)
+	{
+		eHealthPtyConfig config;
+		config.baud = 115200;
+		eHealthSerialPty pty(config);
+		EH_CHECK(pty.open());
+
+		capture got = readRun(pty, 0.3);
+
+		// 0.3 s at 11520 bytes/s, every byte read.
+		EH_CHECK_EQUAL(0u, got.report.overrun);
+		EH_CHECK_EQUAL(got.report.bytes, got.bytes.size());
+		EH_CHECK_NEAR(3456, got.bytes.size(), 200);
+		EH_CHECK(got.report.lineLoad > 0.9);
+
+		std::string text(got.bytes.begin(), got.bytes.end());
+		size_t lines = 0;
+		for (size_t at = 0, end; (end = text.find("\r\n", at)) != std::string::npos; at = end + 2) {
+			int bpm = 0;
+			float conductance = 0;
+			EH_CHECK_EQUAL(2, sscanf(text.substr(at, end - at).c_str(), "%d %f", &bpm, &conductance));
+			EH_CHECK(bpm > 0 && bpm < 250);
+			lines++;
+		}
+		EH_CHECK_EQUAL(got.report.records, lines);
+	}
+
+	EH_TEST(test_no_byte_arrives_before_its_time_on_the_line)
+	{
+		eHealthPtyConfig config;
+		config.baud = 9600;
+		eHealthSerialPty pty(config);
+		EH_CHECK(pty.open());
+
+		capture got = readRun(pty, 0.5);
+
+		// 960 bytes a second, trickling in rather than a line at a time.
+		for (size_t i = 0; i < got.reads.size(); i++) {
+			EH_CHECK(got.reads[i].second <= got.reads[i].first * 960 + 1);
+		}
+		EH_CHECK_NEAR(480, got.bytes.size(), 30);
+		EH_CHECK(got.reads.size() > got.report.records * 3);
+	}
+
+	EH_TEST(test_record_rate_paces_the_lines)
+	{
+		eHealthPtyConfig config;
+		config.baud = 115200;
+		config.rate = 100;
+		eHealthSerialPty pty(config);
+		EH_CHECK(pty.open());
+
+		capture got = readRun(pty, 0.5);
+
+		EH_CHECK_NEAR(50, got.report.records, 2);
+		EH_CHECK(got.report.lineLoad < 0.2);
+	}
+
+	EH_TEST(test_frames_decode_in_sequence)
+	{
+		eHealthPtyConfig config;
+		config.baud = 460800;
+		config.frames = true;
+		eHealthSerialPty pty(config);
+		EH_CHECK(pty.open());
+
+		capture got = readRun(pty, 0.2);
+
+		eHealthFrameDecoder decoder;
+		const uint8_t * data = got.bytes.data();
+		size_t left = got.bytes.size();
+		uint64_t frames = 0;
+		uint32_t timestamp = 0;
+
+		while (left) {
+			size_t used = decoder.feed(data, left);
+			data += used;
+			left -= used;
+			if (decoder.available()) {
+				const eHealthFrame & frame = decoder.frame();
+				EH_CHECK_EQUAL(config.channels, frame.channels);
+				EH_CHECK_EQUAL((uint32_t)frames, frame.sequence);
+				EH_CHECK(frame.timestamp >= timestamp);
+				timestamp = frame.timestamp;
+				frames++;
+			}
+		}
+		// 0.2 s at 46080 bytes/s, in frames of 21 bytes.
+		EH_CHECK_EQUAL(got.report.records, frames);
+		EH_CHECK_NEAR(439, frames, 10);
+	}
+
+
+//***************************************************************
+// Readers														*
+//***************************************************************
+
+	EH_TEST(test_a_reader_that_falls_behind_loses_bytes)
+	{
+		eHealthPtyConfig config;
+		config.baud = 2000000;
+		eHealthSerialPty pty(config);
+		EH_CHECK(pty.open());
+
+		int port = open(pty.path(), O_RDONLY | O_NOCTTY);
+		EH_CHECK(pty.waitForReader(1));
+
+		// 60000 bytes against what the pseudo-terminal buffers.
+		eHealthPtyReport report = pty.run(0.3);
+		EH_CHECK(report.overrun > 0);
+		EH_CHECK(report.bytes < 60000);
+		EH_CHECK_NEAR(60000, report.bytes + report.overrun, 3000);
+		close(port);
+	}
+
+	EH_TEST(test_closing_the_port_ends_the_run)
+	{
+		eHealthSerialPty pty(eHealthPtyConfig{});
+		EH_CHECK(pty.open());
+
+		int port = open(pty.path(), O_RDONLY | O_NOCTTY);
+		EH_CHECK(pty.waitForReader(1));
+		std::thread reader([port]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			close(port);
+		});
+
+		eHealthPtyReport report = pty.run(0);
+		reader.join();
+		EH_CHECK(report.hangup);
+		EH_CHECK(report.wallSeconds < 1);
+		EH_CHECK(report.records > 0);
+	}
+
+EH_TEST_MAIN()
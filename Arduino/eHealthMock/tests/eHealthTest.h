@@ -0,0 +1,88 @@
+/*
+*=========================================================================================
+ *  Minimal test harness for the host build of the eHealth Mock.
+ *
+ *  Tests register themselves with EH_TEST(name) and are run by EH_TEST_MAIN().
+ *  Each test starts with the simulated clock reset to zero.
+ *========================================================================================
+ */
+
+
+#ifndef eHealthTest_h
+#define eHealthTest_h
+
+#include "Arduino.h"
+
+#include <math.h>
+#include <stdio.h>
+
+typedef void (*eHealthTestFunction)(void);
+
+struct eHealthTestCase {
+	const char * name;
+	eHealthTestFunction function;
+	eHealthTestCase * next;
+};
+
+//! Head of the list of registered tests.
+inline eHealthTestCase *& eHealthTestList(void)
+{
+	static eHealthTestCase * head = 0;
+	return head;
+}
+
+//! Number of failed checks in the current run.
+inline int & eHealthTestFailures(void)
+{
+	static int failures = 0;
+	return failures;
+}
+
+struct eHealthTestRegistrar {
+	eHealthTestRegistrar(eHealthTestCase & test)
+	{
+		// Keep declaration order.
+		eHealthTestCase ** tail = &eHealthTestList();
+		while (*tail) {
+			tail = &(*tail)->next;
+		}
+		*tail = &test;
+	}
+};
+
+#define EH_TEST(name) \
+	static void name(void); \
+	static eHealthTestCase name##_case = { #name, name, 0 }; \
+	static eHealthTestRegistrar name##_registrar(name##_case); \
+	static void name(void)
+
+#define EH_CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			eHealthTestFailures()++; \
+		} \
+	} while (0)
+
+#define EH_CHECK_EQUAL(expected, actual) EH_CHECK((expected) == (actual))
+
+#define EH_CHECK_NEAR(expected, actual, tolerance) \
+	EH_CHECK(fabs((double)(expected) - (double)(actual)) <= (tolerance))
+
+#define EH_TEST_MAIN() \
+	int main(void) \
+	{ \
+		int failedTests = 0; \
+		for (eHealthTestCase * test = eHealthTestList(); test; test = test->next) { \
+			int before = eHealthTestFailures(); \
+			hostClockSet(0); \
+			test->function(); \
+			bool passed = eHealthTestFailures() == before; \
+			printf("%s %s\n", passed ? "ok  " : "FAIL", test->name); \
+			failedTests += passed ? 0 : 1; \
+		} \
+		return failedTests ? 1 : 0; \
+	}
+
+#endif
+
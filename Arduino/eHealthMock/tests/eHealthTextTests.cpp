@@ -0,0 +1,80 @@
+/*
+*=========================================================================================
+ *  Tests for the text formatting without the heap.
+ *
+ *  Linked against eHealthMockNoHeap, whose build fails if the library
+ *  references an allocator.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthTest.h"
+
+#include <string.h>
+
+
+	EH_TEST(test_names_come_from_flash_tables)
+	{
+		EH_CHECK(strcmp("January", (const char *)eHealthMonthName(1)) == 0);
+		EH_CHECK(strcmp("December", (const char *)eHealthMonthName(12)) == 0);
+		EH_CHECK(strcmp("December", (const char *)eHealthMonthName(0)) == 0);
+
+		EH_CHECK(strcmp("Supine position", (const char *)eHealthPositionName(EHEALTH_SUPINE)) == 0);
+		EH_CHECK(strcmp("Stand or sit position", (const char *)eHealthPositionName(EHEALTH_STANDING)) == 0);
+		EH_CHECK(strcmp("non-defined position", (const char *)eHealthPositionName(EHEALTH_UNDEFINED_POSITION)) == 0);
+		EH_CHECK(strcmp("non-defined position", (const char *)eHealthPositionName(200)) == 0);
+	}
+
+	EH_TEST(test_writer_truncates_and_counts_like_snprintf)
+	{
+		char buffer[8];
+		eHealthTextWriter text(buffer, sizeof(buffer));
+
+		text.print(F("at "));
+		text.printNumber(7, 2);
+		text.print(':');
+		text.printNumber(4294967295UL);
+
+		EH_CHECK_EQUAL(16U, text.length());
+		EH_CHECK(strcmp("at 07:4", buffer) == 0);
+
+		eHealthTextWriter empty(NULL, 0);
+		empty.print("none");
+		EH_CHECK_EQUAL(4U, empty.length());
+	}
+
+	EH_TEST(test_number_to_month_fills_the_buffer)
+	{
+		eHealthClassMock mock;
+		char name[10];
+
+		EH_CHECK_EQUAL(9U, mock.numberToMonth(9, name, sizeof(name)));
+		EH_CHECK(strcmp("September", name) == 0);
+		EH_CHECK_EQUAL(8U, mock.numberToMonth(-3, name, sizeof(name)));
+		EH_CHECK(strcmp("December", name) == 0);
+		EH_CHECK_EQUAL(8U, mock.numberToMonth(257, name, 4));
+		EH_CHECK(strcmp("Dec", name) == 0);
+	}
+
+	EH_TEST(test_records_format_into_the_buffer)
+	{
+		eHealthClassMock mock;
+		char text[48];
+
+		mock.readGlucometer();
+		mock.readBloodPressureSensor();
+
+		size_t length = mock.formatGlucoseRecord(4, text, sizeof(text));
+		EH_CHECK(strcmp("10 October 2016 10:10 5 mg/dL", text) == 0);
+		EH_CHECK_EQUAL(strlen(text), length);
+
+		length = mock.formatBloodPressureRecord(0, text, sizeof(text));
+		EH_CHECK(strcmp("10 October 2016 10:10 120/80 mmHg 65 bpm", text) == 0);
+		EH_CHECK_EQUAL(strlen(text), length);
+
+		EH_CHECK_EQUAL(length, mock.formatBloodPressureRecord(0, text, 10));
+		EH_CHECK_EQUAL(9U, strlen(text));
+	}
+
+EH_TEST_MAIN()
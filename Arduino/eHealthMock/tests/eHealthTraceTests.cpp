@@ -0,0 +1,231 @@
+/*
+*=========================================================================================
+ *  Tests for trace recording, mapping and replay.
+ *========================================================================================
+ */
+
+
+#include "eHealthMock.h"
+#include "eHealthTrace.h"
+#include "eHealthTest.h"
+
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+
+	static const uint16_t ECG_GSR = EHEALTH_CHANNEL_BIT(EHEALTH_ECG) | EHEALTH_CHANNEL_BIT(EHEALTH_GSR);
+
+	//! Records n ECG/GSR snapshots at 4 ms, 8 per frame, and BPM every 100 snapshots.
+	static std::string recordTrace(uint32_t n)
+	{
+		char path[] = "/tmp/ehealth-trace-XXXXXX";
+		int fd = mkstemp(path);
+		close(fd);
+
+		eHealthTraceWriter writer;
+		writer.open(path);
+
+		for (uint32_t i = 0; i < n; i += 8) {
+			uint16_t values[16];
+			for (uint32_t j = 0; j < 8; j++) {
+				values[2 * j] = (uint16_t)((i + j) % 1024);
+				values[2 * j + 1] = (uint16_t)(1023 - (i + j) % 1024);
+			}
+			writer.record(ECG_GSR, 8, 1000 + 4000 * i, 4000, values);
+
+			if (i % 100 < 8) {
+				uint16_t bpm = (uint16_t)(60 + i / 100);
+				writer.record(EHEALTH_CHANNEL_BIT(EHEALTH_BPM), 1, 1000 + 4000 * i, 0, &bpm);
+			}
+		}
+		writer.close();
+		return path;
+	}
+
+	EH_TEST(test_frame_values_match_unpack)
+	{
+		eHealthFrameEncoder encoder;
+		uint16_t values[11 * 3];
+		uint16_t unpacked[11 * 3];
+		uint8_t bytes[EHEALTH_FRAME_MAX_SIZE];
+		eHealthFrame frame;
+
+		for (int i = 0; i < 33; i++) {
+			values[i] = (uint16_t)(i * 91 % 256);
+		}
+		size_t size = encoder.encode(EHEALTH_ALL_CHANNELS, 3, 0, 0, values, bytes, sizeof(bytes));
+
+		EH_CHECK_EQUAL(size, eHealthFrameParse(bytes, size, frame));
+		EH_CHECK_EQUAL(0U, eHealthFrameParse(bytes, size - 1, frame));
+		frame.unpack(unpacked);
+
+		bool same = true;
+		for (uint8_t snapshot = 0; snapshot < 3; snapshot++) {
+			for (uint8_t channel = 0; channel < EHEALTH_CHANNEL_COUNT; channel++) {
+				same &= frame.value(snapshot, channel) == unpacked[snapshot * 11 + channel];
+			}
+		}
+		EH_CHECK(same);
+	}
+
+	EH_TEST(test_reader_maps_and_indexes_a_recorded_trace)
+	{
+		std::string path = recordTrace(1000);
+		eHealthTraceReader reader;
+
+		EH_CHECK(reader.open(path.c_str()));
+		EH_CHECK_EQUAL(135U, reader.frames());
+		EH_CHECK_EQUAL(ECG_GSR | EHEALTH_CHANNEL_BIT(EHEALTH_BPM), reader.channels());
+		EH_CHECK_EQUAL(0U, reader.droppedBytes());
+		EH_CHECK_EQUAL(1000U, reader.origin());
+		EH_CHECK_EQUAL(999U * 4000, reader.span());
+
+		// Frames point into the mapping.
+		EH_CHECK(reader.frameData(0) >= reader.data());
+		EH_CHECK(reader.frameData(0) < reader.data() + reader.size());
+		EH_CHECK_EQUAL(17, reader.frame(0).value(7, EHEALTH_GSR) == 1016 ? 17 : 0);
+
+		EH_CHECK(!reader.open("/nonexistent/trace"));
+		unlink(path.c_str());
+	}
+
+	EH_TEST(test_reader_accepts_raw_captures_with_noise)
+	{
+		eHealthFrameEncoder encoder;
+		std::vector<uint8_t> capture;
+		uint8_t bytes[64];
+
+		for (uint16_t i = 0; i < 10; i++) {
+			const uint8_t noise[] = { 'x', 0xA5, '\n' };
+			capture.insert(capture.end(), noise, noise + sizeof(noise));
+
+			size_t size = encoder.encode(EHEALTH_CHANNEL_BIT(EHEALTH_ECG), 1, i * 4000, 0, &i, bytes, sizeof(bytes));
+			capture.insert(capture.end(), bytes, bytes + size);
+		}
+
+		eHealthTraceReader reader;
+		reader.open(capture.data(), capture.size());
+
+		EH_CHECK_EQUAL(10U, reader.frames());
+		EH_CHECK_EQUAL(30U, reader.droppedBytes());
+		EH_CHECK_EQUAL(9U, reader.frame(9).value(0, EHEALTH_ECG));
+	}
+
+	EH_TEST(test_unthrottled_replay_serves_every_value_in_order)
+	{
+		std::string path = recordTrace(1000);
+		eHealthTraceReader reader;
+		reader.open(path.c_str());
+
+		eHealthTraceReplay replay(reader);
+		replay.setSpeed(0);
+
+		eHealthClassMock mock;
+		mock.replay(&replay);
+
+		bool same = true;
+		for (uint32_t i = 0; i < 1000; i++) {
+			same &= mock.readChannel(EHEALTH_ECG) == i % 1024;
+		}
+		EH_CHECK(same);
+		EH_CHECK(!replay.finished());
+
+		// Blocks draw from the same stream; the end holds the last value.
+		float gsr[1001];
+		mock.getSkinConductanceVoltageBlock(gsr, 1001);
+		EH_CHECK_NEAR(5.0, gsr[0], 1e-6);
+		EH_CHECK_NEAR(0.117, gsr[999], 1e-6);
+		EH_CHECK_NEAR(0.117, gsr[1000], 1e-6);
+		EH_CHECK_EQUAL(60, mock.getBPM());
+
+		// Channels missing from the trace keep their synthesized readings.
+		mock.readPulsioximeter();
+		EH_CHECK_EQUAL(98, mock.getOxygenSaturation());
+		EH_CHECK_NEAR(37.5, mock.getTemperature(), 1e-6);
+
+		mock.replay(NULL);
+		EH_CHECK_EQUAL(75, mock.getBPM());
+		unlink(path.c_str());
+	}
+
+	EH_TEST(test_timed_replay_follows_the_clock_at_speed)
+	{
+		std::string path = recordTrace(1000);
+		eHealthTraceReader reader;
+		reader.open(path.c_str());
+
+		eHealthTraceReplay replay(reader);
+		eHealthClassMock mock;
+		mock.replay(&replay);
+
+		replay.setSpeed(1);
+		EH_CHECK_EQUAL(0, mock.readChannel(EHEALTH_ECG));
+		hostClockAdvance(3999);
+		EH_CHECK_EQUAL(0, mock.readChannel(EHEALTH_ECG));
+		hostClockAdvance(1);
+		EH_CHECK_EQUAL(1, mock.readChannel(EHEALTH_ECG));
+		hostClockAdvance(400000);
+		EH_CHECK_EQUAL(101, mock.readChannel(EHEALTH_ECG));
+		EH_CHECK_EQUAL(60, mock.getBPM());
+		hostClockAdvance(12000);
+		EH_CHECK_EQUAL(61, mock.getBPM());
+
+		// Ten times faster, from the start: 100 ms of clock is a second of trace.
+		replay.setSpeed(10);
+		hostClockAdvance(100000);
+		EH_CHECK_EQUAL(250, mock.readChannel(EHEALTH_ECG));
+
+		hostClockAdvance(1000000);
+		EH_CHECK_EQUAL(999, mock.readChannel(EHEALTH_ECG));
+		EH_CHECK_EQUAL(24, mock.readChannel(EHEALTH_GSR));
+		EH_CHECK_EQUAL(69, mock.getBPM());
+		EH_CHECK(replay.finished());
+
+		// Looping wraps the replay time around the trace.
+		replay.setSpeed(1);
+		replay.setLoop(true);
+		hostClockAdvance(4000000 + 8000);
+		EH_CHECK_EQUAL(2, mock.readChannel(EHEALTH_ECG));
+		EH_CHECK(!replay.finished());
+
+		// 2^32 microseconds of trace time hold the end, not wrap to the start.
+		replay.setSpeed(16384);
+		replay.setLoop(false);
+		hostClockAdvance(262144);
+		EH_CHECK_EQUAL(999, mock.readChannel(EHEALTH_ECG));
+		EH_CHECK_EQUAL(24, mock.readChannel(EHEALTH_GSR));
+		EH_CHECK_EQUAL(69, mock.getBPM());
+		EH_CHECK(replay.finished());
+		unlink(path.c_str());
+	}
+
+	EH_TEST(test_write_frame_records_through_a_trace_writer)
+	{
+		char path[] = "/tmp/ehealth-trace-XXXXXX";
+		close(mkstemp(path));
+
+		eHealthTraceWriter writer;
+		writer.open(path);
+		eHealthOutput output(writer);
+		eHealthClassMock mock;
+		mock.setOutput(output);
+		mock.readPulsioximeter();
+
+		for (int i = 0; i < 5; i++) {
+			mock.writeFrame(EHEALTH_CHANNEL_BIT(EHEALTH_SPO2));
+			hostClockAdvance(1000);
+		}
+		writer.close();
+
+		eHealthTraceReader reader;
+		reader.open(path);
+		EH_CHECK_EQUAL(5U, reader.frames());
+		EH_CHECK_EQUAL(4000U, reader.span());
+		EH_CHECK_EQUAL(98, reader.frame(4).value(0, EHEALTH_SPO2));
+		unlink(path);
+	}
+
+EH_TEST_MAIN()
@@ -0,0 +1,118 @@
+/*
+*=========================================================================================
+ *  Tests for the synthetic waveform engine.
+ *========================================================================================
+ */
+
+
+#include "eHealthWaveform.h"
+#include "eHealthTest.h"
+
+
+	//! Counts upward crossings of threshold in samples.
+	static int countCrossings(const uint16_t * samples, size_t count, uint16_t threshold)
+	{
+		int crossings = 0;
+
+		for (size_t i = 1; i < count; i++) {
+			if (samples[i - 1] < threshold && samples[i] >= threshold) {
+				crossings++;
+			}
+		}
+		return crossings;
+	}
+
+	EH_TEST(test_ecg_beats_at_heart_rate)
+	{
+		static uint16_t samples[500 * 60];
+		eHealthWaveform waveform;
+
+		// One minute at 500 Hz and 72 bpm.
+		waveform.setECG(72, 300, 500);
+		waveform.fillECG(samples, 500 * 60);
+
+		// Only the R wave reaches half its amplitude above the 400 count baseline.
+		EH_CHECK_NEAR(72, countCrossings(samples, 500 * 60, 550), 1);
+	}
+
+	EH_TEST(test_ecg_has_pqrst_shape)
+	{
+		uint16_t samples[250];
+		eHealthWaveform waveform;
+
+		// One beat per second at 250 Hz: exactly one cycle.
+		waveform.setECG(60, 300, 250);
+		waveform.fillECG(samples, 250);
+
+		uint16_t highest = 0;
+		uint16_t lowest = 1023;
+		for (int i = 0; i < 250; i++) {
+			highest = samples[i] > highest ? samples[i] : highest;
+			lowest = samples[i] < lowest ? samples[i] : lowest;
+		}
+
+		EH_CHECK_NEAR(700, highest, 3);
+		EH_CHECK_NEAR(400 - 300 * 841 / 4096, lowest, 3);
+		EH_CHECK_EQUAL(400, samples[0]);
+	}
+
+	EH_TEST(test_air_flow_breathes_at_respiration_rate)
+	{
+		static uint16_t samples[50 * 60];
+		eHealthWaveform waveform;
+
+		waveform.setAirFlow(18, 400, 50);
+		waveform.fillAirFlow(samples, 50 * 60);
+
+		EH_CHECK_NEAR(18, countCrossings(samples, 50 * 60, 220), 1);
+	}
+
+	EH_TEST(test_emg_bursts_are_louder_than_rest)
+	{
+		static uint16_t samples[1000 * 5];
+		eHealthWaveform waveform;
+
+		// One contraction per second: 30% burst, 70% rest.
+		waveform.setEMG(60, 400, 1000);
+		waveform.fillEMG(samples, 1000 * 5);
+
+		long burst = 0;
+		long rest = 0;
+		for (int i = 0; i < 1000 * 5; i++) {
+			long deviation = labs((long)samples[i] - 512);
+			if (i % 1000 < 290) {
+				burst += deviation;
+			} else if (i % 1000 > 310) {
+				rest += deviation;
+			}
+		}
+
+		EH_CHECK(burst / 290 > 4 * (rest / 690));
+	}
+
+	EH_TEST(test_readings_stay_in_adc_range)
+	{
+		eHealthWaveform waveform;
+
+		waveform.setECG(200, 2000, 250);
+		for (int i = 0; i < 10000; i++) {
+			EH_CHECK(waveform.nextECG() <= 1023);
+		}
+	}
+
+	EH_TEST(test_rates_beyond_the_sample_rate_do_not_wrap)
+	{
+		uint16_t samples[300];
+		eHealthWaveform waveform;
+
+		// 200 bpm at 3 Hz is more than a beat per sample: the phase must not
+		// wrap around to a slow wave with R peaks in it.
+		waveform.setECG(200, 300, 3);
+		waveform.fillECG(samples, 300);
+
+		for (int i = 0; i < 300; i++) {
+			EH_CHECK_NEAR(samples[0], samples[i], 2);
+		}
+	}
+
+EH_TEST_MAIN()
@@ -2,31 +2,65 @@
  1)Initialize a serial communication (COM port)
  2)Receive the data from it
  3) write it to a dict
- 4)Parse it to Json"""
+ 4)Parse it to Json
+
+Usage: python3 ArduinoConnector.py [PORT [BAUD [SECONDS [TIMEOUT]]]]
+Without a port the first one found is used, at 9600 baud. Stops after
+SECONDS, or on Ctrl-C, and prints the lines read per second and the CPU
+time spent. TIMEOUT is the read timeout in seconds, 0 by default: reads
+return at once, busy polling the port, as this script always did; 1 lets
+the reader sleep until a line comes. Arduino/eHealthMock's ehealth_pty
+emulates the board."""
 import serial
+import sys
 import time
 import serial.tools.list_ports
 import json
 #Detecting the connected port
-ports = list(serial.tools.list_ports.comports())
-print(ports)
-for p in ports:
-    x=str(p)
-    x=x[0:4]
+if len(sys.argv) > 1:
+    x = sys.argv[1]
+else:
+    ports = list(serial.tools.list_ports.comports())
+    print(ports)
+    if not ports:
+        sys.exit('No serial port found, give one on the command line')
+    x = ports[0].device
     print(x)
+baud = int(sys.argv[2]) if len(sys.argv) > 2 else 9600
+seconds = float(sys.argv[3]) if len(sys.argv) > 3 else 0
+timeout = float(sys.argv[4]) if len(sys.argv) > 4 else 0
 #Initialize the connection
-ser = serial.Serial( x , 9600, timeout=0)
+ser = serial.Serial(x, baud, timeout=timeout)
+lines = 0
+received = 0
+pending = b''
+start = time.monotonic()
+cpu = time.process_time()
 #Reading The data
-while 1:
-    try:
-        val=ser.readline()
-        list1 = list() #making a BPR list
-        list2 = list() #making a Skin conductance
-        val = str.split() #spliting the recieved line of data to BPR and Skin conductance
-        list1.append(val[0]) #adding data to BPR list
-        list2.append(val[1]) #adding data to skin conductance list
-        data_dict = {"BPR": list1, "Skin conductance": list2} #making a dict
-        data_Json = json.dumps(data_dict) #parse into json
-    except ser.SerialTimeoutException:
-        print('Data could not be read')
-        time.sleep(1)
+try:
+    while not seconds or time.monotonic() - start < seconds:
+        try:
+            pending += ser.readline()
+            if not pending.endswith(b'\n'):
+                continue #the rest of the line is still on its way
+            line, pending = pending, b''
+            received += len(line)
+            val = line.decode('ascii', 'replace').split() #spliting the recieved line of data to BPR and Skin conductance
+            if len(val) < 2:
+                continue #a line cut short
+            lines += 1
+            list1 = list() #making a BPR list
+            list2 = list() #making a Skin conductance
+            list1.append(val[0]) #adding data to BPR list
+            list2.append(val[1]) #adding data to skin conductance list
+            data_dict = {"BPR": list1, "Skin conductance": list2} #making a dict
+            data_Json = json.dumps(data_dict) #parse into json
+        except serial.SerialException:
+            print('Data could not be read')
+            time.sleep(1)
+except KeyboardInterrupt:
+    pass
+wall = time.monotonic() - start
+cpu = time.process_time() - cpu
+print('%d lines, %d bytes in %.2f s: %.0f lines/s, %.0f bytes/s, cpu %.2f s (%.0f%%)'
+      % (lines, received, wall, lines / wall, received / wall, cpu, 100 * cpu / wall))
@@ -3,6 +3,12 @@ from math import sin
 from kivy.garden.graph import Graph, MeshLinePlot
 from kivy.uix.widget import Widget
 from kivy.clock import Clock
+from array import array
+
+try:
+    import ehealthmock #built in Arduino/eHealthMock; put its build directory on PYTHONPATH
+except ImportError:
+    ehealthmock = None
 
 
 class Widgets(Widget):
@@ -16,8 +22,22 @@ class Widgets(Widget):
         self.ids.g1.add_plot(self.plotter1)
         self.ids.g2.add_plot(self.plotter2)
 
+        #ECG and EMG from the mock, filled in place each refresh
+        self.mock = ehealthmock.Mock(rate=250) if ehealthmock else None
+        self.ecg = array('f', bytes(4 * 101))
+        self.emg = array('f', bytes(4 * 101))
+        if self.mock:
+            for g in (self.ids.g1, self.ids.g2):
+                g.ymin, g.ymax = 0, 5
+
     def plot(self, *args):
         self.tick += 1
+        if self.mock:
+            self.mock.ecg(self.ecg)
+            self.mock.emg(self.emg)
+            self.plotter1.points = list(enumerate(self.ecg))
+            self.plotter2.points = list(enumerate(self.emg))
+            return
         self.plotter1.points = [(x, sin((x-self.tick) / 10.)) for x in range(0, 101)]
         self.plotter2.points = [(x, sin((x+self.tick) / 10.)) for x in range(0, 101)]
         print(self.tick)